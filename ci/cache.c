@@ -0,0 +1,380 @@
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../core/sha256.h"
+#include "ci.h"
+#include "ignore.h"
+
+/*
+ * Cache de resultados de steps em <repo>/.clurg/ci/cache/<ab>/<chave>/:
+ *
+ *   status        exit code do step (só sucessos são guardados)
+ *   outputs.tar   os caminhos de outputs: como estavam no fim do step
+ *
+ * A chave é o SHA-256 do comando, das variáveis de ambiente (menos as que
+ * mudam a cada sessão, como PWD e SHLVL), da lista de outputs e, para cada
+ * arquivo do workspace que casa com os inputs, caminho, bit de execução e
+ * hash do conteúdo. Mudar a versão em CACHE_FORMAT invalida tudo.
+ */
+
+#define CACHE_FORMAT "clurg-ci-cache 1"
+
+extern char **environ;
+
+/* Prefixos de variáveis que não entram na chave */
+static const char *volatile_env[] = {"PWD=",     "OLDPWD=", "SHLVL=",  "_=",    "TERM=",
+                                     "COLUMNS=", "LINES=",  "DISPLAY=", "SSH_", "TMUX",
+                                     "XDG_",     "CLURG_COMMIT_",      "CLURG_CI_", NULL};
+
+typedef struct {
+  char **items;
+  size_t count, cap;
+} str_list_t;
+
+static int list_add(str_list_t *list, const char *s) {
+  if (list->count == list->cap) {
+    size_t cap = list->cap ? list->cap * 2 : 64;
+    char **items = realloc(list->items, cap * sizeof(*items));
+    if (!items) {
+      return -1;
+    }
+    list->items = items;
+    list->cap = cap;
+  }
+  list->items[list->count] = strdup(s);
+  return list->items[list->count++] ? 0 : -1;
+}
+
+static void list_free(str_list_t *list) {
+  size_t i;
+
+  for (i = 0; i < list->count; i++) {
+    free(list->items[i]);
+  }
+  free(list->items);
+}
+
+static int compare_str(const void *a, const void *b) {
+  return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static void hash_field(sha256_ctx_t *ctx, const char *tag, const char *value) {
+  sha256_update(ctx, tag, strlen(tag) + 1);
+  sha256_update(ctx, value, strlen(value) + 1);
+}
+
+static int is_volatile(const char *var) {
+  size_t i;
+
+  for (i = 0; volatile_env[i]; i++) {
+    if (strncmp(var, volatile_env[i], strlen(volatile_env[i])) == 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* Arquivos do workspace (cwd) que casam com os inputs; um diretório que casa
+ * leva tudo o que está abaixo dele */
+static int collect_inputs(const ignore_t *inputs, const char *rel, int included,
+                          str_list_t *out) {
+  char rel_path[PATH_MAX];
+  struct dirent *entry;
+  DIR *dir = opendir(rel[0] ? rel : ".");
+  int ret = 0;
+
+  if (!dir) {
+    return -1;
+  }
+
+  while (ret == 0 && (entry = readdir(dir)) != NULL) {
+    struct stat st;
+    int is_dir, match;
+
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0 ||
+        strcmp(entry->d_name, ".clurg") == 0 || strcmp(entry->d_name, ".git") == 0) {
+      continue;
+    }
+    if (snprintf(rel_path, sizeof(rel_path), "%s%s%s", rel, rel[0] ? "/" : "", entry->d_name) >=
+        (int)sizeof(rel_path)) {
+      continue;
+    }
+
+    if (entry->d_type == DT_DIR || entry->d_type == DT_REG) {
+      is_dir = entry->d_type == DT_DIR;
+    } else if (stat(rel_path, &st) == 0 && (S_ISDIR(st.st_mode) || S_ISREG(st.st_mode))) {
+      is_dir = S_ISDIR(st.st_mode);
+    } else {
+      continue;
+    }
+
+    match = included || ignore_match(inputs, rel_path, is_dir);
+    if (is_dir) {
+      ret = collect_inputs(inputs, rel_path, match, out);
+    } else if (match) {
+      ret = list_add(out, rel_path);
+    }
+  }
+
+  closedir(dir);
+  return ret;
+}
+
+static int action_key(const ci_step_t *step, char hex[SHA256_HEX_SIZE]) {
+  uint8_t digest[SHA256_DIGEST_SIZE];
+  uint8_t (*digests)[SHA256_DIGEST_SIZE] = NULL;
+  int *results = NULL;
+  str_list_t env = {0}, files = {0};
+  sha256_ctx_t ctx;
+  ignore_t *inputs = ignore_new();
+  size_t i;
+  int ret = -1;
+
+  if (!inputs) {
+    return -1;
+  }
+  for (i = 0; i < step->input_count; i++) {
+    ignore_add(inputs, step->inputs[i]);
+  }
+
+  sha256_init(&ctx);
+  hash_field(&ctx, "format", CACHE_FORMAT);
+  hash_field(&ctx, "run", step->command);
+
+  for (i = 0; environ[i]; i++) {
+    if (!is_volatile(environ[i]) && list_add(&env, environ[i]) != 0) {
+      goto out;
+    }
+  }
+  qsort(env.items, env.count, sizeof(*env.items), compare_str);
+  for (i = 0; i < env.count; i++) {
+    hash_field(&ctx, "env", env.items[i]);
+  }
+
+  for (i = 0; i < step->output_count; i++) {
+    hash_field(&ctx, "output", step->outputs[i]);
+  }
+
+  if (collect_inputs(inputs, "", 0, &files) != 0) {
+    goto out;
+  }
+  qsort(files.items, files.count, sizeof(*files.items), compare_str);
+
+  /* Conteúdo dos inputs em lote (multi-buffer para os arquivos pequenos) */
+  digests = malloc((files.count ? files.count : 1) * sizeof(*digests));
+  results = malloc((files.count ? files.count : 1) * sizeof(*results));
+  if (!digests || !results ||
+      sha256_files((const char *const *)files.items, files.count, digests, results) != 0) {
+    goto out;
+  }
+  for (i = 0; i < files.count; i++) {
+    struct stat st;
+    char file_hex[SHA256_HEX_SIZE];
+
+    sha256_to_hex(digests[i], file_hex);
+    hash_field(&ctx, "input", files.items[i]);
+    hash_field(&ctx, stat(files.items[i], &st) == 0 && (st.st_mode & S_IXUSR) ? "x" : "-",
+               file_hex);
+  }
+
+  sha256_final(&ctx, digest);
+  sha256_to_hex(digest, hex);
+  ret = 0;
+
+out:
+  free(digests);
+  free(results);
+  list_free(&env);
+  list_free(&files);
+  ignore_free(inputs);
+  return ret;
+}
+
+static int wait_exit_code(pid_t pid) {
+  int status;
+
+  while (waitpid(pid, &status, 0) < 0) {
+    if (errno != EINTR) {
+      return -1;
+    }
+  }
+  if (WIFEXITED(status)) {
+    return WEXITSTATUS(status);
+  }
+  return WIFSIGNALED(status) ? 128 + WTERMSIG(status) : -1;
+}
+
+static int run_command(char *const argv[]) {
+  pid_t pid;
+
+  fflush(stdout);
+  fflush(stderr);
+  pid = fork();
+
+  if (pid < 0) {
+    perror("fork");
+    return -1;
+  }
+  if (pid == 0) {
+    execvp(argv[0], argv);
+    perror("execvp");
+    _exit(1);
+  }
+  return wait_exit_code(pid);
+}
+
+static int mkdir_p(const char *path) {
+  char tmp[PATH_MAX];
+  char *p;
+
+  snprintf(tmp, sizeof(tmp), "%s", path);
+  for (p = tmp + 1; *p; p++) {
+    if (*p == '/') {
+      *p = '\0';
+      if (mkdir(tmp, 0755) != 0 && errno != EEXIST) {
+        return -1;
+      }
+      *p = '/';
+    }
+  }
+  return mkdir(tmp, 0755) != 0 && errno != EEXIST ? -1 : 0;
+}
+
+/* Guarda outputs e status num diretório temporário e o renomeia para o nome
+ * final: leitores nunca veem uma entrada pela metade */
+static void cache_store(const ci_step_t *step, const char *cache_dir, const char *entry,
+                        int exit_code) {
+  char tmp[PATH_MAX];
+  char file[PATH_MAX + 16];
+  char **argv;
+  size_t i;
+  int argc = 0;
+  FILE *f;
+
+  for (i = 0; i < step->output_count; i++) {
+    if (access(step->outputs[i], F_OK) != 0) {
+      fprintf(stderr, "aviso: output '%s' do step '%s' não existe; resultado fora do cache\n",
+              step->outputs[i], step->name);
+      return;
+    }
+  }
+
+  if (snprintf(tmp, sizeof(tmp), "%s/tmp-%d", cache_dir, (int)getpid()) >= (int)sizeof(tmp) ||
+      mkdir_p(tmp) != 0) {
+    return;
+  }
+
+  if (step->output_count > 0) {
+    argv = malloc((step->output_count + 5) * sizeof(*argv));
+    if (!argv) {
+      goto fail;
+    }
+    snprintf(file, sizeof(file), "%s/outputs.tar", tmp);
+    argv[argc++] = "tar";
+    argv[argc++] = "-cf";
+    argv[argc++] = file;
+    argv[argc++] = "--";
+    for (i = 0; i < step->output_count; i++) {
+      argv[argc++] = (char *)step->outputs[i];
+    }
+    argv[argc] = NULL;
+    argc = run_command(argv);
+    free(argv);
+    if (argc != 0) {
+      goto fail;
+    }
+  }
+
+  snprintf(file, sizeof(file), "%s/status", tmp);
+  f = fopen(file, "w");
+  if (!f || fprintf(f, "%d\n", exit_code) < 0 || fclose(f) != 0) {
+    goto fail;
+  }
+
+  /* Outro processo pode ter guardado a mesma chave antes: fica a dele */
+  if (rename(tmp, entry) == 0) {
+    printf("  cache: guardado %.12s\n", strrchr(entry, '/') + 1);
+    return;
+  }
+
+fail:
+  snprintf(file, sizeof(file), "%s/outputs.tar", tmp);
+  unlink(file);
+  snprintf(file, sizeof(file), "%s/status", tmp);
+  unlink(file);
+  rmdir(tmp);
+}
+
+int cache_run_step(const ci_step_t *step, const char *cache_dir, char *const argv[]) {
+  char hex[SHA256_HEX_SIZE];
+  char entry[PATH_MAX];
+  char shard[PATH_MAX];
+  char file[PATH_MAX + 16];
+  int exit_code;
+  FILE *f;
+
+  if (action_key(step, hex) != 0) {
+    fprintf(stderr, "aviso: não foi possível calcular a chave do step '%s'; rodando sem cache\n",
+            step->name);
+    return run_command(argv);
+  }
+
+  if (snprintf(shard, sizeof(shard), "%s/%.2s", cache_dir, hex) >= (int)sizeof(shard) ||
+      snprintf(entry, sizeof(entry), "%s/%s", shard, hex) >= (int)sizeof(entry)) {
+    fprintf(stderr, "aviso: caminho do cache longo demais para o step '%s'; rodando sem cache\n",
+            step->name);
+    return run_command(argv);
+  }
+  snprintf(file, sizeof(file), "%s/status", entry);
+
+  f = fopen(file, "r");
+  if (f) {
+    int ok = fscanf(f, "%d", &exit_code) == 1;
+    fclose(f);
+
+    /* Um step com outputs: sempre guarda o outputs.tar; sem ele o hit
+     * deixaria o workspace sem os artefatos que os próximos steps esperam */
+    snprintf(file, sizeof(file), "%s/outputs.tar", entry);
+    if (ok && step->output_count > 0) {
+      char *tar[] = {"tar", "-xf", file, NULL};
+      ok = access(file, F_OK) == 0 && run_command(tar) == 0;
+    }
+    if (ok) {
+      printf("  cache: hit %.12s (exit %d)\n", hex, exit_code);
+      return exit_code;
+    }
+    fprintf(stderr, "aviso: entrada de cache %.12s inválida; rodando o step\n", hex);
+    /* Abre espaço para o rename de cache_store gravar a entrada de novo */
+    unlink(file);
+    snprintf(file, sizeof(file), "%s/status", entry);
+    unlink(file);
+    rmdir(entry);
+  }
+
+  exit_code = run_command(argv);
+  if (exit_code == 0 && mkdir_p(shard) == 0) {
+    cache_store(step, cache_dir, entry, exit_code);
+  }
+  return exit_code;
+}
+
+int cache_dir_path(const char *repo_root, char *out, size_t size) {
+  const char *env = getenv("CLURG_CI_CACHE");
+  char root[PATH_MAX];
+
+  if ((env && strcmp(env, "0") == 0) || !repo_root || !realpath(repo_root, root)) {
+    return -1;
+  }
+  /* Os steps rodam com cwd no workspace: o caminho precisa ser absoluto */
+  return snprintf(out, size, "%s/.clurg/ci/cache", root) < (int)size ? 0 : -1;
+}
@@ -0,0 +1,237 @@
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "ci.h"
+
+/*
+ * Contabilidade por cgroup v2: <cgroup atual>/clurg-ci-<pid>/step-<n>.
+ *
+ * O rusage do wait4() só enxerga os processos que o step esperou; o cgroup
+ * pega também os que ele largou em segundo plano, e dá pico de memória e
+ * bytes de I/O (quando os controladores memory e io estão disponíveis no
+ * cgroup atual). Tudo aqui é opcional: qualquer falha só desliga o cgroup.
+ */
+
+static char pipeline_cgroup[PATH_MAX];
+
+/* Ponto de montagem do cgroup2 segundo /proc/self/mountinfo */
+static int find_cgroup2_mount(char *out, size_t size) {
+  char line[4096];
+  FILE *f = fopen("/proc/self/mountinfo", "r");
+  int found = -1;
+
+  if (!f) {
+    return -1;
+  }
+  while (found != 0 && fgets(line, sizeof(line), f)) {
+    /* ... <mount point> <opções> ... - <fstype> <origem> <opções> */
+    char mount_point[PATH_MAX];
+    char *sep = strstr(line, " - ");
+
+    if (!sep || strncmp(sep + 3, "cgroup2 ", 8) != 0) {
+      continue;
+    }
+    if (sscanf(line, "%*s %*s %*s %*s %4095s", mount_point) == 1 &&
+        snprintf(out, size, "%s", mount_point) < (int)size) {
+      found = 0;
+    }
+  }
+  fclose(f);
+  return found;
+}
+
+/* Caminho do cgroup v2 atual ("0::/caminho" em /proc/self/cgroup) */
+static int current_cgroup(char *out, size_t size) {
+  char line[PATH_MAX + 16];
+  FILE *f = fopen("/proc/self/cgroup", "r");
+  int found = -1;
+
+  if (!f) {
+    return -1;
+  }
+  while (found != 0 && fgets(line, sizeof(line), f)) {
+    if (strncmp(line, "0::", 3) == 0) {
+      line[strcspn(line, "\n")] = '\0';
+      found = snprintf(out, size, "%s", line + 3) < (int)size ? 0 : -1;
+    }
+  }
+  fclose(f);
+  return found;
+}
+
+static int write_file(const char *dir, const char *name, const char *value) {
+  char path[PATH_MAX + 64];
+  ssize_t len = (ssize_t)strlen(value);
+  int fd, ok;
+
+  snprintf(path, sizeof(path), "%s/%s", dir, name);
+  fd = open(path, O_WRONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return -1;
+  }
+  ok = write(fd, value, len) == len;
+  close(fd);
+  return ok ? 0 : -1;
+}
+
+/* Conteúdo de <dir>/<name> em `buf`; -1 se não existe */
+static int read_file(const char *dir, const char *name, char *buf, size_t size) {
+  char path[PATH_MAX + 64];
+  ssize_t n;
+  int fd;
+
+  snprintf(path, sizeof(path), "%s/%s", dir, name);
+  fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return -1;
+  }
+  n = read(fd, buf, size - 1);
+  close(fd);
+  if (n < 0) {
+    return -1;
+  }
+  buf[n] = '\0';
+  return 0;
+}
+
+/* Valor de "chave N" num arquivo de estatísticas (cpu.stat) */
+static long long stat_value(const char *text, const char *key) {
+  size_t len = strlen(key);
+  const char *p = text;
+
+  while (p && *p) {
+    if (strncmp(p, key, len) == 0 && p[len] == ' ') {
+      return strtoll(p + len + 1, NULL, 10);
+    }
+    p = strchr(p, '\n');
+    p = p ? p + 1 : NULL;
+  }
+  return -1;
+}
+
+/* io.stat: uma linha por dispositivo, "8:0 rbytes=N wbytes=N ..." */
+static void io_totals(const char *text, long long *rbytes, long long *wbytes) {
+  const char *p;
+
+  *rbytes = *wbytes = 0;
+  for (p = text; (p = strstr(p, "bytes=")) != NULL; p += 6) {
+    if (p - text >= 1 && p[-1] == 'r') {
+      *rbytes += strtoll(p + 6, NULL, 10);
+    } else if (p - text >= 1 && p[-1] == 'w') {
+      *wbytes += strtoll(p + 6, NULL, 10);
+    }
+  }
+}
+
+int cgroup_pipeline_init(void) {
+  const char *env = getenv("CLURG_CI_CGROUP");
+  char mount_point[PATH_MAX];
+  char current[PATH_MAX];
+
+  pipeline_cgroup[0] = '\0';
+  if ((env && strcmp(env, "0") == 0) || find_cgroup2_mount(mount_point, sizeof(mount_point)) != 0 ||
+      current_cgroup(current, sizeof(current)) != 0) {
+    return -1;
+  }
+
+  if (snprintf(pipeline_cgroup, sizeof(pipeline_cgroup), "%s%s/clurg-ci-%d", mount_point,
+               strcmp(current, "/") == 0 ? "" : current,
+               (int)getpid()) >= (int)sizeof(pipeline_cgroup) ||
+      mkdir(pipeline_cgroup, 0755) != 0) {
+    pipeline_cgroup[0] = '\0';
+    return -1;
+  }
+
+  /* Repassar aos steps os controladores que existirem; sem eles ainda há
+   * cpu.stat, que todo cgroup v2 tem */
+  write_file(pipeline_cgroup, "cgroup.subtree_control", "+memory");
+  write_file(pipeline_cgroup, "cgroup.subtree_control", "+io");
+  return 0;
+}
+
+void cgroup_step_create(size_t index, char *path, size_t path_size) {
+  path[0] = '\0';
+  if (!pipeline_cgroup[0]) {
+    return;
+  }
+  if (snprintf(path, path_size, "%s/step-%zu", pipeline_cgroup, index) >= (int)path_size ||
+      (mkdir(path, 0755) != 0 && errno != EEXIST)) {
+    path[0] = '\0';
+  }
+}
+
+void cgroup_step_enter(const char *path) {
+  if (path && path[0]) {
+    /* "0" = o próprio processo; os filhos dele herdam o cgroup */
+    write_file(path, "cgroup.procs", "0");
+  }
+}
+
+void cgroup_step_collect(size_t index, ci_step_stats_t *stats) {
+  char path[PATH_MAX + 32];
+  char buf[4096];
+
+  if (!pipeline_cgroup[0]) {
+    return;
+  }
+  snprintf(path, sizeof(path), "%s/step-%zu", pipeline_cgroup, index);
+  if (access(path, F_OK) != 0) {
+    return;
+  }
+
+  stats->has_cgroup = 1;
+  stats->cg_cpu_usec = -1;
+  stats->cg_memory_peak = -1;
+  stats->cg_io_read = stats->cg_io_write = -1;
+
+  if (read_file(path, "cpu.stat", buf, sizeof(buf)) == 0) {
+    stats->cg_cpu_usec = stat_value(buf, "usage_usec");
+  }
+  if (read_file(path, "memory.peak", buf, sizeof(buf)) == 0) {
+    stats->cg_memory_peak = strtoll(buf, NULL, 10);
+  }
+  if (read_file(path, "io.stat", buf, sizeof(buf)) == 0) {
+    io_totals(buf, &stats->cg_io_read, &stats->cg_io_write);
+  }
+
+  /* Falha se sobrou processo do step vivo; cgroup_pipeline_cleanup() tenta
+   * de novo */
+  rmdir(path);
+}
+
+void cgroup_pipeline_cleanup(void) {
+  char path[PATH_MAX + NAME_MAX + 2];
+  struct dirent *entry;
+  DIR *dir;
+
+  if (!pipeline_cgroup[0]) {
+    return;
+  }
+  if (rmdir(pipeline_cgroup) != 0 && errno == EBUSY && (dir = opendir(pipeline_cgroup))) {
+    /* Steps que deixaram processos: derrubá-los e remover os cgroups */
+    while ((entry = readdir(dir)) != NULL) {
+      if (strncmp(entry->d_name, "step-", 5) == 0) {
+        snprintf(path, sizeof(path), "%s/%s", pipeline_cgroup, entry->d_name);
+        int tries;
+
+        write_file(path, "cgroup.kill", "1");
+        /* O kill é assíncrono: esperar o cgroup esvaziar (até ~0,5 s) */
+        for (tries = 0; rmdir(path) != 0 && errno == EBUSY && tries < 50; tries++) {
+          usleep(10000);
+        }
+      }
+    }
+    closedir(dir);
+    rmdir(pipeline_cgroup);
+  }
+  pipeline_cgroup[0] = '\0';
+}
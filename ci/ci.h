@@ -2,41 +2,176 @@
 #define CI_H
 
 #include <stddef.h>
+#include <stdio.h>
 
-#define MAX_STEPS 64
-#define MAX_STEP_NAME 64
-#define MAX_COMMAND 256
-#define MAX_PIPELINE_NAME 64
+/* Estado do parser: arena de onde saem steps, listas e strings do pipeline */
+typedef struct ci_arena ci_arena_t;
 
 typedef struct {
-  char name[MAX_STEP_NAME];
-  char command[MAX_COMMAND];
+  const char *name;
+  const char *command;
+  int line; /* linha do "step" no arquivo, para mensagens de erro */
+  /* needs: "a", "b" — sem a chave, o step depende do anterior no arquivo */
+  const char **needs;
+  size_t need_count;
+  int needs_declared;
+  /* índices em steps[] resolvidos por config_parse() */
+  int *deps;
+  size_t dep_count;
+  /* inputs: padrões no formato do .clurgignore; com eles o resultado do step
+   * vai para o cache (.clurg/ci/cache), junto com os caminhos de outputs: */
+  const char **inputs;
+  size_t input_count;
+  const char **outputs;
+  size_t output_count;
 } ci_step_t;
 
+/* Um eixo de `matrix { CC: ["gcc", "clang"] }`: variável de ambiente e valores */
 typedef struct {
-  char name[MAX_PIPELINE_NAME];
-  ci_step_t steps[MAX_STEPS];
+  const char *name;
+  const char **values;
+  size_t value_count;
+  int line;
+} ci_matrix_axis_t;
+
+/* Tudo o que o pipeline aponta vive em `arena`; config_free() libera de uma vez */
+typedef struct {
+  const char *name;
+  ci_step_t *steps;
   size_t step_count;
+  /* Sem matrix, matrix_count = 0; com ela o pipeline roda uma vez por
+   * combinação de valores (matrix.c) */
+  ci_matrix_axis_t *matrix;
+  size_t matrix_count;
+  ci_arena_t *arena;
 } ci_pipeline_t;
 
-/* Logger */
+/* Recursos consumidos por um step: rusage do wait4() (o step e os filhos
+ * que ele esperou) e, com cgroup v2, os contadores do cgroup do step */
+typedef struct {
+  double wall_s; /* relógio monotônico, do fork ao wait */
+  double user_s;
+  double sys_s;
+  long max_rss_kb;
+  long in_blocks; /* blocos de 512 bytes lidos/gravados no disco */
+  long out_blocks;
+  long voluntary_ctxsw;
+  long involuntary_ctxsw;
+  int has_cgroup;
+  long long cg_cpu_usec;     /* -1 quando o arquivo não existe */
+  long long cg_memory_peak;  /* bytes */
+  long long cg_io_read;      /* bytes */
+  long long cg_io_write;
+} ci_step_stats_t;
+
+/* Logger. Além do .log legível, logger_cleanup() grava um .json com o mesmo
+ * nome e os recursos de cada step */
 int logger_init(const char *log_dir);
-void logger_log_step(const char *step_name, int status, int exit_code);
+/* mkdir -p */
+int logger_mkdirs(const char *dir);
+/* `stats` pode ser NULL (step que nem chegou a rodar) */
+void logger_log_step(const char *step_name, int status, int exit_code,
+                     const ci_step_stats_t *stats);
 void logger_cleanup(void);
+/* Diretório da execução (<log_dir>/ci_<data>/), com a saída de cada step;
+ * NULL se não pôde ser criado */
+const char *logger_run_dir(void);
+/* Escrita de JSON compartilhada com events.c */
+void logger_json_string(FILE *f, const char *s);
+void logger_json_stats(FILE *f, const ci_step_stats_t *stats);
+
+/* Eventos da execução (events.c): um objeto JSON por linha em
+ * ci_<data>.jsonl, com "t_ns" do CLOCK_MONOTONIC. Quem chama só copia o
+ * evento para um ring buffer; uma thread grava em lotes. As funções
+ * events_* devem ser chamadas de uma thread só (a do executor). */
+int events_open(const char *path);
+void events_close(void);
+void events_pipeline_start(const char *pipeline, size_t step_count, int jobs);
+void events_step_start(const char *step, size_t index, int pid);
+/* `outcome`: "ok", "fail", "canceled" ou "skipped"; `stats` pode ser NULL */
+void events_step_end(const char *step, size_t index, const char *outcome, int exit_code,
+                     const ci_step_stats_t *stats);
+void events_pipeline_end(int failed, double critical_s);
+
+/* Saída dos steps (output.c): pipe não bloqueante + <run>/<step>.log + fim
+ * da saída em memória (tamanho fixo) para o resumo de falhas */
+typedef struct ci_output ci_output_t;
+/* Cria o pipe; `*write_fd` é a ponta que o filho usa como stdout e stderr */
+ci_output_t *output_open(const char *run_dir, const char *step_name, int *write_fd);
+int output_fd(const ci_output_t *out);
+/* Lê o que houver sem bloquear; 1 quando o pipe fechou */
+int output_drain(ci_output_t *out);
+unsigned long long output_bytes(const ci_output_t *out);
+void output_print_tail(const ci_output_t *out, FILE *f);
+void output_close(ci_output_t *out);
+
+/* cgroup v2 (cgroup.c): um cgroup por pipeline, embaixo do cgroup atual, com
+ * um filho por step. Sem cgroup v2 gravável (ou com CLURG_CI_CGROUP=0),
+ * cgroup_pipeline_init() retorna -1 e os steps rodam sem ele */
+int cgroup_pipeline_init(void);
+/* Cria o cgroup do step `index`; `path` vazio se não houver */
+void cgroup_step_create(size_t index, char *path, size_t path_size);
+/* No processo filho, antes do exec: entra no cgroup do step */
+void cgroup_step_enter(const char *path);
+/* Lê os contadores do cgroup do step `index` para `stats` e o remove */
+void cgroup_step_collect(size_t index, ci_step_stats_t *stats);
+void cgroup_pipeline_cleanup(void);
 
 /* Workspace */
 int workspace_create(char *workspace_path, size_t path_size);
+/* Com CLURG_CI_WORKSPACE=warm, reserva um slot do pool persistente do pipeline
+ * em <repo>/.clurg/ci/workspaces/; senão (ou sem slot livre) workspace_create() */
+int workspace_open(const char *repo_root, const char *pipeline_name, char *workspace_path,
+                   size_t path_size);
 int workspace_cleanup(const char *workspace_path);
 int workspace_setup(const char *workspace_path, const char *repo_path);
+/* Estratégia usada pelo último workspace_setup(): overlay, reflink, hardlink, copy ou warm */
+const char *workspace_strategy(void);
+/* Duração do último workspace_setup() */
+double workspace_setup_ms(void);
+/* No processo filho, antes do chdir: entra no namespace do workspace overlay */
+int workspace_enter(const char *workspace_path);
 
-/* Config (Parser) */
+/* Config (Parser). Erros vão para stderr como "arquivo:linha: mensagem" */
 int config_parse(const char *config_file, ci_pipeline_t *pipeline);
 void config_free(ci_pipeline_t *pipeline);
 
 /* Executor */
 int executor_run_step(const ci_step_t *step, const char *workspace_path);
+/* Roda os steps em até `jobs` slots, cada um assim que seus needs terminam
+ * com sucesso; a primeira falha cancela os que estão rodando (fail-fast).
+ * Steps com inputs: usam o cache em `cache_dir` (NULL desliga).
+ * Retorna 0 se todos passaram, 1 caso contrário. */
+int executor_run_pipeline(const ci_pipeline_t *pipeline, const char *workspace_path, int jobs,
+                          const char *cache_dir);
+
+/* Cache de resultados (cache.c). Roda no processo do step, já no workspace:
+ * calcula a chave (comando, ambiente, outputs e conteúdo dos inputs); num hit
+ * restaura os outputs e devolve o exit code guardado, senão executa `argv`
+ * e guarda o resultado se passou. */
+int cache_run_step(const ci_step_t *step, const char *cache_dir, char *const argv[]);
+/* <repo_root>/.clurg/ci/cache em caminho absoluto; -1 com CLURG_CI_CACHE=0 */
+int cache_dir_path(const char *repo_root, char *out, size_t size);
+
+/* CLURG_CI_JOBS ou o número de CPUs */
+int executor_default_jobs(void);
+
+/* Matrix (matrix.c): uma instância do pipeline por combinação de valores,
+ * cada uma num processo com as variáveis da célula no ambiente, workspace e
+ * logs próprios. As células dividem os `jobs` slots entre si; todas rodam
+ * até o fim e o resumo sai no final. Retorna 0 se todas passaram. */
+size_t matrix_cell_count(const ci_pipeline_t *pipeline);
+int matrix_run(const ci_pipeline_t *pipeline, const char *repo_root, const char *log_dir, int jobs);
 
 /* High-level API for library usage */
+/* `repo_root` NULL: a raiz é procurada a partir do diretório atual */
 int ci_run_pipeline(const char *pipeline_file, const char *repo_root);
+/* Primeiro diretório com .clurg subindo a partir do cwd (ou o próprio cwd);
+ * buffer estático */
+char *ci_find_clurg_root(void);
+/* Uma instância de um pipeline já parseado: logger em `log_dir`, workspace
+ * (pool `workspace_name` no modo warm) e executor. Retorna 0 se passou */
+int ci_run_instance(const ci_pipeline_t *pipeline, const char *repo_root, const char *log_dir,
+                    const char *workspace_name, int jobs);
 
 #endif /* CI_H */
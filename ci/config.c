@@ -1,176 +1,726 @@
-#include <ctype.h>
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "ci.h"
 
-static void skip_whitespace(FILE *f) {
-  int c;
-  while ((c = fgetc(f)) != EOF && isspace(c)) {
-    /* skip todos os espaços, incluindo newlines */
+/*
+ * Parser do DSL de pipeline: um tokenizador sobre o arquivo mapeado com mmap.
+ * Steps, listas e strings saem de uma arena por pipeline, sem limites fixos
+ * de quantidade ou tamanho; o mapeamento só existe durante o parse.
+ *
+ *   # comentário até o fim da linha (fora de strings)
+ *   pipeline "nome"
+ *   matrix { CC: ["gcc", "clang"]  CFLAGS: ["-O0", "-O2"] }   (opcional)
+ *   step "nome" { run: "..."  needs: [...]  inputs: [...]  outputs: [...] }
+ */
+
+/* Produto dos eixos da matrix; acima disso é quase certamente engano */
+#define MATRIX_MAX_CELLS 256
+
+#define ARENA_BLOCK (64 * 1024)
+#define ARENA_ALIGN 16
+
+typedef struct arena_block {
+  struct arena_block *next;
+  size_t used;
+  size_t size;
+  char data[];
+} arena_block_t;
+
+struct ci_arena {
+  arena_block_t *head;
+  void *last; /* última alocação: arena_grow() a estende no lugar */
+  /* O vetor de steps cresce com realloc (mremap nos grandes, sem cópia) e
+   * é liberado junto com a arena */
+  ci_step_t *steps;
+};
+
+static void *arena_alloc(ci_arena_t *arena, size_t size) {
+  arena_block_t *block = arena->head;
+  size_t aligned = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+
+  if (!block || block->size - block->used < aligned) {
+    size_t block_size = aligned > ARENA_BLOCK ? aligned : ARENA_BLOCK;
+
+    block = malloc(sizeof(*block) + block_size);
+    if (!block) {
+      return NULL;
+    }
+    block->next = arena->head;
+    block->used = 0;
+    block->size = block_size;
+    arena->head = block;
   }
-  if (c != EOF) {
-    ungetc(c, f);
+
+  arena->last = block->data + block->used;
+  block->used += aligned;
+  return arena->last;
+}
+
+/* Realoca `ptr` (a alocação de `old_size` bytes); listas e o vetor de steps
+ * crescem dobrando, quase sempre no lugar */
+static void *arena_grow(ci_arena_t *arena, void *ptr, size_t old_size, size_t new_size) {
+  arena_block_t *block = arena->head;
+  void *p;
+
+  if (ptr && ptr == arena->last) {
+    size_t offset = (char *)ptr - block->data;
+    size_t aligned = (new_size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+
+    if (block->size - offset >= aligned) {
+      block->used = offset + aligned;
+      return ptr;
+    }
   }
+
+  p = arena_alloc(arena, new_size);
+  if (p && ptr) {
+    memcpy(p, ptr, old_size);
+  }
+  return p;
 }
 
-static int read_word(FILE *f, const char *word) {
-  const char *p = word;
+static void arena_free(ci_arena_t *arena) {
+  arena_block_t *block, *next;
+
+  if (!arena) {
+    return;
+  }
+  for (block = arena->head; block; block = next) {
+    next = block->next;
+    free(block);
+  }
+  free(arena->steps);
+  free(arena);
+}
+
+typedef struct {
+  const char *p;
+  const char *end;
+  const char *file;
+  int line;
+  ci_arena_t *arena;
+} parser_t;
+
+static int parse_error(const parser_t *ps, int line, const char *fmt, ...) {
+  va_list ap;
+
+  fprintf(stderr, "%s:%d: ", ps->file, line);
+  va_start(ap, fmt);
+  vfprintf(stderr, fmt, ap);
+  va_end(ap);
+  fputc('\n', stderr);
+  return -1;
+}
+
+/* Classes de caractere do tokenizador */
+enum { CH_SPACE = 1, CH_NEWLINE = 2, CH_COMMENT = 4, CH_WORD = 8 };
+
+static unsigned char char_class[256];
+
+static pthread_once_t char_class_once = PTHREAD_ONCE_INIT;
+
+static void init_char_class(void) {
   int c;
 
-  while (*p) {
-    c = fgetc(f);
-    if (c != *p) {
-      /* Restaurar caracteres lidos */
-      ungetc(c, f);
-      while (p > word) {
-        ungetc(*--p, f);
-      }
-      return -1;
+  for (c = 'a'; c <= 'z'; c++) {
+    char_class[c] = CH_WORD;
+    char_class[c - 'a' + 'A'] = CH_WORD;
+  }
+  for (c = '0'; c <= '9'; c++) {
+    char_class[c] = CH_WORD;
+  }
+  char_class['_'] = char_class['-'] = CH_WORD;
+  char_class[' '] = char_class['\t'] = char_class['\r'] = CH_SPACE;
+  char_class['\f'] = char_class['\v'] = CH_SPACE;
+  char_class['\n'] = CH_NEWLINE;
+  char_class['#'] = CH_COMMENT;
+}
+
+/* Espaços, quebras de linha e comentários. Os laços usam cópias locais de
+ * p e line: o compilador não precisa recarregá-las a cada byte */
+static void skip_space(parser_t *ps) {
+  const char *p = ps->p;
+  const char *end = ps->end;
+  int line = ps->line;
+
+  while (p < end) {
+    unsigned char cls = char_class[(unsigned char)*p];
+
+    if (cls & CH_SPACE) {
+      p++;
+    } else if (cls & CH_NEWLINE) {
+      line++;
+      p++;
+    } else if (cls & CH_COMMENT) {
+      const char *nl = memchr(p, '\n', end - p);
+      p = nl ? nl : end;
+    } else {
+      break;
     }
+  }
+
+  ps->p = p;
+  ps->line = line;
+}
+
+static int at(const parser_t *ps, char c) {
+  return ps->p < ps->end && *ps->p == c;
+}
+
+/* Palavra (pipeline, step, run...); `len` = 0 se não há uma na posição */
+static const char *read_word(parser_t *ps, size_t *len) {
+  const char *start = ps->p;
+  const char *p = start;
+
+  while (p < ps->end && (char_class[(unsigned char)*p] & CH_WORD)) {
     p++;
   }
+  ps->p = p;
+  *len = p - start;
+  return start;
+}
 
-  return 0;
+static int word_is(const char *word, size_t len, const char *expected) {
+  return strlen(expected) == len && memcmp(word, expected, len) == 0;
 }
 
-static int read_quoted_string(FILE *f, char *buf, size_t buf_size) {
-  int c = fgetc(f);
-  if (c != '"') {
-    return -1;
+/* String entre aspas, copiada para a arena (pode ter quebras de linha) */
+static int read_string(parser_t *ps, const char *what, const char **out) {
+  const char *start, *close, *nl;
+  char *s;
+  int line = ps->line;
+
+  if (!at(ps, '"')) {
+    return parse_error(ps, line, "esperado %s entre aspas", what);
+  }
+  start = ps->p + 1;
+  close = memchr(start, '"', ps->end - start);
+  if (!close) {
+    return parse_error(ps, line, "%s: string não fechada", what);
   }
 
-  size_t i = 0;
-  while ((c = fgetc(f)) != EOF && c != '"' && i < buf_size - 1) {
-    buf[i++] = c;
+  for (nl = start; (nl = memchr(nl, '\n', close - nl)) != NULL; nl++) {
+    ps->line++;
   }
-  buf[i] = '\0';
 
-  if (c != '"') {
-    return -1; /* String não fechada */
+  s = arena_alloc(ps->arena, close - start + 1);
+  if (!s) {
+    return parse_error(ps, line, "sem memória");
   }
+  memcpy(s, start, close - start);
+  s[close - start] = '\0';
 
+  *out = s;
+  ps->p = close + 1;
   return 0;
 }
 
-static int parse_step(FILE *f, ci_step_t *step) {
-  int c;
+/* Lista de strings: "a", "b"  ou  ["a", "b"]  ou  [] */
+static int parse_string_list(parser_t *ps, const char *key, const char ***items,
+                             size_t *count) {
+  size_t cap = 0;
+  int bracket = 0;
+
+  *items = NULL;
+  *count = 0;
+
+  skip_space(ps);
+  if (at(ps, '[')) {
+    ps->p++;
+    bracket = 1;
+    skip_space(ps);
+    if (at(ps, ']')) {
+      ps->p++;
+      return 0;
+    }
+  }
 
-  skip_whitespace(f);
+  while (1) {
+    if (*count == cap) {
+      size_t new_cap = cap ? cap * 2 : 4;
+      const char **grown =
+          arena_grow(ps->arena, (void *)*items, cap * sizeof(**items), new_cap * sizeof(**items));
 
-  /* Ler "step" */
-  if (read_word(f, "step") != 0) {
-    return -1;
+      if (!grown) {
+        return parse_error(ps, ps->line, "sem memória");
+      }
+      *items = grown;
+      cap = new_cap;
+    }
+    if (read_string(ps, key, &(*items)[*count]) != 0) {
+      return -1;
+    }
+    (*count)++;
+
+    skip_space(ps);
+    if (at(ps, ',')) {
+      ps->p++;
+      skip_space(ps);
+      continue;
+    }
+    if (bracket) {
+      if (!at(ps, ']')) {
+        return parse_error(ps, ps->line, "%s: esperado ',' ou ']'", key);
+      }
+      ps->p++;
+    }
+    return 0;
   }
+}
 
-  skip_whitespace(f);
+static int parse_step(parser_t *ps, ci_step_t *step) {
+  const char *word;
+  size_t len;
 
-  /* Ler nome do step entre aspas */
-  if (read_quoted_string(f, step->name, MAX_STEP_NAME) != 0) {
-    return -1;
-  }
+  memset(step, 0, sizeof(*step));
+  step->line = ps->line;
 
-  skip_whitespace(f);
+  word = read_word(ps, &len);
+  if (!word_is(word, len, "step")) {
+    return parse_error(ps, ps->line, "esperado 'step'");
+  }
 
-  /* Ler "{" */
-  c = fgetc(f);
-  if (c != '{') {
+  skip_space(ps);
+  if (read_string(ps, "nome do step", &step->name) != 0) {
     return -1;
   }
 
-  skip_whitespace(f);
+  skip_space(ps);
+  if (!at(ps, '{')) {
+    return parse_error(ps, ps->line, "step '%s': esperado '{'", step->name);
+  }
+  ps->p++;
 
-  /* Ler "run:" */
-  if (read_word(f, "run:") != 0) {
-    return -1;
+  /* Campos em qualquer ordem: "run:" (obrigatório), "needs:", "inputs:" e "outputs:" */
+  while (1) {
+    int line;
+
+    skip_space(ps);
+    if (ps->p >= ps->end) {
+      return parse_error(ps, step->line, "step '%s': '}' não encontrado", step->name);
+    }
+    if (at(ps, '}')) {
+      ps->p++;
+      break;
+    }
+
+    line = ps->line;
+    word = read_word(ps, &len);
+    skip_space(ps);
+    if (len == 0 || !at(ps, ':')) {
+      return parse_error(ps, line, "step '%s': esperado 'chave:'", step->name);
+    }
+    ps->p++;
+    skip_space(ps);
+
+    if (word_is(word, len, "run")) {
+      if (read_string(ps, "run", &step->command) != 0) {
+        return -1;
+      }
+    } else if (word_is(word, len, "needs")) {
+      step->needs_declared = 1;
+      if (parse_string_list(ps, "needs", &step->needs, &step->need_count) != 0) {
+        return -1;
+      }
+    } else if (word_is(word, len, "inputs")) {
+      if (parse_string_list(ps, "inputs", &step->inputs, &step->input_count) != 0) {
+        return -1;
+      }
+    } else if (word_is(word, len, "outputs")) {
+      if (parse_string_list(ps, "outputs", &step->outputs, &step->output_count) != 0) {
+        return -1;
+      }
+    } else {
+      return parse_error(ps, line, "step '%s': chave desconhecida '%.*s'", step->name, (int)len,
+                         word);
+    }
   }
 
-  skip_whitespace(f);
+  if (!step->command) {
+    return parse_error(ps, step->line, "step '%s' sem 'run:'", step->name);
+  }
+  return 0;
+}
 
-  /* Ler comando entre aspas */
-  if (read_quoted_string(f, step->command, MAX_COMMAND) != 0) {
-    return -1;
+/* matrix { VAR: ["a", "b"] ... }: cada chave vira variável de ambiente */
+static int parse_matrix(parser_t *ps, ci_pipeline_t *pipeline) {
+  size_t cap = 0;
+  size_t cells = 1;
+  int line = ps->line;
+
+  if (pipeline->matrix_count > 0) {
+    return parse_error(ps, line, "'matrix' repetido");
+  }
+  skip_space(ps);
+  if (!at(ps, '{')) {
+    return parse_error(ps, ps->line, "matrix: esperado '{'");
   }
+  ps->p++;
+
+  while (1) {
+    ci_matrix_axis_t *axis;
+    const char *word;
+    size_t len, i;
+    int axis_line;
+    char *name;
+
+    skip_space(ps);
+    if (ps->p >= ps->end) {
+      return parse_error(ps, line, "matrix: '}' não encontrado");
+    }
+    if (at(ps, '}')) {
+      ps->p++;
+      break;
+    }
+
+    axis_line = ps->line;
+    word = read_word(ps, &len);
+    skip_space(ps);
+    if (len == 0 || !at(ps, ':')) {
+      return parse_error(ps, axis_line, "matrix: esperado 'VARIAVEL:'");
+    }
+    ps->p++;
+    if ((word[0] >= '0' && word[0] <= '9') || memchr(word, '-', len)) {
+      return parse_error(ps, axis_line, "matrix: '%.*s' não é nome de variável de ambiente",
+                         (int)len, word);
+    }
+    for (i = 0; i < pipeline->matrix_count; i++) {
+      if (word_is(word, len, pipeline->matrix[i].name)) {
+        return parse_error(ps, axis_line, "matrix: '%.*s' repetido", (int)len, word);
+      }
+    }
 
-  skip_whitespace(f);
+    if (pipeline->matrix_count == cap) {
+      size_t new_cap = cap ? cap * 2 : 4;
+      ci_matrix_axis_t *grown = arena_grow(ps->arena, pipeline->matrix,
+                                           cap * sizeof(*grown), new_cap * sizeof(*grown));
 
-  /* Ler "}" */
-  c = fgetc(f);
-  if (c != '}') {
-    return -1;
+      if (!grown) {
+        return parse_error(ps, axis_line, "sem memória");
+      }
+      pipeline->matrix = grown;
+      cap = new_cap;
+    }
+    name = arena_alloc(ps->arena, len + 1);
+    if (!name) {
+      return parse_error(ps, axis_line, "sem memória");
+    }
+    memcpy(name, word, len);
+    name[len] = '\0';
+
+    axis = &pipeline->matrix[pipeline->matrix_count];
+    axis->name = name;
+    axis->line = axis_line;
+    if (parse_string_list(ps, name, &axis->values, &axis->value_count) != 0) {
+      return -1;
+    }
+    if (axis->value_count == 0) {
+      return parse_error(ps, axis_line, "matrix: '%s' sem valores", name);
+    }
+    pipeline->matrix_count++;
+
+    cells *= axis->value_count;
+    if (cells > MATRIX_MAX_CELLS) {
+      return parse_error(ps, axis_line, "matrix: mais de %d combinações", MATRIX_MAX_CELLS);
+    }
   }
 
+  if (pipeline->matrix_count == 0) {
+    return parse_error(ps, line, "matrix vazia");
+  }
   return 0;
 }
 
-int config_parse(const char *config_file, ci_pipeline_t *pipeline) {
-  FILE *f;
-  int c;
+static uint32_t hash_name(const char *s) {
+  uint32_t h = 2166136261u; /* FNV-1a */
 
-  /* Inicializar pipeline */
-  memset(pipeline, 0, sizeof(ci_pipeline_t));
-  pipeline->step_count = 0;
+  while (*s) {
+    h = (h ^ (unsigned char)*s++) * 16777619u;
+  }
+  /* Nomes gerados ("shard-1", "shard-2"...) só diferem no fim: misturar os
+   * bits altos nos baixos antes de usar a máscara da tabela */
+  h ^= h >> 16;
+  h *= 0x85ebca6bu;
+  h ^= h >> 13;
+  return h;
+}
 
-  f = fopen(config_file, "r");
-  if (!f) {
-    perror("fopen config_file");
-    return -1;
+/* Converte needs em índices e rejeita nomes repetidos ou desconhecidos e
+ * ciclos. Nomes numa tabela hash e dependentes em listas de adjacência:
+ * linear no número de steps e needs. */
+static int resolve_needs(parser_t *ps, ci_pipeline_t *pipeline) {
+  size_t n = pipeline->step_count;
+  size_t table_size = 16;
+  int *table = NULL;
+  int *pending = NULL, *queue = NULL, *first = NULL, *dependents = NULL;
+  size_t edges = 0, done = 0, head = 0;
+  size_t i, j;
+  int ret = -1;
+
+  while (table_size < n * 2) {
+    table_size *= 2;
+  }
+  table = malloc(table_size * sizeof(*table));
+  pending = calloc(n ? n : 1, sizeof(*pending));
+  queue = malloc((n ? n : 1) * sizeof(*queue));
+  first = calloc(n + 1, sizeof(*first));
+  if (!table || !pending || !queue || !first) {
+    parse_error(ps, ps->line, "sem memória");
+    goto out;
   }
+  memset(table, -1, table_size * sizeof(*table));
 
-  skip_whitespace(f);
+  for (i = 0; i < n; i++) {
+    const ci_step_t *step = &pipeline->steps[i];
+    size_t slot = hash_name(step->name) & (table_size - 1);
 
-  /* Ler "pipeline" */
-  if (read_word(f, "pipeline") != 0) {
-    fprintf(stderr, "esperado 'pipeline' no início do arquivo\n");
-    fclose(f);
-    return -1;
+    while (table[slot] >= 0) {
+      if (strcmp(pipeline->steps[table[slot]].name, step->name) == 0) {
+        parse_error(ps, step->line, "step '%s' repetido (primeiro na linha %d)", step->name,
+                    pipeline->steps[table[slot]].line);
+        goto out;
+      }
+      slot = (slot + 1) & (table_size - 1);
+    }
+    table[slot] = (int)i;
   }
 
-  skip_whitespace(f);
+  for (i = 0; i < n; i++) {
+    ci_step_t *step = &pipeline->steps[i];
 
-  /* Ler nome do pipeline entre aspas */
-  if (read_quoted_string(f, pipeline->name, MAX_PIPELINE_NAME) != 0) {
-    fprintf(stderr, "erro ao ler nome do pipeline\n");
-    fclose(f);
-    return -1;
+    step->dep_count = 0;
+    step->deps = arena_alloc(pipeline->arena, (step->need_count ? step->need_count : 1) *
+                                                  sizeof(*step->deps));
+    if (!step->deps) {
+      parse_error(ps, step->line, "sem memória");
+      goto out;
+    }
+    if (!step->needs_declared) {
+      if (i > 0) {
+        step->deps[step->dep_count++] = (int)i - 1;
+      }
+    }
+
+    for (j = 0; j < step->need_count; j++) {
+      size_t slot = hash_name(step->needs[j]) & (table_size - 1);
+      int dep = -1;
+
+      while (table[slot] >= 0) {
+        if (strcmp(pipeline->steps[table[slot]].name, step->needs[j]) == 0) {
+          dep = table[slot];
+          break;
+        }
+        slot = (slot + 1) & (table_size - 1);
+      }
+      if (dep < 0) {
+        parse_error(ps, step->line, "step '%s': needs desconhecido '%s'", step->name,
+                    step->needs[j]);
+        goto out;
+      }
+      if (dep == (int)i) {
+        parse_error(ps, step->line, "step '%s' depende de si mesmo", step->name);
+        goto out;
+      }
+      step->deps[step->dep_count++] = dep;
+    }
+
+    pending[i] = (int)step->dep_count;
+    edges += step->dep_count;
   }
 
-  /* Ler steps até o final do arquivo */
-  skip_whitespace(f);
+  /* Dependentes de cada step, agrupados: first[d]..first[d+1] */
+  dependents = malloc((edges ? edges : 1) * sizeof(*dependents));
+  if (!dependents) {
+    parse_error(ps, ps->line, "sem memória");
+    goto out;
+  }
+  for (i = 0; i < n; i++) {
+    for (j = 0; j < pipeline->steps[i].dep_count; j++) {
+      first[pipeline->steps[i].deps[j] + 1]++;
+    }
+  }
+  for (i = 0; i < n; i++) {
+    first[i + 1] += first[i];
+  }
+  for (i = 0; i < n; i++) {
+    for (j = 0; j < pipeline->steps[i].dep_count; j++) {
+      dependents[first[pipeline->steps[i].deps[j]]++] = (int)i;
+    }
+  }
+  for (i = n; i > 0; i--) {
+    first[i] = first[i - 1];
+  }
+  first[0] = 0;
 
-  while (pipeline->step_count < MAX_STEPS) {
-    /* Verificar se há mais conteúdo */
-    c = fgetc(f);
-    if (c == EOF) {
-      break;
+  /* Kahn: se nem todos os steps saem da fila, há ciclo */
+  for (i = 0; i < n; i++) {
+    if (pending[i] == 0) {
+      queue[done++] = (int)i;
+    }
+  }
+  while (head < done) {
+    int cur = queue[head++];
+    for (j = first[cur]; j < (size_t)first[cur + 1]; j++) {
+      if (--pending[dependents[j]] == 0) {
+        queue[done++] = dependents[j];
+      }
+    }
+  }
+  if (done != n) {
+    for (i = 0; i < n; i++) {
+      if (pending[i] > 0) {
+        parse_error(ps, pipeline->steps[i].line, "ciclo de needs envolvendo o step '%s'",
+                    pipeline->steps[i].name);
+        break;
+      }
     }
-    ungetc(c, f);
+    goto out;
+  }
 
-    skip_whitespace(f);
+  ret = 0;
 
-    /* Verificar novamente se chegou ao fim */
-    c = fgetc(f);
-    if (c == EOF) {
+out:
+  free(table);
+  free(pending);
+  free(queue);
+  free(first);
+  free(dependents);
+  return ret;
+}
+
+static int parse_pipeline(parser_t *ps, ci_pipeline_t *pipeline) {
+  size_t cap = 0;
+  const char *word;
+  size_t len;
+
+  skip_space(ps);
+  word = read_word(ps, &len);
+  if (!word_is(word, len, "pipeline")) {
+    return parse_error(ps, ps->line, "esperado 'pipeline' no início do arquivo");
+  }
+  skip_space(ps);
+  if (read_string(ps, "nome do pipeline", &pipeline->name) != 0) {
+    return -1;
+  }
+
+  while (1) {
+    skip_space(ps);
+    if (ps->p >= ps->end) {
       break;
     }
-    ungetc(c, f);
 
-    /* Tentar ler um step */
-    if (parse_step(f, &pipeline->steps[pipeline->step_count]) == 0) {
-      pipeline->step_count++;
-    } else {
-      /* Erro ao parsear ou fim do arquivo */
-      break;
+    if (ps->end - ps->p > 6 && memcmp(ps->p, "matrix", 6) == 0 &&
+        !(char_class[(unsigned char)ps->p[6]] & CH_WORD)) {
+      ps->p += 6;
+      if (parse_matrix(ps, pipeline) != 0) {
+        return -1;
+      }
+      continue;
+    }
+
+    if (pipeline->step_count == cap) {
+      size_t new_cap = cap ? cap * 2 : 16;
+      ci_step_t *grown = realloc(pipeline->arena->steps, new_cap * sizeof(ci_step_t));
+
+      if (!grown) {
+        return parse_error(ps, ps->line, "sem memória");
+      }
+      pipeline->steps = pipeline->arena->steps = grown;
+      cap = new_cap;
+    }
+    if (parse_step(ps, &pipeline->steps[pipeline->step_count]) != 0) {
+      return -1;
     }
+    pipeline->step_count++;
   }
 
-  fclose(f);
-  return 0;
+  return resolve_needs(ps, pipeline);
+}
+
+int config_parse(const char *config_file, ci_pipeline_t *pipeline) {
+  parser_t ps;
+  struct stat st;
+  void *map = MAP_FAILED;
+  char *buf = NULL;
+  size_t size = 0;
+  int fd;
+  int ret;
+
+  memset(pipeline, 0, sizeof(ci_pipeline_t));
+  pthread_once(&char_class_once, init_char_class);
+
+  fd = open(config_file, O_RDONLY | O_CLOEXEC);
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    perror("open config_file");
+    if (fd >= 0) {
+      close(fd);
+    }
+    return -1;
+  }
+
+  if (S_ISREG(st.st_mode) && st.st_size > 0) {
+    size = (size_t)st.st_size;
+    map = mmap(NULL, size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+  }
+  if (map == MAP_FAILED) {
+    /* Pipe, /dev/stdin ou arquivo vazio: ler tudo */
+    size_t cap = 0;
+    ssize_t n;
+
+    size = 0;
+    do {
+      if (size == cap) {
+        char *grown = realloc(buf, cap = cap ? cap * 2 : 4096);
+        if (!grown) {
+          free(buf);
+          close(fd);
+          return -1;
+        }
+        buf = grown;
+      }
+      n = read(fd, buf + size, cap - size);
+      if (n > 0) {
+        size += (size_t)n;
+      }
+    } while (n > 0 || (n < 0 && errno == EINTR));
+  }
+  close(fd);
+
+  pipeline->arena = calloc(1, sizeof(ci_arena_t));
+  if (!pipeline->arena) {
+    ret = -1;
+  } else {
+    ps.p = map != MAP_FAILED ? map : buf;
+    ps.end = ps.p + size;
+    ps.file = config_file;
+    ps.line = 1;
+    ps.arena = pipeline->arena;
+    ret = parse_pipeline(&ps, pipeline);
+  }
+
+  if (map != MAP_FAILED) {
+    munmap(map, size);
+  }
+  free(buf);
+
+  if (ret != 0) {
+    config_free(pipeline);
+  }
+  return ret;
 }
 
 void config_free(ci_pipeline_t *pipeline) {
-  /* Por enquanto não há memória alocada dinamicamente */
-  /* Esta função existe para manter a interface consistente */
-  (void)pipeline;
+  arena_free(pipeline->arena);
+  memset(pipeline, 0, sizeof(*pipeline));
 }
@@ -0,0 +1,290 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ci.h"
+
+/*
+ * Log de eventos em JSONL. O executor (único produtor) preenche um slot do
+ * ring e publica o índice `head`; a thread de escrita (único consumidor) lê
+ * de `tail` até `head`, formata tudo num lote e faz um fflush por lote. Sem
+ * lock: cada índice só é escrito por um lado.
+ *
+ * A thread dorme num eventfd. Para não pagar uma syscall por evento, o
+ * produtor só escreve no eventfd quando ela avisou que vai dormir
+ * (`sleeping`); os dois lados publicam antes de conferir o outro (seq_cst),
+ * então o aviso não se perde.
+ */
+
+#define EVENTS_RING 1024 /* potência de 2 */
+#define EVENTS_NAME 128
+#define EVENTS_BUFFER 65536
+
+typedef enum {
+  EVENT_PIPELINE_START,
+  EVENT_STEP_START,
+  EVENT_STEP_END,
+  EVENT_PIPELINE_END,
+} event_type_t;
+
+typedef struct {
+  event_type_t type;
+  uint64_t t_ns;
+  char name[EVENTS_NAME]; /* pipeline ou step, truncado */
+  size_t index;
+  long long value; /* step_count, pid ou exit_code, conforme o tipo */
+  int jobs;
+  const char *outcome; /* literal */
+  int has_stats;
+  ci_step_stats_t stats;
+  uint64_t unix_ns;  /* pipeline_start: relógio de parede, para ancorar t_ns */
+  double critical_s; /* pipeline_end */
+} event_t;
+
+static event_t ring[EVENTS_RING];
+static _Atomic size_t head;
+static _Atomic size_t tail;
+static _Atomic int sleeping;
+static _Atomic int stopping;
+static int wake_fd = -1;
+static FILE *events_file;
+static pthread_t writer;
+static int active;
+static uint64_t pipeline_t0;
+
+static uint64_t clock_ns(clockid_t clock) {
+  struct timespec ts;
+
+  clock_gettime(clock, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void wake_writer(void) {
+  uint64_t one = 1;
+
+  if (write(wake_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+    perror("eventfd");
+  }
+}
+
+static void write_event(FILE *f, const event_t *ev) {
+  static const char *names[] = {"pipeline_start", "step_start", "step_end", "pipeline_end"};
+
+  fprintf(f, "{\"t_ns\": %llu, \"event\": \"%s\"", (unsigned long long)ev->t_ns, names[ev->type]);
+  switch (ev->type) {
+  case EVENT_PIPELINE_START:
+    fprintf(f, ", \"pipeline\": ");
+    logger_json_string(f, ev->name);
+    fprintf(f, ", \"steps\": %lld, \"jobs\": %d, \"unix_ns\": %llu", ev->value, ev->jobs,
+            (unsigned long long)ev->unix_ns);
+    break;
+  case EVENT_STEP_START:
+    fprintf(f, ", \"step\": ");
+    logger_json_string(f, ev->name);
+    fprintf(f, ", \"index\": %zu, \"pid\": %lld", ev->index, ev->value);
+    break;
+  case EVENT_STEP_END:
+    fprintf(f, ", \"step\": ");
+    logger_json_string(f, ev->name);
+    fprintf(f, ", \"index\": %zu, \"status\": \"%s\", \"exit_code\": %lld", ev->index, ev->outcome,
+            ev->value);
+    if (ev->has_stats) {
+      fprintf(f, ", \"duration_ns\": %llu",
+              (unsigned long long)(ev->stats.wall_s * 1e9 + 0.5));
+      logger_json_stats(f, &ev->stats);
+    }
+    break;
+  case EVENT_PIPELINE_END:
+    fprintf(f, ", \"status\": \"%s\", \"duration_ns\": %llu, \"critical_path_ns\": %llu",
+            ev->outcome, (unsigned long long)(ev->t_ns - pipeline_t0),
+            (unsigned long long)(ev->critical_s * 1e9 + 0.5));
+    break;
+  }
+  fputs("}\n", f);
+}
+
+static void *writer_main(void *arg) {
+  (void)arg;
+
+  for (;;) {
+    size_t end = atomic_load(&head);
+    size_t pos = atomic_load_explicit(&tail, memory_order_relaxed);
+
+    if (pos != end) {
+      /* Lote: tudo o que já foi publicado, num único fflush */
+      for (; pos != end; pos++) {
+        write_event(events_file, &ring[pos & (EVENTS_RING - 1)]);
+      }
+      atomic_store_explicit(&tail, pos, memory_order_release);
+      fflush(events_file);
+      continue;
+    }
+
+    if (atomic_load(&stopping)) {
+      break;
+    }
+
+    atomic_store(&sleeping, 1);
+    if (atomic_load(&head) == pos && !atomic_load(&stopping)) {
+      struct pollfd pfd = {.fd = wake_fd, .events = POLLIN};
+      uint64_t count;
+
+      if (poll(&pfd, 1, -1) > 0 && read(wake_fd, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+        perror("eventfd");
+      }
+    }
+    atomic_store(&sleeping, 0);
+  }
+  return NULL;
+}
+
+int events_open(const char *path) {
+  int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+
+  if (fd < 0) {
+    perror("open eventos");
+    return -1;
+  }
+  events_file = fdopen(fd, "w");
+  wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (!events_file || wake_fd < 0) {
+    perror("eventos");
+    goto fail;
+  }
+  setvbuf(events_file, NULL, _IOFBF, EVENTS_BUFFER);
+
+  atomic_store(&head, 0);
+  atomic_store(&tail, 0);
+  atomic_store(&sleeping, 0);
+  atomic_store(&stopping, 0);
+  if (pthread_create(&writer, NULL, writer_main, NULL) != 0) {
+    fprintf(stderr, "aviso: sem thread para o log de eventos\n");
+    goto fail;
+  }
+  active = 1;
+  return 0;
+
+fail:
+  if (events_file) {
+    fclose(events_file);
+  } else {
+    close(fd);
+  }
+  events_file = NULL;
+  if (wake_fd >= 0) {
+    close(wake_fd);
+    wake_fd = -1;
+  }
+  return -1;
+}
+
+void events_close(void) {
+  if (!active) {
+    return;
+  }
+  atomic_store(&stopping, 1);
+  wake_writer();
+  pthread_join(writer, NULL);
+  active = 0;
+
+  if (fclose(events_file) != 0) {
+    perror("gravar eventos");
+  }
+  events_file = NULL;
+  close(wake_fd);
+  wake_fd = -1;
+}
+
+/* Slot livre para o próximo evento; NULL sem log de eventos */
+static event_t *event_begin(event_type_t type, const char *name) {
+  size_t pos;
+  event_t *ev;
+
+  if (!active) {
+    return NULL;
+  }
+  pos = atomic_load_explicit(&head, memory_order_relaxed);
+  /* Ring cheio: esperar a thread em vez de perder evento (só acontece se o
+   * disco travar por mais de EVENTS_RING eventos) */
+  while (pos - atomic_load_explicit(&tail, memory_order_acquire) == EVENTS_RING) {
+    wake_writer();
+    sched_yield();
+  }
+
+  ev = &ring[pos & (EVENTS_RING - 1)];
+  ev->type = type;
+  ev->t_ns = clock_ns(CLOCK_MONOTONIC);
+  snprintf(ev->name, sizeof(ev->name), "%s", name ? name : "");
+  ev->has_stats = 0;
+  return ev;
+}
+
+static void event_commit(void) {
+  atomic_fetch_add(&head, 1);
+  if (atomic_load(&sleeping)) {
+    wake_writer();
+  }
+}
+
+void events_pipeline_start(const char *pipeline, size_t step_count, int jobs) {
+  event_t *ev = event_begin(EVENT_PIPELINE_START, pipeline);
+
+  if (!ev) {
+    return;
+  }
+  ev->value = (long long)step_count;
+  ev->jobs = jobs;
+  ev->unix_ns = clock_ns(CLOCK_REALTIME);
+  pipeline_t0 = ev->t_ns;
+  event_commit();
+}
+
+void events_step_start(const char *step, size_t index, int pid) {
+  event_t *ev = event_begin(EVENT_STEP_START, step);
+
+  if (!ev) {
+    return;
+  }
+  ev->index = index;
+  ev->value = pid;
+  event_commit();
+}
+
+void events_step_end(const char *step, size_t index, const char *outcome, int exit_code,
+                     const ci_step_stats_t *stats) {
+  event_t *ev = event_begin(EVENT_STEP_END, step);
+
+  if (!ev) {
+    return;
+  }
+  ev->index = index;
+  ev->outcome = outcome;
+  ev->value = exit_code;
+  if (stats) {
+    ev->has_stats = 1;
+    ev->stats = *stats;
+  }
+  event_commit();
+}
+
+void events_pipeline_end(int failed, double critical_s) {
+  event_t *ev = event_begin(EVENT_PIPELINE_END, NULL);
+
+  if (!ev) {
+    return;
+  }
+  ev->outcome = failed ? "fail" : "ok";
+  ev->critical_s = critical_s;
+  event_commit();
+}
@@ -4,9 +4,15 @@
 #include <fcntl.h>
 #include <glob.h>
 #include <limits.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
@@ -131,13 +137,18 @@ static int expand_argv_wildcards(char **argv, int argc, int max_args, const char
   return new_argc;
 }
 
-int executor_run_step(const ci_step_t *step, const char *workspace_path) {
+/* Prepara argv e faz fork; o filho roda em `workspace_path`. Com
+ * `own_group`, o filho vira líder de um grupo de processos para que o
+ * cancelamento alcance também os processos que ele criar. Com `cache_dir`,
+ * steps que declaram inputs passam pelo cache de resultados; com `cgroup`,
+ * o filho entra nele antes de tudo. Com `out_fd` >= 0, stdout e stderr do
+ * filho vão para ele. */
+static pid_t spawn_step(const ci_step_t *step, const char *workspace_path, int own_group,
+                        const char *cache_dir, const char *cgroup, int out_fd) {
   pid_t pid;
-  int status;
   char *argv[256]; /* Aumentado para suportar expansão de wildcards */
   int argc;
   int i;
-  int exit_code;
   char cwd[PATH_MAX];
 
   /* Obter diretório atual se workspace_path for NULL */
@@ -155,34 +166,49 @@ int executor_run_step(const ci_step_t *step, const char *workspace_path) {
     return -1;
   }
 
-  /* Expandir wildcards nos argumentos (exceto no comando) */
-  argc = expand_argv_wildcards(argv, argc, 256, workspace_path);
-  if (argc < 0) {
-    fprintf(stderr, "erro ao expandir wildcards no step: %s\n", step->name);
-    /* Limpar argv parcial */
-    for (i = 0; argv[i] != NULL; i++) {
-      free(argv[i]);
-    }
-    return -1;
-  }
+  fflush(stdout);
+  fflush(stderr);
 
   pid = fork();
   if (pid < 0) {
     perror("fork");
-    /* Limpar argv */
-    for (i = 0; i < argc; i++) {
-      free(argv[i]);
+  } else if (pid == 0) {
+    /* Processo filho */
+    if (own_group) {
+      setpgid(0, 0);
+    }
+
+    if (out_fd >= 0) {
+      dup2(out_fd, STDOUT_FILENO);
+      dup2(out_fd, STDERR_FILENO);
+      close(out_fd);
+    }
+
+    /* Antes de entrar no namespace do workspace, que pode tirar o acesso ao
+     * cgroupfs */
+    cgroup_step_enter(cgroup);
+
+    /* Workspace overlay só é visível dentro do namespace dele */
+    if (workspace_enter(workspace_path) != 0) {
+      _exit(1);
     }
-    return -1;
-  }
 
-  if (pid == 0) {
-    /* Processo filho */
     /* Se workspace_path for fornecido, mudar para ele */
-    /* Por enquanto, NULL significa usar diretório atual */
     if (workspace_path && workspace_path[0] != '\0' && chdir(workspace_path) != 0) {
       perror("chdir workspace");
-      exit(1);
+      _exit(1);
+    }
+
+    /* Expandir wildcards nos argumentos (exceto no comando), já no workspace */
+    if (expand_argv_wildcards(argv, argc, 256, NULL) < 0) {
+      fprintf(stderr, "erro ao expandir wildcards no step: %s\n", step->name);
+      _exit(1);
+    }
+
+    if (cache_dir && step->input_count > 0) {
+      int code = cache_run_step(step, cache_dir, argv);
+      fflush(stdout);
+      _exit(code);
     }
 
     /* Executar comando */
@@ -190,31 +216,395 @@ int executor_run_step(const ci_step_t *step, const char *workspace_path) {
 
     /* Se chegou aqui, execvp falhou */
     perror("execvp");
-    exit(1);
-  } else {
-    /* Processo pai */
-    if (waitpid(pid, &status, 0) == -1) {
-      perror("waitpid");
-      /* Limpar argv */
-      for (i = 0; i < argc; i++) {
-        free(argv[i]);
+    _exit(1);
+  } else if (own_group) {
+    /* Também no pai: evita a corrida com um kill() antes do filho rodar */
+    setpgid(pid, pid);
+  }
+
+  /* Limpar argv */
+  for (i = 0; i < argc; i++) {
+    free(argv[i]);
+  }
+
+  return pid;
+}
+
+static int decode_status(const ci_step_t *step, int status) {
+  if (WIFEXITED(status)) {
+    return WEXITSTATUS(status);
+  } else if (WIFSIGNALED(status)) {
+    fprintf(stderr, "step '%s' terminado por sinal: %d\n", step->name, WTERMSIG(status));
+    return 128 + WTERMSIG(status); /* Convenção Unix */
+  }
+  return -1;
+}
+
+int executor_run_step(const ci_step_t *step, const char *workspace_path) {
+  pid_t pid;
+  int status;
+
+  pid = spawn_step(step, workspace_path, 0, NULL, NULL, -1);
+  if (pid < 0) {
+    return -1;
+  }
+
+  /* Processo pai */
+  if (waitpid(pid, &status, 0) == -1) {
+    perror("waitpid");
+    return -1;
+  }
+
+  return decode_status(step, status);
+}
+
+int executor_default_jobs(void) {
+  const char *env = getenv("CLURG_CI_JOBS");
+  long n;
+
+  if (env && *env) {
+    n = strtol(env, NULL, 10);
+    if (n > 0) {
+      return (int)n;
+    }
+  }
+
+  n = sysconf(_SC_NPROCESSORS_ONLN);
+  return n > 0 ? (int)n : 1;
+}
+
+enum { STEP_PENDING, STEP_RUNNING, STEP_OK, STEP_FAILED, STEP_CANCELED, STEP_SKIPPED };
+
+static double now_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void collect_stats(const struct rusage *usage, double wall_s, ci_step_stats_t *stats) {
+  memset(stats, 0, sizeof(*stats));
+  stats->wall_s = wall_s;
+  stats->user_s = usage->ru_utime.tv_sec + usage->ru_utime.tv_usec / 1e6;
+  stats->sys_s = usage->ru_stime.tv_sec + usage->ru_stime.tv_usec / 1e6;
+  stats->max_rss_kb = usage->ru_maxrss;
+  stats->in_blocks = usage->ru_inblock;
+  stats->out_blocks = usage->ru_oublock;
+  stats->voluntary_ctxsw = usage->ru_nvcsw;
+  stats->involuntary_ctxsw = usage->ru_nivcsw;
+}
+
+/* Próximo step pendente com todos os needs concluídos com sucesso, na ordem do arquivo */
+static int next_ready(const ci_pipeline_t *pipeline, const int *state) {
+  size_t i, j;
+
+  for (i = 0; i < pipeline->step_count; i++) {
+    const ci_step_t *step = &pipeline->steps[i];
+    int ready = state[i] == STEP_PENDING;
+
+    for (j = 0; ready && j < step->dep_count; j++) {
+      ready = state[step->deps[j]] == STEP_OK;
+    }
+    if (ready) {
+      return (int)i;
+    }
+  }
+  return -1;
+}
+
+/* pidfd do filho (Linux 5.3+): fica legível quando ele termina, então o
+ * mesmo epoll_wait espera saídas e fim de steps. -1 sem suporte */
+static int open_pidfd(pid_t pid) {
+#ifdef SYS_pidfd_open
+  return (int)syscall(SYS_pidfd_open, pid, 0);
+#else
+  (void)pid;
+  return -1;
+#endif
+}
+
+/* Dados do epoll: índice do step e se o evento é do pipe ou do pidfd */
+#define EVENT_PIPE 0
+#define EVENT_PIDFD 1
+
+/* Prazo entre o SIGTERM do fail-fast e o SIGKILL nos steps que o ignoram */
+#define CANCEL_GRACE_S 5.0
+
+/* Manda `sig` ao grupo de processos de cada step que ainda roda */
+static void signal_running(const ci_pipeline_t *pipeline, const int *state, const pid_t *pids,
+                           int sig) {
+  size_t i;
+
+  for (i = 0; i < pipeline->step_count; i++) {
+    if (state[i] == STEP_RUNNING) {
+      kill(-pids[i], sig);
+    }
+  }
+}
+
+int executor_run_pipeline(const ci_pipeline_t *pipeline, const char *workspace_path, int jobs,
+                          const char *cache_dir) {
+  size_t n = pipeline->step_count ? pipeline->step_count : 1;
+  int *state = malloc(n * sizeof(*state));
+  pid_t *pids = malloc(n * sizeof(*pids));
+  int *pidfds = malloc(n * sizeof(*pidfds));
+  ci_output_t **outputs = calloc(n, sizeof(*outputs));
+  double *started = malloc(n * sizeof(*started));
+  double *finish = malloc(n * sizeof(*finish)); /* fim no caminho crítico (soma das durações) */
+  double t0 = now_seconds();
+  double critical = 0.0;
+  double kill_at = 0.0; /* prazo do SIGKILL depois de uma falha; 0 = nenhum */
+  int running = 0;
+  int failed = 0;
+  int poll_children = 0; /* sem pidfd: wait4(WNOHANG) a cada volta */
+  int ep = epoll_create1(EPOLL_CLOEXEC);
+  size_t i, j;
+
+  if (!state || !pids || !pidfds || !outputs || !started || !finish || ep < 0) {
+    fprintf(stderr, "erro: sem memória para %zu steps\n", pipeline->step_count);
+    free(state);
+    free(pids);
+    free(pidfds);
+    free(outputs);
+    free(started);
+    free(finish);
+    if (ep >= 0) {
+      close(ep);
+    }
+    return 1;
+  }
+
+  if (jobs < 1) {
+    jobs = 1;
+  }
+
+  for (i = 0; i < pipeline->step_count; i++) {
+    state[i] = STEP_PENDING;
+    pids[i] = -1;
+    pidfds[i] = -1;
+    finish[i] = 0.0;
+  }
+
+  if (cgroup_pipeline_init() == 0) {
+    printf("Contabilidade por cgroup v2 ativa\n");
+  }
+  if (logger_run_dir()) {
+    printf("Saída dos steps em: %s/\n", logger_run_dir());
+  }
+  events_pipeline_start(pipeline->name, pipeline->step_count, jobs);
+
+  while (1) {
+    struct epoll_event events[32];
+    struct rusage usage;
+    char cgroup[PATH_MAX];
+    pid_t pid;
+    int status;
+    int nevents, e;
+    int timeout;
+    int idx = -1;
+
+    /* Ocupar os slots livres com steps prontos */
+    while (!failed && running < jobs) {
+      int next = next_ready(pipeline, state);
+      const ci_step_t *step;
+      struct epoll_event ev;
+      int out_fd = -1;
+
+      if (next < 0) {
+        break;
       }
-      return -1;
+
+      step = &pipeline->steps[next];
+      printf("Executando step: %s\n", step->name);
+      printf("  Comando: %s\n", step->command);
+      fflush(stdout);
+
+      outputs[next] = output_open(logger_run_dir(), step->name, &out_fd);
+      cgroup_step_create((size_t)next, cgroup, sizeof(cgroup));
+      pids[next] = spawn_step(step, workspace_path, 1, cache_dir, cgroup, out_fd);
+      if (out_fd >= 0) {
+        close(out_fd); /* só o filho escreve; o EOF chega quando ele fecha */
+      }
+      if (pids[next] < 0) {
+        state[next] = STEP_FAILED;
+        logger_log_step(step->name, 1, -1, NULL);
+        events_step_end(step->name, (size_t)next, "fail", -1, NULL);
+        output_close(outputs[next]);
+        outputs[next] = NULL;
+
+        /* Fail-fast também quando o step nem chega a rodar */
+        failed = 1;
+        signal_running(pipeline, state, pids, SIGTERM);
+        kill_at = now_seconds() + CANCEL_GRACE_S;
+        break;
+      }
+
+      if (outputs[next]) {
+        ev.events = EPOLLIN;
+        ev.data.u64 = (uint64_t)next << 1 | EVENT_PIPE;
+        epoll_ctl(ep, EPOLL_CTL_ADD, output_fd(outputs[next]), &ev);
+      }
+      pidfds[next] = open_pidfd(pids[next]);
+      if (pidfds[next] >= 0) {
+        ev.events = EPOLLIN;
+        ev.data.u64 = (uint64_t)next << 1 | EVENT_PIDFD;
+        epoll_ctl(ep, EPOLL_CTL_ADD, pidfds[next], &ev);
+      } else {
+        poll_children = 1;
+      }
+
+      state[next] = STEP_RUNNING;
+      started[next] = now_seconds();
+      events_step_start(step->name, (size_t)next, pids[next]);
+      running++;
     }
 
-    /* Limpar argv */
-    for (i = 0; i < argc; i++) {
-      free(argv[i]);
+    if (running == 0) {
+      break;
     }
 
-    if (WIFEXITED(status)) {
-      exit_code = WEXITSTATUS(status);
-      return exit_code;
-    } else if (WIFSIGNALED(status)) {
-      fprintf(stderr, "step '%s' terminado por sinal: %d\n", step->name, WTERMSIG(status));
-      return 128 + WTERMSIG(status); /* Convenção Unix */
-    } else {
-      return -1;
+    /* Saída de qualquer step e fim de step no mesmo laço: um step verboso
+     * só ocupa o tempo de copiar o que já escreveu */
+    timeout = poll_children ? 50 : -1;
+    if (kill_at > 0.0) {
+      double left = kill_at - now_seconds();
+      int left_ms = left > 0.0 ? (int)(left * 1000.0) + 1 : 0;
+
+      if (timeout < 0 || left_ms < timeout) {
+        timeout = left_ms;
+      }
+    }
+    nevents = epoll_wait(ep, events, 32, timeout);
+    if (nevents < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      perror("epoll_wait");
+      break;
+    }
+    if (kill_at > 0.0 && now_seconds() >= kill_at) {
+      /* Passou o prazo do SIGTERM: quem sobrou não pode segurar o pipeline */
+      signal_running(pipeline, state, pids, SIGKILL);
+      kill_at = 0.0;
+    }
+
+    pid = 0;
+    for (e = 0; e < nevents; e++) {
+      int k = (int)(events[e].data.u64 >> 1);
+
+      if ((events[e].data.u64 & 1) == EVENT_PIPE) {
+        if (outputs[k] && output_drain(outputs[k])) {
+          epoll_ctl(ep, EPOLL_CTL_DEL, output_fd(outputs[k]), NULL);
+        }
+      } else if (idx < 0 && wait4(pids[k], &status, WNOHANG, &usage) == pids[k]) {
+        /* Um fim de step por volta; os demais pidfds continuam legíveis */
+        idx = k;
+        pid = pids[k];
+      }
+    }
+    if (idx < 0 && poll_children) {
+      pid = wait4(-1, &status, WNOHANG, &usage);
+      for (i = 0; pid > 0 && i < pipeline->step_count; i++) {
+        if (state[i] == STEP_RUNNING && pids[i] == pid) {
+          idx = (int)i;
+          break;
+        }
+      }
+    }
+    if (idx < 0) {
+      continue; /* só saída, ou filho que não é nosso */
+    }
+    running--;
+
+    {
+      const ci_step_t *step = &pipeline->steps[idx];
+      double elapsed = now_seconds() - started[idx];
+      double base = 0.0;
+      ci_step_stats_t stats;
+      int exit_code;
+
+      /* O que sobrou no pipe; processos que o step largou em segundo plano
+       * e ainda escrevem nele não seguram o pipeline */
+      if (outputs[idx]) {
+        output_drain(outputs[idx]);
+        epoll_ctl(ep, EPOLL_CTL_DEL, output_fd(outputs[idx]), NULL);
+      }
+      if (pidfds[idx] >= 0) {
+        close(pidfds[idx]);
+        pidfds[idx] = -1;
+      }
+
+      collect_stats(&usage, elapsed, &stats);
+      cgroup_step_collect((size_t)idx, &stats);
+
+      for (j = 0; j < step->dep_count; j++) {
+        if (finish[step->deps[j]] > base) {
+          base = finish[step->deps[j]];
+        }
+      }
+      finish[idx] = base + elapsed;
+      if (finish[idx] > critical) {
+        critical = finish[idx];
+      }
+
+      if (failed) {
+        /* Cancelado pela falha de outro step */
+        state[idx] = STEP_CANCELED;
+        printf("Step cancelado: %s (%.2fs)\n", step->name, elapsed);
+        events_step_end(step->name, (size_t)idx, "canceled", -1, &stats);
+      } else if ((exit_code = decode_status(step, status)) == 0) {
+        state[idx] = STEP_OK;
+        logger_log_step(step->name, 0, 0, &stats);
+        events_step_end(step->name, (size_t)idx, "ok", 0, &stats);
+      } else {
+        state[idx] = STEP_FAILED;
+        logger_log_step(step->name, 1, exit_code, &stats);
+        events_step_end(step->name, (size_t)idx, "fail", exit_code, &stats);
+        if (outputs[idx]) {
+          output_print_tail(outputs[idx], stderr);
+        }
+
+        /* Fail-fast: derrubar os irmãos que ainda rodam */
+        failed = 1;
+        signal_running(pipeline, state, pids, SIGTERM);
+        kill_at = now_seconds() + CANCEL_GRACE_S;
+      }
+
+      output_close(outputs[idx]);
+      outputs[idx] = NULL;
+    }
+  }
+
+  for (i = 0; i < pipeline->step_count; i++) {
+    if (state[i] == STEP_PENDING) {
+      state[i] = STEP_SKIPPED;
+      events_step_end(pipeline->steps[i].name, i, "skipped", -1, NULL);
+      if (failed) {
+        printf("Step não executado: %s\n", pipeline->steps[i].name);
+      }
+    } else if (state[i] == STEP_RUNNING) {
+      /* epoll_wait falhou: não deixar processos órfãos */
+      kill(-pids[i], SIGKILL);
+      waitpid(pids[i], NULL, 0);
+      events_step_end(pipeline->steps[i].name, i, "canceled", -1, NULL);
+      output_close(outputs[i]);
+      if (pidfds[i] >= 0) {
+        close(pidfds[i]);
+      }
+      failed = 1;
     }
   }
+  cgroup_pipeline_cleanup();
+  close(ep);
+  events_pipeline_end(failed, critical);
+
+  printf("Tempo total: %.2fs (caminho crítico: %.2fs, %d slot%s)\n", now_seconds() - t0, critical,
+         jobs, jobs == 1 ? "" : "s");
+
+  free(state);
+  free(pids);
+  free(pidfds);
+  free(outputs);
+  free(started);
+  free(finish);
+  return failed ? 1 : 0;
 }
@@ -0,0 +1,530 @@
+#define _GNU_SOURCE
+#include "ignore.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define IGNORE_LINE_MAX 4096
+
+/* Glob compilado para um único componente (nunca casa '/') */
+typedef enum { TOK_LIT, TOK_ANY, TOK_STAR, TOK_CLASS } tok_kind_t;
+
+typedef struct {
+  tok_kind_t kind;
+  unsigned char c;
+  int negate;
+  uint8_t set[32]; /* bitmap de [...] */
+} glob_tok_t;
+
+typedef struct {
+  glob_tok_t *toks;
+  size_t count;
+  int double_star; /* componente "**" */
+} glob_t;
+
+typedef struct {
+  int negate;
+  int dir_only;
+  glob_t *comps; /* padrões ancorados: componentes restantes depois do trie */
+  size_t comp_count;
+  glob_t name; /* padrões de nome sem literal/sufixo */
+} rule_t;
+
+typedef struct {
+  char *name;
+  size_t rule;
+} literal_t;
+
+/* Trie de sufixos: filhos indexados pelo caractere, percorrido de trás para frente */
+typedef struct suffix_node {
+  unsigned char c;
+  struct suffix_node *children;
+  size_t child_count;
+  size_t *rules;
+  size_t rule_count;
+} suffix_node_t;
+
+/* Trie de componentes literais do início dos padrões ancorados */
+typedef struct path_node {
+  char *name;
+  struct path_node *children;
+  size_t child_count;
+  size_t *rules;
+  size_t rule_count;
+} path_node_t;
+
+struct ignore {
+  rule_t *rules;
+  size_t rule_count;
+  size_t rule_capacity;
+  literal_t *literals; /* ordenado por nome */
+  size_t literal_count;
+  size_t literal_capacity;
+  suffix_node_t suffix_root;
+  size_t *globs; /* regras de nome avaliadas uma a uma */
+  size_t glob_count;
+  path_node_t path_root;
+};
+
+static int push_index(size_t **list, size_t *count, size_t value) {
+  size_t *grown = realloc(*list, (*count + 1) * sizeof(**list));
+  if (!grown) return -1;
+  grown[(*count)++] = value;
+  *list = grown;
+  return 0;
+}
+
+/* ---- glob de um componente ---- */
+
+static int has_wildcard(const char *s, size_t len) {
+  size_t i;
+  for (i = 0; i < len; i++) {
+    if (s[i] == '*' || s[i] == '?' || s[i] == '[' || s[i] == '\\') return 1;
+  }
+  return 0;
+}
+
+static int glob_compile(glob_t *g, const char *s, size_t len) {
+  size_t i = 0;
+
+  memset(g, 0, sizeof(*g));
+  if (len == 2 && s[0] == '*' && s[1] == '*') {
+    g->double_star = 1;
+    return 0;
+  }
+  g->toks = calloc(len + 1, sizeof(*g->toks));
+  if (!g->toks) return -1;
+
+  while (i < len) {
+    glob_tok_t *t = &g->toks[g->count];
+
+    if (s[i] == '*') {
+      while (i < len && s[i] == '*') i++; /* "**" dentro do nome = "*" */
+      t->kind = TOK_STAR;
+    } else if (s[i] == '?') {
+      t->kind = TOK_ANY;
+      i++;
+    } else if (s[i] == '[' && memchr(s + i + 1, ']', len - i - 1)) {
+      size_t j = i + 1;
+      t->kind = TOK_CLASS;
+      if (j < len && (s[j] == '!' || s[j] == '^')) {
+        t->negate = 1;
+        j++;
+      }
+      /* "]" logo no começo é literal */
+      do {
+        unsigned char lo = (unsigned char)s[j];
+        unsigned char hi = lo;
+        unsigned int c;
+        if (j + 2 < len && s[j + 1] == '-' && s[j + 2] != ']') {
+          hi = (unsigned char)s[j + 2];
+          j += 2;
+        }
+        for (c = lo; c <= hi; c++) t->set[c >> 3] |= (uint8_t)(1u << (c & 7));
+        j++;
+      } while (j < len && s[j] != ']');
+      i = j + 1;
+    } else {
+      if (s[i] == '\\' && i + 1 < len) i++;
+      t->kind = TOK_LIT;
+      t->c = (unsigned char)s[i++];
+    }
+    g->count++;
+  }
+  return 0;
+}
+
+static int tok_matches(const glob_tok_t *t, unsigned char c) {
+  switch (t->kind) {
+    case TOK_LIT:
+      return t->c == c;
+    case TOK_ANY:
+      return 1;
+    case TOK_CLASS:
+      return ((t->set[c >> 3] >> (c & 7)) & 1) != t->negate;
+    default:
+      return 0;
+  }
+}
+
+/* Casamento linear com um único ponto de retrocesso por '*' (o '*' não cruza '/') */
+static int glob_match(const glob_t *g, const char *s) {
+  size_t ti = 0;
+  size_t star = (size_t)-1;
+  const char *star_s = NULL;
+
+  while (*s) {
+    if (ti < g->count && g->toks[ti].kind == TOK_STAR) {
+      star = ti++;
+      star_s = s;
+    } else if (ti < g->count && tok_matches(&g->toks[ti], (unsigned char)*s)) {
+      ti++;
+      s++;
+    } else if (star != (size_t)-1) {
+      ti = star + 1;
+      s = ++star_s;
+    } else {
+      return 0;
+    }
+  }
+  while (ti < g->count && g->toks[ti].kind == TOK_STAR) ti++;
+  return ti == g->count;
+}
+
+static void glob_free(glob_t *g) {
+  free(g->toks);
+  memset(g, 0, sizeof(*g));
+}
+
+/* ---- tries ---- */
+
+static suffix_node_t *suffix_child(suffix_node_t *node, unsigned char c, int create) {
+  size_t i;
+  suffix_node_t *grown;
+
+  for (i = 0; i < node->child_count; i++) {
+    if (node->children[i].c == c) return &node->children[i];
+  }
+  if (!create) return NULL;
+  grown = realloc(node->children, (node->child_count + 1) * sizeof(*grown));
+  if (!grown) return NULL;
+  node->children = grown;
+  memset(&grown[node->child_count], 0, sizeof(*grown));
+  grown[node->child_count].c = c;
+  return &grown[node->child_count++];
+}
+
+static void suffix_free(suffix_node_t *node) {
+  size_t i;
+  for (i = 0; i < node->child_count; i++) suffix_free(&node->children[i]);
+  free(node->children);
+  free(node->rules);
+}
+
+static path_node_t *path_child(path_node_t *node, const char *name, size_t len, int create) {
+  size_t i;
+  path_node_t *grown;
+
+  for (i = 0; i < node->child_count; i++) {
+    if (strlen(node->children[i].name) == len && memcmp(node->children[i].name, name, len) == 0) {
+      return &node->children[i];
+    }
+  }
+  if (!create) return NULL;
+  grown = realloc(node->children, (node->child_count + 1) * sizeof(*grown));
+  if (!grown) return NULL;
+  node->children = grown;
+  memset(&grown[node->child_count], 0, sizeof(*grown));
+  grown[node->child_count].name = strndup(name, len);
+  if (!grown[node->child_count].name) return NULL;
+  return &grown[node->child_count++];
+}
+
+static void path_free(path_node_t *node) {
+  size_t i;
+  for (i = 0; i < node->child_count; i++) path_free(&node->children[i]);
+  free(node->children);
+  free(node->rules);
+  free(node->name);
+}
+
+/* ---- compilação ---- */
+
+ignore_t *ignore_new(void) {
+  return calloc(1, sizeof(ignore_t));
+}
+
+ignore_t *ignore_load(const char *root) {
+  ignore_t *ig = ignore_new();
+  char path[IGNORE_LINE_MAX];
+  char line[IGNORE_LINE_MAX];
+  FILE *fp;
+
+  if (!ig) return NULL;
+  if (snprintf(path, sizeof(path), "%s/%s", root, IGNORE_FILE) >= (int)sizeof(path)) return ig;
+
+  fp = fopen(path, "r");
+  if (!fp) return ig;
+  while (fgets(line, sizeof(line), fp)) {
+    if (ignore_add(ig, line) != 0) {
+      fprintf(stderr, "aviso: %s: memória insuficiente, regras truncadas\n", path);
+      break;
+    }
+  }
+  fclose(fp);
+  return ig;
+}
+
+static rule_t *new_rule(ignore_t *ig) {
+  if (ig->rule_count == ig->rule_capacity) {
+    size_t capacity = ig->rule_capacity ? ig->rule_capacity * 2 : 32;
+    rule_t *grown = realloc(ig->rules, capacity * sizeof(*grown));
+    if (!grown) return NULL;
+    ig->rules = grown;
+    ig->rule_capacity = capacity;
+  }
+  memset(&ig->rules[ig->rule_count], 0, sizeof(rule_t));
+  return &ig->rules[ig->rule_count];
+}
+
+static int add_literal(ignore_t *ig, const char *name, size_t len, size_t rule) {
+  size_t lo = 0;
+  size_t hi = ig->literal_count;
+  char *copy = strndup(name, len);
+
+  if (!copy) return -1;
+  if (ig->literal_count == ig->literal_capacity) {
+    size_t capacity = ig->literal_capacity ? ig->literal_capacity * 2 : 32;
+    literal_t *grown = realloc(ig->literals, capacity * sizeof(*grown));
+    if (!grown) {
+      free(copy);
+      return -1;
+    }
+    ig->literals = grown;
+    ig->literal_capacity = capacity;
+  }
+  /* Inserção ordenada (estável: regras repetidas ficam na ordem do arquivo) */
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (strcmp(ig->literals[mid].name, copy) <= 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  memmove(&ig->literals[lo + 1], &ig->literals[lo], (ig->literal_count - lo) * sizeof(literal_t));
+  ig->literals[lo].name = copy;
+  ig->literals[lo].rule = rule;
+  ig->literal_count++;
+  return 0;
+}
+
+static int add_suffix(ignore_t *ig, const char *suffix, size_t len, size_t rule) {
+  suffix_node_t *node = &ig->suffix_root;
+  size_t i;
+
+  for (i = len; i-- > 0;) {
+    node = suffix_child(node, (unsigned char)suffix[i], 1);
+    if (!node) return -1;
+  }
+  return push_index(&node->rules, &node->rule_count, rule);
+}
+
+/* Padrão com barra: componentes literais no trie, o resto compilado */
+static int add_anchored(ignore_t *ig, rule_t *rule, const char *pat, size_t rule_index) {
+  path_node_t *node = &ig->path_root;
+  const char *p = pat;
+  size_t comps = 0;
+
+  while (*p) {
+    const char *slash = strchr(p, '/');
+    size_t len = slash ? (size_t)(slash - p) : strlen(p);
+
+    if (len > 0 && !has_wildcard(p, len) && rule->comp_count == 0) {
+      node = path_child(node, p, len, 1);
+      if (!node) return -1;
+    } else if (len > 0) {
+      glob_t *grown = realloc(rule->comps, (rule->comp_count + 1) * sizeof(*grown));
+      if (!grown) return -1;
+      rule->comps = grown;
+      if (glob_compile(&rule->comps[rule->comp_count], p, len) != 0) return -1;
+      rule->comp_count++;
+    }
+    comps++;
+    p += len;
+    while (*p == '/') p++;
+  }
+  if (comps == 0) return 1;
+  return push_index(&node->rules, &node->rule_count, rule_index);
+}
+
+int ignore_add(ignore_t *ig, const char *raw) {
+  char pat[IGNORE_LINE_MAX];
+  size_t len = strcspn(raw, "\r\n");
+  size_t rule_index = ig->rule_count;
+  const char *p;
+  rule_t *rule;
+  int ret;
+
+  if (len >= sizeof(pat)) return 0;
+  memcpy(pat, raw, len);
+  pat[len] = '\0';
+
+  /* Espaços finais não contam, a menos que escapados */
+  while (len > 0 && pat[len - 1] == ' ' && !(len > 1 && pat[len - 2] == '\\')) pat[--len] = '\0';
+  if (len == 0 || pat[0] == '#') return 0;
+
+  rule = new_rule(ig);
+  if (!rule) return -1;
+
+  p = pat;
+  if (*p == '!') {
+    rule->negate = 1;
+    p++;
+  } else if (*p == '\\' && (p[1] == '!' || p[1] == '#')) {
+    p++;
+  }
+  if (len > 0 && pat[len - 1] == '/') {
+    rule->dir_only = 1;
+    pat[--len] = '\0';
+  }
+  if (*p == '\0') return 0;
+
+  /* "**" no começo seguido de um único nome equivale a um padrão de nome */
+  if (strncmp(p, "**/", 3) == 0 && !strchr(p + 3, '/')) p += 3;
+
+  if (strchr(p, '/')) {
+    while (*p == '/') p++;
+    ret = add_anchored(ig, rule, p, rule_index);
+    if (ret != 0) {
+      rule_t tmp = *rule;
+      size_t i;
+      for (i = 0; i < tmp.comp_count; i++) glob_free(&tmp.comps[i]);
+      free(tmp.comps);
+      return ret < 0 ? -1 : 0;
+    }
+  } else if (!has_wildcard(p, strlen(p))) {
+    if (add_literal(ig, p, strlen(p), rule_index) != 0) return -1;
+  } else if (p[0] == '*' && p[1] != '*' && !has_wildcard(p + 1, strlen(p + 1))) {
+    if (add_suffix(ig, p + 1, strlen(p + 1), rule_index) != 0) return -1;
+  } else {
+    if (glob_compile(&rule->name, p, strlen(p)) != 0 ||
+        push_index(&ig->globs, &ig->glob_count, rule_index) != 0) {
+      glob_free(&rule->name);
+      return -1;
+    }
+  }
+
+  ig->rule_count++;
+  return 0;
+}
+
+/* ---- consulta ---- */
+
+typedef struct {
+  const ignore_t *ig;
+  int is_dir;
+  long best; /* maior índice de regra que casou, -1 = nenhuma */
+} match_state_t;
+
+static void consider(match_state_t *m, size_t rule) {
+  if (m->ig->rules[rule].dir_only && !m->is_dir) return;
+  if ((long)rule > m->best) m->best = (long)rule;
+}
+
+/* Componentes glob restantes contra os componentes restantes do caminho */
+static int match_comps(const glob_t *comps, size_t n, char **parts, size_t count) {
+  if (n == 0) return count == 0;
+  if (comps[0].double_star) {
+    size_t skip;
+    /* "**" como último componente casa o que está dentro, não o próprio diretório */
+    if (n == 1) return count > 0;
+    for (skip = 0; skip <= count; skip++) {
+      if (match_comps(comps + 1, n - 1, parts + skip, count - skip)) return 1;
+    }
+    return 0;
+  }
+  if (count == 0 || !glob_match(&comps[0], parts[0])) return 0;
+  return match_comps(comps + 1, n - 1, parts + 1, count - 1);
+}
+
+static void match_name(match_state_t *m, const char *name) {
+  const ignore_t *ig = m->ig;
+  const suffix_node_t *node = &ig->suffix_root;
+  size_t lo = 0;
+  size_t hi = ig->literal_count;
+  size_t len = strlen(name);
+  size_t i;
+
+  /* Literais: primeira ocorrência por busca binária, depois as repetidas */
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (strcmp(ig->literals[mid].name, name) < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  for (; lo < ig->literal_count && strcmp(ig->literals[lo].name, name) == 0; lo++) {
+    consider(m, ig->literals[lo].rule);
+  }
+
+  /* Sufixos: cada nó alcançado é um sufixo completo do nome */
+  for (i = 0; i < node->rule_count; i++) consider(m, node->rules[i]);
+  for (i = len; i-- > 0;) {
+    size_t r;
+    node = suffix_child((suffix_node_t *)node, (unsigned char)name[i], 0);
+    if (!node) break;
+    for (r = 0; r < node->rule_count; r++) consider(m, node->rules[r]);
+  }
+
+  for (i = 0; i < ig->glob_count; i++) {
+    if (glob_match(&ig->rules[ig->globs[i]].name, name)) consider(m, ig->globs[i]);
+  }
+}
+
+int ignore_match(const ignore_t *ig, const char *rel_path, int is_dir) {
+  match_state_t m;
+  char buf[IGNORE_LINE_MAX];
+  char *parts[IGNORE_LINE_MAX / 2];
+  size_t count = 0;
+  const path_node_t *node;
+  char *p;
+  size_t depth;
+
+  if (!ig || ig->rule_count == 0) return 0;
+  if (snprintf(buf, sizeof(buf), "%s", rel_path) >= (int)sizeof(buf)) return 0;
+
+  for (p = strtok(buf, "/"); p && count < sizeof(parts) / sizeof(parts[0]); p = strtok(NULL, "/")) {
+    parts[count++] = p;
+  }
+  if (count == 0) return 0;
+
+  m.ig = ig;
+  m.is_dir = is_dir;
+  m.best = -1;
+
+  match_name(&m, parts[count - 1]);
+
+  /* Ancorados: descer pelo trie junto com o caminho */
+  node = &ig->path_root;
+  for (depth = 0;; depth++) {
+    size_t i;
+    for (i = 0; i < node->rule_count; i++) {
+      const rule_t *rule = &ig->rules[node->rules[i]];
+      if (match_comps(rule->comps, rule->comp_count, parts + depth, count - depth)) {
+        consider(&m, node->rules[i]);
+      }
+    }
+    if (depth == count) break;
+    node = path_child((path_node_t *)node, parts[depth], strlen(parts[depth]), 0);
+    if (!node) break;
+  }
+
+  return m.best >= 0 && !ig->rules[m.best].negate;
+}
+
+size_t ignore_rule_count(const ignore_t *ig) {
+  return ig ? ig->rule_count : 0;
+}
+
+void ignore_free(ignore_t *ig) {
+  size_t i;
+
+  if (!ig) return;
+  for (i = 0; i < ig->rule_count; i++) {
+    size_t c;
+    for (c = 0; c < ig->rules[i].comp_count; c++) glob_free(&ig->rules[i].comps[c]);
+    free(ig->rules[i].comps);
+    glob_free(&ig->rules[i].name);
+  }
+  for (i = 0; i < ig->literal_count; i++) free(ig->literals[i].name);
+  free(ig->rules);
+  free(ig->literals);
+  free(ig->globs);
+  suffix_free(&ig->suffix_root);
+  path_free(&ig->path_root);
+  free(ig);
+}
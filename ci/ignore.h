@@ -0,0 +1,45 @@
+#ifndef CI_IGNORE_H
+#define CI_IGNORE_H
+
+#include <stddef.h>
+
+/*
+ * .clurgignore: padrões no estilo do .gitignore, compilados uma vez.
+ *
+ *   # comentário          linhas vazias e comentários são ignorados
+ *   build/                barra final: só diretórios
+ *   *.o                   sem barra: casa o nome em qualquer nível
+ *   /dist, src/gen        com barra: relativo à raiz do repositório
+ *   **                    como componente inteiro: zero ou mais diretórios
+ *   !keep.o               negação; a última regra que casa decide
+ *
+ * Nomes literais ficam numa tabela ordenada, sufixos ("*.ext") num trie de
+ * sufixos percorrido do fim do nome para o começo, e padrões ancorados num
+ * trie de componentes do caminho; só o que sobra vira glob avaliado regra a
+ * regra.
+ *
+ * Quem percorre a árvore deve consultar ignore_match() antes de descer num
+ * diretório: o que está abaixo de um diretório ignorado nunca é visitado
+ * (como no git, não dá para reincluir um arquivo dentro dele).
+ */
+
+#define IGNORE_FILE ".clurgignore"
+
+typedef struct ignore ignore_t;
+
+/* Conjunto vazio, para montar com ignore_add(); NULL só sem memória */
+ignore_t *ignore_new(void);
+
+/* Lê <root>/.clurgignore; sem arquivo resulta num conjunto vazio. NULL só sem memória */
+ignore_t *ignore_load(const char *root);
+
+/* Acrescenta uma linha no formato do arquivo (0 = ok ou linha ignorada) */
+int ignore_add(ignore_t *ig, const char *line);
+
+/* 1 se `rel_path` (relativo à raiz, sem "./") deve ser ignorado */
+int ignore_match(const ignore_t *ig, const char *rel_path, int is_dir);
+
+size_t ignore_rule_count(const ignore_t *ig);
+void ignore_free(ignore_t *ig);
+
+#endif /* CI_IGNORE_H */
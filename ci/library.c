@@ -7,24 +7,18 @@
 
 #include "ci.h"
 
-#define MAX_PATH 512
-
-static char *get_clurg_root(void) {
+char *ci_find_clurg_root(void) {
   static char root[PATH_MAX];
-  char cwd[PATH_MAX];
   char *p;
 
-  if (getcwd(cwd, sizeof(cwd)) == NULL) {
+  if (getcwd(root, sizeof(root)) == NULL) {
     perror("getcwd");
     return NULL;
   }
 
   /* Procurar diretório .clurg subindo na árvore */
-  strncpy(root, cwd, sizeof(root) - 1);
-  root[sizeof(root) - 1] = '\0';
-
   while (1) {
-    char test_path[PATH_MAX];
+    char test_path[PATH_MAX + sizeof("/.clurg")];
     snprintf(test_path, sizeof(test_path), "%s/.clurg", root);
 
     if (access(test_path, F_OK) == 0) {
@@ -41,47 +35,24 @@ static char *get_clurg_root(void) {
   }
 }
 
-int ci_run_pipeline(const char *pipeline_file, const char *repo_root) {
-  ci_pipeline_t pipeline;
-  char workspace_path[MAX_PATH];
-  char log_dir[MAX_PATH];
-  int i;
+int ci_run_instance(const ci_pipeline_t *pipeline, const char *repo_root, const char *log_dir,
+                    const char *workspace_name, int jobs) {
+  char workspace_path[PATH_MAX];
+  char cache_dir[PATH_MAX];
   int ret = 0;
 
-  /* Preparar diretório de logs */
-  if (repo_root) {
-    snprintf(log_dir, sizeof(log_dir), "%s/.clurg/ci/logs", repo_root);
-  } else {
-    /* Fallback: procurar .clurg subindo na árvore */
-    char *root = get_clurg_root();
-    if (root) {
-      snprintf(log_dir, sizeof(log_dir), "%s/.clurg/ci/logs", root);
-    } else {
-      fprintf(stderr, "erro: não foi possível determinar raiz do projeto\n");
-      return 1;
-    }
-  }
-
   /* Inicializar logger */
   if (logger_init(log_dir) != 0) {
     fprintf(stderr, "erro ao inicializar logger\n");
     return 1;
   }
 
-  /* Parsear pipeline */
-  if (config_parse(pipeline_file, &pipeline) != 0) {
-    fprintf(stderr, "erro ao parsear pipeline: %s\n", pipeline_file);
-    logger_cleanup();
-    return 1;
-  }
-
-  printf("Executando pipeline: %s\n", pipeline.name);
-  printf("Steps: %zu\n", pipeline.step_count);
+  printf("Executando pipeline: %s\n", pipeline->name);
+  printf("Steps: %zu\n", pipeline->step_count);
 
   /* Criar workspace */
-  if (workspace_create(workspace_path, sizeof(workspace_path)) != 0) {
+  if (workspace_open(repo_root, workspace_name, workspace_path, sizeof(workspace_path)) != 0) {
     fprintf(stderr, "erro ao criar workspace\n");
-    config_free(&pipeline);
     logger_cleanup();
     return 1;
   }
@@ -90,39 +61,20 @@ int ci_run_pipeline(const char *pipeline_file, const char *repo_root) {
   if (repo_root && workspace_setup(workspace_path, repo_root) != 0) {
     fprintf(stderr, "erro ao configurar workspace\n");
     workspace_cleanup(workspace_path);
-    config_free(&pipeline);
     logger_cleanup();
     return 1;
   }
 
-  printf("Workspace criado em: %s\n", workspace_path);
-
-  /* Executar cada step no workspace */
-  for (i = 0; i < (int)pipeline.step_count; i++) {
-    int exit_code;
-
-    printf("Executando step: %s\n", pipeline.steps[i].name);
-    printf("  Comando: %s\n", pipeline.steps[i].command);
-
-    /* Executar no workspace */
-    exit_code = executor_run_step(&pipeline.steps[i], workspace_path);
+  printf("Workspace criado em: %s (%s, %.0f ms)\n", workspace_path, workspace_strategy(),
+         workspace_setup_ms());
 
-    if (exit_code == 0) {
-      logger_log_step(pipeline.steps[i].name, 0, 0);
-    } else {
-      logger_log_step(pipeline.steps[i].name, 1, exit_code);
-      ret = 1; /* Pipeline falhou */
-      /* Continuar executando os outros steps?
-       * Por enquanto, vamos parar no primeiro erro conforme a regra de ouro */
-      break;
-    }
-  }
+  /* Executar os steps no workspace, respeitando os needs */
+  ret = executor_run_pipeline(pipeline, workspace_path, jobs,
+                              cache_dir_path(repo_root, cache_dir, sizeof(cache_dir)) == 0 ? cache_dir
+                                                                                       : NULL);
 
   /* Limpar workspace */
   workspace_cleanup(workspace_path);
-
-  /* Limpar recursos */
-  config_free(&pipeline);
   logger_cleanup();
 
   if (ret == 0) {
@@ -133,3 +85,38 @@ int ci_run_pipeline(const char *pipeline_file, const char *repo_root) {
 
   return ret;
 }
+
+int ci_run_pipeline(const char *pipeline_file, const char *repo_root) {
+  ci_pipeline_t pipeline;
+  char log_dir[PATH_MAX];
+  int jobs = executor_default_jobs();
+  int ret = 0;
+
+  /* Fallback: procurar .clurg subindo na árvore */
+  if (!repo_root && !(repo_root = ci_find_clurg_root())) {
+    fprintf(stderr, "erro: não foi possível determinar raiz do projeto\n");
+    return 1;
+  }
+
+  /* Preparar diretório de logs */
+  if (snprintf(log_dir, sizeof(log_dir), "%s/.clurg/ci/logs", repo_root) >= (int)sizeof(log_dir)) {
+    fprintf(stderr, "erro: caminho do projeto longo demais: %s\n", repo_root);
+    return 1;
+  }
+
+  /* Parsear pipeline */
+  if (config_parse(pipeline_file, &pipeline) != 0) {
+    fprintf(stderr, "erro ao parsear pipeline: %s\n", pipeline_file);
+    return 1;
+  }
+
+  if (pipeline.matrix_count > 0) {
+    ret = matrix_run(&pipeline, repo_root, log_dir, jobs);
+  } else {
+    ret = ci_run_instance(&pipeline, repo_root, log_dir, pipeline.name, jobs);
+  }
+
+  /* Limpar recursos */
+  config_free(&pipeline);
+  return ret;
+}
@@ -1,4 +1,6 @@
+#define _GNU_SOURCE
 #include <errno.h>
+#include <fcntl.h>
 #include <libgen.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -12,16 +14,17 @@
 
 static FILE *log_file = NULL;
 static char log_file_path[512];
+static char run_dir[512];
 
-int logger_init(const char *log_dir) {
+int logger_mkdirs(const char *dir) {
   struct stat st = {0};
 
-  /* Criar diretório de logs recursivamente (mkdir -p) */
-  if (stat(log_dir, &st) == -1) {
+  /* Criar diretório recursivamente (mkdir -p) */
+  if (stat(dir, &st) == -1) {
     char tmp[512];
     char *p;
 
-    strncpy(tmp, log_dir, sizeof(tmp) - 1);
+    strncpy(tmp, dir, sizeof(tmp) - 1);
     tmp[sizeof(tmp) - 1] = '\0';
 
     for (p = tmp + 1; *p; p++) {
@@ -44,56 +47,260 @@ int logger_init(const char *log_dir) {
       }
     }
   }
+  return 0;
+}
+
+int logger_init(const char *log_dir) {
+  if (logger_mkdirs(log_dir) != 0) {
+    return -1;
+  }
 
   /* Gerar nome do arquivo de log com timestamp */
   time_t now = time(NULL);
   struct tm *tm_info = localtime(&now);
 
-  snprintf(log_file_path, sizeof(log_file_path), "%s/ci_%04d%02d%02d_%02d%02d%02d.log", log_dir,
-           tm_info->tm_year + 1900, tm_info->tm_mon + 1, tm_info->tm_mday, tm_info->tm_hour,
-           tm_info->tm_min, tm_info->tm_sec);
+  /* Duas execuções no mesmo segundo: ci_<data>_2.log, _3... (a segunda
+   * não pode truncar o log e a saída dos steps da primeira) */
+  for (int seq = 1; !log_file && seq < 100; seq++) {
+    int fd;
+    char suffix[8] = "";
+
+    if (seq > 1) {
+      snprintf(suffix, sizeof(suffix), "_%d", seq);
+    }
+    snprintf(log_file_path, sizeof(log_file_path), "%s/ci_%04d%02d%02d_%02d%02d%02d%s.log",
+             log_dir, tm_info->tm_year + 1900, tm_info->tm_mon + 1, tm_info->tm_mday,
+             tm_info->tm_hour, tm_info->tm_min, tm_info->tm_sec, suffix);
 
-  log_file = fopen(log_file_path, "w");
+    fd = open(log_file_path, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd >= 0) {
+      log_file = fdopen(fd, "w");
+    } else if (errno != EEXIST) {
+      break;
+    }
+  }
   if (!log_file) {
     perror("fopen log_file");
     return -1;
   }
 
+  /* Mesmo nome com ".jsonl": eventos da execução. Sem ele o .log basta */
+  {
+    char events_path[sizeof(log_file_path) + 2];
+
+    snprintf(events_path, sizeof(events_path), "%.*s.jsonl", (int)strlen(log_file_path) - 4,
+             log_file_path);
+    events_open(events_path);
+  }
+
+  /* Mesmo nome sem ".log": diretório com a saída de cada step */
+  snprintf(run_dir, sizeof(run_dir), "%.*s", (int)strlen(log_file_path) - 4, log_file_path);
+  if (mkdir(run_dir, 0755) != 0 && errno != EEXIST) {
+    perror("mkdir run_dir");
+    run_dir[0] = '\0';
+  }
+
   return 0;
 }
 
-void logger_log_step(const char *step_name, int status, int exit_code) {
+/* Um registro por step para o resumo em JSON */
+typedef struct {
+  char *name;
+  int status;
+  int exit_code;
+  int has_stats;
+  ci_step_stats_t stats;
+} step_record_t;
+
+static step_record_t *records = NULL;
+static size_t record_count = 0;
+static size_t record_cap = 0;
+
+static void record_step(const char *step_name, int status, int exit_code,
+                        const ci_step_stats_t *stats) {
+  step_record_t *r;
+
+  if (record_count == record_cap) {
+    size_t cap = record_cap ? record_cap * 2 : 32;
+    step_record_t *grown = realloc(records, cap * sizeof(*records));
+    if (!grown) {
+      return;
+    }
+    records = grown;
+    record_cap = cap;
+  }
+
+  r = &records[record_count];
+  r->name = strdup(step_name);
+  if (!r->name) {
+    return;
+  }
+  r->status = status;
+  r->exit_code = exit_code;
+  r->has_stats = stats != NULL;
+  if (stats) {
+    r->stats = *stats;
+  }
+  record_count++;
+}
+
+/* " (2.31s, cpu 1.90s+0.20s, rss 45.2 MB, ...)" para o log legível */
+static void format_stats(const ci_step_stats_t *stats, char *buf, size_t size) {
+  int n;
+
+  if (!stats) {
+    buf[0] = '\0';
+    return;
+  }
+
+  n = snprintf(buf, size, " [%.2fs, cpu %.2fs+%.2fs, rss %.1f MB, blocos %ld/%ld, csw %ld/%ld",
+               stats->wall_s, stats->user_s, stats->sys_s, stats->max_rss_kb / 1024.0,
+               stats->in_blocks, stats->out_blocks, stats->voluntary_ctxsw,
+               stats->involuntary_ctxsw);
+  if (stats->has_cgroup && n > 0 && (size_t)n < size) {
+    if (stats->cg_cpu_usec >= 0) {
+      n += snprintf(buf + n, size - n, ", cgroup cpu %.2fs", stats->cg_cpu_usec / 1e6);
+    }
+    if (stats->cg_memory_peak >= 0 && (size_t)n < size) {
+      n += snprintf(buf + n, size - n, ", cgroup mem %.1f MB", stats->cg_memory_peak / 1048576.0);
+    }
+    if (stats->cg_io_read >= 0 && (size_t)n < size) {
+      n += snprintf(buf + n, size - n, ", cgroup io %.1f/%.1f MB", stats->cg_io_read / 1048576.0,
+                    stats->cg_io_write / 1048576.0);
+    }
+  }
+  if (n > 0 && (size_t)n < size) {
+    snprintf(buf + n, size - n, "]");
+  }
+}
+
+void logger_log_step(const char *step_name, int status, int exit_code,
+                     const ci_step_stats_t *stats) {
+  char usage[256];
+  char line[1024];
+
   if (!log_file) return;
 
   time_t now = time(NULL);
   struct tm *tm_info = localtime(&now);
 
-  /* Formato: [2025-01-12 20:14:03] build: OK */
-  /* ou: [2025-01-12 20:14:05] test: FAIL (exit 1) */
+  /* Formato: [2025-01-12 20:14:03] build: OK [2.31s, cpu 1.90s+0.20s, ...] */
+  /* ou: [2025-01-12 20:14:05] test: FAIL (exit 1) [...] */
+
+  format_stats(stats, usage, sizeof(usage));
+  record_step(step_name, status, exit_code, stats);
 
   if (status == 0) {
-    fprintf(log_file, "[%04d-%02d-%02d %02d:%02d:%02d] %s: OK\n", tm_info->tm_year + 1900,
-            tm_info->tm_mon + 1, tm_info->tm_mday, tm_info->tm_hour, tm_info->tm_min,
-            tm_info->tm_sec, step_name);
-    /* Também imprimir no stdout */
-    printf("[%04d-%02d-%02d %02d:%02d:%02d] %s: OK\n", tm_info->tm_year + 1900, tm_info->tm_mon + 1,
-           tm_info->tm_mday, tm_info->tm_hour, tm_info->tm_min, tm_info->tm_sec, step_name);
+    snprintf(line, sizeof(line), "[%04d-%02d-%02d %02d:%02d:%02d] %s: OK%s\n",
+             tm_info->tm_year + 1900, tm_info->tm_mon + 1, tm_info->tm_mday, tm_info->tm_hour,
+             tm_info->tm_min, tm_info->tm_sec, step_name, usage);
   } else {
-    fprintf(log_file, "[%04d-%02d-%02d %02d:%02d:%02d] %s: FAIL (exit %d)\n",
-            tm_info->tm_year + 1900, tm_info->tm_mon + 1, tm_info->tm_mday, tm_info->tm_hour,
-            tm_info->tm_min, tm_info->tm_sec, step_name, exit_code);
-    /* Também imprimir no stderr */
-    fprintf(stderr, "[%04d-%02d-%02d %02d:%02d:%02d] %s: FAIL (exit %d)\n", tm_info->tm_year + 1900,
-            tm_info->tm_mon + 1, tm_info->tm_mday, tm_info->tm_hour, tm_info->tm_min,
-            tm_info->tm_sec, step_name, exit_code);
+    snprintf(line, sizeof(line), "[%04d-%02d-%02d %02d:%02d:%02d] %s: FAIL (exit %d)%s\n",
+             tm_info->tm_year + 1900, tm_info->tm_mon + 1, tm_info->tm_mday, tm_info->tm_hour,
+             tm_info->tm_min, tm_info->tm_sec, step_name, exit_code, usage);
   }
 
+  /* Formatada uma vez: a mesma linha vai para o log e para o terminal
+   * (falhas no stderr) */
+  fputs(line, log_file);
+  fputs(line, status == 0 ? stdout : stderr);
   fflush(log_file);
 }
 
+void logger_json_string(FILE *f, const char *s) {
+  fputc('"', f);
+  for (; *s; s++) {
+    unsigned char c = (unsigned char)*s;
+    if (c == '"' || c == '\\') {
+      fprintf(f, "\\%c", c);
+    } else if (c < 0x20) {
+      fprintf(f, "\\u%04x", c);
+    } else {
+      fputc(c, f);
+    }
+  }
+  fputc('"', f);
+}
+
+/* Campos de recursos de um step, começando com ", " (resumo e eventos) */
+void logger_json_stats(FILE *f, const ci_step_stats_t *st) {
+  fprintf(f,
+          ", \"wall_s\": %.3f, \"user_s\": %.3f, \"sys_s\": %.3f, \"max_rss_kb\": %ld, "
+          "\"in_blocks\": %ld, \"out_blocks\": %ld, \"voluntary_ctxsw\": %ld, "
+          "\"involuntary_ctxsw\": %ld",
+          st->wall_s, st->user_s, st->sys_s, st->max_rss_kb, st->in_blocks, st->out_blocks,
+          st->voluntary_ctxsw, st->involuntary_ctxsw);
+  if (st->has_cgroup) {
+    /* -1: contador indisponível neste cgroup */
+    fprintf(f,
+            ", \"cgroup\": {\"cpu_usec\": %lld, \"memory_peak_bytes\": %lld, "
+            "\"io_read_bytes\": %lld, \"io_write_bytes\": %lld}",
+            st->cg_cpu_usec, st->cg_memory_peak, st->cg_io_read, st->cg_io_write);
+  }
+}
+
+/* ci_<data>.json ao lado do .log: gravado num .tmp e renomeado */
+static void write_summary(void) {
+  char path[sizeof(log_file_path)];
+  char tmp[sizeof(log_file_path) + 8];
+  size_t len = strlen(log_file_path);
+  size_t i;
+  FILE *f;
+
+  if (len < 4 || strcmp(log_file_path + len - 4, ".log") != 0) {
+    return;
+  }
+  snprintf(path, sizeof(path), "%.*s.json", (int)(len - 4), log_file_path);
+  snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+
+  f = fopen(tmp, "w");
+  if (!f) {
+    perror("fopen resumo");
+    return;
+  }
+
+  fprintf(f, "{\n  \"log\": ");
+  logger_json_string(f, strrchr(log_file_path, '/') ? strrchr(log_file_path, '/') + 1
+                                                    : log_file_path);
+  fprintf(f, ",\n  \"steps\": [");
+  for (i = 0; i < record_count; i++) {
+    const step_record_t *r = &records[i];
+
+    fprintf(f, "%s\n    {\"name\": ", i ? "," : "");
+    logger_json_string(f, r->name);
+    fprintf(f, ", \"status\": \"%s\", \"exit_code\": %d", r->status == 0 ? "ok" : "fail",
+            r->exit_code);
+    if (r->has_stats) {
+      logger_json_stats(f, &r->stats);
+    }
+    fprintf(f, "}");
+  }
+  fprintf(f, "%s]\n}\n", record_count ? "\n  " : "");
+
+  if (fclose(f) != 0 || rename(tmp, path) != 0) {
+    perror("gravar resumo");
+    unlink(tmp);
+  }
+}
+
+const char *logger_run_dir(void) {
+  return log_file && run_dir[0] ? run_dir : NULL;
+}
+
 void logger_cleanup(void) {
+  size_t i;
+
+  events_close();
   if (log_file) {
     fclose(log_file);
     log_file = NULL;
+    write_summary();
+  }
+
+  for (i = 0; i < record_count; i++) {
+    free(records[i].name);
   }
+  free(records);
+  records = NULL;
+  record_count = record_cap = 0;
 }
@@ -0,0 +1,300 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ci.h"
+
+/*
+ * Matrix: o pipeline roda uma vez por combinação dos eixos, cada combinação
+ * (célula) num processo filho que é uma execução comum do clurg-ci: logger,
+ * workspace, cgroup e cache próprios. A célula só difere no ambiente (as
+ * variáveis dos eixos e CLURG_CI_MATRIX) e no nome do pool de workspaces
+ * warm (<pipeline>-<n>), para as células não disputarem os mesmos slots.
+ *
+ * O stdout/stderr de cada célula vai por um pipe para
+ * .clurg/ci/logs/matrix_<data>/<célula>.log (output.c); o terminal só recebe
+ * uma linha por célula que termina e o fim da saída das que falham.
+ */
+
+typedef struct {
+  pid_t pid;
+  ci_output_t *out;
+  int eof;
+  double started;
+  double elapsed;
+  int exit_code;
+  char label[256];
+} matrix_cell_t;
+
+static double now_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+size_t matrix_cell_count(const ci_pipeline_t *pipeline) {
+  size_t cells = 1;
+  size_t i;
+
+  for (i = 0; i < pipeline->matrix_count; i++) {
+    cells *= pipeline->matrix[i].value_count;
+  }
+  return cells;
+}
+
+/* Valor do eixo `axis` na célula `cell`: o primeiro eixo varia mais devagar,
+ * como laços aninhados na ordem do arquivo */
+static const char *cell_value(const ci_pipeline_t *pipeline, size_t cell, size_t axis) {
+  size_t i;
+
+  for (i = pipeline->matrix_count; i-- > axis + 1;) {
+    cell /= pipeline->matrix[i].value_count;
+  }
+  return pipeline->matrix[axis].values[cell % pipeline->matrix[axis].value_count];
+}
+
+/* "CC=gcc CFLAGS=-O2" */
+static void cell_label(const ci_pipeline_t *pipeline, size_t cell, char *out, size_t size) {
+  size_t i, used = 0;
+
+  out[0] = '\0';
+  for (i = 0; i < pipeline->matrix_count && used < size; i++) {
+    int n = snprintf(out + used, size - used, "%s%s=%s", i ? " " : "",
+                     pipeline->matrix[i].name, cell_value(pipeline, cell, i));
+    if (n < 0) {
+      break;
+    }
+    used += (size_t)n;
+  }
+}
+
+/* <log_dir>/matrix_<data>[_n]: um diretório novo por execução */
+static int make_matrix_dir(const char *log_dir, char *out, size_t size) {
+  time_t now = time(NULL);
+  struct tm *tm_info = localtime(&now);
+  int seq;
+
+  if (logger_mkdirs(log_dir) != 0) {
+    return -1;
+  }
+  for (seq = 1; seq < 100; seq++) {
+    char suffix[8] = "";
+
+    if (seq > 1) {
+      snprintf(suffix, sizeof(suffix), "_%d", seq);
+    }
+    snprintf(out, size, "%s/matrix_%04d%02d%02d_%02d%02d%02d%s", log_dir,
+             tm_info->tm_year + 1900, tm_info->tm_mon + 1, tm_info->tm_mday, tm_info->tm_hour,
+             tm_info->tm_min, tm_info->tm_sec, suffix);
+    if (mkdir(out, 0755) == 0) {
+      return 0;
+    }
+    if (errno != EEXIST) {
+      break;
+    }
+  }
+  perror("mkdir matrix");
+  return -1;
+}
+
+/* Processo da célula: ambiente da célula e uma execução normal do pipeline */
+static void run_cell(const ci_pipeline_t *pipeline, size_t cell, const char *label,
+                     const char *repo_root, const char *log_dir, int jobs, int out_fd) {
+  char workspace_name[NAME_MAX + 1];
+  size_t i;
+  int ret;
+
+  if (out_fd >= 0) {
+    dup2(out_fd, STDOUT_FILENO);
+    dup2(out_fd, STDERR_FILENO);
+    close(out_fd);
+  }
+  for (i = 0; i < pipeline->matrix_count; i++) {
+    setenv(pipeline->matrix[i].name, cell_value(pipeline, cell, i), 1);
+  }
+  setenv("CLURG_CI_MATRIX", label, 1);
+  snprintf(workspace_name, sizeof(workspace_name), "%s-%zu", pipeline->name, cell + 1);
+
+  printf("Matrix: %s\n", label);
+  ret = ci_run_instance(pipeline, repo_root, log_dir, workspace_name, jobs);
+
+  /* Sem exit(): nada do pai (atexit, buffers) deve rodar duas vezes */
+  fflush(NULL);
+  _exit(ret);
+}
+
+static int start_cell(const ci_pipeline_t *pipeline, size_t index, matrix_cell_t *cell,
+                      const char *matrix_dir, const char *repo_root, const char *log_dir,
+                      int jobs) {
+  int out_fd = -1;
+
+  cell_label(pipeline, index, cell->label, sizeof(cell->label));
+  cell->out = output_open(matrix_dir, cell->label, &out_fd);
+  cell->eof = cell->out == NULL;
+  cell->started = now_seconds();
+
+  fflush(NULL); /* o filho herdaria o que estiver no buffer */
+  cell->pid = fork();
+  if (cell->pid == 0) {
+    run_cell(pipeline, index, cell->label, repo_root, log_dir, jobs, out_fd);
+  }
+  if (out_fd >= 0) {
+    close(out_fd);
+  }
+  if (cell->pid < 0) {
+    perror("fork");
+    output_close(cell->out);
+    cell->out = NULL;
+    cell->exit_code = -1;
+    return -1;
+  }
+  return 0;
+}
+
+int matrix_run(const ci_pipeline_t *pipeline, const char *repo_root, const char *log_dir, int jobs) {
+  size_t count = matrix_cell_count(pipeline);
+  matrix_cell_t *cells = calloc(count, sizeof(*cells));
+  struct pollfd *fds = calloc(count, sizeof(*fds));
+  size_t *fd_cell = calloc(count, sizeof(*fd_cell));
+  char matrix_dir[PATH_MAX];
+  double t0 = now_seconds();
+  double slowest = 0.0;
+  size_t next = 0, done = 0, passed = 0, i;
+  int concurrent, cell_jobs;
+  int running = 0;
+
+  if (!cells || !fds || !fd_cell) {
+    fprintf(stderr, "erro: sem memória para %zu combinações\n", count);
+    free(cells);
+    free(fds);
+    free(fd_cell);
+    return 1;
+  }
+  if (make_matrix_dir(log_dir, matrix_dir, sizeof(matrix_dir)) != 0) {
+    matrix_dir[0] = '\0';
+  }
+
+  /* `jobs` é o total: até `jobs` células ao mesmo tempo, e os slots que
+   * sobram são divididos entre elas */
+  if (jobs < 1) {
+    jobs = 1;
+  }
+  concurrent = (size_t)jobs < count ? jobs : (int)count;
+  cell_jobs = jobs / concurrent;
+
+  printf("Executando matrix do pipeline %s: %zu combinações, %d por vez, %d slot%s cada\n",
+         pipeline->name, count, concurrent, cell_jobs, cell_jobs == 1 ? "" : "s");
+  if (matrix_dir[0]) {
+    printf("Saída das combinações em: %s/\n", matrix_dir);
+  }
+
+  while (done < count) {
+    nfds_t nfds = 0;
+    pid_t pid;
+    int status;
+
+    while (running < concurrent && next < count) {
+      if (start_cell(pipeline, next, &cells[next], matrix_dir[0] ? matrix_dir : NULL, repo_root,
+                     log_dir, cell_jobs) == 0) {
+        running++;
+      } else {
+        printf("[FAIL] %s (não iniciou)\n", cells[next].label);
+        done++;
+      }
+      next++;
+    }
+    if (running == 0) {
+      continue;
+    }
+
+    for (i = 0; i < next; i++) {
+      if (cells[i].pid > 0 && !cells[i].eof) {
+        fds[nfds].fd = output_fd(cells[i].out);
+        fds[nfds].events = POLLIN;
+        fd_cell[nfds++] = i;
+      }
+    }
+    /* Sem pipe aberto (processo largado pela célula segurando-o, ou pipe que
+     * já fechou) o timeout ainda acorda o laço para recolher o filho */
+    if (poll(fds, nfds, 100) < 0 && errno != EINTR) {
+      perror("poll");
+      break;
+    }
+    for (i = 0; i < nfds; i++) {
+      if (fds[i].revents && output_drain(cells[fd_cell[i]].out)) {
+        cells[fd_cell[i]].eof = 1;
+      }
+    }
+
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+      matrix_cell_t *cell = NULL;
+
+      for (i = 0; i < next; i++) {
+        if (cells[i].pid == pid) {
+          cell = &cells[i];
+          break;
+        }
+      }
+      if (!cell) {
+        continue;
+      }
+
+      cell->pid = 0;
+      cell->elapsed = now_seconds() - cell->started;
+      cell->exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+      if (cell->out) {
+        output_drain(cell->out);
+      }
+      running--;
+      done++;
+      if (cell->elapsed > slowest) {
+        slowest = cell->elapsed;
+      }
+
+      if (cell->exit_code == 0) {
+        passed++;
+        printf("[OK]   %s (%.2fs)\n", cell->label, cell->elapsed);
+      } else {
+        printf("[FAIL] %s (%.2fs, exit %d)\n", cell->label, cell->elapsed, cell->exit_code);
+        if (cell->out) {
+          output_print_tail(cell->out, stderr);
+        }
+      }
+      fflush(stdout);
+      output_close(cell->out);
+      cell->out = NULL;
+    }
+  }
+
+  /* poll falhou: não deixar células órfãs */
+  for (i = 0; i < next; i++) {
+    if (cells[i].pid > 0) {
+      kill(cells[i].pid, SIGTERM);
+      waitpid(cells[i].pid, NULL, 0);
+      output_close(cells[i].out);
+      cells[i].exit_code = -1;
+    }
+  }
+
+  printf("\nResumo da matrix (%zu/%zu ok, %.2fs no total, combinação mais lenta %.2fs):\n",
+         passed, count, now_seconds() - t0, slowest);
+  for (i = 0; i < count; i++) {
+    const char *result = i >= next ? "----" : cells[i].exit_code == 0 ? "OK" : "FAIL";
+    printf("  %-4s  %s\n", result, cells[i].label[0] ? cells[i].label : "(não executada)");
+  }
+
+  free(cells);
+  free(fds);
+  free(fd_cell);
+  return passed == count ? 0 : 1;
+}
@@ -0,0 +1,229 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ci.h"
+
+/*
+ * Saída de um step: stdout e stderr do filho vão para o mesmo pipe (a ordem
+ * entre os dois se mantém), cuja ponta de leitura é não bloqueante e fica no
+ * epoll do executor. Cada leitura vai para <run>/<step>.log e para um buffer
+ * circular com o fim da saída, mostrado quando o step falha. A memória por
+ * step é fixa, não importa quanto ele escreva.
+ */
+
+#define OUTPUT_TAIL 16384
+#define OUTPUT_TAIL_LINES 20
+#define OUTPUT_READ 65536
+
+struct ci_output {
+  char name[NAME_MAX + 1];
+  int fd;     /* ponta de leitura do pipe */
+  int log_fd; /* <run>/<step>.log; -1 se não abriu */
+  int stream; /* CLURG_CI_STREAM=1: ecoar no stdout com prefixo */
+  int at_line_start;
+  unsigned long long bytes;
+  char tail[OUTPUT_TAIL];
+  size_t tail_start; /* posição do byte mais antigo */
+  size_t tail_len;
+};
+
+/* Nome do step como nome de arquivo */
+static void safe_name(const char *name, char *out, size_t size) {
+  size_t i;
+
+  for (i = 0; name[i] && i < size - 1; i++) {
+    char c = name[i];
+    out[i] = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+                     c == '-' || c == '_' || c == '.'
+                 ? c
+                 : '_';
+  }
+  out[i] = '\0';
+  if (!out[0] || out[0] == '.') {
+    out[0] = '_';
+  }
+}
+
+ci_output_t *output_open(const char *run_dir, const char *step_name, int *write_fd) {
+  const char *stream = getenv("CLURG_CI_STREAM");
+  char file[PATH_MAX + NAME_MAX + 8];
+  ci_output_t *out;
+  int fds[2];
+
+  out = calloc(1, sizeof(*out));
+  if (!out) {
+    return NULL;
+  }
+  if (pipe2(fds, O_CLOEXEC) != 0) {
+    perror("pipe2");
+    free(out);
+    return NULL;
+  }
+  /* Só a ponta do executor é não bloqueante: o step escreve normalmente e,
+   * com o pipe cheio, espera só ele mesmo */
+  fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+
+  snprintf(out->name, sizeof(out->name), "%s", step_name);
+  out->fd = fds[0];
+  out->stream = stream && strcmp(stream, "1") == 0;
+  out->at_line_start = 1;
+  out->log_fd = -1;
+
+  if (run_dir) {
+    char name[NAME_MAX - 4];
+
+    safe_name(step_name, name, sizeof(name));
+    snprintf(file, sizeof(file), "%s/%s.log", run_dir, name);
+    out->log_fd = open(file, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (out->log_fd < 0) {
+      fprintf(stderr, "aviso: não foi possível criar %s: %s\n", file, strerror(errno));
+    }
+  }
+
+  *write_fd = fds[1];
+  return out;
+}
+
+int output_fd(const ci_output_t *out) {
+  return out->fd;
+}
+
+unsigned long long output_bytes(const ci_output_t *out) {
+  return out->bytes;
+}
+
+static void tail_append(ci_output_t *out, const char *data, size_t len) {
+  if (len >= OUTPUT_TAIL) {
+    memcpy(out->tail, data + len - OUTPUT_TAIL, OUTPUT_TAIL);
+    out->tail_start = 0;
+    out->tail_len = OUTPUT_TAIL;
+    return;
+  }
+  while (len > 0) {
+    size_t end = (out->tail_start + out->tail_len) % OUTPUT_TAIL;
+    size_t chunk = OUTPUT_TAIL - end < len ? OUTPUT_TAIL - end : len;
+
+    memcpy(out->tail + end, data, chunk);
+    data += chunk;
+    len -= chunk;
+    out->tail_len += chunk;
+    if (out->tail_len > OUTPUT_TAIL) {
+      out->tail_start = (out->tail_start + out->tail_len - OUTPUT_TAIL) % OUTPUT_TAIL;
+      out->tail_len = OUTPUT_TAIL;
+    }
+  }
+}
+
+static void stream_lines(ci_output_t *out, const char *data, size_t len) {
+  size_t i;
+
+  for (i = 0; i < len; i++) {
+    if (out->at_line_start) {
+      printf("[%s] ", out->name);
+    }
+    putchar(data[i]);
+    out->at_line_start = data[i] == '\n';
+  }
+}
+
+static void write_log(ci_output_t *out, const char *data, size_t len) {
+  while (out->log_fd >= 0 && len > 0) {
+    ssize_t n = write(out->log_fd, data, len);
+
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      fprintf(stderr, "aviso: log do step '%s' incompleto: %s\n", out->name, strerror(errno));
+      close(out->log_fd);
+      out->log_fd = -1;
+      return;
+    }
+    data += n;
+    len -= (size_t)n;
+  }
+}
+
+int output_drain(ci_output_t *out) {
+  char buf[OUTPUT_READ];
+
+  while (out->fd >= 0) {
+    ssize_t n = read(out->fd, buf, sizeof(buf));
+
+    if (n > 0) {
+      out->bytes += (unsigned long long)n;
+      write_log(out, buf, (size_t)n);
+      tail_append(out, buf, (size_t)n);
+      if (out->stream) {
+        stream_lines(out, buf, (size_t)n);
+        fflush(stdout);
+      }
+      continue;
+    }
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0 && errno == EAGAIN) {
+      return 0;
+    }
+    return 1; /* EOF (ou erro): ninguém mais escreve */
+  }
+  return 1;
+}
+
+void output_print_tail(const ci_output_t *out, FILE *f) {
+  char *text;
+  size_t i, start = 0;
+  int lines = 0;
+
+  if (out->tail_len == 0) {
+    return;
+  }
+  text = malloc(out->tail_len + 1);
+  if (!text) {
+    return;
+  }
+  for (i = 0; i < out->tail_len; i++) {
+    text[i] = out->tail[(out->tail_start + i) % OUTPUT_TAIL];
+  }
+  text[out->tail_len] = '\0';
+
+  /* Últimas OUTPUT_TAIL_LINES linhas (a última pode não ter '\n') */
+  for (i = out->tail_len; i > 0; i--) {
+    if (text[i - 1] == '\n' && i != out->tail_len && ++lines == OUTPUT_TAIL_LINES) {
+      start = i;
+      break;
+    }
+  }
+
+  fflush(stdout);
+  fprintf(f, "--- saída de %s (fim, %llu bytes no total) ---\n", out->name, out->bytes);
+  fputs(text + start, f);
+  if (text[out->tail_len - 1] != '\n') {
+    fputc('\n', f);
+  }
+  fprintf(f, "---\n");
+  free(text);
+}
+
+void output_close(ci_output_t *out) {
+  if (!out) {
+    return;
+  }
+  if (out->stream && !out->at_line_start) {
+    putchar('\n');
+  }
+  if (out->fd >= 0) {
+    close(out->fd);
+  }
+  if (out->log_fd >= 0) {
+    close(out->log_fd);
+  }
+  free(out);
+}
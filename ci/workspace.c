@@ -2,15 +2,107 @@
 #include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <ftw.h>
 #include <limits.h>
+#include <linux/fs.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/file.h>
+#include <sys/ioctl.h>
+#include <sys/mount.h>
+#include <sys/sendfile.h>
 #include <sys/stat.h>
+#include <sys/sysmacros.h>
 #include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "ci.h"
+#include "ignore.h"
+
+/*
+ * Estratégias de workspace (CLURG_CI_WORKSPACE):
+ *
+ *   overlay   overlayfs com o repositório como lowerdir, montado num mount
+ *             namespace (dentro de um user namespace quando não somos root).
+ *             O custo não depende do tamanho do repositório: o kernel faz a
+ *             cópia (copy-up) só do que os steps escreverem.
+ *   reflink   árvore recriada com FICLONE: cada arquivo compartilha os
+ *             extents com o original (btrfs, xfs); cai para cópia onde o
+ *             sistema de arquivos não suporta.
+ *   hardlink  árvore de hardlinks. Compiladores e make gravam arquivo novo e
+ *             renomeiam, o que não toca o original; escrita no lugar altera o
+ *             repositório, por isso só é usada se pedida explicitamente.
+ *   copy      cópia completa (copy_file_range).
+ *   warm      workspace persistente de um pool por pipeline, sincronizado só
+ *             no que mudou; saídas de build (.o etc.) ficam de uma execução
+ *             para a outra.
+ *
+ * auto (padrão) tenta overlay, depois reflink/cópia.
+ */
+typedef enum {
+  WORKSPACE_AUTO,
+  WORKSPACE_OVERLAY,
+  WORKSPACE_REFLINK,
+  WORKSPACE_HARDLINK,
+  WORKSPACE_COPY,
+  WORKSPACE_WARM
+} workspace_strategy_t;
+
+static const char *strategy_names[] = {"auto", "overlay", "reflink", "hardlink", "copy", "warm"};
+
+/* Workspace montado com overlay: o processo que segura os namespaces vive até
+ * workspace_cleanup() fechar o pipe `hold_fd` */
+static struct {
+  char path[PATH_MAX];
+  pid_t holder;
+  int hold_fd;
+  int userns;
+  workspace_strategy_t used;
+  uint64_t files_cloned;
+  uint64_t files_linked;
+  uint64_t files_copied;
+  double setup_ms;
+  /* slot do pool em uso: lock mantido até workspace_cleanup() */
+  int warm_lock_fd;
+  char warm_manifest[PATH_MAX];
+} current = {.holder = -1, .hold_fd = -1, .used = WORKSPACE_COPY, .warm_lock_fd = -1};
+
+static workspace_strategy_t strategy_from_env(void) {
+  const char *env = getenv("CLURG_CI_WORKSPACE");
+  size_t i;
+
+  if (!env || !*env) {
+    return WORKSPACE_AUTO;
+  }
+  for (i = 0; i < sizeof(strategy_names) / sizeof(strategy_names[0]); i++) {
+    if (strcmp(env, strategy_names[i]) == 0) {
+      return (workspace_strategy_t)i;
+    }
+  }
+  fprintf(stderr, "aviso: CLURG_CI_WORKSPACE desconhecido '%s', usando auto\n", env);
+  return WORKSPACE_AUTO;
+}
+
+const char *workspace_strategy(void) {
+  return strategy_names[current.used];
+}
+
+double workspace_setup_ms(void) {
+  return current.setup_ms;
+}
+
+static double now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
 
 int workspace_create(char *workspace_path, size_t path_size) {
   char template[] = "/tmp/clurg-ci-XXXXXX";
@@ -40,95 +132,1054 @@ static int should_ignore(const char *name) {
   /* Não ignorar outros arquivos ocultos, podem ser necessários para o build */
 }
 
-static int copy_file(const char *src_path, const char *dst_path) {
-  FILE *src, *dst;
-  char buffer[8192];
-  size_t n;
+/* Tipo da entrada sem stat quando o d_type responde; symlinks são seguidos
+ * (como o stat() de antes). 1 = diretório, 0 = arquivo regular, -1 = outro */
+static int entry_kind(int dir_fd, const struct dirent *entry) {
+  struct stat st;
 
-  src = fopen(src_path, "rb");
-  if (!src) {
-    perror("fopen src");
+  switch (entry->d_type) {
+  case DT_DIR:
+    return 1;
+  case DT_REG:
+    return 0;
+  case DT_UNKNOWN:
+  case DT_LNK:
+    if (fstatat(dir_fd, entry->d_name, &st, 0) != 0) {
+      return -1;
+    }
+    return S_ISDIR(st.st_mode) ? 1 : S_ISREG(st.st_mode) ? 0 : -1;
+  default:
     return -1;
   }
+}
 
-  dst = fopen(dst_path, "wb");
-  if (!dst) {
-    perror("fopen dst");
-    fclose(src);
-    return -1;
+/* Copia `size` bytes dentro do kernel: copy_file_range (que clona em alguns
+ * fs), sendfile entre sistemas de arquivos antigos e read/write no fim */
+static int copy_fd(int src, int dst, off_t size) {
+  char buffer[65536];
+  int method = 0;
+  off_t done = 0;
+  ssize_t n;
+
+  while (1) {
+    size_t want = size > done ? (size_t)(size - done) : 65536;
+
+    if (method == 0) {
+      n = copy_file_range(src, NULL, dst, NULL, want, 0);
+    } else if (method == 1) {
+      n = sendfile(dst, src, NULL, want);
+    } else {
+      n = read(src, buffer, sizeof(buffer));
+      if (n > 0 && write(dst, buffer, n) != n) {
+        n = -1;
+      }
+    }
+
+    if (n < 0 && method < 2 && done == 0 &&
+        (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP)) {
+      method++;
+      continue;
+    }
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      perror("copy");
+      return -1;
+    }
+    if (n == 0) {
+      return 0; /* o arquivo pode ter crescido: copia até o EOF */
+    }
+    done += n;
   }
+}
+
+/* Materializa um arquivo conforme a estratégia; reflink/hardlink sem suporte
+ * passam a copiar (e não tentam de novo nos arquivos seguintes) */
+static int place_file(int *mode, int src_dir, int dst_dir, const char *name) {
+  struct stat st;
+  int src, dst;
+  int m = __atomic_load_n(mode, __ATOMIC_RELAXED);
+  int cloned = 0;
+  int ret = 0;
 
-  while ((n = fread(buffer, 1, sizeof(buffer), src)) > 0) {
-    if (fwrite(buffer, 1, n, dst) != n) {
-      perror("fwrite");
-      fclose(src);
-      fclose(dst);
+  if (m == WORKSPACE_HARDLINK) {
+    if (linkat(src_dir, name, dst_dir, name, 0) == 0) {
+      __atomic_fetch_add(&current.files_linked, 1, __ATOMIC_RELAXED);
+      return 0;
+    }
+    if (errno != EXDEV && errno != EPERM && errno != EMLINK) {
+      perror("link");
       return -1;
     }
+    if (__atomic_exchange_n(mode, WORKSPACE_COPY, __ATOMIC_RELAXED) == WORKSPACE_HARDLINK) {
+      fprintf(stderr, "aviso: hardlink indisponível (%s), copiando\n", strerror(errno));
+    }
+    m = WORKSPACE_COPY;
+  }
+
+  src = openat(src_dir, name, O_RDONLY | O_CLOEXEC);
+  if (src < 0 || fstat(src, &st) != 0) {
+    perror("open src");
+    if (src >= 0) {
+      close(src);
+    }
+    return -1;
+  }
+
+  dst = openat(dst_dir, name, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+  if (dst < 0) {
+    perror("open dst");
+    close(src);
+    return -1;
+  }
+
+  if (m == WORKSPACE_REFLINK) {
+    if (ioctl(dst, FICLONE, src) == 0) {
+      __atomic_fetch_add(&current.files_cloned, 1, __ATOMIC_RELAXED);
+      cloned = 1;
+    } else if (errno == EOPNOTSUPP || errno == ENOTTY || errno == EXDEV || errno == EINVAL) {
+      __atomic_store_n(mode, WORKSPACE_COPY, __ATOMIC_RELAXED);
+    } else {
+      perror("ioctl FICLONE");
+      ret = -1;
+    }
+  }
+
+  if (ret == 0 && !cloned) {
+    ret = copy_fd(src, dst, st.st_size);
+    __atomic_fetch_add(&current.files_copied, 1, __ATOMIC_RELAXED);
+  }
+
+  /* Copiar permissões */
+  if (ret == 0) {
+    fchmod(dst, st.st_mode & 07777);
+  }
+
+  close(src);
+  if (close(dst) != 0) {
+    ret = -1;
+  }
+  return ret;
+}
+
+/*
+ * Réplica da árvore: cada diretório é uma tarefa numa pilha compartilhada
+ * por `threads` workers. O worker abre o par de diretórios (openat a partir
+ * das raízes), cria os subdiretórios e os empilha, e materializa os arquivos
+ * relativos aos descritores, sem montar caminhos absolutos.
+ */
+typedef struct copy_task {
+  struct copy_task *next;
+  char rel[]; /* relativo à raiz ("" = a própria raiz) */
+} copy_task_t;
+
+typedef struct {
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  copy_task_t *stack;
+  size_t pending; /* tarefas empilhadas ou em andamento */
+  int failed;
+  int src_root;
+  int dst_root;
+  const ignore_t *ignore;
+  int mode;
+} copier_t;
+
+static int copier_push(copier_t *c, const char *rel) {
+  size_t len = strlen(rel);
+  copy_task_t *task = malloc(sizeof(*task) + len + 1);
+
+  if (!task) {
+    return -1;
   }
+  memcpy(task->rel, rel, len + 1);
 
-  fclose(src);
-  fclose(dst);
+  pthread_mutex_lock(&c->lock);
+  task->next = c->stack;
+  c->stack = task;
+  c->pending++;
+  pthread_cond_signal(&c->cond);
+  pthread_mutex_unlock(&c->lock);
   return 0;
 }
 
-static int copy_dir_recursive(const char *src_dir, const char *dst_dir) {
-  DIR *dir;
+static int copy_one_dir(copier_t *c, const char *rel) {
+  const char *at = rel[0] ? rel : ".";
+  char rel_path[PATH_MAX];
   struct dirent *entry;
-  struct stat st;
-  char src_path[PATH_MAX];
-  char dst_path[PATH_MAX];
+  int src_fd, dst_fd;
+  DIR *dir;
   int ret = 0;
 
-  /* Criar diretório destino */
-  if (mkdir(dst_dir, 0755) != 0 && errno != EEXIST) {
-    perror("mkdir dst_dir");
+  src_fd = openat(c->src_root, at, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (src_fd < 0) {
+    perror("opendir");
     return -1;
   }
-
-  dir = opendir(src_dir);
+  dst_fd = openat(c->dst_root, at, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (dst_fd < 0) {
+    perror("open dst_dir");
+    close(src_fd);
+    return -1;
+  }
+  dir = fdopendir(src_fd);
   if (!dir) {
-    perror("opendir");
+    perror("fdopendir");
+    close(src_fd);
+    close(dst_fd);
     return -1;
   }
 
   while ((entry = readdir(dir)) != NULL) {
+    int kind;
+
     if (should_ignore(entry->d_name)) {
       continue;
     }
+    if (__atomic_load_n(&c->failed, __ATOMIC_RELAXED)) {
+      break;
+    }
+
+    kind = entry_kind(src_fd, entry);
+    if (kind < 0) {
+      continue; /* Ignorar outros tipos (sockets, fifos, links quebrados) */
+    }
+
+    if (snprintf(rel_path, sizeof(rel_path), "%s%s%s", rel, rel[0] ? "/" : "", entry->d_name) >=
+        (int)sizeof(rel_path)) {
+      continue;
+    }
+    if (ignore_match(c->ignore, rel_path, kind == 1)) {
+      continue;
+    }
+
+    if (kind == 1) {
+      /* Criar o diretório aqui e deixar o conteúdo para qualquer worker */
+      if ((mkdirat(dst_fd, entry->d_name, 0755) != 0 && errno != EEXIST) ||
+          copier_push(c, rel_path) != 0) {
+        perror("mkdir dst_dir");
+        ret = -1;
+        break;
+      }
+    } else if (place_file(&c->mode, src_fd, dst_fd, entry->d_name) != 0) {
+      ret = -1;
+      break;
+    }
+  }
+
+  closedir(dir);
+  close(dst_fd);
+  return ret;
+}
+
+static void *copier_worker(void *arg) {
+  copier_t *c = arg;
+
+  pthread_mutex_lock(&c->lock);
+  while (1) {
+    copy_task_t *task;
+
+    while (!c->stack && c->pending > 0 && !c->failed) {
+      pthread_cond_wait(&c->cond, &c->lock);
+    }
+    if (!c->stack || c->failed) {
+      break;
+    }
 
-    snprintf(src_path, sizeof(src_path), "%s/%s", src_dir, entry->d_name);
-    snprintf(dst_path, sizeof(dst_path), "%s/%s", dst_dir, entry->d_name);
+    task = c->stack;
+    c->stack = task->next;
+    pthread_mutex_unlock(&c->lock);
 
-    if (stat(src_path, &st) != 0) {
+    if (copy_one_dir(c, task->rel) != 0) {
+      __atomic_store_n(&c->failed, 1, __ATOMIC_RELAXED);
+    }
+    free(task);
+
+    pthread_mutex_lock(&c->lock);
+    if (--c->pending == 0 || c->failed) {
+      pthread_cond_broadcast(&c->cond);
+    }
+  }
+  pthread_mutex_unlock(&c->lock);
+  return NULL;
+}
+
+/* CLURG_CI_COPY_THREADS ou o número de CPUs, até 8 */
+static int copy_threads(void) {
+  const char *env = getenv("CLURG_CI_COPY_THREADS");
+  long n = env && *env ? strtol(env, NULL, 10) : sysconf(_SC_NPROCESSORS_ONLN);
+
+  if (n < 1) {
+    n = 1;
+  }
+  return n > 8 ? 8 : (int)n;
+}
+
+static int copy_tree(const char *src_dir, const char *dst_dir, const ignore_t *ignore,
+                     workspace_strategy_t *mode) {
+  pthread_t tids[8];
+  copier_t c;
+  int threads = copy_threads();
+  int started = 0;
+  int i;
+
+  memset(&c, 0, sizeof(c));
+  pthread_mutex_init(&c.lock, NULL);
+  pthread_cond_init(&c.cond, NULL);
+  c.ignore = ignore;
+  c.mode = *mode;
+  c.src_root = open(src_dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  c.dst_root = open(dst_dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+  if (c.src_root >= 0 && c.dst_root >= 0 && copier_push(&c, "") == 0) {
+    for (i = 1; i < threads; i++) {
+      if (pthread_create(&tids[started], NULL, copier_worker, &c) == 0) {
+        started++;
+      }
+    }
+    copier_worker(&c);
+    for (i = 0; i < started; i++) {
+      pthread_join(tids[i], NULL);
+    }
+  } else {
+    perror("open workspace");
+    c.failed = 1;
+  }
+
+  /* Em falha podem sobrar tarefas na pilha */
+  while (c.stack) {
+    copy_task_t *next = c.stack->next;
+    free(c.stack);
+    c.stack = next;
+  }
+  if (c.src_root >= 0) {
+    close(c.src_root);
+  }
+  if (c.dst_root >= 0) {
+    close(c.dst_root);
+  }
+  pthread_mutex_destroy(&c.lock);
+  pthread_cond_destroy(&c.cond);
+
+  *mode = (workspace_strategy_t)c.mode;
+  return c.failed ? -1 : 0;
+}
+
+static int write_proc(const char *path, const char *text) {
+  int fd = open(path, O_WRONLY | O_CLOEXEC);
+  ssize_t len = (ssize_t)strlen(text);
+  int ok;
+
+  if (fd < 0) {
+    return -1;
+  }
+  ok = write(fd, text, len) == len;
+  close(fd);
+  return ok ? 0 : -1;
+}
+
+/* Esconde no overlay o que a cópia não levaria (.clurg, .git e o
+ * .clurgignore) com whiteouts (char device 0/0) no upperdir, criados antes
+ * da montagem. Sem regras no .clurgignore só o primeiro nível é olhado, então
+ * o custo não cresce com o repositório. */
+static int hide_ignored(const char *lower, const char *upper, const char *rel,
+                        const ignore_t *ignore, int deep) {
+  DIR *dir;
+  struct dirent *entry;
+  char path[PATH_MAX];
+  char rel_path[PATH_MAX];
+  char out[PATH_MAX];
+  int ret = 0;
+
+  if (snprintf(path, sizeof(path), "%s%s%s", lower, rel[0] ? "/" : "", rel) >=
+      (int)sizeof(path)) {
+    return -1;
+  }
+  dir = opendir(path);
+  if (!dir) {
+    return -1;
+  }
+
+  while ((entry = readdir(dir)) != NULL) {
+    int kind;
+
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
       continue;
     }
 
-    if (S_ISDIR(st.st_mode)) {
-      /* Copiar diretório recursivamente */
-      if (copy_dir_recursive(src_path, dst_path) != 0) {
+    /* Caminho truncado criaria o whiteout no lugar errado: sem overlay, então */
+    if (snprintf(rel_path, sizeof(rel_path), "%s%s%s", rel, rel[0] ? "/" : "", entry->d_name) >=
+            (int)sizeof(rel_path) ||
+        snprintf(out, sizeof(out), "%s/%s", upper, rel_path) >= (int)sizeof(out)) {
+      ret = -1;
+      break;
+    }
+
+    kind = entry_kind(dirfd(dir), entry);
+    if (should_ignore(entry->d_name) || ignore_match(ignore, rel_path, kind == 1)) {
+      if (mknod(out, S_IFCHR, makedev(0, 0)) != 0) {
         ret = -1;
         break;
       }
-    } else if (S_ISREG(st.st_mode)) {
-      /* Copiar arquivo regular */
-      if (copy_file(src_path, dst_path) != 0) {
+    } else if (deep && kind == 1) {
+      struct stat st;
+      mode_t mode = fstatat(dirfd(dir), entry->d_name, &st, 0) == 0 ? st.st_mode & 07777 : 0755;
+
+      /* diretório no upper sem marca de opaco: o conteúdo do lower continua visível */
+      if ((mkdir(out, mode) != 0 && errno != EEXIST) ||
+          hide_ignored(lower, upper, rel_path, ignore, deep) != 0) {
         ret = -1;
         break;
       }
-      /* Copiar permissões */
-      chmod(dst_path, st.st_mode);
     }
-    /* Ignorar outros tipos (symlinks, etc) */
   }
 
   closedir(dir);
   return ret;
 }
 
+/* Roda no processo que vai segurar os namespaces: cria-os e monta o overlay.
+ * Retorna 'u' (com user namespace), 'n' (só mount namespace) ou 0 em erro. */
+static char overlay_mount(const char *workspace_path, const char *repo_path, const char *base,
+                          const ignore_t *ignore, uid_t uid, gid_t gid) {
+  char opts[3 * PATH_MAX + 64];
+  char upper[PATH_MAX], work[PATH_MAX];
+  char map[64];
+  char kind = 'n';
+
+  if (geteuid() == 0) {
+    if (unshare(CLONE_NEWNS) != 0) {
+      return 0;
+    }
+  } else {
+    if (unshare(CLONE_NEWUSER | CLONE_NEWNS) != 0) {
+      return 0;
+    }
+    /* Mapear o usuário atual para root dentro do namespace */
+    snprintf(map, sizeof(map), "0 %u 1", (unsigned)uid);
+    if (write_proc("/proc/self/setgroups", "deny") != 0 ||
+        write_proc("/proc/self/uid_map", map) != 0) {
+      return 0;
+    }
+    snprintf(map, sizeof(map), "0 %u 1", (unsigned)gid);
+    if (write_proc("/proc/self/gid_map", map) != 0) {
+      return 0;
+    }
+    kind = 'u';
+  }
+
+  /* Montagens feitas aqui não propagam para fora */
+  mount(NULL, "/", NULL, MS_REC | MS_PRIVATE, NULL);
+
+  if (snprintf(upper, sizeof(upper), "%s/upper", base) >= (int)sizeof(upper) ||
+      snprintf(work, sizeof(work), "%s/work", base) >= (int)sizeof(work)) {
+    return 0;
+  }
+  if (hide_ignored(repo_path, upper, "", ignore, ignore_rule_count(ignore) > 0) != 0) {
+    return 0;
+  }
+
+  if (snprintf(opts, sizeof(opts), "lowerdir=%s,upperdir=%s,workdir=%s", repo_path, upper,
+               work) >= (int)sizeof(opts)) {
+    return 0;
+  }
+  if (mount("overlay", workspace_path, "overlay", 0, opts) != 0) {
+    return 0;
+  }
+
+  return kind;
+}
+
+static void remove_overlay_dirs(const char *base) {
+  char cmd[2 * PATH_MAX + 64];
+
+  /* o workdir do overlay pode ficar sem permissão de leitura; um comando
+   * truncado poderia apagar outro diretório */
+  if (snprintf(cmd, sizeof(cmd), "chmod -R u+rwX %s 2>/dev/null; rm -rf %s", base, base) >=
+          (int)sizeof(cmd) ||
+      system(cmd) != 0) {
+    fprintf(stderr, "falha ao limpar workspace: %s\n", base);
+  }
+}
+
+/* O overlay só existe no mount namespace de um processo filho que fica
+ * bloqueado lendo um pipe; os steps entram nele via workspace_enter(). */
+static int setup_overlay(const char *workspace_path, const char *repo_path, const ignore_t *ignore) {
+  char base[PATH_MAX];
+  char sub[PATH_MAX];
+  const char *subdirs[] = {"", "/upper", "/work"};
+  int ready[2], hold[2];
+  char kind = 0;
+  uid_t uid = getuid();
+  gid_t gid = getgid();
+  pid_t pid;
+  size_t i;
+
+  /* vírgula e dois-pontos separam as opções do overlay */
+  if (strpbrk(repo_path, ",:") || strpbrk(workspace_path, ",:")) {
+    return -1;
+  }
+
+  snprintf(base, sizeof(base), "%s.ovl", workspace_path);
+  for (i = 0; i < sizeof(subdirs) / sizeof(subdirs[0]); i++) {
+    snprintf(sub, sizeof(sub), "%s%s", base, subdirs[i]);
+    if (mkdir(sub, 0700) != 0) {
+      remove_overlay_dirs(base);
+      return -1;
+    }
+  }
+
+  if (pipe2(ready, O_CLOEXEC) != 0) {
+    remove_overlay_dirs(base);
+    return -1;
+  }
+  if (pipe2(hold, O_CLOEXEC) != 0) {
+    close(ready[0]);
+    close(ready[1]);
+    remove_overlay_dirs(base);
+    return -1;
+  }
+
+  fflush(stdout);
+  fflush(stderr);
+
+  pid = fork();
+  if (pid == 0) {
+    char c;
+
+    close(ready[0]);
+    close(hold[1]);
+    kind = overlay_mount(workspace_path, repo_path, base, ignore, uid, gid);
+    if (write(ready[1], &kind, 1) != 1 || kind == 0) {
+      _exit(1);
+    }
+    close(ready[1]);
+
+    /* Segurar os namespaces até o pai fechar o pipe (ou morrer) */
+    while (read(hold[0], &c, 1) < 0 && errno == EINTR) {
+    }
+    _exit(0);
+  }
+
+  close(ready[1]);
+  close(hold[0]);
+
+  if (pid < 0 || read(ready[0], &kind, 1) != 1 || kind == 0) {
+    close(ready[0]);
+    close(hold[1]);
+    if (pid > 0) {
+      waitpid(pid, NULL, 0);
+    }
+    remove_overlay_dirs(base);
+    return -1;
+  }
+  close(ready[0]);
+
+  snprintf(current.path, sizeof(current.path), "%s", workspace_path);
+  current.holder = pid;
+  current.hold_fd = hold[1];
+  current.userns = kind == 'u';
+  return 0;
+}
+
+int workspace_enter(const char *workspace_path) {
+  static const struct {
+    const char *name;
+    int type;
+  } ns[] = {{"user", CLONE_NEWUSER}, {"mnt", CLONE_NEWNS}};
+  char path[64];
+  size_t i;
+
+  if (current.holder <= 0 || !workspace_path || strcmp(workspace_path, current.path) != 0) {
+    return 0;
+  }
+
+  for (i = current.userns ? 0 : 1; i < sizeof(ns) / sizeof(ns[0]); i++) {
+    int fd;
+
+    snprintf(path, sizeof(path), "/proc/%d/ns/%s", (int)current.holder, ns[i].name);
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0 || setns(fd, ns[i].type) != 0) {
+      perror("setns workspace");
+      if (fd >= 0) {
+        close(fd);
+      }
+      return -1;
+    }
+    close(fd);
+  }
+
+  return 0;
+}
+
+/*
+ * Pool de workspaces quentes: <repo>/.clurg/ci/workspaces/<pipeline>/<n>,
+ * com n < CLURG_CI_POOL_SIZE (padrão 2). Cada slot tem um <n>.lock (flock,
+ * para execuções simultâneas pegarem slots diferentes) e um <n>.manifest com
+ * uma linha por arquivo sincronizado:
+ *
+ *   <tamanho> <mtime ns> <modo> <tamanho no ws> <mtime ns no ws> <caminho>
+ *
+ * A sincronização compara o stat do repositório e o do workspace com o
+ * manifesto (como o quick check do rsync) e só regrava o que difere dos dois
+ * lados; arquivos que saíram do repositório (ou passaram a ser ignorados) são
+ * apagados. O que não está no manifesto, como as saídas do build, fica.
+ * O .clurg/index não serve no lugar dele: só conhece o lado do repositório, e
+ * o slot precisa lembrar também o stat de cada cópia no workspace, que os
+ * steps podem ter alterado entre uma execução e outra.
+ */
+
+typedef struct {
+  char *path;
+  int64_t size, mtime;
+  uint32_t mode;
+  int64_t ws_size, ws_mtime;
+  int seen;
+} warm_entry_t;
+
+typedef struct {
+  warm_entry_t *items;
+  size_t count, cap;
+} warm_manifest_t;
+
+typedef struct {
+  int src_root, dst_root;
+  const ignore_t *ignore;
+  const warm_manifest_t *old;
+  warm_manifest_t fresh;
+  uint64_t copied, unchanged, removed;
+} warm_sync_t;
+
+static int64_t stat_mtime_ns(const struct stat *st) {
+  return (int64_t)st->st_mtim.tv_sec * 1000000000 + st->st_mtim.tv_nsec;
+}
+
+static int compare_entries(const void *a, const void *b) {
+  return strcmp(((const warm_entry_t *)a)->path, ((const warm_entry_t *)b)->path);
+}
+
+static warm_entry_t *manifest_add(warm_manifest_t *m, const char *path) {
+  warm_entry_t *e;
+
+  if (m->count == m->cap) {
+    size_t cap = m->cap ? m->cap * 2 : 256;
+    warm_entry_t *items = realloc(m->items, cap * sizeof(*items));
+    if (!items) {
+      return NULL;
+    }
+    m->items = items;
+    m->cap = cap;
+  }
+  e = &m->items[m->count];
+  memset(e, 0, sizeof(*e));
+  e->path = strdup(path);
+  if (!e->path) {
+    return NULL;
+  }
+  m->count++;
+  return e;
+}
+
+static void manifest_free(warm_manifest_t *m) {
+  size_t i;
+
+  for (i = 0; i < m->count; i++) {
+    free(m->items[i].path);
+  }
+  free(m->items);
+  memset(m, 0, sizeof(*m));
+}
+
+/* Manifesto ausente ou ilegível = slot frio: tudo é copiado */
+static void manifest_load(const char *file, warm_manifest_t *m) {
+  char line[PATH_MAX + 128];
+  FILE *f = fopen(file, "r");
+
+  if (!f) {
+    return;
+  }
+  while (fgets(line, sizeof(line), f)) {
+    long long size, mtime, ws_size, ws_mtime;
+    unsigned mode;
+    int off = 0;
+    size_t len = strlen(line);
+    warm_entry_t *e;
+
+    if (len == 0 || line[len - 1] != '\n') {
+      break;
+    }
+    line[len - 1] = '\0';
+    if (sscanf(line, "%lld %lld %o %lld %lld %n", &size, &mtime, &mode, &ws_size, &ws_mtime,
+               &off) != 5 ||
+        off == 0 || !line[off]) {
+      break;
+    }
+    e = manifest_add(m, line + off);
+    if (!e) {
+      break;
+    }
+    e->size = size;
+    e->mtime = mtime;
+    e->mode = mode;
+    e->ws_size = ws_size;
+    e->ws_mtime = ws_mtime;
+  }
+  fclose(f);
+  qsort(m->items, m->count, sizeof(*m->items), compare_entries);
+}
+
+static int manifest_save(const char *file, warm_manifest_t *m) {
+  char tmp[PATH_MAX + 8];
+  FILE *f;
+  size_t i;
+
+  snprintf(tmp, sizeof(tmp), "%s.tmp", file);
+  f = fopen(tmp, "w");
+  if (!f) {
+    perror("fopen manifest");
+    return -1;
+  }
+  qsort(m->items, m->count, sizeof(*m->items), compare_entries);
+  for (i = 0; i < m->count; i++) {
+    const warm_entry_t *e = &m->items[i];
+    fprintf(f, "%lld %lld %o %lld %lld %s\n", (long long)e->size, (long long)e->mtime,
+            (unsigned)e->mode, (long long)e->ws_size, (long long)e->ws_mtime, e->path);
+  }
+  if (fclose(f) != 0 || rename(tmp, file) != 0) {
+    perror("manifest");
+    unlink(tmp);
+    return -1;
+  }
+  return 0;
+}
+
+static warm_entry_t *manifest_find(const warm_manifest_t *m, const char *path) {
+  warm_entry_t key;
+
+  key.path = (char *)path;
+  return m->count ? bsearch(&key, m->items, m->count, sizeof(*m->items), compare_entries) : NULL;
+}
+
+static int remove_tree_cb(const char *path, const struct stat *st, int flag, struct FTW *ftw) {
+  (void)st;
+  (void)ftw;
+  return flag == FTW_DP ? rmdir(path) : unlink(path);
+}
+
+/* Abre `rel` no workspace como diretório, trocando o que estiver no caminho */
+static int warm_open_dir(warm_sync_t *w, const char *rel) {
+  const char *at = rel[0] ? rel : ".";
+  struct stat st;
+  int fd;
+
+  if (rel[0] && fstatat(w->dst_root, rel, &st, AT_SYMLINK_NOFOLLOW) == 0 && !S_ISDIR(st.st_mode)) {
+    unlinkat(w->dst_root, rel, 0);
+  }
+  if (rel[0] && mkdirat(w->dst_root, rel, 0755) != 0 && errno != EEXIST) {
+    perror("mkdir workspace");
+    return -1;
+  }
+  fd = openat(w->dst_root, at, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd < 0) {
+    perror("open workspace");
+  }
+  return fd;
+}
+
+static int warm_sync_file(warm_sync_t *w, int src_dir, int dst_dir, const char *name,
+                          const char *rel) {
+  struct stat src_st, dst_st;
+  warm_entry_t *old = manifest_find(w->old, rel);
+  warm_entry_t *e;
+  char tmp[NAME_MAX + 32];
+  int src, dst;
+  int ret = 0;
+
+  if (fstatat(src_dir, name, &src_st, 0) != 0) {
+    return 0; /* sumiu durante a varredura */
+  }
+  if (old) {
+    old->seen = 1;
+  }
+
+  e = manifest_add(&w->fresh, rel);
+  if (!e) {
+    return -1;
+  }
+  e->size = src_st.st_size;
+  e->mtime = stat_mtime_ns(&src_st);
+  e->mode = src_st.st_mode & 07777;
+
+  /* Quick check: o repositório e a cópia no workspace estão como da última vez */
+  if (old && old->size == e->size && old->mtime == e->mtime && old->mode == e->mode &&
+      fstatat(dst_dir, name, &dst_st, AT_SYMLINK_NOFOLLOW) == 0 && S_ISREG(dst_st.st_mode) &&
+      dst_st.st_size == old->ws_size && stat_mtime_ns(&dst_st) == old->ws_mtime) {
+    e->ws_size = old->ws_size;
+    e->ws_mtime = old->ws_mtime;
+    w->unchanged++;
+    return 0;
+  }
+
+  /* Temporário + rename: o mtime novo (agora) é mais recente que as saídas
+   * do build, então o make recompila o que depende do arquivo */
+  snprintf(tmp, sizeof(tmp), ".clurg-sync-%d", (int)getpid());
+  src = openat(src_dir, name, O_RDONLY | O_CLOEXEC);
+  if (src < 0) {
+    perror("open src");
+    return -1;
+  }
+  dst = openat(dst_dir, tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+  if (dst < 0) {
+    perror("open dst");
+    close(src);
+    return -1;
+  }
+  if (copy_fd(src, dst, src_st.st_size) != 0 || fchmod(dst, e->mode) != 0 ||
+      fstat(dst, &dst_st) != 0) {
+    ret = -1;
+  }
+  close(src);
+  if (close(dst) != 0) {
+    ret = -1;
+  }
+
+  if (ret == 0) {
+    if (fstatat(dst_dir, name, &src_st, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(src_st.st_mode)) {
+      char path[PATH_MAX];
+      snprintf(path, sizeof(path), "/proc/self/fd/%d/%s", dst_dir, name);
+      nftw(path, remove_tree_cb, 16, FTW_DEPTH | FTW_PHYS);
+    }
+    if (renameat(dst_dir, tmp, dst_dir, name) != 0) {
+      perror("rename workspace");
+      ret = -1;
+    }
+  }
+  if (ret != 0) {
+    unlinkat(dst_dir, tmp, 0);
+    return -1;
+  }
+
+  e->ws_size = dst_st.st_size;
+  e->ws_mtime = stat_mtime_ns(&dst_st);
+  w->copied++;
+  return 0;
+}
+
+static int warm_sync_dir(warm_sync_t *w, const char *rel) {
+  const char *at = rel[0] ? rel : ".";
+  char rel_path[PATH_MAX];
+  struct dirent *entry;
+  int src_fd, dst_fd;
+  DIR *dir;
+  int ret = 0;
+
+  src_fd = openat(w->src_root, at, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (src_fd < 0) {
+    perror("opendir");
+    return -1;
+  }
+  dst_fd = warm_open_dir(w, rel);
+  if (dst_fd < 0) {
+    close(src_fd);
+    return -1;
+  }
+  dir = fdopendir(src_fd);
+  if (!dir) {
+    close(src_fd);
+    close(dst_fd);
+    return -1;
+  }
+
+  while (ret == 0 && (entry = readdir(dir)) != NULL) {
+    int kind;
+
+    if (should_ignore(entry->d_name)) {
+      continue;
+    }
+    kind = entry_kind(src_fd, entry);
+    if (kind < 0 ||
+        snprintf(rel_path, sizeof(rel_path), "%s%s%s", rel, rel[0] ? "/" : "", entry->d_name) >=
+            (int)sizeof(rel_path) ||
+        strchr(entry->d_name, '\n')) {
+      continue;
+    }
+    if (ignore_match(w->ignore, rel_path, kind == 1)) {
+      continue;
+    }
+
+    if (kind == 1) {
+      ret = warm_sync_dir(w, rel_path);
+    } else {
+      ret = warm_sync_file(w, src_fd, dst_fd, entry->d_name, rel_path);
+    }
+  }
+
+  closedir(dir);
+  close(dst_fd);
+  return ret;
+}
+
+/* Apaga do workspace o que foi sincronizado antes e não existe mais no
+ * repositório, e os diretórios que ficarem vazios por isso */
+static void warm_remove_stale(warm_sync_t *w) {
+  char dir[PATH_MAX];
+  size_t i;
+
+  for (i = 0; i < w->old->count; i++) {
+    const warm_entry_t *e = &w->old->items[i];
+    char *slash;
+
+    if (e->seen) {
+      continue;
+    }
+    if (unlinkat(w->dst_root, e->path, 0) == 0) {
+      w->removed++;
+    }
+    snprintf(dir, sizeof(dir), "%s", e->path);
+    while ((slash = strrchr(dir, '/')) != NULL) {
+      *slash = '\0';
+      if (unlinkat(w->dst_root, dir, AT_REMOVEDIR) != 0) {
+        break;
+      }
+    }
+  }
+}
+
+static int warm_sync(const char *workspace_path, const char *repo_path, const ignore_t *ignore) {
+  warm_manifest_t old = {0};
+  warm_sync_t w;
+  int ret;
+
+  memset(&w, 0, sizeof(w));
+  manifest_load(current.warm_manifest, &old);
+  w.ignore = ignore;
+  w.old = &old;
+  w.src_root = open(repo_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  w.dst_root = open(workspace_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+  ret = w.src_root >= 0 && w.dst_root >= 0 ? warm_sync_dir(&w, "") : -1;
+  if (ret == 0) {
+    warm_remove_stale(&w);
+    ret = manifest_save(current.warm_manifest, &w.fresh);
+    printf("Workspace sincronizado: %llu copiados, %llu inalterados, %llu removidos\n",
+           (unsigned long long)w.copied, (unsigned long long)w.unchanged,
+           (unsigned long long)w.removed);
+  } else {
+    /* Sincronização pela metade: o próximo uso compara tudo de novo */
+    unlink(current.warm_manifest);
+  }
+
+  if (w.src_root >= 0) {
+    close(w.src_root);
+  }
+  if (w.dst_root >= 0) {
+    close(w.dst_root);
+  }
+  manifest_free(&old);
+  manifest_free(&w.fresh);
+  current.files_copied = w.copied;
+  return ret;
+}
+
+/* mkdir -p */
+static int make_dirs(const char *path) {
+  char tmp[PATH_MAX];
+  char *p;
+
+  snprintf(tmp, sizeof(tmp), "%s", path);
+  for (p = tmp + 1; *p; p++) {
+    if (*p == '/') {
+      *p = '\0';
+      if (mkdir(tmp, 0755) != 0 && errno != EEXIST) {
+        return -1;
+      }
+      *p = '/';
+    }
+  }
+  return mkdir(tmp, 0755) != 0 && errno != EEXIST ? -1 : 0;
+}
+
+static int warm_acquire(const char *repo_root, const char *pipeline_name, char *workspace_path,
+                        size_t path_size) {
+  const char *env = getenv("CLURG_CI_POOL_SIZE");
+  long slots = env && *env ? strtol(env, NULL, 10) : 2;
+  char pool[PATH_MAX];
+  char name[NAME_MAX + 1];
+  char file[PATH_MAX + 32];
+  size_t i;
+  long n;
+
+  /* Nome do pipeline vira nome de diretório */
+  for (i = 0; pipeline_name[i] && i < sizeof(name) - 1; i++) {
+    char c = pipeline_name[i];
+    name[i] = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+                      c == '-' || c == '_' || c == '.'
+                  ? c
+                  : '_';
+  }
+  name[i] = '\0';
+  if (!name[0] || strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
+    snprintf(name, sizeof(name), "default");
+  }
+
+  if (snprintf(pool, sizeof(pool), "%s/.clurg/ci/workspaces/%s", repo_root, name) >=
+      (int)sizeof(pool)) {
+    return -1;
+  }
+  if (make_dirs(pool) != 0) {
+    perror("mkdir pool");
+    return -1;
+  }
+
+  for (n = 0; n < (slots > 0 ? slots : 1); n++) {
+    int fd;
+
+    if (snprintf(file, sizeof(file), "%s/%ld.lock", pool, n) >= (int)sizeof(file)) {
+      return -1;
+    }
+    fd = open(file, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+      continue;
+    }
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+      close(fd);
+      continue; /* outra execução está usando este slot */
+    }
+
+    if ((size_t)snprintf(workspace_path, path_size, "%s/%ld", pool, n) >= path_size ||
+        snprintf(current.warm_manifest, sizeof(current.warm_manifest), "%s/%ld.manifest", pool,
+                 n) >= (int)sizeof(current.warm_manifest) ||
+        (mkdir(workspace_path, 0755) != 0 && errno != EEXIST)) {
+      close(fd);
+      return -1;
+    }
+    snprintf(current.path, sizeof(current.path), "%s", workspace_path);
+    current.warm_lock_fd = fd;
+    return 0;
+  }
+
+  return -1;
+}
+
+int workspace_open(const char *repo_root, const char *pipeline_name, char *workspace_path,
+                   size_t path_size) {
+  if (repo_root && strategy_from_env() == WORKSPACE_WARM) {
+    if (warm_acquire(repo_root, pipeline_name, workspace_path, path_size) == 0) {
+      return 0;
+    }
+    fprintf(stderr, "aviso: nenhum workspace quente livre, usando um temporário\n");
+  }
+  return workspace_create(workspace_path, path_size);
+}
+
 int workspace_setup(const char *workspace_path, const char *repo_path) {
   char abs_repo_path[PATH_MAX];
   char *real_repo_path;
+  ignore_t *ignore;
+  workspace_strategy_t mode = strategy_from_env();
+  double t0 = now_ms();
+  int ret;
 
   /* Verificar se o diretório existe */
   struct stat st;
@@ -144,8 +1195,47 @@ int workspace_setup(const char *workspace_path, const char *repo_path) {
     return -1;
   }
 
-  /* Copiar conteúdo do repo para o workspace */
-  if (copy_dir_recursive(abs_repo_path, workspace_path) != 0) {
+  ignore = ignore_load(abs_repo_path);
+  if (!ignore) {
+    return -1;
+  }
+
+  current.files_cloned = current.files_linked = current.files_copied = 0;
+
+  if (current.warm_lock_fd >= 0 && strcmp(workspace_path, current.path) == 0) {
+    ret = warm_sync(workspace_path, abs_repo_path, ignore);
+    ignore_free(ignore);
+    current.used = WORKSPACE_WARM;
+    current.setup_ms = now_ms() - t0;
+    if (ret != 0) {
+      fprintf(stderr, "erro ao sincronizar workspace\n");
+      return -1;
+    }
+    return 0;
+  }
+  if (mode == WORKSPACE_WARM) {
+    mode = WORKSPACE_AUTO; /* sem slot livre: workspace temporário */
+  }
+
+  if (mode == WORKSPACE_AUTO || mode == WORKSPACE_OVERLAY) {
+    if (setup_overlay(workspace_path, abs_repo_path, ignore) == 0) {
+      current.used = WORKSPACE_OVERLAY;
+      current.setup_ms = now_ms() - t0;
+      ignore_free(ignore);
+      return 0;
+    }
+    if (mode == WORKSPACE_OVERLAY) {
+      fprintf(stderr, "aviso: overlay indisponível, usando reflink/cópia\n");
+    }
+    mode = WORKSPACE_REFLINK;
+  }
+
+  /* Replicar o repo no workspace, sem o que o .clurgignore exclui */
+  ret = copy_tree(abs_repo_path, workspace_path, ignore, &mode);
+  ignore_free(ignore);
+  current.used = mode;
+  current.setup_ms = now_ms() - t0;
+  if (ret != 0) {
     fprintf(stderr, "erro ao copiar estado do repo para workspace\n");
     return -1;
   }
@@ -157,6 +1247,26 @@ int workspace_cleanup(const char *workspace_path) {
   char cmd[1024];
   int ret;
 
+  /* Workspace quente fica como está para a próxima execução */
+  if (current.warm_lock_fd >= 0 && strcmp(workspace_path, current.path) == 0) {
+    close(current.warm_lock_fd);
+    current.warm_lock_fd = -1;
+    current.path[0] = '\0';
+    return 0;
+  }
+
+  /* Derrubar o overlay: sem o processo que segura o namespace, a montagem some */
+  if (current.holder > 0 && strcmp(workspace_path, current.path) == 0) {
+    char base[PATH_MAX];
+
+    close(current.hold_fd);
+    waitpid(current.holder, NULL, 0);
+    current.holder = -1;
+    current.hold_fd = -1;
+    snprintf(base, sizeof(base), "%s.ovl", workspace_path);
+    remove_overlay_dirs(base);
+  }
+
   /* Remover diretório temporário recursivamente */
   if (snprintf(cmd, sizeof(cmd), "rm -rf %s", workspace_path) >= (int)sizeof(cmd)) {
     fprintf(stderr, "workspace_path muito longo\n");
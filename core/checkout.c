@@ -0,0 +1,459 @@
+#define _GNU_SOURCE
+#include "checkout.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "commit.h"
+#include "index.h"
+#include "objects.h"
+#include "threadpool.h"
+
+#define CHECKOUT_HASH_BATCH 64  /* arquivos por tarefa de hash */
+#define CHECKOUT_WRITE_BATCH 16 /* arquivos por tarefa de escrita */
+#define CHECKOUT_MIN_PARALLEL 16
+
+typedef enum { ACT_KEEP, ACT_WRITE, ACT_CHMOD, ACT_DELETE } checkout_action_t;
+
+/* Um caminho presente no HEAD, no alvo ou nos dois */
+typedef struct {
+  const char *path;
+  const index_entry_t *target; /* NULL: não existe no alvo */
+  const index_entry_t *head;   /* NULL: não existe no HEAD */
+  struct stat st;
+  int exists;     /* arquivo/symlink presente na árvore de trabalho */
+  int hash_ok;    /* `current` válido */
+  uint8_t current[SHA256_DIGEST_SIZE];
+  checkout_action_t action;
+  int conflict;
+  int failed;
+} checkout_item_t;
+
+typedef struct {
+  checkout_item_t **items;
+  size_t count;
+} checkout_batch_t;
+
+static int same_type(const struct stat *st, uint32_t mode) {
+  return S_ISLNK(st->st_mode) == S_ISLNK(mode);
+}
+
+static int same_exec(const struct stat *st, uint32_t mode) {
+  return S_ISLNK(st->st_mode) || ((st->st_mode & 0111) != 0) == ((mode & 0111) != 0);
+}
+
+static void hash_batch(void *arg) {
+  checkout_batch_t *batch = arg;
+  const char *paths[CHECKOUT_HASH_BATCH];
+  uint8_t digests[CHECKOUT_HASH_BATCH][SHA256_DIGEST_SIZE];
+  int results[CHECKOUT_HASH_BATCH];
+  size_t files = 0;
+  size_t i;
+
+  for (i = 0; i < batch->count; i++) {
+    checkout_item_t *item = batch->items[i];
+
+    if (S_ISLNK(item->st.st_mode)) {
+      char target[PATH_MAX];
+      ssize_t n = readlink(item->path, target, sizeof(target));
+      if (n >= 0) {
+        sha256_buffer(target, (size_t)n, item->current);
+        item->hash_ok = 1;
+      }
+    } else {
+      paths[files++] = item->path;
+    }
+  }
+
+  sha256_files(paths, files, digests, results);
+
+  files = 0;
+  for (i = 0; i < batch->count; i++) {
+    checkout_item_t *item = batch->items[i];
+
+    if (S_ISLNK(item->st.st_mode)) continue;
+    if (results[files] == 0) {
+      memcpy(item->current, digests[files], SHA256_DIGEST_SIZE);
+      item->hash_ok = 1;
+    }
+    files++;
+  }
+}
+
+/* Grava em <caminho>.clurg-tmp e renomeia: um arquivo nunca fica pela metade */
+static int write_item(checkout_item_t *item) {
+  const index_entry_t *target = item->target;
+  char hex[SHA256_HEX_SIZE];
+  char tmp_path[PATH_MAX];
+
+  sha256_to_hex(target->hash, hex);
+  if (snprintf(tmp_path, sizeof(tmp_path), "%s.clurg-tmp", item->path) >= (int)sizeof(tmp_path)) {
+    fprintf(stderr, "caminho muito longo: %s\n", item->path);
+    return -1;
+  }
+  unlink(tmp_path);
+
+  if (S_ISLNK(target->mode)) {
+    unsigned char *link_target;
+    size_t len;
+    obj_type_t type;
+    int ret;
+
+    if (objects_read(hex, &type, &link_target, &len) != 0) return -1;
+    ret = symlink((const char *)link_target, tmp_path);
+    free(link_target);
+    if (ret != 0) {
+      fprintf(stderr, "erro ao criar link %s: %s\n", item->path, strerror(errno));
+      return -1;
+    }
+  } else {
+    mode_t mode = (target->mode & 0111) ? 0755 : 0644;
+    obj_type_t type;
+    uint64_t size;
+    int fd;
+    int ret;
+
+    if (objects_read_header(hex, &type, &size) != 0) return -1;
+    fd = open(tmp_path, O_WRONLY | O_CREAT | O_EXCL, mode);
+    if (fd < 0) {
+      fprintf(stderr, "erro ao criar %s: %s\n", tmp_path, strerror(errno));
+      return -1;
+    }
+    /* Reservar o espaço de uma vez evita fragmentação e falha no meio da escrita */
+    if (size > 0) {
+      int err = posix_fallocate(fd, 0, (off_t)size);
+      if (err == ENOSPC) {
+        fprintf(stderr, "erro: sem espaço para %s\n", item->path);
+        close(fd);
+        unlink(tmp_path);
+        return -1;
+      }
+    }
+    ret = objects_read_to_fd(hex, fd);
+    if (ret == 0) ret = fchmod(fd, mode);
+    if (close(fd) != 0) ret = -1;
+    if (ret != 0) {
+      fprintf(stderr, "erro ao gravar %s\n", item->path);
+      unlink(tmp_path);
+      return -1;
+    }
+  }
+
+  if (rename(tmp_path, item->path) != 0) {
+    fprintf(stderr, "erro ao gravar %s: %s\n", item->path, strerror(errno));
+    unlink(tmp_path);
+    return -1;
+  }
+  return 0;
+}
+
+static void write_batch(void *arg) {
+  checkout_batch_t *batch = arg;
+  size_t i;
+
+  for (i = 0; i < batch->count; i++) {
+    batch->items[i]->failed = write_item(batch->items[i]) != 0;
+  }
+}
+
+/* Divide `items` em lotes de `per_batch` e roda `fn` no pool (ou direto, sem pool) */
+static void run_batches(threadpool_t *pool, checkout_item_t **items, size_t count,
+                        size_t per_batch, threadpool_fn fn) {
+  size_t batches = (count + per_batch - 1) / per_batch;
+  checkout_batch_t *list;
+  size_t i;
+
+  if (count == 0) return;
+  list = calloc(batches, sizeof(*list));
+  for (i = 0; i < batches; i++) {
+    checkout_batch_t one;
+    checkout_batch_t *batch = list ? &list[i] : &one;
+
+    batch->items = items + i * per_batch;
+    batch->count = (i + 1 < batches) ? per_batch : count - i * per_batch;
+    if (!pool || !list || threadpool_submit(pool, fn, batch) != 0) fn(batch);
+  }
+  if (pool) threadpool_wait(pool);
+  free(list);
+}
+
+/* mkdir -p do diretório pai de `path` */
+static int make_parents(const char *path) {
+  char dir[PATH_MAX];
+  char *p;
+
+  snprintf(dir, sizeof(dir), "%s", path);
+  for (p = strchr(dir, '/'); p; p = strchr(p + 1, '/')) {
+    *p = '\0';
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+      fprintf(stderr, "erro ao criar %s: %s\n", dir, strerror(errno));
+      return -1;
+    }
+    *p = '/';
+  }
+  return 0;
+}
+
+/* Remove os diretórios pais que ficaram vazios */
+static void remove_empty_parents(const char *path) {
+  char dir[PATH_MAX];
+  char *slash;
+
+  snprintf(dir, sizeof(dir), "%s", path);
+  while ((slash = strrchr(dir, '/')) != NULL) {
+    *slash = '\0';
+    if (rmdir(dir) != 0) break;
+  }
+}
+
+static int resolve_commit(const char *arg, char *id, size_t size) {
+  if (strcmp(arg, "HEAD") == 0) {
+    if (commit_read_head(id, size) != 0) {
+      fprintf(stderr, "erro: repositório sem commits\n");
+      return -1;
+    }
+    return 0;
+  }
+  snprintf(id, size, "%s", arg);
+  return 0;
+}
+
+/* Novo índice de stat descrevendo a tree do alvo, como depois de um commit */
+static void write_index(const index_t *target, const char *tree_hex) {
+  index_builder_t builder;
+  size_t i;
+
+  index_builder_init(&builder);
+  for (i = 0; i < target->count; i++) {
+    const index_entry_t *entry = &target->entries[i];
+    const char *path = index_entry_path(target, entry);
+    struct stat st;
+
+    if (lstat(path, &st) != 0) continue;
+    if (index_builder_add(&builder, path, &st, entry->hash) != 0) {
+      index_builder_free(&builder);
+      return;
+    }
+  }
+  index_builder_set_tree(&builder, tree_hex);
+  index_builder_write(&builder);
+  index_builder_free(&builder);
+}
+
+int clurg_checkout(int argc, char *argv[]) {
+  const char *target_arg = NULL;
+  char target_id[256];
+  char head_id[256] = "";
+  char target_tree[SHA256_HEX_SIZE];
+  char head_tree[SHA256_HEX_SIZE] = "";
+  index_t target;
+  index_t head;
+  checkout_item_t *items = NULL;
+  checkout_item_t **hash_list = NULL;
+  checkout_item_t **write_list = NULL;
+  size_t item_count = 0;
+  size_t hash_count = 0;
+  size_t write_count = 0;
+  size_t removed = 0;
+  size_t kept = 0;
+  size_t conflicts = 0;
+  size_t ti = 0;
+  size_t hi = 0;
+  size_t i;
+  threadpool_t *pool = NULL;
+  int force = 0;
+  int ret = 1;
+
+  for (i = 0; i < (size_t)argc; i++) {
+    if (strcmp(argv[i], "-f") == 0 || strcmp(argv[i], "--force") == 0) {
+      force = 1;
+    } else if (!target_arg) {
+      target_arg = argv[i];
+    } else {
+      target_arg = NULL;
+      break;
+    }
+  }
+  if (!target_arg) {
+    fprintf(stderr, "uso: clurg checkout [--force] <commit|HEAD>\n");
+    return 1;
+  }
+  if (access(".clurg", F_OK) != 0) {
+    printf("❌ Repositório não inicializado.\n");
+    return 1;
+  }
+
+  if (resolve_commit(target_arg, target_id, sizeof(target_id)) != 0) return 1;
+  if (commit_read_meta_field(target_id, "tree", target_tree, sizeof(target_tree)) != 0) {
+    fprintf(stderr, "erro: commit '%s' não encontrado ou sem tree\n", target_id);
+    return 1;
+  }
+  if (commit_read_head(head_id, sizeof(head_id)) == 0) {
+    commit_read_meta_field(head_id, "tree", head_tree, sizeof(head_tree));
+  }
+
+  if (objects_tree_to_index(target_tree, &target) != 0) {
+    fprintf(stderr, "erro: não foi possível ler a tree %s\n", target_tree);
+    return 1;
+  }
+
+  /* HEAD: o índice de stat quando descreve a tree do HEAD (evita ler arquivos) */
+  index_load(&head);
+  if (head_tree[0] == '\0' || strcmp(head.tree, head_tree) != 0) {
+    index_free(&head);
+    if (head_tree[0] == '\0' || objects_tree_to_index(head_tree, &head) != 0) {
+      memset(&head, 0, sizeof(head));
+    }
+  }
+
+  items = calloc(target.count + head.count + 1, sizeof(*items));
+  hash_list = calloc(target.count + head.count + 1, sizeof(*hash_list));
+  write_list = calloc(target.count + 1, sizeof(*write_list));
+  if (!items || !hash_list || !write_list) {
+    fprintf(stderr, "erro: memória insuficiente\n");
+    goto out;
+  }
+
+  /* Merge das duas listas ordenadas por caminho */
+  while (ti < target.count || hi < head.count) {
+    checkout_item_t *item = &items[item_count++];
+    int cmp;
+
+    if (ti == target.count) {
+      cmp = 1;
+    } else if (hi == head.count) {
+      cmp = -1;
+    } else {
+      cmp = strcmp(index_entry_path(&target, &target.entries[ti]),
+                   index_entry_path(&head, &head.entries[hi]));
+    }
+
+    if (cmp <= 0) {
+      item->target = &target.entries[ti];
+      item->path = index_entry_path(&target, item->target);
+      ti++;
+    }
+    if (cmp >= 0) {
+      item->head = &head.entries[hi];
+      item->path = index_entry_path(&head, item->head);
+      hi++;
+    }
+
+    if (lstat(item->path, &item->st) == 0 && (S_ISREG(item->st.st_mode) || S_ISLNK(item->st.st_mode))) {
+      item->exists = 1;
+      if (item->head && same_type(&item->st, item->head->mode) &&
+          index_entry_is_clean(&head, item->head, &item->st)) {
+        memcpy(item->current, item->head->hash, SHA256_DIGEST_SIZE);
+        item->hash_ok = 1;
+      } else {
+        hash_list[hash_count++] = item;
+      }
+    }
+    /*
+     * Ausente (ou diretório no lugar do arquivo): se o diretório ficar vazio
+     * com as remoções ele some antes da escrita; senão o rename falha.
+     */
+  }
+
+  if (hash_count + target.count >= CHECKOUT_MIN_PARALLEL) pool = threadpool_create(0);
+  run_batches(pool, hash_list, hash_count, CHECKOUT_HASH_BATCH, hash_batch);
+
+  for (i = 0; i < item_count; i++) {
+    checkout_item_t *item = &items[i];
+    int matches_head = item->head && item->exists && item->hash_ok &&
+                       same_type(&item->st, item->head->mode) &&
+                       memcmp(item->current, item->head->hash, SHA256_DIGEST_SIZE) == 0;
+
+    if (!item->exists) {
+      item->action = item->target ? ACT_WRITE : ACT_KEEP;
+    } else if (item->target && item->hash_ok && same_type(&item->st, item->target->mode) &&
+               memcmp(item->current, item->target->hash, SHA256_DIGEST_SIZE) == 0) {
+      item->action = same_exec(&item->st, item->target->mode) ? ACT_KEEP : ACT_CHMOD;
+    } else {
+      /* Conteúdo difere do alvo: só pode ser substituído se não tiver alterações locais */
+      item->action = item->target ? ACT_WRITE : ACT_DELETE;
+      if (!matches_head) item->conflict = 1;
+    }
+
+    if (item->conflict) conflicts++;
+  }
+
+  if (conflicts > 0 && !force) {
+    fprintf(stderr, "erro: alterações locais seriam sobrescritas pelo checkout:\n");
+    for (i = 0; i < item_count; i++) {
+      if (items[i].conflict) fprintf(stderr, "  %s\n", items[i].path);
+    }
+    fprintf(stderr, "Faça commit das alterações ou use --force para descartá-las.\n");
+    goto out;
+  }
+
+  /* Remoções primeiro: um arquivo pode dar lugar a um diretório */
+  for (i = 0; i < item_count; i++) {
+    checkout_item_t *item = &items[i];
+
+    if (item->action == ACT_DELETE || (item->conflict && !item->target)) {
+      if (unlink(item->path) != 0 && errno != ENOENT) {
+        fprintf(stderr, "erro ao remover %s: %s\n", item->path, strerror(errno));
+        goto out;
+      }
+      remove_empty_parents(item->path);
+      removed++;
+    }
+  }
+
+  for (i = 0; i < item_count; i++) {
+    checkout_item_t *item = &items[i];
+
+    if (!item->target) continue;
+    if (item->action == ACT_KEEP && !item->conflict) {
+      kept++;
+    } else if (item->action == ACT_CHMOD && !item->conflict) {
+      if (chmod(item->path, (item->target->mode & 0111) ? 0755 : 0644) != 0) {
+        fprintf(stderr, "erro ao ajustar modo de %s: %s\n", item->path, strerror(errno));
+        goto out;
+      }
+      kept++;
+    } else {
+      if (make_parents(item->path) != 0) goto out;
+      write_list[write_count++] = item;
+    }
+  }
+
+  run_batches(pool, write_list, write_count, CHECKOUT_WRITE_BATCH, write_batch);
+  for (i = 0; i < write_count; i++) {
+    if (write_list[i]->failed) {
+      fprintf(stderr, "erro: checkout incompleto, HEAD não foi alterado\n");
+      goto out;
+    }
+  }
+
+  /* HEAD anterior que o alvo não contém: guardar a ponta antes de sair dela */
+  if (head_id[0] && !commit_is_ancestor(head_id, target_id)) {
+    if (commit_record_tip(head_id) == 0) {
+      printf("📌 HEAD anterior %s guardado em %s\n", head_id, TIPS_FILE);
+    } else {
+      fprintf(stderr, "aviso: HEAD anterior %s não foi guardado\n", head_id);
+    }
+  }
+  if (commit_update_head(target_id) != 0) goto out;
+  write_index(&target, target_tree);
+
+  printf("✅ Checkout de %s: %zu gravados, %zu removidos, %zu inalterados (%d threads)\n",
+         target_id, write_count, removed, kept, pool ? threadpool_size(pool) : 1);
+  ret = 0;
+
+out:
+  if (pool) threadpool_destroy(pool);
+  free(items);
+  free(hash_list);
+  free(write_list);
+  index_free(&target);
+  index_free(&head);
+  return ret;
+}
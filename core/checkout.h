@@ -0,0 +1,14 @@
+#ifndef CLURG_CHECKOUT_H
+#define CLURG_CHECKOUT_H
+
+/*
+ * clurg checkout [--force] <commit|HEAD>
+ *
+ * Leva a árvore de trabalho para a tree do commit e move o HEAD. Só arquivos
+ * cujo conteúdo difere são gravados (em paralelo); os iguais não são tocados.
+ * Alterações locais que seriam perdidas abortam a operação, a menos que
+ * --force seja passado.
+ */
+int clurg_checkout(int argc, char *argv[]);
+
+#endif
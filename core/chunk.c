@@ -0,0 +1,50 @@
+#include "chunk.h"
+
+#include <pthread.h>
+#include <stdint.h>
+
+/* Bits altos testados: 2 a mais que log2(média) antes dela, 2 a menos depois */
+#define CHUNK_AVG_BITS 16
+#define CHUNK_MASK_S (((1ULL << (CHUNK_AVG_BITS + 2)) - 1) << (64 - CHUNK_AVG_BITS - 2))
+#define CHUNK_MASK_L (((1ULL << (CHUNK_AVG_BITS - 2)) - 1) << (64 - CHUNK_AVG_BITS + 2))
+
+static uint64_t gear[256];
+static pthread_once_t gear_once = PTHREAD_ONCE_INIT;
+
+/*
+ * Tabela fixa gerada por splitmix64 com semente constante: os cortes (e com
+ * eles a deduplicação entre commits e repositórios) não podem mudar.
+ */
+static void gear_init(void) {
+  uint64_t state = 0x636c757267636463ULL; /* "clurgcdc" */
+  int i;
+
+  for (i = 0; i < 256; i++) {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    gear[i] = z ^ (z >> 31);
+  }
+}
+
+size_t chunk_next(const unsigned char *data, size_t len) {
+  size_t normal = CHUNK_AVG_SIZE;
+  uint64_t fp = 0;
+  size_t i;
+
+  if (len <= CHUNK_MIN_SIZE) return len;
+  if (len > CHUNK_MAX_SIZE) len = CHUNK_MAX_SIZE;
+  if (len < normal) normal = len;
+
+  pthread_once(&gear_once, gear_init);
+
+  for (i = CHUNK_MIN_SIZE; i < normal; i++) {
+    fp = (fp << 1) + gear[data[i]];
+    if (!(fp & CHUNK_MASK_S)) return i + 1;
+  }
+  for (; i < len; i++) {
+    fp = (fp << 1) + gear[data[i]];
+    if (!(fp & CHUNK_MASK_L)) return i + 1;
+  }
+  return len;
+}
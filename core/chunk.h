@@ -0,0 +1,25 @@
+#ifndef CLURG_CHUNK_H
+#define CLURG_CHUNK_H
+
+#include <stddef.h>
+
+/*
+ * Chunking definido pelo conteúdo (FastCDC) para blobs grandes.
+ *
+ * Um hash "gear" rolante (fp = (fp << 1) + gear[byte]) percorre o arquivo e
+ * corta onde os bits altos de fp zeram. Como o corte depende só dos bytes
+ * próximos, inserir ou alterar um trecho muda apenas os chunks em volta; os
+ * demais continuam com o mesmo hash e não são gravados (nem transferidos) de
+ * novo. A normalização do FastCDC usa uma máscara mais exigente antes de
+ * CHUNK_AVG_SIZE e uma mais fácil depois, concentrando os tamanhos perto da
+ * média. Nada antes de CHUNK_MIN_SIZE é examinado.
+ */
+
+#define CHUNK_MIN_SIZE (16 * 1024)
+#define CHUNK_AVG_SIZE (64 * 1024)
+#define CHUNK_MAX_SIZE (256 * 1024)
+
+/* Tamanho do chunk que começa em `data` (1..CHUNK_MAX_SIZE, ou `len` no fim) */
+size_t chunk_next(const unsigned char *data, size_t len);
+
+#endif /* CLURG_CHUNK_H */
@@ -1,30 +1,29 @@
 #define _GNU_SOURCE
-<<<<<<< HEAD
-=======
 #include <jansson.h>
->>>>>>> 6f9723b (Adjusts.)
 #include <limits.h>
 #include <linux/limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <time.h>
 #include <unistd.h>
 
+#include "commit.h"
+#include "objects.h"
+#include "sha256.h"
+#include "transfer.h"
+
 #define MAX_PATH PATH_MAX
 
 int clurg_clone(const char *project_name, const char *remote_url) {
   char cwd[PATH_MAX];
   char cmd[4096];
-<<<<<<< HEAD
-  char last_commit_id[256] = "";
-=======
   char response_path[] = "/tmp/clurg_snapshots.json";
   char last_commit_id[256] = "";
   char expected_hash[256] = "";
->>>>>>> 6f9723b (Adjusts.)
-  FILE *fp;
   int ret;
 
   if (!project_name || !remote_url) {
@@ -40,38 +39,24 @@ int clurg_clone(const char *project_name, const char *remote_url) {
 
   printf("Clonando projeto '%s' de %s...\n", project_name, remote_url);
 
-<<<<<<< HEAD
-  /* Primeiro, obter o ID do último commit */
-  /* curl -s <remote_url>/api/last-commit/<project_name> */
-  if (snprintf(cmd, sizeof(cmd), "curl -s \"%s/api/last-commit/%s\"", remote_url, project_name) >=
-=======
+  /* Remoto em diretório: copiar objetos (e chunks) em vez de baixar um tar.gz */
+  if (transfer_is_local(remote_url)) {
+    transfer_stats_t stats;
+
+    if (transfer_clone(remote_url, &stats) != 0) return 1;
+    printf("%llu commits, %llu objetos (%llu bytes)\n", (unsigned long long)stats.commits,
+           (unsigned long long)stats.objects, (unsigned long long)stats.bytes);
+    printf("Projeto clonado com sucesso!\n");
+    return 0;
+  }
+
   /* Obter lista de snapshots */
   if (snprintf(cmd, sizeof(cmd), "curl -s -o \"%s\" \"%s/snapshots\"", response_path, remote_url) >=
->>>>>>> 6f9723b (Adjusts.)
       (int)sizeof(cmd)) {
     fprintf(stderr, "comando muito longo\n");
     return 1;
   }
 
-<<<<<<< HEAD
-  fp = popen(cmd, "r");
-  if (!fp) {
-    perror("popen");
-    return 1;
-  }
-
-  if (fgets(last_commit_id, sizeof(last_commit_id), fp)) {
-    last_commit_id[strcspn(last_commit_id, "\n")] = 0; /* remover newline */
-  }
-  pclose(fp);
-
-  if (strlen(last_commit_id) == 0) {
-    fprintf(stderr, "erro: não foi possível obter o último commit\n");
-    return 1;
-  }
-
-  printf("Último commit: %s\n", last_commit_id);
-=======
   ret = system(cmd);
   if (ret != 0) {
     fprintf(stderr, "erro ao consultar snapshots (ret=%d)\n", ret);
@@ -119,7 +104,6 @@ int clurg_clone(const char *project_name, const char *remote_url) {
   }
 
   printf("Último snapshot: %s\n", last_commit_id);
->>>>>>> 6f9723b (Adjusts.)
 
   /* Criar diretório .clurg/commits se não existir */
   char commits_dir[MAX_PATH];
@@ -128,17 +112,6 @@ int clurg_clone(const char *project_name, const char *remote_url) {
   snprintf(mkdir_cmd, sizeof(mkdir_cmd), "mkdir -p \"%s\"", commits_dir);
   system(mkdir_cmd);
 
-<<<<<<< HEAD
-  /* Baixar o commit */
-  /* curl -s -o .clurg/commits/<id>.tar.gz <remote_url>/download/<project>/<id> */
-  char archive_path[MAX_PATH];
-  char meta_path[MAX_PATH];
-  snprintf(archive_path, sizeof(archive_path), "%s/%s.tar.gz", commits_dir, last_commit_id);
-  snprintf(meta_path, sizeof(meta_path), "%s/%s.meta", commits_dir, last_commit_id);
-
-  if (snprintf(cmd, sizeof(cmd), "curl -s -o \"%s\" \"%s/download/%s/%s\"", archive_path,
-               remote_url, project_name, last_commit_id) >= (int)sizeof(cmd)) {
-=======
   /* Baixar o snapshot */
   /* curl -s -o .clurg/commits/<id>.tar.gz <remote_url>/snapshot/<id> */
   char archive_path[MAX_PATH];
@@ -146,105 +119,43 @@ int clurg_clone(const char *project_name, const char *remote_url) {
 
   if (snprintf(cmd, sizeof(cmd), "curl -s -o \"%s\" \"%s/snapshot/%s\"", archive_path,
                remote_url, last_commit_id) >= (int)sizeof(cmd)) {
->>>>>>> 6f9723b (Adjusts.)
     fprintf(stderr, "comando muito longo\n");
     return 1;
   }
 
   ret = system(cmd);
   if (ret != 0) {
-<<<<<<< HEAD
-    fprintf(stderr, "erro ao baixar commit (ret=%d)\n", ret);
-    return 1;
-  }
-
-  /* Baixar o meta */
-  if (snprintf(cmd, sizeof(cmd), "curl -s -o \"%s\" \"%s/download/%s/%s.meta\"", meta_path,
-               remote_url, project_name, last_commit_id) >= (int)sizeof(cmd)) {
-    fprintf(stderr, "comando muito longo\n");
-    return 1;
-  }
-
-  ret = system(cmd);
-  if (ret != 0) {
-    fprintf(stderr, "erro ao baixar meta (ret=%d)\n", ret);
+    fprintf(stderr, "erro ao baixar snapshot (ret=%d)\n", ret);
     return 1;
   }
 
-  /* Verificar se arquivos existem */
+  /* Verificar se arquivo existe */
   if (access(archive_path, F_OK) != 0) {
-    fprintf(stderr, "erro: arquivo de commit não baixado\n");
-    return 1;
-  }
-
-  if (access(meta_path, F_OK) != 0) {
-    fprintf(stderr, "erro: arquivo meta não baixado\n");
+    fprintf(stderr, "erro: arquivo de snapshot não baixado\n");
     return 1;
   }
 
-  /* Verificar integridade do arquivo baixado */
-  char expected_checksum[65] = "";
-  FILE *meta_f = fopen(meta_path, "r");
-  if (meta_f) {
-    char line[256];
-    while (fgets(line, sizeof(line), meta_f)) {
-      if (strncmp(line, "checksum: ", 10) == 0) {
-        sscanf(line + 10, "%64s", expected_checksum);
-        break;
-      }
-    }
-    fclose(meta_f);
-  }
-
-  if (expected_checksum[0] != '\0') {
-    /* Calcular checksum do arquivo baixado */
-    char checksum_cmd[4096];
-    char checksum_output[128];
-    FILE *checksum_fp;
+  /*
+   * Verificar integridade: hash de 64 dígitos é SHA-256, calculado em processo;
+   * servidores antigos ainda anunciam MD5 (32 dígitos), conferido via md5sum.
+   */
+  if (strlen(expected_hash) == SHA256_HEX_SIZE - 1) {
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    char hash_hex[SHA256_HEX_SIZE];
 
-    if (snprintf(checksum_cmd, sizeof(checksum_cmd), "sha256sum \"%s\" 2>/dev/null",
-                 archive_path) >= (int)sizeof(checksum_cmd)) {
-      fprintf(stderr, "comando de checksum muito longo\n");
+    if (sha256_file(archive_path, digest) != 0) {
+      fprintf(stderr, "erro ao ler %s para verificação\n", archive_path);
       return 1;
     }
-
-    checksum_fp = popen(checksum_cmd, "r");
-    if (checksum_fp) {
-      if (fgets(checksum_output, sizeof(checksum_output), checksum_fp)) {
-        char calculated_checksum[65];
-        if (sscanf(checksum_output, "%64s", calculated_checksum) == 1) {
-          if (strcmp(calculated_checksum, expected_checksum) != 0) {
-            fprintf(stderr, "ERRO DE INTEGRIDADE: Checksum do arquivo baixado não corresponde!\n");
-            fprintf(stderr, "Esperado: %s\n", expected_checksum);
-            fprintf(stderr, "Calculado: %s\n", calculated_checksum);
-            fprintf(stderr, "O arquivo pode ter sido corrompido durante o download.\n");
-            return 1;
-          }
-        }
-      }
-      pclose(checksum_fp);
+    sha256_to_hex(digest, hash_hex);
+    if (strcasecmp(hash_hex, expected_hash) != 0) {
+      fprintf(stderr, "ERRO DE INTEGRIDADE: Hash SHA-256 não corresponde!\n");
+      fprintf(stderr, "Esperado: %s\n", expected_hash);
+      fprintf(stderr, "Calculado: %s\n", hash_hex);
+      return 1;
     }
-
-    printf("Integridade verificada: checksum OK\n");
-  } else {
-    fprintf(stderr, "aviso: arquivo meta não contém checksum (versão antiga?)\n");
-  }
-
-  /* Extrair o tar.gz no diretório atual */
-  if (snprintf(cmd, sizeof(cmd), "tar -xzf \"%s\" -C \"%s\"", archive_path, cwd) >=
-=======
-    fprintf(stderr, "erro ao baixar snapshot (ret=%d)\n", ret);
-    return 1;
-  }
-
-  /* Verificar se arquivo existe */
-  if (access(archive_path, F_OK) != 0) {
-    fprintf(stderr, "erro: arquivo de snapshot não baixado\n");
-    return 1;
-  }
-
-  /* Verificar integridade (MD5 como no servidor Python) */
-  if (strlen(expected_hash) > 0) {
+    printf("Integridade verificada: SHA-256 OK (%s)\n", sha256_impl_name());
+  } else if (strlen(expected_hash) > 0) {
     char hash_cmd[4096];
     char hash_output[128];
     FILE *hash_fp;
@@ -268,7 +179,6 @@ int clurg_clone(const char *project_name, const char *remote_url) {
 
   /* Extrair o tar.gz no diretório atual */
   if (snprintf(cmd, sizeof(cmd), "tar --exclude=.clurg -xzf \"%s\" -C \"%s\"", archive_path, cwd) >=
->>>>>>> 6f9723b (Adjusts.)
       (int)sizeof(cmd)) {
     fprintf(stderr, "comando muito longo\n");
     return 1;
@@ -276,30 +186,41 @@ int clurg_clone(const char *project_name, const char *remote_url) {
 
   ret = system(cmd);
   if (ret != 0) {
-<<<<<<< HEAD
-    fprintf(stderr, "erro ao extrair commit (ret=%d)\n", ret);
+    fprintf(stderr, "erro ao extrair snapshot (ret=%d)\n", ret);
     return 1;
   }
 
-  /* Criar HEAD apontando para o commit baixado */
-=======
-    fprintf(stderr, "erro ao extrair snapshot (ret=%d)\n", ret);
+  /* Importar o snapshot no object store; o tar.gz baixado deixa de ser necessário */
+  char tree_hex[SHA256_HEX_SIZE];
+  objects_stats_t stats = {0};
+
+  if (objects_init() != 0 || objects_write_tree(cwd, tree_hex, &stats) != 0) {
+    fprintf(stderr, "erro ao importar snapshot no object store\n");
+    return 1;
+  }
+  remove(archive_path);
+
+  commit_meta_t meta;
+  time_t now = time(NULL);
+
+  memset(&meta, 0, sizeof(meta));
+  snprintf(meta.id, sizeof(meta.id), "%s", last_commit_id);
+  strcpy(meta.tree, tree_hex);
+  strftime(meta.timestamp, sizeof(meta.timestamp), "%Y-%m-%d %H:%M:%S", localtime(&now));
+  strcpy(meta.author, "clone");
+  snprintf(meta.message, sizeof(meta.message), "clone de %s (%s)", remote_url, project_name);
+  meta.size_bytes = stats.bytes_total;
+  meta.stored_bytes = stats.bytes_stored;
+  strcpy(meta.checksum, tree_hex);
+  if (commit_write_meta(&meta) != 0) {
     return 1;
   }
 
   /* Criar HEAD apontando para o snapshot baixado */
->>>>>>> 6f9723b (Adjusts.)
-  char head_file[MAX_PATH];
-  snprintf(head_file, sizeof(head_file), "%s/HEAD", commits_dir);
-  fp = fopen(head_file, "w");
-  if (fp) {
-    fprintf(fp, "%s\n", last_commit_id);
-    fclose(fp);
-  } else {
-    perror("fopen HEAD");
+  if (commit_update_head(last_commit_id) != 0) {
     return 1;
   }
 
   printf("Projeto clonado com sucesso!\n");
   return 0;
-}
\ No newline at end of file
+}
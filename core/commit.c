@@ -1,17 +1,525 @@
-#include <jansson.h>
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <errno.h>
 #include <limits.h>
 #include <linux/limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "../ci/ci.h"
+#include "commit.h"
+#include "commit_index.h"
+#include "objects.h"
+#include "pack.h"
 
+int commit_read_head(char *id, size_t size) {
+  FILE *fp = fopen(HEAD_FILE, "r");
+  if (!fp) return -1;
+
+  if (!fgets(id, (int)size, fp)) {
+    fclose(fp);
+    return -1;
+  }
+  fclose(fp);
+
+  id[strcspn(id, "\r\n")] = '\0';
+  return id[0] != '\0' ? 0 : -1;
+}
+
+static pack_set_t commit_packs;
+static int commit_packs_loaded;
+
+static const pack_set_t *packed_commits(void) {
+  if (!commit_packs_loaded) {
+    pack_set_load(&commit_packs, COMMITS_PACK_DIR);
+    commit_packs_loaded = 1;
+  }
+  return &commit_packs;
+}
+
+int commit_pack_key(const char *id, uint8_t key[PACK_KEY_SIZE]) {
+  size_t len = strlen(id);
+
+  if (len == 0 || len >= PACK_KEY_SIZE) return -1;
+  memset(key, 0, PACK_KEY_SIZE);
+  memcpy(key, id, len);
+  return 0;
+}
+
+static int read_file(const char *path, char **text) {
+  struct stat st;
+  char *buf;
+  FILE *fp;
+  size_t n;
+
+  fp = fopen(path, "r");
+  if (!fp) return -1;
+  if (fstat(fileno(fp), &st) != 0 || !(buf = malloc((size_t)st.st_size + 1))) {
+    fclose(fp);
+    return -1;
+  }
+  n = fread(buf, 1, (size_t)st.st_size, fp);
+  fclose(fp);
+  buf[n] = '\0';
+  *text = buf;
+  return 0;
+}
+
+int commit_read_meta_text(const char *id, char **text) {
+  char meta_path[PATH_MAX];
+  uint8_t key[PACK_KEY_SIZE];
+  const pack_idx_entry_t *entry;
+  const pack_t *pack;
+
+  if (strchr(id, '/') || snprintf(meta_path, sizeof(meta_path), "%s/%s.meta", COMMITS_DIR, id) >=
+                             (int)sizeof(meta_path)) {
+    return -1;
+  }
+  if (read_file(meta_path, text) == 0) return 0;
+
+  /* Não está solto: procurar nos packs */
+  if (commit_pack_key(id, key) != 0) return -1;
+  entry = pack_set_find(packed_commits(), key, &pack);
+  if (!entry) return -1;
+  return pack_read(pack, entry, (unsigned char **)text);
+}
+
+int commit_exists(const char *id) {
+  char *text;
+
+  if (commit_read_meta_text(id, &text) != 0) return 0;
+  free(text);
+  return 1;
+}
+
+int commit_meta_text_field(const char *text, const char *key, char *value, size_t size) {
+  size_t key_len = strlen(key);
+  const char *line = text;
+
+  while (line) {
+    if (strncmp(line, key, key_len) == 0 && line[key_len] == ':') {
+      const char *v = line + key_len + 1;
+      size_t len;
+      while (*v == ' ') v++;
+      len = strcspn(v, "\r\n");
+      snprintf(value, size, "%.*s", (int)len, v);
+      return 0;
+    }
+    line = strchr(line, '\n');
+    if (line) line++;
+  }
+  return -1;
+}
+
+int commit_read_meta_field(const char *id, const char *key, char *value, size_t size) {
+  char *text;
+  int ret;
+
+  if (commit_read_meta_text(id, &text) != 0) return -1;
+  ret = commit_meta_text_field(text, key, value, size);
+  free(text);
+  return ret;
+}
+
+int commit_read_meta(const char *id, commit_meta_t *meta) {
+  char number[32];
+  char *text;
+
+  if (commit_read_meta_text(id, &text) != 0) return -1;
+
+  memset(meta, 0, sizeof(*meta));
+  commit_meta_text_field(text, "id", meta->id, sizeof(meta->id));
+  commit_meta_text_field(text, "parent", meta->parent, sizeof(meta->parent));
+  commit_meta_text_field(text, "tree", meta->tree, sizeof(meta->tree));
+  commit_meta_text_field(text, "timestamp", meta->timestamp, sizeof(meta->timestamp));
+  commit_meta_text_field(text, "author", meta->author, sizeof(meta->author));
+  commit_meta_text_field(text, "message", meta->message, sizeof(meta->message));
+  commit_meta_text_field(text, "checksum", meta->checksum, sizeof(meta->checksum));
+  commit_meta_text_field(text, "ci_status", meta->ci_status, sizeof(meta->ci_status));
+  if (commit_meta_text_field(text, "size_bytes", number, sizeof(number)) == 0) {
+    meta->size_bytes = strtoull(number, NULL, 10);
+  }
+  if (commit_meta_text_field(text, "stored_bytes", number, sizeof(number)) == 0) {
+    meta->stored_bytes = strtoull(number, NULL, 10);
+  }
+  if (!meta->id[0]) snprintf(meta->id, sizeof(meta->id), "%s", id);
+
+  free(text);
+  return 0;
+}
+
+static int compare_ids(const void *a, const void *b) {
+  return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static int push_id(char ***ids, size_t *count, size_t *capacity, const char *id, size_t len) {
+  char *copy;
+
+  if (*count == *capacity) {
+    size_t grown_capacity = *capacity ? *capacity * 2 : 256;
+    char **grown = realloc(*ids, grown_capacity * sizeof(char *));
+    if (!grown) return -1;
+    *ids = grown;
+    *capacity = grown_capacity;
+  }
+  copy = strndup(id, len);
+  if (!copy) return -1;
+  (*ids)[(*count)++] = copy;
+  return 0;
+}
+
+int commit_list_ids(char ***ids, size_t *count) {
+  const pack_set_t *packs = packed_commits();
+  size_t capacity = 0;
+  struct dirent *entry;
+  size_t i;
+  size_t j;
+  DIR *d;
+
+  *ids = NULL;
+  *count = 0;
+
+  d = opendir(COMMITS_DIR);
+  if (d) {
+    while ((entry = readdir(d)) != NULL) {
+      size_t len = strlen(entry->d_name);
+      if (len > 5 && strcmp(entry->d_name + len - 5, ".meta") == 0 &&
+          push_id(ids, count, &capacity, entry->d_name, len - 5) != 0) {
+        break;
+      }
+    }
+    closedir(d);
+  }
+
+  for (i = 0; i < packs->count; i++) {
+    for (j = 0; j < packs->packs[i].count; j++) {
+      const char *key = (const char *)packs->packs[i].entries[j].key;
+      if (push_id(ids, count, &capacity, key, strnlen(key, PACK_KEY_SIZE)) != 0) break;
+    }
+  }
+
+  /* Ordenar e remover duplicatas (commit solto e empacotado ao mesmo tempo) */
+  qsort(*ids, *count, sizeof(char *), compare_ids);
+  for (i = 0, j = 0; i < *count; i++) {
+    if (j > 0 && strcmp((*ids)[j - 1], (*ids)[i]) == 0) {
+      free((*ids)[i]);
+    } else {
+      (*ids)[j++] = (*ids)[i];
+    }
+  }
+  *count = j;
+  return 0;
+}
+
+void commit_free_ids(char **ids, size_t count) {
+  size_t i;
+
+  for (i = 0; i < count; i++) free(ids[i]);
+  free(ids);
+}
+
+int commit_repack(uint64_t *packed) {
+  const pack_set_t *packs = packed_commits();
+  pack_writer_t w;
+  char pack_path[PATH_MAX];
+  char **ids;
+  size_t count;
+  size_t i;
+  int ret = -1;
+
+  *packed = 0;
+  if (commit_list_ids(&ids, &count) != 0) return -1;
+  if (count == 0) {
+    free(ids);
+    return 0;
+  }
+
+  if (pack_writer_open(&w, COMMITS_PACK_DIR) != 0) goto out;
+  for (i = 0; i < count; i++) {
+    uint8_t key[PACK_KEY_SIZE];
+    char *text;
+    int added;
+
+    if (commit_pack_key(ids[i], key) != 0) {
+      fprintf(stderr, "aviso: id de commit longo demais para o pack, mantido solto: %s\n", ids[i]);
+      free(ids[i]);
+      ids[i] = NULL;
+      continue;
+    }
+    if (commit_read_meta_text(ids[i], &text) != 0) {
+      pack_writer_abort(&w);
+      goto out;
+    }
+    added = pack_writer_add(&w, key, text, strlen(text));
+    free(text);
+    if (added != 0) {
+      pack_writer_abort(&w);
+      goto out;
+    }
+  }
+  if (pack_writer_finish(&w, pack_path, sizeof(pack_path)) != 0) goto out;
+
+  /* O pack novo contém tudo: remover packs antigos e .meta soltos */
+  for (i = 0; i < packs->count; i++) {
+    char idx_path[PATH_MAX];
+    if (strcmp(packs->packs[i].path, pack_path) == 0) continue;
+    snprintf(idx_path, sizeof(idx_path), "%.*s.idx", (int)strlen(packs->packs[i].path) - 5,
+             packs->packs[i].path);
+    unlink(idx_path);
+    unlink(packs->packs[i].path);
+  }
+  for (i = 0; i < count; i++) {
+    char meta_path[PATH_MAX];
+    if (!ids[i]) continue;
+    snprintf(meta_path, sizeof(meta_path), "%s/%s.meta", COMMITS_DIR, ids[i]);
+    if (unlink(meta_path) == 0) (*packed)++;
+  }
+
+  pack_set_free(&commit_packs);
+  commit_packs_loaded = 0;
+  ret = 0;
+
+out:
+  commit_free_ids(ids, count);
+  return ret;
+}
+
+static int is_removed(char *const *ids, size_t count, const uint8_t key[PACK_KEY_SIZE]) {
+  char id[PACK_KEY_SIZE + 1];
+  const char *needle = id;
+
+  memcpy(id, key, PACK_KEY_SIZE);
+  id[PACK_KEY_SIZE] = '\0';
+  return bsearch(&needle, ids, count, sizeof(char *), compare_ids) != NULL;
+}
+
+int commit_remove(char *const *ids, size_t count, uint64_t *removed) {
+  const pack_set_t *packs = packed_commits();
+  size_t i;
+  size_t j;
+
+  *removed = 0;
+  for (i = 0; i < count; i++) {
+    char meta_path[PATH_MAX];
+    if (strchr(ids[i], '/')) continue;
+    snprintf(meta_path, sizeof(meta_path), "%s/%s.meta", COMMITS_DIR, ids[i]);
+    if (unlink(meta_path) == 0) (*removed)++;
+  }
+
+  for (i = 0; i < packs->count; i++) {
+    const pack_t *pack = &packs->packs[i];
+    char pack_path[PATH_MAX];
+    char idx_path[PATH_MAX];
+    pack_writer_t w;
+    size_t dropped = 0;
+
+    for (j = 0; j < pack->count; j++) dropped += is_removed(ids, count, pack->entries[j].key);
+    if (dropped == 0) continue;
+
+    if (pack_writer_open(&w, COMMITS_PACK_DIR) != 0) return -1;
+    for (j = 0; j < pack->count; j++) {
+      unsigned char *text;
+      int added;
+
+      if (is_removed(ids, count, pack->entries[j].key)) continue;
+      if (pack_read(pack, &pack->entries[j], &text) != 0) {
+        pack_writer_abort(&w);
+        return -1;
+      }
+      added = pack_writer_add(&w, pack->entries[j].key, text, (size_t)pack->entries[j].length);
+      free(text);
+      if (added != 0) {
+        pack_writer_abort(&w);
+        return -1;
+      }
+    }
+    if (w.count == 0) {
+      pack_writer_abort(&w);
+      pack_path[0] = '\0';
+    } else if (pack_writer_finish(&w, pack_path, sizeof(pack_path)) != 0) {
+      return -1;
+    }
+    if (strcmp(pack_path, pack->path) != 0) {
+      snprintf(idx_path, sizeof(idx_path), "%.*s.idx", (int)strlen(pack->path) - 5, pack->path);
+      unlink(idx_path);
+      unlink(pack->path);
+    }
+    *removed += dropped;
+  }
+
+  pack_set_free(&commit_packs);
+  commit_packs_loaded = 0;
+  return 0;
+}
+
+int commit_write_meta(const commit_meta_t *meta) {
+  char meta_path[PATH_MAX];
+  char tmp_path[PATH_MAX];
+  FILE *fp;
+
+  if (mkdir(COMMITS_DIR, 0755) != 0 && errno != EEXIST) {
+    fprintf(stderr, "erro ao criar %s: %s\n", COMMITS_DIR, strerror(errno));
+    return -1;
+  }
+
+  if (snprintf(meta_path, sizeof(meta_path), "%s/%s.meta", COMMITS_DIR, meta->id) >=
+          (int)sizeof(meta_path) ||
+      snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", meta_path) >= (int)sizeof(tmp_path)) {
+    fprintf(stderr, "erro: id de commit longo demais: %s\n", meta->id);
+    return -1;
+  }
+  /* Um commit nunca é reescrito: o id já pode estar num pack */
+  if (commit_exists(meta->id)) {
+    fprintf(stderr, "erro: commit %s já existe\n", meta->id);
+    return -1;
+  }
+
+  fp = fopen(tmp_path, "w");
+  if (!fp) {
+    fprintf(stderr, "erro ao criar %s: %s\n", tmp_path, strerror(errno));
+    return -1;
+  }
+
+  /* Formato "chave: valor", o mesmo que clone.c e a interface web esperam */
+  fprintf(fp, "id: %s\n", meta->id);
+  fprintf(fp, "parent: %s\n", meta->parent);
+  fprintf(fp, "tree: %s\n", meta->tree);
+  fprintf(fp, "timestamp: %s\n", meta->timestamp);
+  fprintf(fp, "author: %s\n", meta->author);
+  fprintf(fp, "message: %s\n", meta->message);
+  fprintf(fp, "size_bytes: %llu\n", meta->size_bytes);
+  fprintf(fp, "stored_bytes: %llu\n", meta->stored_bytes);
+  fprintf(fp, "checksum: %s\n", meta->checksum);
+  if (meta->ci_status[0]) fprintf(fp, "ci_status: %s\n", meta->ci_status);
+
+  /* link() em vez de rename(): falha com EEXIST em vez de sobrescrever um
+   * .meta criado por outro commit no meio do caminho */
+  if (fclose(fp) != 0 || link(tmp_path, meta_path) != 0) {
+    if (errno == EEXIST) {
+      fprintf(stderr, "erro: commit %s já existe\n", meta->id);
+    } else {
+      fprintf(stderr, "erro ao gravar %s\n", meta_path);
+    }
+    unlink(tmp_path);
+    return -1;
+  }
+  unlink(tmp_path);
+
+  /* Falha no índice não invalida o commit, mas um log.idx que ainda abre sem
+   * ele esconderia o commit do log: apagá-lo faz o próximo log recriá-lo a
+   * partir dos .meta */
+  if (commit_index_append(meta) != 0) {
+    unlink(COMMIT_INDEX_FILE);
+    unlink(COMMIT_INDEX_STRINGS);
+  }
+  return 0;
+}
+
+int commit_update_head(const char *id) {
+  char tmp_path[] = HEAD_FILE ".tmp";
+  FILE *fp = fopen(tmp_path, "w");
+
+  if (!fp) {
+    fprintf(stderr, "erro ao atualizar %s: %s\n", HEAD_FILE, strerror(errno));
+    return -1;
+  }
+  fprintf(fp, "%s\n", id);
+  if (fclose(fp) != 0 || rename(tmp_path, HEAD_FILE) != 0) {
+    fprintf(stderr, "erro ao atualizar %s\n", HEAD_FILE);
+    unlink(tmp_path);
+    return -1;
+  }
+  return 0;
+}
+
+int commit_is_ancestor(const char *ancestor, const char *id) {
+  char current[32];
+
+  snprintf(current, sizeof(current), "%s", id);
+  while (current[0]) {
+    char parent[32];
+
+    if (strcmp(current, ancestor) == 0) return 1;
+    if (commit_read_meta_field(current, "parent", parent, sizeof(parent)) != 0 ||
+        strcmp(parent, current) == 0) {
+      return 0;
+    }
+    memcpy(current, parent, sizeof(current));
+  }
+  return 0;
+}
+
+int commit_list_tips(char ***ids, size_t *count) {
+  size_t capacity = 0;
+  char line[64];
+  FILE *fp;
+
+  *ids = NULL;
+  *count = 0;
+  fp = fopen(TIPS_FILE, "r");
+  if (!fp) return errno == ENOENT ? 0 : -1;
+  while (fgets(line, sizeof(line), fp)) {
+    size_t len = strcspn(line, "\r\n");
+
+    if (len == 0 || len >= PACK_KEY_SIZE) continue;
+    if (push_id(ids, count, &capacity, line, len) != 0) {
+      fclose(fp);
+      commit_free_ids(*ids, *count);
+      *ids = NULL;
+      *count = 0;
+      return -1;
+    }
+  }
+  fclose(fp);
+  return 0;
+}
+
+int commit_record_tip(const char *id) {
+  char tmp_path[] = TIPS_FILE ".tmp";
+  char **tips;
+  size_t count;
+  size_t i;
+  FILE *fp;
+  int ok;
+
+  if (commit_list_tips(&tips, &count) != 0) return -1;
+  for (i = 0; i < count; i++) {
+    if (strcmp(tips[i], id) == 0) {
+      commit_free_ids(tips, count);
+      return 0;
+    }
+  }
+
+  if ((mkdir(REFS_DIR, 0755) != 0 && errno != EEXIST) || !(fp = fopen(tmp_path, "w"))) {
+    fprintf(stderr, "erro ao gravar %s: %s\n", TIPS_FILE, strerror(errno));
+    commit_free_ids(tips, count);
+    return -1;
+  }
+  ok = 1;
+  for (i = 0; ok && i < count; i++) ok = fprintf(fp, "%s\n", tips[i]) > 0;
+  ok = ok && fprintf(fp, "%s\n", id) > 0;
+  commit_free_ids(tips, count);
+  if (fclose(fp) != 0 || !ok || rename(tmp_path, TIPS_FILE) != 0) {
+    fprintf(stderr, "erro ao gravar %s\n", TIPS_FILE);
+    unlink(tmp_path);
+    return -1;
+  }
+  return 0;
+}
 
 int clurg_commit(const char *message) {
   char cwd[PATH_MAX];
-  char cmd[2048]; /* Ainda usado para o script de commit */
+  commit_meta_t meta;
+  objects_stats_t stats = {0};
+  index_t cache;
+  index_builder_t next_index;
+  watch_dirty_t dirty;
+  time_t now;
+  const char *author;
   int ret;
 
   /* Obter diretório atual para passar para CI */
@@ -20,62 +528,109 @@ int clurg_commit(const char *message) {
     return 1;
   }
 
+  if (access(".clurg", F_OK) != 0) {
+    fprintf(stderr, "Erro: Repositório não inicializado.\n");
+    return 1;
+  }
+
   /* Executar pipeline CI antes do commit */
   /* Usando integração direta com biblioteca CI (sem system calls pesados) */
   printf("Executando pipeline CI...\n");
   ret = ci_run_pipeline("pipelines/default.ci", cwd);
 
-  char ci_status[16] = "failed";
+  memset(&meta, 0, sizeof(meta));
+  strcpy(meta.ci_status, "failed");
   if (ret == 0) {
-    strcpy(ci_status, "passed");
+    strcpy(meta.ci_status, "passed");
     printf("Pipeline CI executado com sucesso!\n");
   } else {
     fprintf(stderr, "Pipeline CI falhou, mas continuando com commit...\n");
     /* Commit continua mesmo se CI falhar, conforme CONTEXT.md linha 200 */
   }
 
-  /* Aqui executamos o script local que cria um snapshot em .clurg/commits */
-  {
-    char script_path[PATH_MAX];
+  /* Metadados calculados em processo (sem date/stat/sha256sum) */
+  now = time(NULL);
+  strftime(meta.id, sizeof(meta.id), "%Y%m%d%H%M%S", localtime(&now));
+  /*
+   * Ids são carimbos de tempo: um segundo commit no mesmo segundo ganha um
+   * sufixo "-02", "-03"... O sufixo mantém a ordem lexicográfica dos ids
+   * igual à ordem em que os commits foram feitos.
+   */
+  if (commit_exists(meta.id)) {
+    size_t base_len = strlen(meta.id);
+    int seq;
 
-    if (snprintf(script_path, sizeof(script_path), "%s/.clurg/scripts/commit.sh", cwd) >=
-        (int)sizeof(script_path)) {
-      fprintf(stderr, "caminho do script muito longo\n");
-      return 1;
+    for (seq = 2; seq < 100; seq++) {
+      snprintf(meta.id + base_len, sizeof(meta.id) - base_len, "-%02d", seq);
+      if (!commit_exists(meta.id)) break;
     }
-
-    /* Garantir que o script exista; se não for executável, usaremos sh */
-    if (access(script_path, F_OK) != 0) {
-      fprintf(stderr, "script de commit local não encontrado: %s\n", script_path);
+    if (seq == 100) {
+      fprintf(stderr, "erro: commits demais no mesmo segundo\n");
       return 1;
     }
+  }
+  strftime(meta.timestamp, sizeof(meta.timestamp), "%Y-%m-%d %H:%M:%S", localtime(&now));
+  author = getenv("USER");
+  snprintf(meta.author, sizeof(meta.author), "%s", author ? author : "unknown");
+  snprintf(meta.message, sizeof(meta.message), "%s", message ? message : "no message");
+  meta.message[strcspn(meta.message, "\r\n")] = '\0'; /* uma linha por campo no .meta */
+  if (commit_read_head(meta.parent, sizeof(meta.parent)) != 0) meta.parent[0] = '\0';
 
-    /* Construir comando para executar o script com a mensagem */
-    if (message) {
-      /* Obs: mensagem não é escapada; evite caracteres especiais no teste */
-      if (snprintf(cmd, sizeof(cmd), "CLURG_CI_STATUS=%s %s \"%s\"", ci_status, script_path,
-                   message) >= (int)sizeof(cmd)) {
-        fprintf(stderr, "comando muito longo\n");
-        return 1;
-      }
-    } else {
-      if (snprintf(cmd, sizeof(cmd), "CLURG_CI_STATUS=%s %s \"%s\"", ci_status, script_path,
-                   "no message") >= (int)sizeof(cmd)) {
-        fprintf(stderr, "comando muito longo\n");
-        return 1;
-      }
-    }
+  printf("📦 Criando snapshot %s...\n", meta.id);
 
-    printf("Executando commit local via script: %s\n", script_path);
-    ret = system(cmd);
-    if (ret != 0) {
-      fprintf(stderr, "erro ao executar script de commit local (ret=%d)\n", ret);
-      return 1;
-    }
+  /*
+   * Gravar a árvore de trabalho no object store: só blobs novos são escritos
+   * e só arquivos com stat diferente do índice são lidos. Com o clurg watch
+   * ativo, só os caminhos que ele relatou são visitados.
+   */
+  watch_dirty_load(&dirty);
+  index_load(&cache);
+  index_builder_init(&next_index);
+  if (!dirty.full) {
+    printf("👀 watch: %zu caminhos alterados desde o último índice\n", dirty.count);
+  }
+  ret = objects_init() == 0
+            ? objects_write_tree_dirty(".", meta.tree, &stats, &cache, &next_index, &dirty)
+            : -1;
+  index_free(&cache);
+  if (ret != 0) {
+    fprintf(stderr, "erro ao gravar objetos do snapshot\n");
+    index_builder_free(&next_index);
+    watch_dirty_free(&dirty);
+    return 1;
+  }
+  printf("Objetos: %llu arquivos (%llu lidos), %llu novos objetos, %llu como delta "
+         "(%llu bytes gravados)\n",
+         (unsigned long long)stats.files, (unsigned long long)stats.files_read,
+         (unsigned long long)stats.objects_new, (unsigned long long)stats.objects_delta,
+         (unsigned long long)stats.bytes_stored);
+  if (stats.objects_chunked > 0) {
+    printf("Chunks: %llu arquivos grandes divididos, %llu chunks reaproveitados\n",
+           (unsigned long long)stats.objects_chunked, (unsigned long long)stats.chunks_reused);
+  }
+
+  meta.size_bytes = stats.bytes_total;
+  meta.stored_bytes = stats.bytes_stored;
+  strcpy(meta.checksum, meta.tree);
 
-    printf("Commit local criado com sucesso.\n");
+  if (commit_write_meta(&meta) != 0 || commit_update_head(meta.id) != 0) {
+    index_builder_free(&next_index);
+    watch_dirty_free(&dirty);
+    return 1;
   }
 
+  /* Índice desatualizado só custa releituras no próximo commit */
+  if (index_builder_write(&next_index) != 0) {
+    fprintf(stderr, "aviso: não foi possível atualizar %s\n", INDEX_FILE);
+  } else {
+    /* O índice novo descreve a árvore inteira: nada fica pendente */
+    watch_dirty_save(&dirty, NULL, 0);
+  }
+  index_builder_free(&next_index);
+  watch_dirty_free(&dirty);
 
+  printf("✅ Commit %s realizado com sucesso!\n", meta.id);
+  printf("   Mensagem: %s\n", meta.message);
+  printf("   Checksum: %s\n", meta.checksum);
   return 0;
 }
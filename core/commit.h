@@ -1,6 +1,80 @@
 #ifndef COMMIT_H
 #define COMMIT_H
 
+#include <stddef.h>
+#include <stdint.h>
+
+#define COMMITS_DIR ".clurg/commits"
+#define COMMITS_PACK_DIR ".clurg/commits/pack"
+#define HEAD_FILE ".clurg/HEAD"
+#define REFS_DIR ".clurg/refs"
+#define TIPS_FILE ".clurg/refs/tips"
+
+#include "pack.h"
+#include "sha256.h"
+
+typedef struct {
+  char id[32];
+  char parent[32];
+  char tree[SHA256_HEX_SIZE];
+  char timestamp[32];
+  char author[128];
+  char message[512];
+  unsigned long long size_bytes;
+  unsigned long long stored_bytes;
+  char checksum[SHA256_HEX_SIZE];
+  char ci_status[16];
+} commit_meta_t;
+
 int clurg_commit(const char *message);
 
+/*
+ * Grava .clurg/commits/<id>.meta (arquivo temporário + link, nunca sobrescreve
+ * um commit existente) e move o HEAD (arquivo temporário + rename)
+ */
+int commit_write_meta(const commit_meta_t *meta);
+int commit_update_head(const char *id);
+
+/* Lê o ID do commit apontado por .clurg/HEAD (0 = ok, -1 = sem commits) */
+int commit_read_head(char *id, size_t size);
+
+/*
+ * Leitura de metadados: procura .clurg/commits/<id>.meta e, se não existir,
+ * os packs de .clurg/commits/pack/ (criados por `clurg repack`).
+ */
+int commit_read_meta_text(const char *id, char **text);
+int commit_read_meta(const char *id, commit_meta_t *meta);
+/* 1 se o commit existe, solto ou empacotado */
+int commit_exists(const char *id);
+
+/* Procura "chave: valor" no texto de um .meta */
+int commit_meta_text_field(const char *text, const char *key, char *value, size_t size);
+
+/* Chave de pack de um commit: o id completado com zeros */
+int commit_pack_key(const char *id, uint8_t key[PACK_KEY_SIZE]);
+
+/* Lê um campo "chave: valor" do .meta de um commit */
+int commit_read_meta_field(const char *id, const char *key, char *value, size_t size);
+
+/* Ids de todos os commits (soltos e empacotados), em ordem crescente */
+int commit_list_ids(char ***ids, size_t *count);
+void commit_free_ids(char **ids, size_t count);
+
+/* 1 se `ancestor` está na cadeia de pais de `id` (incluindo o próprio `id`) */
+int commit_is_ancestor(const char *ancestor, const char *id);
+
+/*
+ * Pontas de histórico deixadas para trás: o checkout de um commit que não
+ * descende do HEAD grava o HEAD anterior em .clurg/refs/tips (um id por
+ * linha), para ele não ficar sem referência.
+ */
+int commit_record_tip(const char *id);
+int commit_list_tips(char ***ids, size_t *count);
+
+/* Agrupa todos os .meta num único pack; `packed` recebe quantos saíram do diretório */
+int commit_repack(uint64_t *packed);
+
+/* Apaga os commits `ids` (ordenados por strcmp); packs que os contêm são reescritos sem eles */
+int commit_remove(char *const *ids, size_t count, uint64_t *removed);
+
 #endif /* COMMIT_H */
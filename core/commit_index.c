@@ -0,0 +1,214 @@
+#define _GNU_SOURCE
+#include "commit_index.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+static int write_all(int fd, const void *data, size_t len) {
+  const unsigned char *p = data;
+  while (len > 0) {
+    ssize_t n = write(fd, p, len);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return -1;
+    }
+    p += n;
+    len -= (size_t)n;
+  }
+  return 0;
+}
+
+static void fill_header(commit_index_header_t *hdr) {
+  memset(hdr, 0, sizeof(*hdr));
+  hdr->magic = COMMIT_INDEX_MAGIC;
+  hdr->version = COMMIT_INDEX_VERSION;
+  hdr->record_size = sizeof(commit_index_record_t);
+}
+
+/* Grava autor e mensagem em `str_fd` e preenche o registro correspondente */
+static int build_record(int str_fd, uint64_t *str_size, const commit_meta_t *meta,
+                        commit_index_record_t *rec) {
+  struct tm tm;
+
+  memset(rec, 0, sizeof(*rec));
+  snprintf(rec->id, sizeof(rec->id), "%s", meta->id);
+  snprintf(rec->parent, sizeof(rec->parent), "%s", meta->parent);
+  rec->size_bytes = meta->size_bytes;
+  sha256_from_hex(meta->checksum, rec->checksum);
+
+  /* O .meta guarda hora local "AAAA-MM-DD HH:MM:SS" */
+  memset(&tm, 0, sizeof(tm));
+  if (strptime(meta->timestamp, "%Y-%m-%d %H:%M:%S", &tm)) {
+    tm.tm_isdst = -1;
+    rec->timestamp = (int64_t)mktime(&tm);
+  }
+
+  rec->author_offset = *str_size;
+  if (write_all(str_fd, meta->author, strlen(meta->author) + 1) != 0) return -1;
+  *str_size += strlen(meta->author) + 1;
+
+  rec->message_offset = *str_size;
+  if (write_all(str_fd, meta->message, strlen(meta->message) + 1) != 0) return -1;
+  *str_size += strlen(meta->message) + 1;
+  return 0;
+}
+
+int commit_index_append(const commit_meta_t *meta) {
+  commit_index_record_t rec;
+  struct stat st;
+  uint64_t str_size;
+  int idx_fd;
+  int str_fd;
+  int ret = -1;
+
+  idx_fd = open(COMMIT_INDEX_FILE, O_RDWR | O_CREAT, 0644);
+  if (idx_fd < 0) return -1;
+  /* Serializa commits concorrentes: o offset em log.str depende do tamanho atual */
+  flock(idx_fd, LOCK_EX);
+
+  str_fd = open(COMMIT_INDEX_STRINGS, O_WRONLY | O_CREAT | O_APPEND, 0644);
+  if (str_fd < 0 || fstat(str_fd, &st) != 0) goto out;
+  str_size = (uint64_t)st.st_size;
+
+  if (fstat(idx_fd, &st) != 0) goto out;
+  if (st.st_size == 0) {
+    commit_index_header_t hdr;
+    fill_header(&hdr);
+    if (write_all(idx_fd, &hdr, sizeof(hdr)) != 0) goto out;
+    st.st_size = sizeof(hdr);
+  } else {
+    /* Cabeçalho truncado ou de outro formato: os registros seguintes não são
+     * confiáveis, e quem chamou descarta o índice para o log recriá-lo */
+    commit_index_header_t hdr;
+    if (st.st_size < (off_t)sizeof(hdr) ||
+        pread(idx_fd, &hdr, sizeof(hdr), 0) != (ssize_t)sizeof(hdr) ||
+        hdr.magic != COMMIT_INDEX_MAGIC || hdr.version != COMMIT_INDEX_VERSION ||
+        hdr.record_size != sizeof(commit_index_record_t)) {
+      goto out;
+    }
+  }
+
+  /* Descartar um registro parcial deixado por uma gravação interrompida */
+  st.st_size -= (st.st_size - (off_t)sizeof(commit_index_header_t)) %
+                (off_t)sizeof(commit_index_record_t);
+
+  if (build_record(str_fd, &str_size, meta, &rec) != 0) goto out;
+  if (pwrite(idx_fd, &rec, sizeof(rec), st.st_size) != (ssize_t)sizeof(rec)) goto out;
+  ret = 0;
+
+out:
+  if (str_fd >= 0) close(str_fd);
+  close(idx_fd);
+  if (ret != 0) fprintf(stderr, "aviso: não foi possível atualizar %s\n", COMMIT_INDEX_FILE);
+  return ret;
+}
+
+int commit_index_rebuild(void) {
+  char idx_tmp[] = COMMIT_INDEX_FILE ".tmp";
+  char str_tmp[] = COMMIT_INDEX_STRINGS ".tmp";
+  commit_index_header_t hdr;
+  uint64_t str_size = 0;
+  char **ids;
+  size_t count;
+  size_t i;
+  int idx_fd;
+  int str_fd;
+  int ok;
+
+  if (commit_list_ids(&ids, &count) != 0) return -1;
+
+  idx_fd = open(idx_tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  str_fd = open(str_tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  fill_header(&hdr);
+  ok = idx_fd >= 0 && str_fd >= 0 && write_all(idx_fd, &hdr, sizeof(hdr)) == 0;
+
+  /* Ids são timestamps: a ordem crescente reproduz a ordem dos commits */
+  for (i = 0; ok && i < count; i++) {
+    commit_meta_t meta;
+    commit_index_record_t rec;
+
+    if (commit_read_meta(ids[i], &meta) != 0) continue;
+    ok = build_record(str_fd, &str_size, &meta, &rec) == 0 &&
+         write_all(idx_fd, &rec, sizeof(rec)) == 0;
+  }
+  commit_free_ids(ids, count);
+
+  if (idx_fd >= 0 && close(idx_fd) != 0) ok = 0;
+  if (str_fd >= 0 && close(str_fd) != 0) ok = 0;
+
+  if (!ok || rename(str_tmp, COMMIT_INDEX_STRINGS) != 0 ||
+      rename(idx_tmp, COMMIT_INDEX_FILE) != 0) {
+    fprintf(stderr, "erro ao recriar %s: %s\n", COMMIT_INDEX_FILE, strerror(errno));
+    unlink(idx_tmp);
+    unlink(str_tmp);
+    return -1;
+  }
+  return 0;
+}
+
+static void *map_file(const char *path, size_t *size) {
+  struct stat st;
+  void *map;
+  int fd = open(path, O_RDONLY);
+
+  if (fd < 0) return NULL;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    return NULL;
+  }
+  map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) return NULL;
+  *size = (size_t)st.st_size;
+  return map;
+}
+
+int commit_index_open(commit_index_t *index) {
+  const commit_index_header_t *hdr;
+
+  memset(index, 0, sizeof(*index));
+  index->idx_map = map_file(COMMIT_INDEX_FILE, &index->idx_size);
+  if (!index->idx_map) return -1;
+
+  hdr = index->idx_map;
+  if (index->idx_size < sizeof(*hdr) || hdr->magic != COMMIT_INDEX_MAGIC ||
+      hdr->version != COMMIT_INDEX_VERSION || hdr->record_size != sizeof(commit_index_record_t)) {
+    commit_index_close(index);
+    return -1;
+  }
+
+  index->records =
+      (const commit_index_record_t *)((const char *)index->idx_map + sizeof(*hdr));
+  index->count = (index->idx_size - sizeof(*hdr)) / sizeof(commit_index_record_t);
+
+  /* Sem commits ainda não existe log.str */
+  index->str_map = map_file(COMMIT_INDEX_STRINGS, &index->str_size);
+  if (!index->str_map && index->count > 0) {
+    commit_index_close(index);
+    return -1;
+  }
+  return 0;
+}
+
+void commit_index_close(commit_index_t *index) {
+  if (index->idx_map) munmap(index->idx_map, index->idx_size);
+  if (index->str_map) munmap(index->str_map, index->str_size);
+  memset(index, 0, sizeof(*index));
+}
+
+const char *commit_index_string(const commit_index_t *index, uint64_t offset) {
+  const char *base = index->str_map;
+
+  if (!base || offset >= index->str_size) return "";
+  /* Só devolve strings terminadas dentro do arquivo mapeado */
+  if (!memchr(base + offset, '\0', index->str_size - (size_t)offset)) return "";
+  return base + offset;
+}
@@ -0,0 +1,66 @@
+#ifndef CLURG_COMMIT_INDEX_H
+#define CLURG_COMMIT_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "commit.h"
+
+/*
+ * Índice de commits para o `clurg log`, sem abrir nenhum .meta.
+ *
+ *   .clurg/commits/log.idx   cabeçalho + registros de tamanho fixo, na ordem
+ *                            em que os commits foram gravados (append-only)
+ *   .clurg/commits/log.str   autores e mensagens, terminados em '\0'
+ *
+ * As strings são gravadas antes do registro, então um registro completo nunca
+ * aponta para além do fim de log.str. Um registro truncado no fim do arquivo
+ * (commit interrompido) é ignorado.
+ */
+
+#define COMMIT_INDEX_FILE COMMITS_DIR "/log.idx"
+#define COMMIT_INDEX_STRINGS COMMITS_DIR "/log.str"
+#define COMMIT_INDEX_MAGIC 0x474f4c43u /* "CLOG" */
+#define COMMIT_INDEX_VERSION 1
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t record_size;
+  uint32_t reserved;
+} commit_index_header_t;
+
+typedef struct {
+  char id[32];
+  char parent[32];
+  int64_t timestamp;       /* segundos desde a época */
+  uint64_t author_offset;  /* offsets em log.str */
+  uint64_t message_offset;
+  uint64_t size_bytes;
+  uint8_t checksum[SHA256_DIGEST_SIZE];
+} commit_index_record_t;
+
+typedef struct {
+  void *idx_map;
+  size_t idx_size;
+  void *str_map;
+  size_t str_size;
+  const commit_index_record_t *records;
+  size_t count;
+} commit_index_t;
+
+/* Acrescenta um commit ao índice (chamado por commit_write_meta). -1 em erro de
+ * gravação ou com log.idx truncado/inválido; quem chama apaga o índice */
+int commit_index_append(const commit_meta_t *meta);
+
+/* Recria o índice a partir dos .meta (soltos e empacotados) */
+int commit_index_rebuild(void);
+
+/* -1 se o índice não existe ou é inválido */
+int commit_index_open(commit_index_t *index);
+void commit_index_close(commit_index_t *index);
+
+/* String de log.str; "" para offsets inválidos */
+const char *commit_index_string(const commit_index_t *index, uint64_t offset);
+
+#endif /* CLURG_COMMIT_INDEX_H */
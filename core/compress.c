@@ -0,0 +1,67 @@
+#define _GNU_SOURCE
+#include "compress.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "pgzip.h"
+#include "repo_config.h"
+
+#define COMPRESS_READ (256 * 1024)
+
+static int write_stdout(const void *data, size_t len, void *ctx) {
+  const char *p = data;
+
+  (void)ctx;
+  while (len > 0) {
+    ssize_t n = write(STDOUT_FILENO, p, len);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) {
+      fprintf(stderr, "erro ao gravar a saída: %s\n", strerror(errno));
+      return -1;
+    }
+    p += n;
+    len -= (size_t)n;
+  }
+  return 0;
+}
+
+int clurg_compress(int argc, char *argv[]) {
+  /* compress.threads: 0 (padrão) = uma thread por CPU */
+  int threads = (int)repo_config_get_long("compress.threads", 0);
+  int level = (int)repo_config_get_long("compress.level", Z_DEFAULT_COMPRESSION);
+  static char buffer[COMPRESS_READ];
+  pgzip_t *z;
+
+  (void)argv;
+  if (argc > 0) {
+    fprintf(stderr, "Uso: clurg compress < entrada > saida.gz\n");
+    return 1;
+  }
+  if (isatty(STDOUT_FILENO)) {
+    fprintf(stderr, "erro: a saída comprimida não vai para o terminal; redirecione-a\n");
+    return 1;
+  }
+
+  z = pgzip_open(threads, level, write_stdout, NULL);
+  if (!z) return 1;
+
+  while (1) {
+    ssize_t n = read(STDIN_FILENO, buffer, sizeof(buffer));
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0) {
+      fprintf(stderr, "erro ao ler a entrada: %s\n", strerror(errno));
+      pgzip_abort(z);
+      return 1;
+    }
+    if (n == 0) break;
+    if (pgzip_write(z, buffer, (size_t)n) != 0) {
+      pgzip_abort(z);
+      return 1;
+    }
+  }
+  return pgzip_finish(z) != 0;
+}
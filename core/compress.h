@@ -0,0 +1,14 @@
+#ifndef CLURG_COMPRESS_H
+#define CLURG_COMPRESS_H
+
+/*
+ * clurg compress
+ *
+ * Comprime a entrada padrão em gzip na saída padrão com o pgzip, usando
+ * compress.threads e compress.level do .clurg/config (ou CLURG_COMPRESS_*).
+ * Usado pelos scripts de backup no lugar do gzip externo: `tar ... | clurg
+ * compress > backup.tar.gz`.
+ */
+int clurg_compress(int argc, char *argv[]);
+
+#endif
@@ -0,0 +1,384 @@
+#define _GNU_SOURCE
+#include "csnap.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "objects.h"
+#include "repo_config.h"
+
+#define CSNAP_BUFFER_SIZE 65536
+
+typedef struct {
+  int fd;
+  char tmp_path[PATH_MAX];
+  uint64_t offset;
+  sha256_ctx_t sha;
+  z_stream zs;
+  csnap_entry_t *entries;
+  size_t count;
+  size_t capacity;
+  char *strtab;
+  size_t strtab_len;
+  size_t strtab_capacity;
+} csnap_writer_t;
+
+typedef struct {
+  csnap_writer_t *w;
+  const char *prefix;
+} csnap_walk_t;
+
+static int write_all(int fd, const void *data, size_t len) {
+  const unsigned char *p = data;
+  while (len > 0) {
+    ssize_t n = write(fd, p, len);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return -1;
+    }
+    p += n;
+    len -= (size_t)n;
+  }
+  return 0;
+}
+
+int csnap_path_for(const char *commit_id, char *path, size_t size) {
+  if (snprintf(path, size, "%s/%s.csnap", CSNAP_DIR, commit_id) >= (int)size) return -1;
+  return 0;
+}
+
+static int writer_emit(csnap_writer_t *w, const void *data, size_t len) {
+  if (write_all(w->fd, data, len) != 0) {
+    fprintf(stderr, "erro ao gravar %s: %s\n", w->tmp_path, strerror(errno));
+    return -1;
+  }
+  sha256_update(&w->sha, data, len);
+  w->offset += len;
+  return 0;
+}
+
+static csnap_entry_t *writer_push(csnap_writer_t *w, const char *path) {
+  size_t path_len = strlen(path);
+  csnap_entry_t *entry;
+
+  if (w->count == w->capacity) {
+    size_t capacity = w->capacity ? w->capacity * 2 : 256;
+    csnap_entry_t *grown = realloc(w->entries, capacity * sizeof(*grown));
+    if (!grown) return NULL;
+    w->entries = grown;
+    w->capacity = capacity;
+  }
+
+  if (w->strtab_len + path_len + 1 > w->strtab_capacity) {
+    size_t capacity = w->strtab_capacity ? w->strtab_capacity * 2 : 8192;
+    char *grown;
+    while (capacity < w->strtab_len + path_len + 1) capacity *= 2;
+    grown = realloc(w->strtab, capacity);
+    if (!grown) return NULL;
+    w->strtab = grown;
+    w->strtab_capacity = capacity;
+  }
+
+  entry = &w->entries[w->count++];
+  memset(entry, 0, sizeof(*entry));
+  entry->path_offset = w->strtab_len;
+  entry->path_len = (uint32_t)path_len;
+  memcpy(w->strtab + w->strtab_len, path, path_len + 1);
+  w->strtab_len += path_len + 1;
+  return entry;
+}
+
+/* Passa um pedaço do conteúdo pelo deflate da entrada atual */
+static int deflate_chunk(csnap_writer_t *w, const void *data, size_t len, int flush) {
+  unsigned char out[CSNAP_BUFFER_SIZE];
+  int zret;
+
+  w->zs.next_in = (Bytef *)data;
+  w->zs.avail_in = (uInt)len;
+  do {
+    w->zs.next_out = out;
+    w->zs.avail_out = sizeof(out);
+    zret = deflate(&w->zs, flush);
+    if (zret == Z_STREAM_ERROR) return -1;
+    if (writer_emit(w, out, sizeof(out) - w->zs.avail_out) != 0) return -1;
+  } while (w->zs.avail_out == 0 || (flush == Z_FINISH && zret != Z_STREAM_END));
+  return 0;
+}
+
+static int content_sink(const void *data, size_t len, void *ctx) {
+  csnap_writer_t *w = ctx;
+
+  /* avail_in é uInt: pedaços grandes vão em partes */
+  while (len > 0) {
+    size_t part = len > (1u << 30) ? (1u << 30) : len;
+    if (deflate_chunk(w, data, part, Z_NO_FLUSH) != 0) return -1;
+    data = (const unsigned char *)data + part;
+    len -= part;
+  }
+  return 0;
+}
+
+static int add_tree_entry(const objects_tree_entry_t *tree_entry, void *ctx) {
+  csnap_walk_t *walk = ctx;
+  csnap_writer_t *w = walk->w;
+  char name[PATH_MAX];
+  csnap_entry_t *entry;
+  obj_type_t type;
+  uint64_t size;
+  uint64_t start;
+  size_t index;
+
+  if (snprintf(name, sizeof(name), "%s%s", walk->prefix, tree_entry->name) >= (int)sizeof(name) - 1) {
+    fprintf(stderr, "caminho muito longo: %s%s\n", walk->prefix, tree_entry->name);
+    return -1;
+  }
+
+  if (tree_entry->mode == OBJ_MODE_DIR) {
+    csnap_walk_t sub = {w, name};
+    strcat(name, "/");
+    return objects_tree_foreach(tree_entry->hex, add_tree_entry, &sub);
+  }
+
+  if (objects_read_header(tree_entry->hex, &type, &size) != 0) return -1;
+
+  entry = writer_push(w, name);
+  if (!entry) {
+    fprintf(stderr, "erro: memória insuficiente\n");
+    return -1;
+  }
+  index = (size_t)(entry - w->entries);
+  entry->mode = tree_entry->mode;
+  entry->size = size;
+  entry->offset = w->offset;
+  sha256_from_hex(tree_entry->hex, entry->hash);
+
+  start = w->offset;
+  if (deflateReset(&w->zs) != Z_OK || objects_read_stream(tree_entry->hex, content_sink, w) != 0 ||
+      deflate_chunk(w, NULL, 0, Z_FINISH) != 0) {
+    return -1;
+  }
+  w->entries[index].csize = w->offset - start;
+  return 0;
+}
+
+static int compare_entries(const void *a, const void *b, void *strtab) {
+  const csnap_entry_t *ea = a;
+  const csnap_entry_t *eb = b;
+  return strcmp((const char *)strtab + ea->path_offset, (const char *)strtab + eb->path_offset);
+}
+
+int csnap_create_from_tree(const char *tree_hex, const char *out_path, snapshot_info_t *info) {
+  csnap_writer_t w;
+  csnap_walk_t walk;
+  csnap_header_t hdr;
+  csnap_trailer_t trailer;
+  int level = (int)repo_config_get_long("compress.level", Z_DEFAULT_COMPRESSION);
+  int ret;
+
+  memset(&w, 0, sizeof(w));
+  if (snprintf(w.tmp_path, sizeof(w.tmp_path), "%s.tmp", out_path) >= (int)sizeof(w.tmp_path)) {
+    fprintf(stderr, "caminho muito longo: %s\n", out_path);
+    return -1;
+  }
+  if (deflateInit(&w.zs, level) != Z_OK) {
+    fprintf(stderr, "erro ao iniciar deflate\n");
+    return -1;
+  }
+  w.fd = open(w.tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (w.fd < 0) {
+    fprintf(stderr, "erro ao criar %s: %s\n", w.tmp_path, strerror(errno));
+    deflateEnd(&w.zs);
+    return -1;
+  }
+  sha256_init(&w.sha);
+
+  memset(&hdr, 0, sizeof(hdr));
+  hdr.magic = CSNAP_MAGIC;
+  hdr.version = CSNAP_VERSION;
+  ret = writer_emit(&w, &hdr, sizeof(hdr));
+
+  walk.w = &w;
+  walk.prefix = "";
+  if (ret == 0) ret = objects_tree_foreach(tree_hex, add_tree_entry, &walk);
+
+  if (ret == 0) {
+    qsort_r(w.entries, w.count, sizeof(csnap_entry_t), compare_entries, w.strtab);
+
+    memset(&trailer, 0, sizeof(trailer));
+    trailer.toc_offset = w.offset;
+    trailer.count = w.count;
+    trailer.strtab_size = w.strtab_len;
+    trailer.magic = CSNAP_MAGIC;
+    trailer.version = CSNAP_VERSION;
+
+    ret = writer_emit(&w, w.entries, w.count * sizeof(csnap_entry_t));
+    if (ret == 0) ret = writer_emit(&w, w.strtab, w.strtab_len);
+    if (ret == 0) ret = writer_emit(&w, &trailer, sizeof(trailer));
+  }
+
+  deflateEnd(&w.zs);
+  if (close(w.fd) != 0) ret = -1;
+  if (ret == 0 && rename(w.tmp_path, out_path) != 0) {
+    fprintf(stderr, "erro ao gravar %s: %s\n", out_path, strerror(errno));
+    ret = -1;
+  }
+  if (ret != 0) unlink(w.tmp_path);
+
+  if (ret == 0 && info) {
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    sha256_final(&w.sha, digest);
+    sha256_to_hex(digest, info->checksum);
+    info->size = w.offset;
+    info->files = w.count;
+    info->threads = 1;
+  }
+
+  free(w.entries);
+  free(w.strtab);
+  return ret;
+}
+
+int csnap_open(csnap_t *snap, const char *path) {
+  csnap_trailer_t trailer;
+  struct stat st;
+  uint64_t toc_size;
+  off_t map_offset;
+  long page = sysconf(_SC_PAGESIZE);
+
+  memset(snap, 0, sizeof(*snap));
+  snap->fd = open(path, O_RDONLY);
+  if (snap->fd < 0) return -1;
+
+  if (fstat(snap->fd, &st) != 0 ||
+      (uint64_t)st.st_size < sizeof(csnap_header_t) + sizeof(trailer) ||
+      pread(snap->fd, &trailer, sizeof(trailer), st.st_size - (off_t)sizeof(trailer)) !=
+          (ssize_t)sizeof(trailer)) {
+    goto invalid;
+  }
+
+  toc_size = trailer.count * sizeof(csnap_entry_t) + trailer.strtab_size;
+  if (trailer.magic != CSNAP_MAGIC || trailer.version != CSNAP_VERSION ||
+      trailer.toc_offset < sizeof(csnap_header_t) ||
+      trailer.toc_offset + toc_size + sizeof(trailer) != (uint64_t)st.st_size) {
+    goto invalid;
+  }
+
+  /* Só o índice é mapeado; os dados são lidos com pread sob demanda */
+  map_offset = (off_t)(trailer.toc_offset & ~(uint64_t)(page - 1));
+  snap->map_size = (size_t)(st.st_size - map_offset);
+  snap->map = mmap(NULL, snap->map_size, PROT_READ, MAP_PRIVATE, snap->fd, map_offset);
+  if (snap->map == MAP_FAILED) {
+    snap->map = NULL;
+    goto invalid;
+  }
+
+  snap->entries =
+      (const csnap_entry_t *)((const char *)snap->map + (trailer.toc_offset - (uint64_t)map_offset));
+  snap->strtab = (const char *)(snap->entries + trailer.count);
+  snap->count = (size_t)trailer.count;
+  if (trailer.strtab_size > 0 && snap->strtab[trailer.strtab_size - 1] != '\0') goto invalid;
+  return 0;
+
+invalid:
+  fprintf(stderr, "aviso: %s inválido, ignorando\n", path);
+  csnap_close(snap);
+  return -1;
+}
+
+void csnap_close(csnap_t *snap) {
+  if (snap->map) munmap(snap->map, snap->map_size);
+  if (snap->fd >= 0) close(snap->fd);
+  memset(snap, 0, sizeof(*snap));
+  snap->fd = -1;
+}
+
+const char *csnap_entry_path(const csnap_t *snap, const csnap_entry_t *entry) {
+  return snap->strtab + entry->path_offset;
+}
+
+const csnap_entry_t *csnap_find(const csnap_t *snap, const char *path) {
+  size_t lo = 0;
+  size_t hi = snap->count;
+
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    int cmp = strcmp(path, csnap_entry_path(snap, &snap->entries[mid]));
+    if (cmp == 0) return &snap->entries[mid];
+    if (cmp < 0) {
+      hi = mid;
+    } else {
+      lo = mid + 1;
+    }
+  }
+  return NULL;
+}
+
+int csnap_extract_to_fd(const csnap_t *snap, const csnap_entry_t *entry, int fd) {
+  unsigned char in[CSNAP_BUFFER_SIZE];
+  unsigned char out[CSNAP_BUFFER_SIZE];
+  uint8_t digest[SHA256_DIGEST_SIZE];
+  uint64_t pos = entry->offset;
+  uint64_t remaining = entry->csize;
+  uint64_t produced = 0;
+  sha256_ctx_t sha;
+  z_stream zs;
+  int zret = Z_OK;
+  int ret = 0;
+
+  memset(&zs, 0, sizeof(zs));
+  if (inflateInit(&zs) != Z_OK) return -1;
+  sha256_init(&sha);
+
+  while (ret == 0 && zret != Z_STREAM_END && remaining > 0) {
+    size_t want = remaining > sizeof(in) ? sizeof(in) : (size_t)remaining;
+    ssize_t n = pread(snap->fd, in, want, (off_t)pos);
+
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) {
+      ret = -1;
+      break;
+    }
+    pos += (uint64_t)n;
+    remaining -= (uint64_t)n;
+
+    zs.next_in = in;
+    zs.avail_in = (uInt)n;
+    do {
+      size_t have;
+      zs.next_out = out;
+      zs.avail_out = sizeof(out);
+      zret = inflate(&zs, Z_NO_FLUSH);
+      if (zret != Z_OK && zret != Z_STREAM_END) {
+        ret = -1;
+        break;
+      }
+      have = sizeof(out) - zs.avail_out;
+      sha256_update(&sha, out, have);
+      produced += have;
+      if (write_all(fd, out, have) != 0) {
+        fprintf(stderr, "erro ao escrever: %s\n", strerror(errno));
+        ret = -1;
+        break;
+      }
+    } while (zs.avail_out == 0 && zret != Z_STREAM_END);
+  }
+  inflateEnd(&zs);
+
+  if (ret == 0 && (zret != Z_STREAM_END || produced != entry->size)) ret = -1;
+  if (ret == 0) {
+    sha256_final(&sha, digest);
+    if (memcmp(digest, entry->hash, SHA256_DIGEST_SIZE) != 0) ret = -1;
+  }
+  if (ret != 0) {
+    fprintf(stderr, "erro: conteúdo de %s corrompido no snapshot\n", csnap_entry_path(snap, entry));
+  }
+  return ret;
+}
@@ -0,0 +1,79 @@
+#ifndef CLURG_CSNAP_H
+#define CLURG_CSNAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sha256.h"
+#include "snapshot.h"
+
+/*
+ * Snapshot com acesso aleatório (.csnap).
+ *
+ * Cada arquivo é comprimido de forma independente (stream zlib próprio) e um
+ * índice no fim do arquivo mapeia caminho -> offset, tamanho comprimido,
+ * tamanho original, modo e hash. Extrair um arquivo lê só o trailer, o
+ * índice (via mmap) e os bytes comprimidos daquele arquivo.
+ *
+ * Layout (little-endian):
+ *   csnap_header_t
+ *   dados          streams zlib concatenados, na ordem da tree
+ *   csnap_entry_t[count]  ordenado por caminho (strcmp)
+ *   tabela de strings     caminhos relativos, terminados em '\0'
+ *   csnap_trailer_t
+ *
+ * Symlinks guardam o alvo como conteúdo; diretórios não têm entrada.
+ */
+
+#define CSNAP_MAGIC 0x504e5343u /* "CSNP" */
+#define CSNAP_VERSION 1
+#define CSNAP_DIR ".clurg/snapshots"
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+} csnap_header_t;
+
+typedef struct {
+  uint64_t offset;      /* início do stream zlib */
+  uint64_t csize;       /* bytes comprimidos */
+  uint64_t size;        /* bytes originais */
+  uint64_t path_offset; /* offset na tabela de strings */
+  uint32_t path_len;
+  uint32_t mode;        /* OBJ_MODE_* */
+  uint8_t hash[SHA256_DIGEST_SIZE];
+} csnap_entry_t;
+
+typedef struct {
+  uint64_t toc_offset;
+  uint64_t count;
+  uint64_t strtab_size; /* a tabela vem logo depois das entradas */
+  uint32_t magic;
+  uint32_t version;
+} csnap_trailer_t;
+
+/* Snapshot aberto para leitura */
+typedef struct {
+  int fd;
+  void *map; /* índice mapeado (a partir de uma página alinhada) */
+  size_t map_size;
+  const csnap_entry_t *entries;
+  const char *strtab;
+  size_t count;
+} csnap_t;
+
+/* Caminho do .csnap de um commit (.clurg/snapshots/<id>.csnap) */
+int csnap_path_for(const char *commit_id, char *path, size_t size);
+
+/* Grava o snapshot de uma tree (temporário + rename) */
+int csnap_create_from_tree(const char *tree_hex, const char *out_path, snapshot_info_t *info);
+
+int csnap_open(csnap_t *snap, const char *path);
+void csnap_close(csnap_t *snap);
+const csnap_entry_t *csnap_find(const csnap_t *snap, const char *path);
+const char *csnap_entry_path(const csnap_t *snap, const csnap_entry_t *entry);
+
+/* Descomprime uma entrada em fd, conferindo tamanho e hash */
+int csnap_extract_to_fd(const csnap_t *snap, const csnap_entry_t *entry, int fd);
+
+#endif /* CLURG_CSNAP_H */
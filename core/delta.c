@@ -0,0 +1,232 @@
+#include "delta.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DELTA_MAX_INSERT 127
+#define DELTA_MAX_COPY 0xffffff
+
+typedef struct {
+  unsigned char *data;
+  size_t len;
+  size_t cap;
+  size_t max;
+} delta_buf_t;
+
+static int buf_reserve(delta_buf_t *b, size_t extra) {
+  size_t cap;
+  unsigned char *grown;
+
+  if (b->len + extra > b->max) return -1;
+  if (b->len + extra <= b->cap) return 0;
+  cap = b->cap ? b->cap * 2 : 4096;
+  while (cap < b->len + extra) cap *= 2;
+  grown = realloc(b->data, cap);
+  if (!grown) return -1;
+  b->data = grown;
+  b->cap = cap;
+  return 0;
+}
+
+static int put_varint(delta_buf_t *b, uint64_t value) {
+  if (buf_reserve(b, 10) != 0) return -1;
+  do {
+    unsigned char c = value & 0x7f;
+    value >>= 7;
+    b->data[b->len++] = c | (value ? 0x80 : 0);
+  } while (value);
+  return 0;
+}
+
+static int put_insert(delta_buf_t *b, const unsigned char *data, size_t len) {
+  while (len > 0) {
+    size_t n = len > DELTA_MAX_INSERT ? DELTA_MAX_INSERT : len;
+    if (buf_reserve(b, n + 1) != 0) return -1;
+    b->data[b->len++] = (unsigned char)n;
+    memcpy(b->data + b->len, data, n);
+    b->len += n;
+    data += n;
+    len -= n;
+  }
+  return 0;
+}
+
+static int put_copy(delta_buf_t *b, uint32_t offset, size_t len) {
+  while (len > 0) {
+    uint32_t n = len > DELTA_MAX_COPY ? DELTA_MAX_COPY : (uint32_t)len;
+    unsigned char *cmd;
+    int i;
+
+    if (buf_reserve(b, 8) != 0) return -1;
+    cmd = &b->data[b->len++];
+    *cmd = 0x80;
+    for (i = 0; i < 4; i++) {
+      unsigned char byte = (unsigned char)(offset >> (8 * i));
+      if (byte) {
+        *cmd |= (unsigned char)(1 << i);
+        b->data[b->len++] = byte;
+      }
+    }
+    for (i = 0; i < 3; i++) {
+      unsigned char byte = (unsigned char)(n >> (8 * i));
+      if (byte) {
+        *cmd |= (unsigned char)(0x10 << i);
+        b->data[b->len++] = byte;
+      }
+    }
+    offset += n;
+    len -= n;
+  }
+  return 0;
+}
+
+static uint32_t block_hash(const unsigned char *p, int shift) {
+  uint64_t a;
+  uint64_t b;
+  memcpy(&a, p, 8);
+  memcpy(&b, p + 8, 8);
+  return (uint32_t)(((a * 0x9e3779b97f4a7c15ULL) ^ (b * 0xc2b2ae3d27d4eb4fULL)) >> shift);
+}
+
+int delta_create(const unsigned char *base, size_t base_len, const unsigned char *target,
+                 size_t target_len, size_t max_len, unsigned char **out, size_t *out_len) {
+  delta_buf_t b = {NULL, 0, 0, max_len};
+  uint32_t *table = NULL;
+  size_t table_bits = 4;
+  size_t lit_start = 0;
+  size_t i = 0;
+
+  /* Offsets de cópia têm 32 bits */
+  if (base_len > UINT32_MAX) return -1;
+  if (put_varint(&b, base_len) != 0 || put_varint(&b, target_len) != 0) goto fail;
+
+  if (base_len >= DELTA_BLOCK) {
+    size_t blocks = base_len / DELTA_BLOCK;
+    size_t j;
+
+    while (((size_t)1 << table_bits) < blocks * 2) table_bits++;
+    table = calloc((size_t)1 << table_bits, sizeof(*table));
+    if (!table) goto fail;
+
+    /* Em colisão fica o bloco mais antigo: cópias longas tendem a começar cedo */
+    for (j = blocks; j-- > 0;) {
+      table[block_hash(base + j * DELTA_BLOCK, 64 - (int)table_bits)] = (uint32_t)(j * DELTA_BLOCK) + 1;
+    }
+
+    while (i + DELTA_BLOCK <= target_len) {
+      uint32_t slot = table[block_hash(target + i, 64 - (int)table_bits)];
+      size_t off;
+      size_t len;
+
+      if (!slot || memcmp(base + slot - 1, target + i, DELTA_BLOCK) != 0) {
+        i++;
+        continue;
+      }
+
+      off = slot - 1;
+      len = DELTA_BLOCK;
+      while (off + len < base_len && i + len < target_len && base[off + len] == target[i + len]) {
+        len++;
+      }
+      while (i > lit_start && off > 0 && base[off - 1] == target[i - 1]) {
+        i--;
+        off--;
+        len++;
+      }
+
+      if (put_insert(&b, target + lit_start, i - lit_start) != 0 ||
+          put_copy(&b, (uint32_t)off, len) != 0) {
+        goto fail;
+      }
+      i += len;
+      lit_start = i;
+    }
+  }
+
+  if (put_insert(&b, target + lit_start, target_len - lit_start) != 0) goto fail;
+
+  free(table);
+  *out = b.data;
+  *out_len = b.len;
+  return 0;
+
+fail:
+  free(table);
+  free(b.data);
+  return -1;
+}
+
+static int get_varint(const unsigned char **p, const unsigned char *end, uint64_t *value) {
+  int shift = 0;
+
+  *value = 0;
+  while (*p < end && shift < 64) {
+    unsigned char c = *(*p)++;
+    *value |= (uint64_t)(c & 0x7f) << shift;
+    if (!(c & 0x80)) return 0;
+    shift += 7;
+  }
+  return -1;
+}
+
+int delta_apply(const unsigned char *base, size_t base_len, const unsigned char *delta,
+                size_t delta_len, unsigned char **out, size_t *out_len) {
+  const unsigned char *p = delta;
+  const unsigned char *end = delta + delta_len;
+  uint64_t expect_base;
+  uint64_t result_len;
+  unsigned char *result;
+  size_t pos = 0;
+
+  if (get_varint(&p, end, &expect_base) != 0 || get_varint(&p, end, &result_len) != 0 ||
+      expect_base != base_len) {
+    return -1;
+  }
+
+  result = malloc(result_len + 1);
+  if (!result) return -1;
+
+  while (p < end) {
+    unsigned char cmd = *p++;
+
+    if (cmd & 0x80) {
+      uint64_t off = 0;
+      uint64_t len = 0;
+      int i;
+
+      for (i = 0; i < 4; i++) {
+        if (cmd & (1 << i)) {
+          if (p >= end) goto fail;
+          off |= (uint64_t)*p++ << (8 * i);
+        }
+      }
+      for (i = 0; i < 3; i++) {
+        if (cmd & (0x10 << i)) {
+          if (p >= end) goto fail;
+          len |= (uint64_t)*p++ << (8 * i);
+        }
+      }
+      if (len == 0) len = 0x10000;
+      if (off + len > base_len || pos + len > result_len) goto fail;
+      memcpy(result + pos, base + off, (size_t)len);
+      pos += (size_t)len;
+    } else if (cmd > 0) {
+      if ((size_t)(end - p) < cmd || pos + cmd > result_len) goto fail;
+      memcpy(result + pos, p, cmd);
+      p += cmd;
+      pos += cmd;
+    } else {
+      goto fail; /* instrução 0 é reservada */
+    }
+  }
+
+  if (pos != result_len) goto fail;
+  *out = result;
+  *out_len = pos;
+  return 0;
+
+fail:
+  free(result);
+  return -1;
+}
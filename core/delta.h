@@ -0,0 +1,31 @@
+#ifndef CLURG_DELTA_H
+#define CLURG_DELTA_H
+
+#include <stddef.h>
+
+/*
+ * Deltas binários entre duas versões de um arquivo (formato do git).
+ *
+ *   varint tamanho_base, varint tamanho_resultado, instruções:
+ *   1xxxxxxx  copy: bits 0-3 dizem quais bytes do offset (LE) seguem,
+ *             bits 4-6 quais bytes do tamanho; tamanho 0 = 0x10000
+ *   0nnnnnnn  insert: os próximos n bytes (1..127) são literais
+ *
+ * As cópias são encontradas indexando a base em blocos de DELTA_BLOCK bytes e
+ * estendendo cada coincidência para os dois lados.
+ */
+
+#define DELTA_BLOCK 16
+
+/*
+ * Gera o delta de `target` contra `base`. Retorna -1 se o delta passaria de
+ * `max_len` bytes (não compensa) ou sem memória; `*out` deve ser liberado.
+ */
+int delta_create(const unsigned char *base, size_t base_len, const unsigned char *target,
+                 size_t target_len, size_t max_len, unsigned char **out, size_t *out_len);
+
+/* Aplica `delta` sobre `base`; `*out` (alocado) recebe o resultado */
+int delta_apply(const unsigned char *base, size_t base_len, const unsigned char *delta,
+                size_t delta_len, unsigned char **out, size_t *out_len);
+
+#endif /* CLURG_DELTA_H */
@@ -12,6 +12,9 @@
 #include <time.h>
 #include <unistd.h>
 
+#include "commit.h"
+#include "objects.h"
+
 // Função auxiliar para obter timestamp formatado
 static void get_timestamp(char *buffer, size_t size) {
   time_t now = time(NULL);
@@ -172,6 +175,38 @@ int deploy_execute(const char *project_name, const char *environment, const char
   char commit_path[4096];
   char cmd[4096];
 
+  // Caminho do snapshot legado do projeto
+  int len = snprintf(commit_path, sizeof(commit_path), ".clurg/projects/%s/commits/%s.tar.gz",
+                     project_name, commit_id);
+  if (len < 0 || (size_t)len >= sizeof(commit_path)) {
+    fprintf(stderr, "Caminho do commit longo demais\n");
+    return -1;
+  }
+
+  /* Um projeto com .clurg/projects/<p>/commits/ só aceita os próprios snapshots.
+   * Sem esse diretório o projeto é o próprio repositório (o nome vem do cwd) e
+   * o commit precisa existir no object store dele. Resolver antes de criar o
+   * diretório de deploy evita deixar um ambiente vazio para um id inválido. */
+  int legacy = access(commit_path, F_OK) == 0;
+  char tree_hex[SHA256_HEX_SIZE];
+
+  if (!legacy) {
+    char project_commits[4096];
+
+    snprintf(project_commits, sizeof(project_commits), ".clurg/projects/%s/commits",
+             project_name);
+    if (access(project_commits, F_OK) == 0) {
+      fprintf(stderr, "erro: commit %s não pertence ao projeto %s (%s)\n", commit_id,
+              project_name, project_commits);
+      return -1;
+    }
+    if (commit_read_meta_field(commit_id, "tree", tree_hex, sizeof(tree_hex)) != 0) {
+      fprintf(stderr, "erro: commit %s não existe no repositório do projeto %s\n", commit_id,
+              project_name);
+      return -1;
+    }
+  }
+
   // Criar diretório de deploy se não existir
   snprintf(deploy_dir, sizeof(deploy_dir), ".clurg/projects/%s/deploy/%s", project_name,
            environment);
@@ -181,21 +216,25 @@ int deploy_execute(const char *project_name, const char *environment, const char
     return -1;
   }
 
-  // Extrair commit para diretório temporário
-  snprintf(commit_path, sizeof(commit_path), ".clurg/projects/%s/commits/%s.tar.gz", project_name,
-           commit_id);
-
-  if (access(commit_path, F_OK) != 0) {
-    fprintf(stderr, "Commit %s não encontrado\n", commit_id);
-    return -1;
-  }
-
-  // Extrair commit
-  printf("📦 Extraindo commit %s...\n", commit_id);
-  snprintf(cmd, sizeof(cmd), "cd %s && tar -xzf ../%s", deploy_dir, commit_path);
-  if (system(cmd) != 0) {
-    fprintf(stderr, "Erro ao extrair commit\n");
-    return -1;
+  if (legacy) {
+    // Extrair commit
+    printf("📦 Extraindo commit %s...\n", commit_id);
+    len = snprintf(cmd, sizeof(cmd), "cd %s && tar -xzf ../%s", deploy_dir, commit_path);
+    if (len < 0 || (size_t)len >= sizeof(cmd)) {
+      fprintf(stderr, "Comando de extração longo demais\n");
+      return -1;
+    }
+    if (system(cmd) != 0) {
+      fprintf(stderr, "Erro ao extrair commit\n");
+      return -1;
+    }
+  } else {
+    // Sem tar.gz: reconstruir a partir do object store
+    printf("📦 Reconstruindo commit %s a partir dos objetos...\n", commit_id);
+    if (objects_checkout(tree_hex, deploy_dir) != 0) {
+      fprintf(stderr, "Erro ao reconstruir commit\n");
+      return -1;
+    }
   }
 
   // Executar comando de deploy
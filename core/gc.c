@@ -0,0 +1,700 @@
+#define _GNU_SOURCE
+#include "gc.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "commit.h"
+#include "commit_index.h"
+#include "csnap.h"
+#include "index.h"
+#include "objects.h"
+#include "repo_config.h"
+
+#define GC_STATE_MAGIC 0x43474c43u /* "CLGC" */
+#define GC_STATE_VERSION 1
+#define GC_FANOUTS 256      /* cursor 0..255: diretórios de objetos soltos */
+#define GC_CURSOR_PACKS 256 /* depois deles, os packs */
+#define GC_STATE_STALE 1u   /* commits apagados nesta volta: marcas podem sobrar */
+#define GC_MIN_MARKS 256    /* progresso mínimo por execução, mesmo sem orçamento */
+
+#define GC_DEFAULT_GRACE 3600
+#define GC_DEFAULT_KEEP_MIN 5
+#define GC_AUTO_MAX_MS 100
+#define GC_AUTO_MAX_IO (32L * 1024 * 1024)
+
+typedef struct {
+  long keep_commits; /* 0 = sem limite */
+  long keep_days;    /* 0 = sem limite */
+  long keep_min;
+  long keep_backups; /* 0 = não mexe nos backups */
+  long max_ms;       /* 0 = sem limite */
+  long max_io;       /* bytes; 0 = sem limite */
+  long grace;        /* segundos */
+} gc_options_t;
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t cursor;
+  uint32_t flags;
+  uint64_t count;
+} gc_state_header_t;
+
+/* Digests marcados: endereçamento aberto, a chave já é um hash */
+typedef struct {
+  uint8_t (*keys)[SHA256_DIGEST_SIZE];
+  uint8_t *used;
+  size_t count;
+  size_t capacity;
+} mark_set_t;
+
+typedef struct {
+  struct timespec start;
+  long max_ms;
+  uint64_t max_io;
+  uint64_t io;
+} budget_t;
+
+typedef struct {
+  mark_set_t *marks;
+  budget_t *budget;
+  uint64_t marked;
+  int exhausted;
+} mark_ctx_t;
+
+typedef struct {
+  char (*ids)[32];
+  size_t count;
+  size_t capacity;
+} id_list_t;
+
+static size_t mark_slot(const mark_set_t *set, const uint8_t key[SHA256_DIGEST_SIZE]) {
+  uint64_t h;
+
+  memcpy(&h, key, sizeof(h));
+  return (size_t)h & (set->capacity - 1);
+}
+
+static int mark_has(const mark_set_t *set, const uint8_t key[SHA256_DIGEST_SIZE]) {
+  size_t i;
+
+  if (set->capacity == 0) return 0;
+  for (i = mark_slot(set, key); set->used[i]; i = (i + 1) & (set->capacity - 1)) {
+    if (memcmp(set->keys[i], key, SHA256_DIGEST_SIZE) == 0) return 1;
+  }
+  return 0;
+}
+
+static int mark_add(mark_set_t *set, const uint8_t key[SHA256_DIGEST_SIZE]);
+
+static int mark_grow(mark_set_t *set) {
+  mark_set_t grown;
+  size_t i;
+
+  grown.capacity = set->capacity ? set->capacity * 2 : 4096;
+  grown.count = 0;
+  grown.keys = malloc(grown.capacity * sizeof(*grown.keys));
+  grown.used = calloc(grown.capacity, 1);
+  if (!grown.keys || !grown.used) {
+    free(grown.keys);
+    free(grown.used);
+    return -1;
+  }
+  for (i = 0; i < set->capacity; i++) {
+    if (set->used[i]) mark_add(&grown, set->keys[i]);
+  }
+  free(set->keys);
+  free(set->used);
+  *set = grown;
+  return 0;
+}
+
+static int mark_add(mark_set_t *set, const uint8_t key[SHA256_DIGEST_SIZE]) {
+  size_t i;
+
+  if ((set->count + 1) * 10 > set->capacity * 7 && mark_grow(set) != 0) return -1;
+  for (i = mark_slot(set, key); set->used[i]; i = (i + 1) & (set->capacity - 1)) {
+    if (memcmp(set->keys[i], key, SHA256_DIGEST_SIZE) == 0) return 0;
+  }
+  memcpy(set->keys[i], key, SHA256_DIGEST_SIZE);
+  set->used[i] = 1;
+  set->count++;
+  return 0;
+}
+
+static void mark_free(mark_set_t *set) {
+  free(set->keys);
+  free(set->used);
+  memset(set, 0, sizeof(*set));
+}
+
+static long elapsed_ms(const budget_t *budget) {
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - budget->start.tv_sec) * 1000 +
+         (now.tv_nsec - budget->start.tv_nsec) / 1000000;
+}
+
+static int budget_exhausted(const budget_t *budget) {
+  if (budget->max_io > 0 && budget->io >= budget->max_io) return 1;
+  return budget->max_ms > 0 && elapsed_ms(budget) >= budget->max_ms;
+}
+
+/* Marcas e cursor da volta em andamento; qualquer problema recomeça do zero */
+static void load_state(mark_set_t *marks, uint32_t *cursor, uint32_t *flags) {
+  gc_state_header_t hdr;
+  uint8_t key[SHA256_DIGEST_SIZE];
+  uint64_t i;
+  FILE *fp = fopen(GC_STATE_FILE, "rb");
+
+  *cursor = 0;
+  *flags = 0;
+  if (!fp) return;
+  if (fread(&hdr, sizeof(hdr), 1, fp) != 1 || hdr.magic != GC_STATE_MAGIC ||
+      hdr.version != GC_STATE_VERSION || hdr.cursor > GC_CURSOR_PACKS) {
+    fclose(fp);
+    return;
+  }
+  for (i = 0; i < hdr.count; i++) {
+    if (fread(key, sizeof(key), 1, fp) != 1 || mark_add(marks, key) != 0) {
+      fclose(fp);
+      mark_free(marks);
+      return;
+    }
+  }
+  fclose(fp);
+  *cursor = hdr.cursor;
+  *flags = hdr.flags;
+}
+
+static int save_state(const mark_set_t *marks, uint32_t cursor, uint32_t flags) {
+  char tmp_path[] = GC_STATE_FILE ".tmp";
+  gc_state_header_t hdr = {GC_STATE_MAGIC, GC_STATE_VERSION, cursor, flags, marks->count};
+  FILE *fp = fopen(tmp_path, "wb");
+  size_t i;
+  int ok;
+
+  if (!fp) {
+    fprintf(stderr, "aviso: não foi possível gravar %s: %s\n", GC_STATE_FILE, strerror(errno));
+    return -1;
+  }
+  ok = fwrite(&hdr, sizeof(hdr), 1, fp) == 1;
+  for (i = 0; ok && i < marks->capacity; i++) {
+    if (marks->used[i]) ok = fwrite(marks->keys[i], SHA256_DIGEST_SIZE, 1, fp) == 1;
+  }
+  if (fclose(fp) != 0 || !ok || rename(tmp_path, GC_STATE_FILE) != 0) {
+    fprintf(stderr, "aviso: não foi possível gravar %s\n", GC_STATE_FILE);
+    unlink(tmp_path);
+    return -1;
+  }
+  return 0;
+}
+
+/* Marca `hex` depois de tudo de que ele depende (pós-ordem) */
+static int mark_object(const char *hex, void *arg) {
+  mark_ctx_t *ctx = arg;
+  uint8_t key[SHA256_DIGEST_SIZE];
+
+  if (sha256_from_hex(hex, key) != 0) return -1;
+  if (mark_has(ctx->marks, key)) return 0;
+  /*
+   * Cada execução relê o caminho da raiz até onde parou, então sem um mínimo
+   * de marcas um orçamento pequeno nunca avançaria.
+   */
+  if (ctx->marked >= GC_MIN_MARKS && budget_exhausted(ctx->budget)) {
+    ctx->exhausted = 1;
+    return -1;
+  }
+  if (objects_references(hex, mark_object, ctx, &ctx->budget->io) != 0) return -1;
+  if (mark_add(ctx->marks, key) != 0) return -1;
+  ctx->marked++;
+  return 0;
+}
+
+static int is_marked(const uint8_t digest[SHA256_DIGEST_SIZE], void *ctx) {
+  return mark_has(ctx, digest);
+}
+
+static int id_list_add(id_list_t *list, const char *id) {
+  if (list->count == list->capacity) {
+    size_t capacity = list->capacity ? list->capacity * 2 : 64;
+    char (*grown)[32] = realloc(list->ids, capacity * sizeof(*grown));
+    if (!grown) return -1;
+    list->ids = grown;
+    list->capacity = capacity;
+  }
+  snprintf(list->ids[list->count++], sizeof(list->ids[0]), "%s", id);
+  return 0;
+}
+
+static int compare_list_ids(const void *a, const void *b) {
+  return strcmp(a, b);
+}
+
+/* Ordena e tira repetições, para id_list_has */
+static void id_list_sort(id_list_t *list) {
+  size_t out = 0;
+  size_t i;
+
+  qsort(list->ids, list->count, sizeof(list->ids[0]), compare_list_ids);
+  for (i = 0; i < list->count; i++) {
+    if (out == 0 || strcmp(list->ids[out - 1], list->ids[i]) != 0) {
+      memmove(list->ids[out++], list->ids[i], sizeof(list->ids[0]));
+    }
+  }
+  list->count = out;
+}
+
+static int id_list_has(const id_list_t *list, const char *id) {
+  return bsearch(id, list->ids, list->count, sizeof(list->ids[0]), compare_list_ids) != NULL;
+}
+
+static time_t meta_time(const commit_meta_t *meta) {
+  struct tm tm;
+
+  memset(&tm, 0, sizeof(tm));
+  if (!strptime(meta->timestamp, "%Y-%m-%d %H:%M:%S", &tm)) return 0;
+  tm.tm_isdst = -1;
+  return mktime(&tm);
+}
+
+/* Cadeia de `tip` até a primeira regra de retenção que falhar */
+static int collect_line(const gc_options_t *opts, time_t now, const char *tip, id_list_t *kept) {
+  commit_meta_t meta;
+  char id[32];
+  long depth = 0;
+
+  snprintf(id, sizeof(id), "%s", tip);
+  while (id[0] && commit_read_meta(id, &meta) == 0) {
+    /* A regra de idade nunca derruba os gc.keep_min mais recentes */
+    int keep = (opts->keep_commits == 0 || depth < opts->keep_commits) &&
+               (opts->keep_days == 0 || depth < opts->keep_min ||
+                now - meta_time(&meta) <= opts->keep_days * 86400L);
+
+    if (!keep) break;
+    if (id_list_add(kept, id) != 0) return -1;
+    /* Repositórios antigos podem ter commits que apontam para si mesmos */
+    if (strcmp(meta.parent, id) == 0) break;
+    snprintf(id, sizeof(id), "%s", meta.parent);
+    depth++;
+  }
+  return 0;
+}
+
+/*
+ * Commits mantidos. Sem --keep-commits/--keep-days (nem gc.keep_* no config)
+ * nenhum commit é apagado. Com eles, a retenção vale para cada linha de
+ * histórico: HEAD, as pontas de .clurg/refs/tips e todo commit que não é pai
+ * de outro (pontas anteriores ao refs/tips, históricos trazidos por fetch).
+ */
+static int collect_history(const gc_options_t *opts, time_t now, id_list_t *kept) {
+  id_list_t parents = {NULL, 0, 0};
+  char **ids;
+  char **tips;
+  size_t count;
+  size_t tip_count;
+  size_t i;
+  char head[32];
+  int ret = 0;
+
+  if (commit_list_ids(&ids, &count) != 0) return -1;
+  if (opts->keep_commits == 0 && opts->keep_days == 0) {
+    for (i = 0; ret == 0 && i < count; i++) ret = id_list_add(kept, ids[i]);
+    commit_free_ids(ids, count);
+    return ret;
+  }
+
+  for (i = 0; ret == 0 && i < count; i++) {
+    char parent[32];
+
+    if (commit_read_meta_field(ids[i], "parent", parent, sizeof(parent)) == 0 && parent[0] &&
+        strcmp(parent, ids[i]) != 0) {
+      ret = id_list_add(&parents, parent);
+    }
+  }
+  id_list_sort(&parents);
+  for (i = 0; ret == 0 && i < count; i++) {
+    if (!id_list_has(&parents, ids[i])) ret = collect_line(opts, now, ids[i], kept);
+  }
+  free(parents.ids);
+  commit_free_ids(ids, count);
+  if (ret != 0) return ret;
+
+  if (commit_read_head(head, sizeof(head)) == 0) ret = collect_line(opts, now, head, kept);
+  if (ret != 0 || commit_list_tips(&tips, &tip_count) != 0) return -1;
+  for (i = 0; ret == 0 && i < tip_count; i++) ret = collect_line(opts, now, tips[i], kept);
+  commit_free_ids(tips, tip_count);
+  return ret;
+}
+
+/* Commits em produção: .clurg/projects/<projeto>/deploy/<ambiente>/current */
+static int collect_deployed(id_list_t *kept) {
+  struct dirent *project;
+  DIR *projects = opendir(".clurg/projects");
+  int ret = 0;
+
+  if (!projects) return 0;
+  while (ret == 0 && (project = readdir(projects)) != NULL) {
+    char deploy_dir[PATH_MAX];
+    struct dirent *env;
+    DIR *envs;
+
+    if (project->d_name[0] == '.') continue;
+    snprintf(deploy_dir, sizeof(deploy_dir), ".clurg/projects/%s/deploy", project->d_name);
+    envs = opendir(deploy_dir);
+    if (!envs) continue;
+
+    while (ret == 0 && (env = readdir(envs)) != NULL) {
+      char current[PATH_MAX];
+      char id[32];
+      FILE *fp;
+
+      if (env->d_name[0] == '.') continue;
+      if (snprintf(current, sizeof(current), "%s/%s/current", deploy_dir, env->d_name) >=
+          (int)sizeof(current)) {
+        continue;
+      }
+      fp = fopen(current, "r");
+      if (!fp) continue;
+      if (fgets(id, sizeof(id), fp)) {
+        id[strcspn(id, "\r\n")] = '\0';
+        if (id[0]) ret = id_list_add(kept, id);
+      }
+      fclose(fp);
+    }
+    closedir(envs);
+  }
+  closedir(projects);
+  return ret;
+}
+
+/* .meta solto recente: pode ser de um commit que ainda não moveu o HEAD */
+static int meta_is_recent(const char *id, time_t before) {
+  char path[PATH_MAX];
+  struct stat st;
+
+  snprintf(path, sizeof(path), "%s/%s.meta", COMMITS_DIR, id);
+  return stat(path, &st) == 0 && st.st_mtime >= before;
+}
+
+static int drop_commits(const id_list_t *kept, time_t before, uint64_t *dropped) {
+  char **ids;
+  char **drop;
+  size_t count;
+  size_t n = 0;
+  size_t i;
+  int ret;
+
+  *dropped = 0;
+  if (commit_list_ids(&ids, &count) != 0) return -1;
+  drop = malloc((count ? count : 1) * sizeof(char *));
+  if (!drop) {
+    commit_free_ids(ids, count);
+    return -1;
+  }
+  for (i = 0; i < count; i++) {
+    if (!id_list_has(kept, ids[i]) && !meta_is_recent(ids[i], before)) drop[n++] = ids[i];
+  }
+
+  ret = n > 0 ? commit_remove(drop, n, dropped) : 0;
+  for (i = 0; ret == 0 && i < n; i++) {
+    char csnap_path[PATH_MAX];
+    if (csnap_path_for(drop[i], csnap_path, sizeof(csnap_path)) == 0) unlink(csnap_path);
+  }
+  if (ret == 0 && *dropped > 0 && commit_index_rebuild() != 0) {
+    fprintf(stderr, "aviso: não foi possível recriar %s\n", COMMIT_INDEX_FILE);
+  }
+
+  free(drop);
+  commit_free_ids(ids, count);
+  return ret;
+}
+
+/* Raízes: trees dos commits mantidos e hashes do índice de stat */
+static int mark_roots(const id_list_t *kept, mark_ctx_t *ctx) {
+  index_t idx;
+  size_t i;
+  int ret = 0;
+
+  for (i = 0; ret == 0 && i < kept->count; i++) {
+    char tree[SHA256_HEX_SIZE];
+
+    if (commit_read_meta_field(kept->ids[i], "tree", tree, sizeof(tree)) != 0 || !tree[0]) {
+      continue;
+    }
+    ret = mark_object(tree, ctx);
+  }
+  if (ret != 0) return ret;
+
+  index_load(&idx);
+  if (idx.tree[0]) ret = mark_object(idx.tree, ctx);
+  for (i = 0; ret == 0 && i < idx.count; i++) {
+    char hex[SHA256_HEX_SIZE];
+
+    /* O índice é só uma rede de segurança: hashes fora do store não são erro */
+    if (mark_has(ctx->marks, idx.entries[i].hash)) continue;
+    sha256_to_hex(idx.entries[i].hash, hex);
+    if (objects_exists(hex)) ret = mark_object(hex, ctx);
+  }
+  index_free(&idx);
+  return ret;
+}
+
+typedef struct {
+  char path[PATH_MAX];
+  time_t mtime;
+  off_t size;
+} backup_t;
+
+static int compare_backups(const void *a, const void *b) {
+  const backup_t *x = a;
+  const backup_t *y = b;
+  return x->mtime < y->mtime ? 1 : x->mtime > y->mtime ? -1 : strcmp(y->path, x->path);
+}
+
+/* Mantém os `keep` backup-*.tar.gz mais novos */
+static uint64_t prune_backups(long keep, uint64_t *freed) {
+  backup_t *list = NULL;
+  size_t count = 0;
+  size_t capacity = 0;
+  uint64_t removed = 0;
+  struct dirent *entry;
+  DIR *d;
+  size_t i;
+
+  if (keep <= 0 || !(d = opendir(GC_BACKUPS_DIR))) return 0;
+  while ((entry = readdir(d)) != NULL) {
+    size_t len = strlen(entry->d_name);
+    struct stat st;
+
+    if (strncmp(entry->d_name, "backup-", 7) != 0 || len < 7 + 7 ||
+        strcmp(entry->d_name + len - 7, ".tar.gz") != 0) {
+      continue;
+    }
+    if (count == capacity) {
+      size_t grown_capacity = capacity ? capacity * 2 : 16;
+      backup_t *grown = realloc(list, grown_capacity * sizeof(*grown));
+      if (!grown) break;
+      list = grown;
+      capacity = grown_capacity;
+    }
+    snprintf(list[count].path, sizeof(list[count].path), "%s/%s", GC_BACKUPS_DIR,
+             entry->d_name);
+    if (stat(list[count].path, &st) != 0) continue;
+    list[count].mtime = st.st_mtime;
+    list[count].size = st.st_size;
+    count++;
+  }
+  closedir(d);
+
+  qsort(list, count, sizeof(*list), compare_backups);
+  for (i = (size_t)keep; i < count; i++) {
+    if (unlink(list[i].path) == 0) {
+      removed++;
+      *freed += (uint64_t)list[i].size;
+    }
+  }
+  free(list);
+  return removed;
+}
+
+static int parse_long(const char *flag, const char *value, long *out) {
+  char *end;
+
+  if (!value) {
+    fprintf(stderr, "erro: %s requer um valor\n", flag);
+    return -1;
+  }
+  *out = strtol(value, &end, 10);
+  if (*end != '\0' || *out < 0) {
+    fprintf(stderr, "erro: valor inválido para %s: %s\n", flag, value);
+    return -1;
+  }
+  return 0;
+}
+
+static int parse_options(int argc, char *argv[], gc_options_t *opts) {
+  int auto_mode = 0;
+  int i;
+
+  opts->keep_commits = repo_config_get_long("gc.keep_commits", 0);
+  opts->keep_days = repo_config_get_long("gc.keep_days", 0);
+  opts->keep_min = repo_config_get_long("gc.keep_min", GC_DEFAULT_KEEP_MIN);
+  opts->keep_backups = repo_config_get_long("gc.keep_backups", 0);
+  opts->max_ms = repo_config_get_long("gc.max_ms", -1);
+  opts->max_io = repo_config_get_long("gc.max_io", -1);
+  opts->grace = repo_config_get_long("gc.grace", GC_DEFAULT_GRACE);
+
+  for (i = 0; i < argc; i++) {
+    const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+    long *target = NULL;
+
+    if (strcmp(argv[i], "--auto") == 0) {
+      auto_mode = 1;
+      continue;
+    } else if (strcmp(argv[i], "--max-ms") == 0) {
+      target = &opts->max_ms;
+    } else if (strcmp(argv[i], "--max-io") == 0) {
+      target = &opts->max_io;
+    } else if (strcmp(argv[i], "--keep-commits") == 0) {
+      target = &opts->keep_commits;
+    } else if (strcmp(argv[i], "--keep-days") == 0) {
+      target = &opts->keep_days;
+    } else if (strcmp(argv[i], "--keep-backups") == 0) {
+      target = &opts->keep_backups;
+    } else {
+      fprintf(stderr,
+              "uso: clurg gc [--auto] [--max-ms N] [--max-io BYTES] [--keep-commits N] "
+              "[--keep-days N] [--keep-backups N]\n");
+      return -1;
+    }
+    if (parse_long(argv[i], value, target) != 0) return -1;
+    i++;
+  }
+
+  /* Sem orçamento explícito: --auto usa um pequeno, a execução manual vai até o fim */
+  if (opts->max_ms < 0) opts->max_ms = auto_mode ? GC_AUTO_MAX_MS : 0;
+  if (opts->max_io < 0) opts->max_io = auto_mode ? GC_AUTO_MAX_IO : 0;
+  if (opts->keep_min < 1) opts->keep_min = 1;
+  if (opts->grace < 0) opts->grace = 0;
+  return 0;
+}
+
+int clurg_gc(int argc, char *argv[]) {
+  gc_options_t opts;
+  budget_t budget;
+  mark_set_t marks = {NULL, NULL, 0, 0};
+  mark_ctx_t mark_ctx;
+  objects_sweep_stats_t sweep;
+  id_list_t kept = {NULL, 0, 0};
+  uint64_t dropped = 0;
+  uint64_t backups = 0;
+  uint32_t cursor;
+  uint32_t flags;
+  time_t now;
+  time_t before;
+  int lock_fd;
+  int ret = 1;
+
+  if (parse_options(argc, argv, &opts) != 0) return 1;
+  if (access(".clurg", F_OK) != 0) {
+    fprintf(stderr, "erro: não é um repositório clurg\n");
+    return 1;
+  }
+
+  /* Um gc por vez: o hook de um commit pode disparar enquanto outro roda */
+  lock_fd = open(GC_LOCK_FILE, O_RDWR | O_CREAT, 0644);
+  if (lock_fd < 0 || flock(lock_fd, LOCK_EX | LOCK_NB) != 0) {
+    printf("🧹 gc já em execução, nada a fazer\n");
+    if (lock_fd >= 0) close(lock_fd);
+    return 0;
+  }
+
+  memset(&budget, 0, sizeof(budget));
+  memset(&sweep, 0, sizeof(sweep));
+  clock_gettime(CLOCK_MONOTONIC, &budget.start);
+  budget.max_ms = opts.max_ms;
+  budget.max_io = (uint64_t)opts.max_io;
+  now = time(NULL);
+  before = now - opts.grace;
+
+  printf("🧹 Coletando lixo...\n");
+
+  /* 1. Commits: retenção + deploys */
+  if (collect_history(&opts, now, &kept) != 0 || collect_deployed(&kept) != 0) {
+    fprintf(stderr, "erro: falha ao listar commits\n");
+    goto out;
+  }
+  id_list_sort(&kept);
+  if (drop_commits(&kept, before, &dropped) != 0) {
+    fprintf(stderr, "erro: falha ao aplicar a retenção de commits\n");
+    goto out;
+  }
+  printf("   commits: %zu mantidos, %llu removidos\n", kept.count, (unsigned long long)dropped);
+
+  /* 2. Marcação (retomada de onde a execução anterior parou) */
+  load_state(&marks, &cursor, &flags);
+  if (dropped > 0 && cursor == 0) {
+    /* Volta ainda não começou: descartar marcas herdadas em vez de varrer com elas */
+    mark_free(&marks);
+    flags = 0;
+  } else if (dropped > 0) {
+    flags |= GC_STATE_STALE;
+  }
+  memset(&mark_ctx, 0, sizeof(mark_ctx));
+  mark_ctx.marks = &marks;
+  mark_ctx.budget = &budget;
+  if (mark_roots(&kept, &mark_ctx) != 0) {
+    if (!mark_ctx.exhausted) {
+      fprintf(stderr, "erro: objeto alcançável ilegível; nada foi apagado\n");
+      goto out;
+    }
+    save_state(&marks, cursor, flags);
+    printf("   marcação: %zu objetos alcançáveis até agora\n", marks.count);
+    printf("⏸  Orçamento esgotado (%ld ms, %llu bytes lidos): continua no próximo gc\n",
+           elapsed_ms(&budget), (unsigned long long)budget.io);
+    ret = 0;
+    goto out;
+  }
+
+  /* 3. Varredura: um fanout por vez, depois os packs */
+  while (cursor < GC_FANOUTS && !budget_exhausted(&budget)) {
+    if (objects_sweep_loose(cursor, is_marked, &marks, before, &sweep) != 0) goto out;
+    cursor++;
+  }
+  if (cursor == GC_CURSOR_PACKS && !budget_exhausted(&budget)) {
+    uint64_t room = budget.max_io > 0 ? budget.max_io - budget.io : 0;
+
+    if (objects_sweep_packs(is_marked, &marks, before, room, &sweep) != 0) goto out;
+    budget.io += sweep.io_bytes;
+    cursor++;
+  }
+  printf("   objetos: %zu alcançáveis, %llu removidos (%llu bytes liberados)\n", marks.count,
+         (unsigned long long)sweep.objects_removed, (unsigned long long)sweep.bytes_freed);
+  if (sweep.packs_rewritten || sweep.packs_removed || sweep.packs_deferred) {
+    printf("   packs: %llu reescritos, %llu apagados, %llu adiados\n",
+           (unsigned long long)sweep.packs_rewritten, (unsigned long long)sweep.packs_removed,
+           (unsigned long long)sweep.packs_deferred);
+  }
+
+  /* 4. Backups de .clurg/backups */
+  backups = prune_backups(opts.keep_backups, &sweep.bytes_freed);
+  if (backups > 0) printf("   backups: %llu removidos\n", (unsigned long long)backups);
+
+  if (cursor > GC_CURSOR_PACKS) {
+    /*
+     * Volta completa. Sem commits apagados, tudo o que está marcado continua
+     * alcançável e as marcas servem para a próxima volta; senão ela remarca
+     * a partir das raízes de então.
+     */
+    if (flags & GC_STATE_STALE) {
+      unlink(GC_STATE_FILE);
+    } else {
+      save_state(&marks, 0, 0);
+    }
+    printf("✅ gc concluído em %ld ms\n", elapsed_ms(&budget));
+  } else {
+    save_state(&marks, cursor, flags);
+    printf("⏸  Orçamento esgotado (%ld ms, %llu bytes de I/O): varredura continua no próximo gc\n",
+           elapsed_ms(&budget), (unsigned long long)budget.io);
+  }
+  ret = 0;
+
+out:
+  mark_free(&marks);
+  free(kept.ids);
+  close(lock_fd);
+  return ret;
+}
@@ -0,0 +1,38 @@
+#ifndef CLURG_GC_H
+#define CLURG_GC_H
+
+/*
+ * clurg gc [--auto] [--max-ms N] [--max-io BYTES]
+ *          [--keep-commits N] [--keep-days N] [--keep-backups N]
+ *
+ * Coleta de lixo por alcançabilidade, em três fases:
+ *
+ *   1. commits: sem regra de retenção todos ficam. Com gc.keep_commits ou
+ *      gc.keep_days, cada linha de histórico (HEAD, .clurg/refs/tips e todo
+ *      commit que não é pai de outro) é mantida até a primeira regra que
+ *      falhar; gc.keep_days nunca derruba os gc.keep_min mais recentes de
+ *      uma linha. Commits apontados por algum
+ *      .clurg/projects/<p>/deploy/<env>/current também ficam. O resto é
+ *      apagado (.meta solto, registro no pack de commits e .csnap).
+ *   2. marcação: a partir das trees dos commits mantidos e do .clurg/index,
+ *      seguindo entradas de tree, chunks e bases de delta. Um objeto só é
+ *      marcado depois de tudo abaixo dele, então a marcação interrompida
+ *      continua válida e é retomada na próxima execução.
+ *   3. varredura: objetos soltos não marcados, um diretório de fanout por
+ *      vez, e depois os packs (apagados ou reescritos só com o que é
+ *      alcançável). Terminada a volta, as marcas são descartadas e a próxima
+ *      execução começa outra.
+ *
+ * Com orçamento (gc.max_ms, gc.max_io ou --auto), cada execução para ao
+ * esgotá-lo e grava o progresso em .clurg/gc.state: roda depois de cada
+ * commit sem latência visível. Objetos e .meta mais novos que gc.grace
+ * segundos nunca são apagados (podem ser de um commit em andamento).
+ */
+
+#define GC_STATE_FILE ".clurg/gc.state"
+#define GC_LOCK_FILE ".clurg/gc.lock"
+#define GC_BACKUPS_DIR ".clurg/backups"
+
+int clurg_gc(int argc, char *argv[]);
+
+#endif /* CLURG_GC_H */
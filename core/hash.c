@@ -0,0 +1,204 @@
+#define _GNU_SOURCE
+#include "hash.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "sha256.h"
+
+/* Caminhos e hashes esperados lidos de uma lista no formato do sha256sum */
+typedef struct {
+  char **paths;
+  char (*expected)[SHA256_HEX_SIZE];
+  size_t count;
+  size_t capacity;
+} check_list_t;
+
+static int hash_and_print(char *const *paths, size_t count) {
+  uint8_t (*digests)[SHA256_DIGEST_SIZE] = malloc(count * sizeof(*digests));
+  int *results = malloc(count * sizeof(*results));
+  size_t i;
+  int ret = 0;
+
+  if (!digests || !results) {
+    fprintf(stderr, "erro: memória insuficiente\n");
+    free(digests);
+    free(results);
+    return 1;
+  }
+
+  sha256_files((const char *const *)paths, count, digests, results);
+  for (i = 0; i < count; i++) {
+    char hex[SHA256_HEX_SIZE];
+
+    if (results[i] != 0) {
+      fprintf(stderr, "erro ao ler %s\n", paths[i]);
+      ret = 1;
+      continue;
+    }
+    sha256_to_hex(digests[i], hex);
+    printf("%s  %s\n", hex, paths[i]);
+  }
+
+  free(digests);
+  free(results);
+  return ret;
+}
+
+static int check_list_push(check_list_t *list, const char *hex, const char *path) {
+  if (list->count == list->capacity) {
+    size_t capacity = list->capacity ? list->capacity * 2 : 256;
+    char **paths = realloc(list->paths, capacity * sizeof(*paths));
+    char (*expected)[SHA256_HEX_SIZE];
+
+    if (!paths) return -1;
+    list->paths = paths;
+    expected = realloc(list->expected, capacity * sizeof(*expected));
+    if (!expected) return -1;
+    list->expected = expected;
+    list->capacity = capacity;
+  }
+  list->paths[list->count] = strdup(path);
+  if (!list->paths[list->count]) return -1;
+  memcpy(list->expected[list->count], hex, SHA256_HEX_SIZE - 1);
+  list->expected[list->count][SHA256_HEX_SIZE - 1] = '\0';
+  list->count++;
+  return 0;
+}
+
+static void check_list_free(check_list_t *list) {
+  size_t i;
+  for (i = 0; i < list->count; i++) free(list->paths[i]);
+  free(list->paths);
+  free(list->expected);
+}
+
+/* Linhas "<hash>  <caminho>" (ou "<hash> *<caminho>", modo binário do sha256sum) */
+static int check_list_load(const char *list_path, check_list_t *list) {
+  FILE *fp = fopen(list_path, "r");
+  char line[8192];
+  size_t lineno = 0;
+  int ret = 0;
+
+  if (!fp) {
+    fprintf(stderr, "erro ao abrir %s\n", list_path);
+    return -1;
+  }
+
+  while (fgets(line, sizeof(line), fp)) {
+    size_t len = strcspn(line, "\r\n");
+    size_t hex_len = strspn(line, "0123456789abcdefABCDEF");
+
+    lineno++;
+    line[len] = '\0';
+    if (len == 0 || line[0] == '#') continue;
+    if (hex_len != SHA256_HEX_SIZE - 1 || line[hex_len] != ' ' ||
+        (line[hex_len + 1] != ' ' && line[hex_len + 1] != '*') || line[hex_len + 2] == '\0') {
+      fprintf(stderr, "aviso: %s:%zu: linha mal formatada, ignorando\n", list_path, lineno);
+      continue;
+    }
+    if (check_list_push(list, line, line + hex_len + 2) != 0) {
+      fprintf(stderr, "erro: memória insuficiente\n");
+      ret = -1;
+      break;
+    }
+  }
+  fclose(fp);
+  return ret;
+}
+
+static int check_and_print(const char *list_path, int quiet) {
+  check_list_t list = {0};
+  uint8_t (*digests)[SHA256_DIGEST_SIZE] = NULL;
+  int *results = NULL;
+  size_t failed = 0;
+  size_t unreadable = 0;
+  size_t i;
+
+  if (check_list_load(list_path, &list) != 0) {
+    check_list_free(&list);
+    return 1;
+  }
+
+  if (list.count > 0) {
+    digests = malloc(list.count * sizeof(*digests));
+    results = malloc(list.count * sizeof(*results));
+    if (!digests || !results) {
+      fprintf(stderr, "erro: memória insuficiente\n");
+      free(digests);
+      free(results);
+      check_list_free(&list);
+      return 1;
+    }
+    sha256_files((const char *const *)list.paths, list.count, digests, results);
+  }
+
+  for (i = 0; i < list.count; i++) {
+    char hex[SHA256_HEX_SIZE];
+
+    if (results[i] != 0) {
+      printf("%s: FALHOU (ilegível)\n", list.paths[i]);
+      unreadable++;
+      continue;
+    }
+    sha256_to_hex(digests[i], hex);
+    if (strcasecmp(hex, list.expected[i]) != 0) {
+      printf("%s: FALHOU\n", list.paths[i]);
+      failed++;
+    } else if (!quiet) {
+      printf("%s: OK\n", list.paths[i]);
+    }
+  }
+
+  if (failed) fprintf(stderr, "aviso: %zu hash(es) não conferem\n", failed);
+  if (unreadable) fprintf(stderr, "aviso: %zu arquivo(s) não puderam ser lidos\n", unreadable);
+
+  free(digests);
+  free(results);
+  check_list_free(&list);
+  return (failed || unreadable) ? 1 : 0;
+}
+
+int clurg_hash(int argc, char *argv[]) {
+  const char *check_path = NULL;
+  char **files;
+  size_t file_count = 0;
+  int quiet = 0;
+  int ret;
+  int i;
+
+  files = malloc((size_t)(argc > 0 ? argc : 1) * sizeof(*files));
+  if (!files) {
+    fprintf(stderr, "erro: memória insuficiente\n");
+    return 1;
+  }
+
+  for (i = 0; i < argc; i++) {
+    if (strcmp(argv[i], "-c") == 0 || strcmp(argv[i], "--check") == 0) {
+      if (i + 1 >= argc) {
+        fprintf(stderr, "erro: %s requer um arquivo com a lista de hashes\n", argv[i]);
+        free(files);
+        return 1;
+      }
+      check_path = argv[++i];
+    } else if (strcmp(argv[i], "-q") == 0 || strcmp(argv[i], "--quiet") == 0) {
+      quiet = 1;
+    } else {
+      files[file_count++] = argv[i];
+    }
+  }
+
+  if (check_path) {
+    ret = check_and_print(check_path, quiet);
+  } else if (file_count == 0) {
+    fprintf(stderr, "Uso: clurg hash [-c LISTA] [-q] [arquivo...]\n");
+    ret = 1;
+  } else {
+    ret = hash_and_print(files, file_count);
+  }
+
+  free(files);
+  return ret;
+}
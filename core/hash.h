@@ -0,0 +1,13 @@
+#ifndef CLURG_HASH_H
+#define CLURG_HASH_H
+
+/*
+ * clurg hash [-c LISTA] [-q] [arquivo...]
+ *
+ * SHA-256 de arquivos com a mesma saída do sha256sum ("<hash>  <caminho>"), e
+ * -c confere uma lista nesse formato. Usado pelos scripts de backup e
+ * manutenção no lugar do sha256sum externo.
+ */
+int clurg_hash(int argc, char *argv[]);
+
+#endif
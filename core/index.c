@@ -0,0 +1,270 @@
+#define _GNU_SOURCE
+#include "index.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define NSEC_PER_SEC 1000000000LL
+
+static int64_t timespec_ns(const struct timespec *ts) {
+  return (int64_t)ts->tv_sec * NSEC_PER_SEC + ts->tv_nsec;
+}
+
+int index_load(index_t *idx) {
+  const index_header_t *hdr;
+  struct stat st;
+  int fd;
+
+  memset(idx, 0, sizeof(*idx));
+
+  fd = open(INDEX_FILE, O_RDONLY);
+  if (fd < 0) return 0; /* sem índice: tudo será lido */
+
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(index_header_t)) {
+    close(fd);
+    return 0;
+  }
+
+  idx->map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (idx->map == MAP_FAILED) {
+    idx->map = NULL;
+    return 0;
+  }
+  idx->map_size = (size_t)st.st_size;
+  idx->written_ns = timespec_ns(&st.st_mtim);
+
+  hdr = idx->map;
+  if (hdr->magic == INDEX_MAGIC && hdr->version != INDEX_VERSION) {
+    index_free(idx); /* formato antigo: será regravado no próximo commit */
+    return 0;
+  }
+  if (hdr->magic != INDEX_MAGIC ||
+      sizeof(*hdr) + hdr->count * sizeof(index_entry_t) > hdr->strtab_offset ||
+      hdr->strtab_offset + hdr->strtab_size > idx->map_size) {
+    fprintf(stderr, "aviso: %s inválido, ignorando\n", INDEX_FILE);
+    index_free(idx);
+    return 0;
+  }
+
+  idx->entries = (const index_entry_t *)((const char *)idx->map + sizeof(*hdr));
+  idx->strtab = (const char *)idx->map + hdr->strtab_offset;
+  idx->count = (size_t)hdr->count;
+  sha256_to_hex(hdr->tree, idx->tree);
+  return 0;
+}
+
+void index_free(index_t *idx) {
+  if (idx->map) {
+    munmap(idx->map, idx->map_size);
+  } else {
+    /* Índice em memória (index_from_builder) */
+    free((void *)idx->entries);
+    free((void *)idx->strtab);
+  }
+  memset(idx, 0, sizeof(*idx));
+}
+
+const char *index_entry_path(const index_t *idx, const index_entry_t *entry) {
+  return idx->strtab + entry->path_offset;
+}
+
+const index_entry_t *index_lookup(const index_t *idx, const char *path) {
+  size_t lo = 0;
+  size_t hi = idx->count;
+
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    int cmp = strcmp(path, index_entry_path(idx, &idx->entries[mid]));
+    if (cmp == 0) return &idx->entries[mid];
+    if (cmp < 0) {
+      hi = mid;
+    } else {
+      lo = mid + 1;
+    }
+  }
+  return NULL;
+}
+
+size_t index_lower_bound(const index_t *idx, const char *path) {
+  size_t lo = 0;
+  size_t hi = idx->count;
+
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (strcmp(index_entry_path(idx, &idx->entries[mid]), path) < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+int index_entry_is_clean(const index_t *idx, const index_entry_t *entry, const struct stat *st) {
+  int64_t mtime_ns = timespec_ns(&st->st_mtim);
+
+  if (entry->size != (uint64_t)st->st_size || entry->mtime_ns != mtime_ns ||
+      entry->ctime_ns != timespec_ns(&st->st_ctim) || entry->ino != (uint64_t)st->st_ino ||
+      entry->mode != (uint32_t)st->st_mode) {
+    return 0;
+  }
+
+  /* Modificado no mesmo instante da gravação do índice: o stat não é confiável */
+  return mtime_ns < idx->written_ns;
+}
+
+void index_builder_init(index_builder_t *builder) {
+  memset(builder, 0, sizeof(*builder));
+}
+
+static index_entry_t *builder_push(index_builder_t *builder, const char *path) {
+  size_t path_len = strlen(path);
+  index_entry_t *entry;
+
+  if (builder->count == builder->capacity) {
+    size_t capacity = builder->capacity ? builder->capacity * 2 : 256;
+    index_entry_t *grown = realloc(builder->entries, capacity * sizeof(*grown));
+    if (!grown) return NULL;
+    builder->entries = grown;
+    builder->capacity = capacity;
+  }
+
+  if (builder->strtab_len + path_len + 1 > builder->strtab_capacity) {
+    size_t capacity = builder->strtab_capacity ? builder->strtab_capacity * 2 : 8192;
+    char *grown;
+    while (capacity < builder->strtab_len + path_len + 1) capacity *= 2;
+    grown = realloc(builder->strtab, capacity);
+    if (!grown) return NULL;
+    builder->strtab = grown;
+    builder->strtab_capacity = capacity;
+  }
+
+  entry = &builder->entries[builder->count++];
+  memset(entry, 0, sizeof(*entry));
+  entry->path_offset = builder->strtab_len;
+  entry->path_len = (uint32_t)path_len;
+
+  memcpy(builder->strtab + builder->strtab_len, path, path_len + 1);
+  builder->strtab_len += path_len + 1;
+  return entry;
+}
+
+static void entry_set_stat(index_entry_t *entry, const struct stat *st) {
+  entry->size = (uint64_t)st->st_size;
+  entry->mtime_ns = timespec_ns(&st->st_mtim);
+  entry->ctime_ns = timespec_ns(&st->st_ctim);
+  entry->ino = (uint64_t)st->st_ino;
+  entry->mode = (uint32_t)st->st_mode;
+}
+
+int index_builder_add(index_builder_t *builder, const char *path, const struct stat *st,
+                      const uint8_t hash[SHA256_DIGEST_SIZE]) {
+  index_entry_t *entry = builder_push(builder, path);
+
+  if (!entry) return -1;
+  entry_set_stat(entry, st);
+  memcpy(entry->hash, hash, SHA256_DIGEST_SIZE);
+  return 0;
+}
+
+int index_builder_add_entry(index_builder_t *builder, const char *path,
+                            const index_entry_t *src, const struct stat *st) {
+  index_entry_t *entry = builder_push(builder, path);
+  uint64_t path_offset;
+  uint32_t path_len;
+
+  if (!entry) return -1;
+  path_offset = entry->path_offset;
+  path_len = entry->path_len;
+  *entry = *src;
+  entry->path_offset = path_offset;
+  entry->path_len = path_len;
+  if (st) entry_set_stat(entry, st);
+  return 0;
+}
+
+void index_builder_set_tree(index_builder_t *builder, const char *tree_hex) {
+  sha256_from_hex(tree_hex, builder->tree);
+}
+
+
+static int compare_entries(const void *a, const void *b, void *strtab) {
+  const index_entry_t *ea = a;
+  const index_entry_t *eb = b;
+  return strcmp((const char *)strtab + ea->path_offset, (const char *)strtab + eb->path_offset);
+}
+
+static int write_all(int fd, const void *data, size_t len) {
+  const unsigned char *p = data;
+  while (len > 0) {
+    ssize_t n = write(fd, p, len);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return -1;
+    }
+    p += n;
+    len -= (size_t)n;
+  }
+  return 0;
+}
+
+int index_builder_write(index_builder_t *builder) {
+  char tmp_path[] = INDEX_FILE ".tmp";
+  index_header_t hdr;
+  int fd;
+  int ok;
+
+  qsort_r(builder->entries, builder->count, sizeof(index_entry_t), compare_entries,
+          builder->strtab);
+
+  memset(&hdr, 0, sizeof(hdr));
+  hdr.magic = INDEX_MAGIC;
+  hdr.version = INDEX_VERSION;
+  hdr.count = builder->count;
+  hdr.strtab_offset = sizeof(hdr) + builder->count * sizeof(index_entry_t);
+  hdr.strtab_size = builder->strtab_len;
+  memcpy(hdr.tree, builder->tree, SHA256_DIGEST_SIZE);
+
+  fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    fprintf(stderr, "erro ao criar %s: %s\n", tmp_path, strerror(errno));
+    return -1;
+  }
+
+  ok = write_all(fd, &hdr, sizeof(hdr)) == 0 &&
+       write_all(fd, builder->entries, builder->count * sizeof(index_entry_t)) == 0 &&
+       write_all(fd, builder->strtab, builder->strtab_len) == 0;
+  if (close(fd) != 0) ok = 0;
+
+  if (!ok || rename(tmp_path, INDEX_FILE) != 0) {
+    fprintf(stderr, "erro ao gravar %s: %s\n", INDEX_FILE, strerror(errno));
+    unlink(tmp_path);
+    return -1;
+  }
+  return 0;
+}
+
+void index_from_builder(index_t *idx, index_builder_t *builder) {
+  qsort_r(builder->entries, builder->count, sizeof(index_entry_t), compare_entries,
+          builder->strtab);
+
+  memset(idx, 0, sizeof(*idx));
+  idx->entries = builder->entries;
+  idx->strtab = builder->strtab;
+  idx->count = builder->count;
+  idx->written_ns = INT64_MIN;
+  sha256_to_hex(builder->tree, idx->tree);
+  memset(builder, 0, sizeof(*builder));
+}
+
+void index_builder_free(index_builder_t *builder) {
+  free(builder->entries);
+  free(builder->strtab);
+  memset(builder, 0, sizeof(*builder));
+}
@@ -0,0 +1,101 @@
+#ifndef CLURG_INDEX_H
+#define CLURG_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/stat.h>
+
+#include "sha256.h"
+
+/*
+ * Índice de stat (.clurg/index), no estilo do index do git.
+ *
+ * Guarda, para cada arquivo e symlink do último snapshot, os dados de stat e
+ * o hash do conteúdo, além do hash da tree raiz que gerou o índice. Arquivos
+ * cujo stat não mudou reaproveitam o hash sem serem lidos.
+ *
+ * Layout binário (little-endian, lido via mmap sem parsing):
+ *   index_header_t
+ *   index_entry_t[count]   ordenado por caminho (strcmp)
+ *   tabela de strings      caminhos relativos, terminados em '\0'
+ */
+
+#define INDEX_FILE ".clurg/index"
+#define INDEX_MAGIC 0x58444943u /* "CIDX" */
+#define INDEX_VERSION 2
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t count;
+  uint64_t strtab_offset;
+  uint64_t strtab_size;
+  uint8_t tree[SHA256_DIGEST_SIZE]; /* tree raiz descrita pelo índice */
+} index_header_t;
+
+typedef struct {
+  uint64_t size;
+  int64_t mtime_ns;
+  int64_t ctime_ns;
+  uint64_t ino;
+  uint64_t path_offset; /* offset na tabela de strings */
+  uint32_t path_len;
+  uint32_t mode;
+  uint8_t hash[SHA256_DIGEST_SIZE];
+} index_entry_t;
+
+/* Índice carregado (somente leitura, mapeado em memória) */
+typedef struct {
+  void *map;
+  size_t map_size;
+  const index_entry_t *entries;
+  const char *strtab;
+  size_t count;
+  int64_t written_ns; /* mtime do próprio arquivo de índice */
+  char tree[SHA256_HEX_SIZE];
+} index_t;
+
+/* Índice em construção */
+typedef struct {
+  index_entry_t *entries;
+  size_t count;
+  size_t capacity;
+  char *strtab;
+  size_t strtab_len;
+  size_t strtab_capacity;
+  uint8_t tree[SHA256_DIGEST_SIZE];
+} index_builder_t;
+
+/* Carrega .clurg/index; índice ausente ou inválido resulta em índice vazio */
+int index_load(index_t *idx);
+void index_free(index_t *idx);
+
+const index_entry_t *index_lookup(const index_t *idx, const char *path);
+
+/* Posição da primeira entrada com caminho >= path (entradas de "dir/" são contíguas) */
+size_t index_lower_bound(const index_t *idx, const char *path);
+const char *index_entry_path(const index_t *idx, const index_entry_t *entry);
+
+/*
+ * Retorna 1 se o stat bate com a entrada e a entrada não é "racy" (arquivo
+ * modificado no mesmo instante em que o índice foi gravado).
+ */
+int index_entry_is_clean(const index_t *idx, const index_entry_t *entry, const struct stat *st);
+
+void index_builder_init(index_builder_t *builder);
+int index_builder_add(index_builder_t *builder, const char *path, const struct stat *st,
+                      const uint8_t hash[SHA256_DIGEST_SIZE]);
+/* Copia uma entrada existente (st == NULL mantém o stat da entrada) */
+int index_builder_add_entry(index_builder_t *builder, const char *path,
+                            const index_entry_t *entry, const struct stat *st);
+void index_builder_set_tree(index_builder_t *builder, const char *tree_hex);
+int index_builder_write(index_builder_t *builder);
+void index_builder_free(index_builder_t *builder);
+
+/*
+ * Transforma o builder num índice em memória (sem arquivo, nenhuma entrada
+ * é considerada limpa). O builder passa a pertencer ao índice.
+ */
+void index_from_builder(index_t *idx, index_builder_t *builder);
+
+#endif /* CLURG_INDEX_H */
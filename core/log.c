@@ -0,0 +1,121 @@
+#define _GNU_SOURCE
+#include "log.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "commit.h"
+#include "commit_index.h"
+
+typedef struct {
+  long max_count; /* -1 = sem limite */
+  int has_since;
+  int64_t since;
+  const char *author;
+} log_filter_t;
+
+static int parse_date(const char *text, int64_t *out) {
+  struct tm tm;
+  const char *end;
+
+  memset(&tm, 0, sizeof(tm));
+  end = strptime(text, "%Y-%m-%d %H:%M:%S", &tm);
+  if (!end) {
+    memset(&tm, 0, sizeof(tm));
+    end = strptime(text, "%Y-%m-%d", &tm);
+  }
+  if (!end || *end != '\0') return -1;
+  tm.tm_isdst = -1;
+  *out = (int64_t)mktime(&tm);
+  return 0;
+}
+
+static int parse_args(int argc, char *argv[], log_filter_t *filter) {
+  int i;
+
+  filter->max_count = -1;
+  filter->has_since = 0;
+  filter->since = 0;
+  filter->author = NULL;
+
+  for (i = 0; i < argc; i++) {
+    const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+    if (strcmp(argv[i], "-n") == 0 && value) {
+      char *end;
+      filter->max_count = strtol(value, &end, 10);
+      if (*end != '\0' || filter->max_count < 0) {
+        fprintf(stderr, "erro: valor inválido para -n: %s\n", value);
+        return -1;
+      }
+      i++;
+    } else if (strcmp(argv[i], "--since") == 0 && value) {
+      if (parse_date(value, &filter->since) != 0) {
+        fprintf(stderr, "erro: data inválida para --since: %s (use AAAA-MM-DD)\n", value);
+        return -1;
+      }
+      filter->has_since = 1;
+      i++;
+    } else if (strcmp(argv[i], "--author") == 0 && value) {
+      filter->author = value;
+      i++;
+    } else {
+      fprintf(stderr, "uso: clurg log [-n N] [--since AAAA-MM-DD] [--author NOME]\n");
+      return -1;
+    }
+  }
+  return 0;
+}
+
+int clurg_log(int argc, char *argv[]) {
+  commit_index_t index;
+  log_filter_t filter;
+  struct stat st;
+  long shown = 0;
+  size_t i;
+
+  if (parse_args(argc, argv, &filter) != 0) return 1;
+
+  if (stat(COMMITS_DIR, &st) != 0) {
+    printf("❌ Sem commits encontrados.\n");
+    return 0;
+  }
+
+  /* Repositórios anteriores ao índice: gerar uma vez a partir dos .meta */
+  if (commit_index_open(&index) != 0) {
+    if (commit_index_rebuild() != 0 || commit_index_open(&index) != 0) {
+      fprintf(stderr, "erro: não foi possível ler %s\n", COMMIT_INDEX_FILE);
+      return 1;
+    }
+  }
+
+  printf("📜 Histórico de Commits:\n");
+  printf("========================\n");
+
+  /* Registros em ordem de gravação: do fim para o começo = mais novo primeiro */
+  for (i = index.count; i-- > 0 && (filter.max_count < 0 || shown < filter.max_count);) {
+    const commit_index_record_t *rec = &index.records[i];
+    const char *author = commit_index_string(&index, rec->author_offset);
+    char date[32];
+    time_t when;
+
+    if (filter.has_since && rec->timestamp < filter.since) continue;
+    if (filter.author && !strstr(author, filter.author)) continue;
+
+    when = (time_t)rec->timestamp;
+    strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", localtime(&when));
+
+    printf("Commit: %.*s\n", (int)strnlen(rec->id, sizeof(rec->id)), rec->id);
+    printf("Data:   %s\n", date);
+    printf("Autor:  %s\n", author);
+    printf("    %s\n", commit_index_string(&index, rec->message_offset));
+    printf("\n");
+    shown++;
+  }
+
+  commit_index_close(&index);
+  return 0;
+}
@@ -0,0 +1,7 @@
+#ifndef CLURG_LOG_H
+#define CLURG_LOG_H
+
+/* clurg log [-n N] [--since AAAA-MM-DD[ HH:MM:SS]] [--author NOME] */
+int clurg_log(int argc, char *argv[]);
+
+#endif
@@ -2,11 +2,20 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "checkout.h"
 #include "clone.h"
 #include "commit.h"
+#include "compress.h"
 #include "deploy.h"
-#include "push.h"
+#include "gc.h"
+#include "hash.h"
 #include "init.h"
+#include "log.h"
+#include "push.h"
+#include "repack.h"
+#include "show.h"
+#include "status.h"
+#include "watch.h"
 
 static void usage(const char *prog_name) {
   printf("Uso: %s <comando> [opções]\n", prog_name);
@@ -15,7 +24,14 @@ static void usage(const char *prog_name) {
   printf("  status               - Mostrar estado do repositório\n");
   printf("  add .                - Adicionar arquivos (auto-stage)\n");
   printf("  commit [mensagem]    - Fazer commit\n");
-  printf("  log                  - Ver histórico de commits\n");
+  printf("  log [-n N] [--since D] [--author A] - Ver histórico de commits\n");
+  printf("  checkout [--force] <id> - Restaurar um commit na árvore de trabalho\n");
+  printf("  show <commit> <caminho> - Mostrar um arquivo de um commit\n");
+  printf("  watch [--stop|--status] - Daemon inotify que acelera status e commit\n");
+  printf("  repack               - Agrupar objetos e commits em packs\n");
+  printf("  gc [--auto] [--max-ms N] - Apagar commits e objetos inalcançáveis\n");
+  printf("  hash [-c LISTA] [arquivos...] - SHA-256 de arquivos (formato sha256sum)\n");
+  printf("  compress             - gzip paralelo da entrada padrão para a saída\n");
   printf("  push <remote>        - Enviar commits\n");
   printf("  clone <url>          - Clonar repositório\n");
   printf("  deploy <env> <id>    - Deploy para ambiente\n");
@@ -66,9 +82,23 @@ int main(int argc, char *argv[]) {
   if (strcmp(argv[1], "init") == 0) {
       return clurg_init();
   } else if (strcmp(argv[1], "status") == 0) {
-      return system("./.clurg/scripts/status.sh");
+      return clurg_status();
   } else if (strcmp(argv[1], "log") == 0) {
-      return system("./.clurg/scripts/log.sh");
+      return clurg_log(argc - 2, argv + 2);
+  } else if (strcmp(argv[1], "repack") == 0) {
+      return clurg_repack();
+  } else if (strcmp(argv[1], "gc") == 0) {
+      return clurg_gc(argc - 2, argv + 2);
+  } else if (strcmp(argv[1], "checkout") == 0) {
+      return clurg_checkout(argc - 2, argv + 2);
+  } else if (strcmp(argv[1], "show") == 0) {
+      return clurg_show(argc - 2, argv + 2);
+  } else if (strcmp(argv[1], "hash") == 0) {
+      return clurg_hash(argc - 2, argv + 2);
+  } else if (strcmp(argv[1], "compress") == 0) {
+      return clurg_compress(argc - 2, argv + 2);
+  } else if (strcmp(argv[1], "watch") == 0) {
+      return clurg_watch(argc - 2, argv + 2);
   } else if (strcmp(argv[1], "add") == 0) {
       printf("ℹ️  Clurg usa modelo snapshot-based. Todos os arquivos serão incluídos no commit.\n");
       return 0;
@@ -91,12 +121,8 @@ int main(int argc, char *argv[]) {
   } else if (strcmp(argv[1], "push") == 0) {
     const char *arg1 = (argc >= 3) ? argv[2] : NULL;
     const char *arg2 = (argc >= 4) ? argv[3] : NULL;
-<<<<<<< HEAD
-    return clurg_push(arg1, arg2);
-=======
     const char *arg3 = (argc >= 5) ? argv[4] : NULL;
     return clurg_push(arg1, arg2, arg3);
->>>>>>> 6f9723b (Adjusts.)
   } else if (strcmp(argv[1], "clone") == 0) {
     if (argc < 4) {
       fprintf(stderr, "erro: clone requer <project> <remote_url>\n");
@@ -0,0 +1,1607 @@
+#define _GNU_SOURCE
+#include "objects.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "../ci/ignore.h"
+#include "chunk.h"
+#include "delta.h"
+#include "pack.h"
+#include "repo_config.h"
+#include "watch.h"
+
+#define OBJ_BUFFER_SIZE 65536
+#define OBJ_HEADER_MAX 192
+
+/* Blobs maiores que isso sempre são gravados inteiros */
+#define OBJ_DELTA_MAX_SIZE (64ULL * 1024 * 1024)
+#define OBJ_DELTA_DEFAULT_DEPTH 10
+
+/* Blobs a partir deste tamanho são divididos em chunks (chunk.threshold, 0 desliga) */
+#define OBJ_CHUNK_DEFAULT_THRESHOLD (1024 * 1024)
+#define OBJ_CHUNK_LINE (64 + 1 + 20 + 1) /* "<hash> <tamanho>\n" */
+
+/* Cabeçalho de um objeto no disco; deltas guardam a base e a profundidade da cadeia */
+typedef struct {
+  obj_type_t type;
+  uint64_t size;         /* tamanho do conteúdo reconstruído */
+  uint64_t payload_size; /* bytes descomprimidos no arquivo (== size se não for delta) */
+  int depth;             /* 0 = objeto completo (keyframe) */
+  int chunked;           /* payload é a lista de chunks ("<hash> <tamanho>\n" cada) */
+  char base[SHA256_HEX_SIZE];
+} obj_header_t;
+
+static const char *type_name(obj_type_t type) {
+  return type == OBJ_TREE ? "tree" : "blob";
+}
+
+static int type_from_name(const char *name, obj_type_t *type) {
+  if (strcmp(name, "blob") == 0) {
+    *type = OBJ_BLOB;
+  } else if (strcmp(name, "tree") == 0) {
+    *type = OBJ_TREE;
+  } else {
+    return -1;
+  }
+  return 0;
+}
+
+int objects_init(void) {
+  if (mkdir(OBJECTS_DIR, 0755) != 0 && errno != EEXIST) {
+    fprintf(stderr, "erro ao criar %s: %s\n", OBJECTS_DIR, strerror(errno));
+    return -1;
+  }
+  return 0;
+}
+
+int objects_path(const char *hex, char *path, size_t size) {
+  if (strlen(hex) != 64) return -1;
+  if (snprintf(path, size, "%s/%.2s/%s", OBJECTS_DIR, hex, hex + 2) >= (int)size) return -1;
+  return 0;
+}
+
+/* Packs de objetos, carregados na primeira consulta */
+static pthread_mutex_t packs_lock = PTHREAD_MUTEX_INITIALIZER;
+static pack_set_t packs;
+static int packs_loaded;
+
+static const pack_set_t *object_packs(void) {
+  pthread_mutex_lock(&packs_lock);
+  if (!packs_loaded) {
+    pack_set_load(&packs, OBJECTS_PACK_DIR);
+    packs_loaded = 1;
+  }
+  pthread_mutex_unlock(&packs_lock);
+  return &packs;
+}
+
+static const pack_idx_entry_t *find_packed(const char *hex, const pack_t **pack) {
+  uint8_t key[SHA256_DIGEST_SIZE];
+
+  if (sha256_from_hex(hex, key) != 0) return NULL;
+  return pack_set_find(object_packs(), key, pack);
+}
+
+void objects_reload_packs(void) {
+  pthread_mutex_lock(&packs_lock);
+  if (packs_loaded) pack_set_free(&packs);
+  packs_loaded = 0;
+  pthread_mutex_unlock(&packs_lock);
+}
+
+int objects_exists(const char *hex) {
+  char path[PATH_MAX];
+  if (objects_path(hex, path, sizeof(path)) != 0) return 0;
+  return access(path, F_OK) == 0 || find_packed(hex, NULL) != NULL;
+}
+
+static int write_all(int fd, const void *data, size_t len) {
+  const unsigned char *p = data;
+  while (len > 0) {
+    ssize_t n = write(fd, p, len);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return -1;
+    }
+    p += n;
+    len -= (size_t)n;
+  }
+  return 0;
+}
+
+/*
+ * Grava um objeto cujo hash já é conhecido. O arquivo é escrito em um
+ * temporário e renomeado, então um commit interrompido nunca deixa um objeto
+ * truncado no store.
+ */
+static int store_object(const char *hex, const char *header, const void *data, uint64_t size,
+                        objects_stats_t *stats) {
+  char final_path[PATH_MAX];
+  char dir_path[PATH_MAX];
+  char tmp_path[PATH_MAX];
+  unsigned char out[OBJ_BUFFER_SIZE];
+  const unsigned char *p = data;
+  uint64_t remaining = size;
+  z_stream zs;
+  int fd;
+  int flush;
+  int ret = -1;
+  struct stat st;
+
+  objects_path(hex, final_path, sizeof(final_path));
+  snprintf(dir_path, sizeof(dir_path), "%s/%.2s", OBJECTS_DIR, hex);
+  if (mkdir(dir_path, 0755) != 0 && errno != EEXIST) {
+    fprintf(stderr, "erro ao criar %s: %s\n", dir_path, strerror(errno));
+    return -1;
+  }
+
+  snprintf(tmp_path, sizeof(tmp_path), "%s/tmp_obj_XXXXXX", OBJECTS_DIR);
+  fd = mkstemp(tmp_path);
+  if (fd < 0) {
+    fprintf(stderr, "erro ao criar objeto temporário: %s\n", strerror(errno));
+    return -1;
+  }
+
+  if (write_all(fd, header, strlen(header)) != 0) goto out;
+
+  memset(&zs, 0, sizeof(zs));
+  if (deflateInit(&zs, Z_DEFAULT_COMPRESSION) != Z_OK) goto out;
+
+  /* avail_in é 32 bits: alimentar o zlib em fatias */
+  do {
+    uInt chunk = remaining > (1u << 30) ? (1u << 30) : (uInt)remaining;
+    zs.next_in = (unsigned char *)p;
+    zs.avail_in = chunk;
+    p += chunk;
+    remaining -= chunk;
+    flush = remaining == 0 ? Z_FINISH : Z_NO_FLUSH;
+
+    do {
+      zs.next_out = out;
+      zs.avail_out = sizeof(out);
+      deflate(&zs, flush);
+      if (write_all(fd, out, sizeof(out) - zs.avail_out) != 0) {
+        deflateEnd(&zs);
+        goto out;
+      }
+    } while (zs.avail_out == 0);
+  } while (flush != Z_FINISH);
+
+  deflateEnd(&zs);
+
+  if (fstat(fd, &st) == 0 && stats) {
+    stats->bytes_stored += (uint64_t)st.st_size;
+  }
+  fchmod(fd, 0444);
+
+  if (rename(tmp_path, final_path) != 0) {
+    fprintf(stderr, "erro ao gravar objeto %s: %s\n", hex, strerror(errno));
+    goto out;
+  }
+  if (stats) stats->objects_new++;
+  ret = 0;
+
+out:
+  close(fd);
+  if (ret != 0) unlink(tmp_path);
+  return ret;
+}
+
+static int store_full(const char *hex, obj_type_t type, const void *data, size_t len,
+                      objects_stats_t *stats) {
+  char header[OBJ_HEADER_MAX];
+
+  snprintf(header, sizeof(header), "%s %llu\n", type_name(type), (unsigned long long)len);
+  return store_object(hex, header, data, len, stats);
+}
+
+static int read_object_header(const char *hex, obj_header_t *hdr);
+
+static int delta_max_depth(void) {
+  static int max_depth = -1;
+
+  /* delta.max_depth: 0 desliga os deltas */
+  if (max_depth < 0) {
+    long value = repo_config_get_long("delta.max_depth", OBJ_DELTA_DEFAULT_DEPTH);
+    max_depth = value < 0 ? 0 : (int)value;
+  }
+  return max_depth;
+}
+
+/*
+ * Tenta gravar um blob como delta contra `base_hex` (a versão anterior do
+ * mesmo caminho). Retorna 1 se não compensa: cadeia no limite (o blob vira um
+ * novo keyframe), base ausente ou delta maior que metade do blob.
+ */
+static int store_delta(const char *hex, const void *data, size_t len, const char *base_hex,
+                       objects_stats_t *stats) {
+  char header[OBJ_HEADER_MAX];
+  obj_header_t base_hdr;
+  unsigned char *base = NULL;
+  unsigned char *delta = NULL;
+  size_t base_len;
+  size_t delta_len;
+  obj_type_t type;
+  int ret;
+
+  if (len < 2 * DELTA_BLOCK || len > OBJ_DELTA_MAX_SIZE || !objects_exists(base_hex)) return 1;
+  if (read_object_header(base_hex, &base_hdr) != 0 || base_hdr.type != OBJ_BLOB ||
+      base_hdr.depth + 1 > delta_max_depth() || base_hdr.size > OBJ_DELTA_MAX_SIZE) {
+    return 1;
+  }
+
+  if (objects_read(base_hex, &type, &base, &base_len) != 0) return 1;
+  ret = delta_create(base, base_len, data, len, len / 2, &delta, &delta_len);
+  free(base);
+  if (ret != 0) return 1;
+
+  snprintf(header, sizeof(header), "delta %llu %s %d %llu\n", (unsigned long long)len, base_hex,
+           base_hdr.depth + 1, (unsigned long long)delta_len);
+  ret = store_object(hex, header, delta, delta_len, stats);
+  if (ret == 0 && stats) stats->objects_delta++;
+  free(delta);
+  return ret;
+}
+
+static uint64_t chunk_threshold(void) {
+  static long threshold = -1;
+
+  if (threshold < 0) {
+    long value = repo_config_get_long("chunk.threshold", OBJ_CHUNK_DEFAULT_THRESHOLD);
+    threshold = value < 0 ? 0 : value;
+  }
+  return (uint64_t)threshold;
+}
+
+/*
+ * Blob grande: cada chunk (FastCDC) vira um blob próprio e o objeto guarda só
+ * a lista "<hash> <tamanho>". Chunks que já estão no store não são regravados.
+ */
+static int store_chunked(const char *hex, const unsigned char *data, size_t len,
+                         objects_stats_t *stats) {
+  char header[OBJ_HEADER_MAX];
+  char *list;
+  size_t list_len = 0;
+  size_t offset = 0;
+  int ret = 0;
+
+  list = malloc((len / CHUNK_MIN_SIZE + 1) * OBJ_CHUNK_LINE + 1);
+  if (!list) return -1;
+
+  while (ret == 0 && offset < len) {
+    size_t n = chunk_next(data + offset, len - offset);
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    char chunk_hex[SHA256_HEX_SIZE];
+
+    sha256_buffer(data + offset, n, digest);
+    sha256_to_hex(digest, chunk_hex);
+    if (objects_exists(chunk_hex)) {
+      if (stats) stats->chunks_reused++;
+    } else {
+      ret = store_full(chunk_hex, OBJ_BLOB, data + offset, n, stats);
+    }
+    list_len += (size_t)sprintf(list + list_len, "%s %zu\n", chunk_hex, n);
+    offset += n;
+  }
+
+  if (ret == 0) {
+    snprintf(header, sizeof(header), "chunked %llu %zu\n", (unsigned long long)len, list_len);
+    ret = store_object(hex, header, list, list_len, stats);
+    if (ret == 0 && stats) stats->objects_chunked++;
+  }
+  free(list);
+  return ret;
+}
+
+static int write_blob(const void *data, size_t len, const char *base_hex,
+                      char hex[SHA256_HEX_SIZE], objects_stats_t *stats) {
+  uint8_t digest[SHA256_DIGEST_SIZE];
+  uint64_t threshold = chunk_threshold();
+
+  sha256_buffer(data, len, digest);
+  sha256_to_hex(digest, hex);
+
+  if (objects_exists(hex)) return 0;
+  if (threshold > 0 && len >= threshold) return store_chunked(hex, data, len, stats);
+  if (base_hex && strcmp(base_hex, hex) != 0) {
+    int ret = store_delta(hex, data, len, base_hex, stats);
+    if (ret <= 0) return ret;
+  }
+  return store_full(hex, OBJ_BLOB, data, len, stats);
+}
+
+int objects_write_buffer(obj_type_t type, const void *data, size_t len, char hex[SHA256_HEX_SIZE],
+                         objects_stats_t *stats) {
+  uint8_t digest[SHA256_DIGEST_SIZE];
+
+  sha256_buffer(data, len, digest);
+  sha256_to_hex(digest, hex);
+
+  if (objects_exists(hex)) return 0;
+  return store_full(hex, type, data, len, stats);
+}
+
+static int write_file_blob(const char *path, const char *base_hex, char hex[SHA256_HEX_SIZE],
+                           objects_stats_t *stats) {
+  static const char empty[1];
+  const void *data = empty;
+  struct stat st;
+  int fd;
+  int ret;
+
+  fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    fprintf(stderr, "erro ao abrir %s: %s\n", path, strerror(errno));
+    return -1;
+  }
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return -1;
+  }
+
+  /*
+   * O arquivo é mapeado uma única vez: o hash e, se o blob for novo, a
+   * compressão leem a mesma região, sem segunda passada de read().
+   */
+  if (st.st_size > 0) {
+    data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      fprintf(stderr, "erro ao mapear %s: %s\n", path, strerror(errno));
+      close(fd);
+      return -1;
+    }
+    madvise((void *)data, (size_t)st.st_size, MADV_SEQUENTIAL);
+  }
+  close(fd);
+
+  ret = write_blob(data, (size_t)st.st_size, base_hex, hex, stats);
+
+  if (stats) {
+    stats->files++;
+    stats->bytes_total += (uint64_t)st.st_size;
+  }
+  if (st.st_size > 0) munmap((void *)data, (size_t)st.st_size);
+  return ret;
+}
+
+int objects_write_file(const char *path, char hex[SHA256_HEX_SIZE], objects_stats_t *stats) {
+  return write_file_blob(path, NULL, hex, stats);
+}
+
+typedef struct {
+  unsigned int mode;
+  char hex[SHA256_HEX_SIZE];
+  char name[NAME_MAX + 1];
+} tree_item_t;
+
+static int compare_items(const void *a, const void *b) {
+  return strcmp(((const tree_item_t *)a)->name, ((const tree_item_t *)b)->name);
+}
+
+static int should_skip(const char *name) {
+  return strcmp(name, ".") == 0 || strcmp(name, "..") == 0 || strcmp(name, ".clurg") == 0;
+}
+
+/* Estado compartilhado pela gravação recursiva de uma árvore */
+typedef struct {
+  const index_t *cache;   /* índice anterior (pode ser NULL) */
+  index_builder_t *next;  /* índice sendo reconstruído (pode ser NULL) */
+  objects_stats_t *stats;
+  const ignore_t *ignore; /* regras do .clurgignore (pode ser NULL) */
+  const watch_dirty_t *dirty; /* caminhos relatados pelo clurg watch (pode ser NULL) */
+} tree_walk_t;
+
+/* Itens da tree anterior de um diretório, para reaproveitar o que o watch não tocou */
+typedef struct {
+  tree_item_t *items;
+  size_t count;
+  size_t capacity;
+} base_items_t;
+
+static int collect_base_item(const objects_tree_entry_t *entry, void *ctx) {
+  base_items_t *base = ctx;
+  tree_item_t *item;
+
+  if (strlen(entry->name) > NAME_MAX) return -1;
+  if (base->count == base->capacity) {
+    size_t capacity = base->capacity ? base->capacity * 2 : 32;
+    tree_item_t *grown = realloc(base->items, capacity * sizeof(*grown));
+    if (!grown) return -1;
+    base->items = grown;
+    base->capacity = capacity;
+  }
+  item = &base->items[base->count++];
+  item->mode = entry->mode;
+  memcpy(item->hex, entry->hex, SHA256_HEX_SIZE);
+  strcpy(item->name, entry->name);
+  return 0;
+}
+
+static const tree_item_t *find_base_item(const base_items_t *base, const char *name) {
+  tree_item_t key;
+
+  if (!base || strlen(name) > NAME_MAX) return NULL;
+  strcpy(key.name, name);
+  return bsearch(&key, base->items, base->count, sizeof(*base->items), compare_items);
+}
+
+/* Entrada copiada do índice anterior sem stat; as "racy" perdem o mtime e serão relidas */
+static int reuse_entry(tree_walk_t *walk, const index_entry_t *entry) {
+  index_entry_t copy = *entry;
+
+  if (copy.mtime_ns >= walk->cache->written_ns) copy.mtime_ns = 0;
+  if (walk->stats && !S_ISLNK(entry->mode)) {
+    walk->stats->files++;
+    walk->stats->bytes_total += entry->size;
+  }
+  if (!walk->next) return 0;
+  return index_builder_add_entry(walk->next, index_entry_path(walk->cache, entry), &copy, NULL);
+}
+
+/*
+ * Item que o watch não tocou: o hash vem da tree anterior e as entradas do
+ * índice são copiadas. Retorna 1 se reaproveitou, 0 se é preciso ler o disco.
+ */
+static int reuse_item(tree_walk_t *walk, const base_items_t *base, const char *rel,
+                      const char *name, tree_item_t *item) {
+  const tree_item_t *prev = find_base_item(base, name);
+
+  if (!prev) return 0;
+  if (prev->mode == OBJ_MODE_DIR) {
+    char prefix[PATH_MAX];
+    size_t len = (size_t)snprintf(prefix, sizeof(prefix), "%s/", rel);
+    size_t i;
+
+    if (len >= sizeof(prefix)) return 0;
+    for (i = index_lower_bound(walk->cache, prefix); i < walk->cache->count; i++) {
+      const index_entry_t *entry = &walk->cache->entries[i];
+      if (strncmp(index_entry_path(walk->cache, entry), prefix, len) != 0) break;
+      if (reuse_entry(walk, entry) != 0) return -1;
+    }
+  } else {
+    const index_entry_t *entry = index_lookup(walk->cache, rel);
+    char hex[SHA256_HEX_SIZE];
+
+    if (!entry) return 0;
+    sha256_to_hex(entry->hash, hex);
+    if (strcmp(hex, prev->hex) != 0) return 0;
+    if (reuse_entry(walk, entry) != 0) return -1;
+  }
+  *item = *prev;
+  return 1;
+}
+
+static int write_file_item(tree_walk_t *walk, const char *path, const char *rel,
+                           const struct stat *st, char hex[SHA256_HEX_SIZE]) {
+  const index_entry_t *cached = walk->cache ? index_lookup(walk->cache, rel) : NULL;
+  uint8_t digest[SHA256_DIGEST_SIZE];
+  char base_hex[SHA256_HEX_SIZE];
+
+  if (cached && index_entry_is_clean(walk->cache, cached, st)) {
+    /* stat idêntico ao do último snapshot: reaproveitar o hash sem ler o arquivo */
+    memcpy(digest, cached->hash, SHA256_DIGEST_SIZE);
+    sha256_to_hex(digest, hex);
+    if (walk->stats) {
+      walk->stats->files++;
+      walk->stats->bytes_total += (uint64_t)st->st_size;
+    }
+  } else {
+    /* A versão anterior do mesmo caminho é a base natural para um delta */
+    if (cached) sha256_to_hex(cached->hash, base_hex);
+    if (write_file_blob(path, cached ? base_hex : NULL, hex, walk->stats) != 0) return -1;
+    sha256_from_hex(hex, digest);
+    if (walk->stats) walk->stats->files_read++;
+  }
+
+  if (walk->next && index_builder_add(walk->next, rel, st, digest) != 0) return -1;
+  return 0;
+}
+
+static int write_tree_rec(tree_walk_t *walk, const char *dir, const char *rel,
+                          char hex[SHA256_HEX_SIZE], const char *base_hex) {
+  DIR *d;
+  struct dirent *entry;
+  base_items_t base_items = {NULL, 0, 0};
+  const base_items_t *base = NULL;
+  tree_item_t *items = NULL;
+  size_t count = 0;
+  size_t capacity = 0;
+  char *text = NULL;
+  size_t text_len = 0;
+  size_t i;
+  int ret = -1;
+
+  /* Com o watch, a tree anterior deste diretório fornece tudo o que não mudou */
+  if (walk->dirty && base_hex) {
+    if (objects_tree_foreach(base_hex, collect_base_item, &base_items) != 0) {
+      free(base_items.items);
+      return -1;
+    }
+    base = &base_items;
+  }
+
+  d = opendir(dir);
+  if (!d) {
+    fprintf(stderr, "erro ao abrir diretório %s: %s\n", dir, strerror(errno));
+    free(base_items.items);
+    return -1;
+  }
+
+  while ((entry = readdir(d)) != NULL) {
+    char path[PATH_MAX];
+    char rel_path[PATH_MAX];
+    struct stat st;
+    tree_item_t *item;
+    int reused;
+
+    if (should_skip(entry->d_name)) continue;
+    if (strchr(entry->d_name, '\n')) {
+      fprintf(stderr, "aviso: ignorando nome com quebra de linha em %s\n", dir);
+      continue;
+    }
+
+    if (snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name) >= (int)sizeof(path) ||
+        snprintf(rel_path, sizeof(rel_path), "%s%s%s", rel, rel[0] ? "/" : "", entry->d_name) >=
+            (int)sizeof(rel_path)) {
+      fprintf(stderr, "caminho muito longo: %s/%s\n", dir, entry->d_name);
+      goto out;
+    }
+
+    if (count == capacity) {
+      size_t new_capacity = capacity ? capacity * 2 : 32;
+      tree_item_t *grown = realloc(items, new_capacity * sizeof(*items));
+      if (!grown) goto out;
+      items = grown;
+      capacity = new_capacity;
+    }
+    item = &items[count];
+
+    reused = base && !watch_dirty_touches(walk->dirty, rel_path)
+                 ? reuse_item(walk, base, rel_path, entry->d_name, item)
+                 : 0;
+    if (reused < 0) goto out;
+    if (reused) {
+      count++;
+      continue;
+    }
+
+    if (lstat(path, &st) != 0) continue;
+    if (ignore_match(walk->ignore, rel_path, S_ISDIR(st.st_mode))) continue;
+    strcpy(item->name, entry->d_name);
+
+    if (S_ISDIR(st.st_mode)) {
+      const tree_item_t *prev = find_base_item(base, entry->d_name);
+      item->mode = OBJ_MODE_DIR;
+      if (write_tree_rec(walk, path, rel_path, item->hex,
+                         prev && prev->mode == OBJ_MODE_DIR ? prev->hex : NULL) != 0) {
+        goto out;
+      }
+    } else if (S_ISREG(st.st_mode)) {
+      item->mode = (st.st_mode & 0111) ? OBJ_MODE_EXEC : OBJ_MODE_FILE;
+      if (write_file_item(walk, path, rel_path, &st, item->hex) != 0) goto out;
+    } else if (S_ISLNK(st.st_mode)) {
+      char target[PATH_MAX];
+      ssize_t n = readlink(path, target, sizeof(target));
+      if (n < 0) continue;
+      item->mode = OBJ_MODE_LINK;
+      if (objects_write_buffer(OBJ_BLOB, target, (size_t)n, item->hex, walk->stats) != 0) {
+        goto out;
+      }
+      if (walk->next) {
+        uint8_t digest[SHA256_DIGEST_SIZE];
+        sha256_from_hex(item->hex, digest);
+        if (index_builder_add(walk->next, rel_path, &st, digest) != 0) goto out;
+      }
+    } else {
+      continue; /* sockets, fifos etc. não entram no snapshot */
+    }
+    count++;
+  }
+
+  qsort(items, count, sizeof(*items), compare_items);
+
+  /* "<modo> <hash> <nome>\n" por entrada */
+  for (i = 0; i < count; i++) {
+    text_len += 7 + 64 + 1 + strlen(items[i].name) + 1;
+  }
+  text = malloc(text_len + 1);
+  if (!text) goto out;
+  text_len = 0;
+  for (i = 0; i < count; i++) {
+    text_len += (size_t)sprintf(text + text_len, "%06o %s %s\n", items[i].mode, items[i].hex,
+                                items[i].name);
+  }
+
+  ret = objects_write_buffer(OBJ_TREE, text, text_len, hex, walk->stats);
+
+out:
+  closedir(d);
+  free(base_items.items);
+  free(items);
+  free(text);
+  return ret;
+}
+
+int objects_write_tree(const char *dir, char hex[SHA256_HEX_SIZE], objects_stats_t *stats) {
+  return objects_write_tree_indexed(dir, hex, stats, NULL, NULL);
+}
+
+int objects_write_tree_indexed(const char *dir, char hex[SHA256_HEX_SIZE], objects_stats_t *stats,
+                               const index_t *cache, index_builder_t *next) {
+  return objects_write_tree_dirty(dir, hex, stats, cache, next, NULL);
+}
+
+int objects_write_tree_dirty(const char *dir, char hex[SHA256_HEX_SIZE], objects_stats_t *stats,
+                             const index_t *cache, index_builder_t *next,
+                             const watch_dirty_t *dirty) {
+  tree_walk_t walk;
+  int ret;
+
+  walk.cache = cache;
+  walk.next = next;
+  walk.stats = stats;
+  walk.dirty = dirty && !dirty->full && cache && cache->tree[0] ? dirty : NULL;
+
+  if (walk.dirty && dirty->count == 0) {
+    /* Nada mudou desde o índice: a tree é a mesma e as entradas são copiadas */
+    size_t i;
+    for (i = 0; i < cache->count; i++) {
+      if (reuse_entry(&walk, &cache->entries[i]) != 0) return -1;
+    }
+    strcpy(hex, cache->tree);
+    if (next) index_builder_set_tree(next, hex);
+    return 0;
+  }
+
+  walk.ignore = ignore_load(dir);
+  if (!walk.ignore) return -1;
+  ret = write_tree_rec(&walk, dir, "", hex, walk.dirty ? cache->tree : NULL);
+  ignore_free((ignore_t *)walk.ignore);
+  if (ret != 0) return -1;
+  if (next) index_builder_set_tree(next, hex);
+  return 0;
+}
+
+/* Lê e valida o cabeçalho "<tipo> <tamanho>\n" (ou "delta ...") de um objeto aberto */
+static int read_header(FILE *fp, obj_header_t *hdr) {
+  char header[OBJ_HEADER_MAX];
+  char name[16];
+  unsigned long long size;
+  unsigned long long payload;
+  int depth;
+
+  memset(hdr, 0, sizeof(*hdr));
+  if (!fgets(header, sizeof(header), fp)) return -1;
+  if (sscanf(header, "%15s %llu", name, &size) != 2) return -1;
+
+  if (strcmp(name, "delta") == 0) {
+    if (sscanf(header, "%*s %*u %64s %d %llu", hdr->base, &depth, &payload) != 3 ||
+        strlen(hdr->base) != 64 || depth < 1) {
+      return -1;
+    }
+    hdr->type = OBJ_BLOB;
+    hdr->depth = depth;
+    hdr->payload_size = payload;
+  } else if (strcmp(name, "chunked") == 0) {
+    if (sscanf(header, "%*s %*u %llu", &payload) != 1) return -1;
+    hdr->type = OBJ_BLOB;
+    hdr->chunked = 1;
+    hdr->payload_size = payload;
+  } else {
+    if (type_from_name(name, &hdr->type) != 0) return -1;
+    hdr->payload_size = size;
+  }
+  hdr->size = size;
+  return 0;
+}
+
+static FILE *open_object(const char *hex, obj_header_t *hdr) {
+  char path[PATH_MAX];
+  FILE *fp;
+
+  if (objects_path(hex, path, sizeof(path)) != 0) return NULL;
+  fp = fopen(path, "rb");
+  if (!fp) {
+    /* Não está solto: ler do pack, a partir do offset indicado no índice */
+    const pack_t *pack;
+    const pack_idx_entry_t *entry = find_packed(hex, &pack);
+
+    if (entry) fp = fopen(pack->path, "rb");
+    if (fp && fseeko(fp, (off_t)entry->offset, SEEK_SET) != 0) {
+      fclose(fp);
+      fp = NULL;
+    }
+  }
+  if (!fp) {
+    fprintf(stderr, "objeto não encontrado: %s\n", hex);
+    return NULL;
+  }
+  if (read_header(fp, hdr) != 0) {
+    fprintf(stderr, "objeto corrompido: %s\n", hex);
+    fclose(fp);
+    return NULL;
+  }
+  return fp;
+}
+
+/* Descomprime o payload de um objeto, entregando os bytes a `sink` à medida que saem do zlib */
+static int inflate_object(FILE *fp, uint64_t size, objects_sink_cb sink, void *ctx) {
+  unsigned char in[OBJ_BUFFER_SIZE];
+  unsigned char out[OBJ_BUFFER_SIZE];
+  uint64_t produced = 0;
+  z_stream zs;
+  int zret = Z_OK;
+
+  memset(&zs, 0, sizeof(zs));
+  if (inflateInit(&zs) != Z_OK) return -1;
+
+  while (zret != Z_STREAM_END) {
+    size_t n = fread(in, 1, sizeof(in), fp);
+    if (n == 0) break;
+    zs.next_in = in;
+    zs.avail_in = (uInt)n;
+
+    do {
+      size_t have;
+      zs.next_out = out;
+      zs.avail_out = sizeof(out);
+      zret = inflate(&zs, Z_NO_FLUSH);
+      if (zret != Z_OK && zret != Z_STREAM_END && zret != Z_BUF_ERROR) {
+        inflateEnd(&zs);
+        return -1;
+      }
+      have = sizeof(out) - zs.avail_out;
+      if (produced + have > size || (have > 0 && sink(out, have, ctx) != 0)) {
+        inflateEnd(&zs);
+        return -1;
+      }
+      produced += have;
+    } while (zs.avail_out == 0 && zret != Z_STREAM_END);
+  }
+
+  inflateEnd(&zs);
+  return (zret == Z_STREAM_END && produced == size) ? 0 : -1;
+}
+
+static int read_object_header(const char *hex, obj_header_t *hdr) {
+  FILE *fp = open_object(hex, hdr);
+  if (!fp) return -1;
+  fclose(fp);
+  return 0;
+}
+
+int objects_read_header(const char *hex, obj_type_t *type, uint64_t *size) {
+  obj_header_t hdr;
+
+  if (read_object_header(hex, &hdr) != 0) return -1;
+  *type = hdr.type;
+  *size = hdr.size;
+  return 0;
+}
+
+typedef struct {
+  unsigned char *data;
+  size_t len;
+  size_t cap;
+} memory_sink_t;
+
+static int memory_sink(const void *data, size_t len, void *ctx) {
+  memory_sink_t *mem = ctx;
+  if (len > mem->cap - mem->len) return -1;
+  memcpy(mem->data + mem->len, data, len);
+  mem->len += len;
+  return 0;
+}
+
+static int fd_sink(const void *data, size_t len, void *ctx) {
+  return write_all(*(int *)ctx, data, len);
+}
+
+/* Descomprime o payload inteiro para a memória (com '\0' extra no fim) */
+static int inflate_to_memory(FILE *fp, uint64_t size, unsigned char **data) {
+  memory_sink_t mem;
+
+  mem.data = malloc(size + 1);
+  mem.len = 0;
+  mem.cap = size;
+  if (!mem.data) return -1;
+
+  if (inflate_object(fp, size, memory_sink, &mem) != 0) {
+    free(mem.data);
+    return -1;
+  }
+  mem.data[size] = '\0';
+  *data = mem.data;
+  return 0;
+}
+
+typedef int (*chunk_cb)(const char *hex, uint64_t len, void *ctx);
+
+/* Percorre a lista de um objeto "chunked"; `cb` NULL só valida (tamanhos somam `size`) */
+static int foreach_chunk(const unsigned char *list, size_t list_len, uint64_t size, chunk_cb cb,
+                         void *ctx) {
+  const char *p = (const char *)list;
+  const char *end = p + list_len;
+  uint64_t total = 0;
+
+  while (p < end) {
+    const char *nl = memchr(p, '\n', (size_t)(end - p));
+    char hex[SHA256_HEX_SIZE];
+    char *num_end;
+    unsigned long long n;
+
+    if (!nl || nl - p < 66 || p[64] != ' ') return -1;
+    memcpy(hex, p, 64);
+    hex[64] = '\0';
+    n = strtoull(p + 65, &num_end, 10);
+    if (num_end != nl || n == 0) return -1;
+    total += n;
+    if (cb && cb(hex, n, ctx) != 0) return -1;
+    p = nl + 1;
+  }
+  return total == size ? 0 : -1;
+}
+
+typedef struct {
+  objects_sink_cb sink;
+  void *ctx;
+  uint64_t produced;
+} chunk_stream_t;
+
+static int counting_sink(const void *data, size_t len, void *ctx) {
+  chunk_stream_t *stream = ctx;
+  stream->produced += len;
+  return stream->sink(data, len, stream->ctx);
+}
+
+static int stream_chunk(const char *hex, uint64_t len, void *ctx) {
+  chunk_stream_t *stream = ctx;
+  uint64_t before = stream->produced;
+
+  if (objects_read_stream(hex, counting_sink, stream) != 0) return -1;
+  return stream->produced - before == len ? 0 : -1;
+}
+
+/* Entrega o conteúdo de um blob "chunked", chunk por chunk, a `sink` */
+static int stream_chunks(const char *hex, const unsigned char *list, size_t list_len,
+                         uint64_t size, objects_sink_cb sink, void *ctx) {
+  chunk_stream_t stream = {sink, ctx, 0};
+
+  if (foreach_chunk(list, list_len, size, NULL, NULL) != 0 ||
+      foreach_chunk(list, list_len, size, stream_chunk, &stream) != 0) {
+    fprintf(stderr, "lista de chunks corrompida: %s\n", hex);
+    return -1;
+  }
+  return 0;
+}
+
+int objects_read(const char *hex, obj_type_t *type, unsigned char **data, size_t *len) {
+  obj_header_t hdr;
+  unsigned char *payload;
+  unsigned char *base;
+  size_t base_len;
+  obj_type_t base_type;
+  FILE *fp;
+  int ret;
+
+  fp = open_object(hex, &hdr);
+  if (!fp) return -1;
+
+  ret = inflate_to_memory(fp, hdr.payload_size, &payload);
+  fclose(fp);
+  if (ret != 0) {
+    fprintf(stderr, "objeto corrompido: %s\n", hex);
+    return -1;
+  }
+
+  *type = hdr.type;
+  if (hdr.chunked) {
+    memory_sink_t mem;
+
+    mem.data = malloc(hdr.size + 1);
+    mem.len = 0;
+    mem.cap = hdr.size;
+    ret = mem.data ? stream_chunks(hex, payload, (size_t)hdr.payload_size, hdr.size, memory_sink,
+                                   &mem)
+                   : -1;
+    free(payload);
+    if (ret != 0) {
+      free(mem.data);
+      return -1;
+    }
+    mem.data[hdr.size] = '\0';
+    *data = mem.data;
+    *len = (size_t)hdr.size;
+    return 0;
+  }
+  if (hdr.depth == 0) {
+    *data = payload;
+    *len = (size_t)hdr.size;
+    return 0;
+  }
+
+  /* Delta: reconstruir a base (recursivamente, até o keyframe) e aplicar */
+  if (objects_read(hdr.base, &base_type, &base, &base_len) != 0) {
+    free(payload);
+    return -1;
+  }
+  ret = delta_apply(base, base_len, payload, (size_t)hdr.payload_size, data, len);
+  free(base);
+  free(payload);
+  if (ret != 0 || *len != hdr.size) {
+    if (ret == 0) free(*data);
+    fprintf(stderr, "delta corrompido: %s\n", hex);
+    return -1;
+  }
+  (*data)[*len] = '\0';
+  return 0;
+}
+
+int objects_read_stream(const char *hex, objects_sink_cb sink, void *ctx) {
+  obj_header_t hdr;
+  FILE *fp;
+  int ret;
+
+  fp = open_object(hex, &hdr);
+  if (!fp) return -1;
+
+  if (hdr.chunked) {
+    /* Só a lista fica na memória; os chunks são descomprimidos um a um */
+    unsigned char *list;
+
+    ret = inflate_to_memory(fp, hdr.payload_size, &list);
+    fclose(fp);
+    if (ret != 0) {
+      fprintf(stderr, "objeto corrompido: %s\n", hex);
+      return -1;
+    }
+    ret = stream_chunks(hex, list, (size_t)hdr.payload_size, hdr.size, sink, ctx);
+    free(list);
+    return ret;
+  }
+
+  if (hdr.depth > 0) {
+    /* Deltas precisam da base inteira; são limitados a OBJ_DELTA_MAX_SIZE */
+    unsigned char *data;
+    size_t len;
+    obj_type_t type;
+
+    fclose(fp);
+    if (objects_read(hex, &type, &data, &len) != 0) return -1;
+    ret = len > 0 ? sink(data, len, ctx) : 0;
+    free(data);
+    return ret;
+  }
+
+  ret = inflate_object(fp, hdr.size, sink, ctx);
+  if (ret != 0) fprintf(stderr, "objeto corrompido: %s\n", hex);
+
+  fclose(fp);
+  return ret;
+}
+
+int objects_read_to_fd(const char *hex, int fd) {
+  return objects_read_stream(hex, fd_sink, &fd);
+}
+
+int objects_valid_name(const char *name, size_t len) {
+  /* Os mesmos nomes que should_skip() nunca deixa entrar numa tree */
+  if (len == 0 || (len == 1 && name[0] == '.') || (len == 2 && memcmp(name, "..", 2) == 0) ||
+      (len == 6 && memcmp(name, ".clurg", 6) == 0)) {
+    return 0;
+  }
+  return memchr(name, '/', len) == NULL && memchr(name, '\0', len) == NULL;
+}
+
+int objects_tree_foreach(const char *tree_hex, objects_tree_cb cb, void *ctx) {
+  unsigned char *data;
+  size_t len;
+  obj_type_t type;
+  const char *prev = NULL;
+  char *line;
+  char *next;
+  int ret = 0;
+
+  if (objects_read(tree_hex, &type, &data, &len) != 0) return -1;
+  if (type != OBJ_TREE) {
+    fprintf(stderr, "objeto %s não é uma tree\n", tree_hex);
+    free(data);
+    return -1;
+  }
+
+  for (line = (char *)data; line < (char *)data + len; line = next) {
+    objects_tree_entry_t entry;
+    char *end = strchr(line, '\n');
+
+    if (!end) break;
+    *end = '\0';
+    next = end + 1;
+
+    /* "<modo> <hash> <nome>" */
+    if (strlen(line) < 7 + 64 + 1 + 1 || line[6] != ' ' || line[71] != ' ') {
+      fprintf(stderr, "tree corrompida: %s\n", tree_hex);
+      ret = -1;
+      break;
+    }
+    entry.mode = (unsigned int)strtoul(line, NULL, 8);
+    memcpy(entry.hex, line + 7, 64);
+    entry.hex[64] = '\0';
+    entry.name = line + 72;
+    /* end - name: um NUL no meio do nome também o invalida */
+    if (!objects_valid_name(entry.name, (size_t)(end - entry.name))) {
+      fprintf(stderr, "tree %s com nome de entrada inválido: '%s'\n", tree_hex, entry.name);
+      ret = -1;
+      break;
+    }
+    /* Entradas ordenadas e sem repetição: um nome não pode ser link e diretório */
+    if (prev && strcmp(prev, entry.name) >= 0) {
+      fprintf(stderr, "tree %s com entradas repetidas ou fora de ordem: '%s'\n", tree_hex,
+              entry.name);
+      ret = -1;
+      break;
+    }
+    prev = entry.name;
+
+    ret = cb(&entry, ctx);
+    if (ret != 0) break;
+  }
+
+  free(data);
+  return ret;
+}
+
+typedef struct {
+  objects_ref_cb cb;
+  void *ctx;
+} ref_walk_t;
+
+static int chunk_ref(const char *hex, uint64_t len, void *ctx) {
+  ref_walk_t *walk = ctx;
+  (void)len;
+  return walk->cb(hex, walk->ctx);
+}
+
+/* Hashes das entradas de uma tree; `cb` NULL só valida o formato */
+static int tree_refs(const unsigned char *data, size_t len, objects_ref_cb cb, void *ctx) {
+  const char *line = (const char *)data;
+  const char *end = line + len;
+
+  while (line < end) {
+    const char *nl = memchr(line, '\n', (size_t)(end - line));
+    char hex[SHA256_HEX_SIZE];
+
+    if (!nl || nl - line < 7 + 64 + 1 + 1 || line[6] != ' ' || line[71] != ' ' ||
+        !objects_valid_name(line + 72, (size_t)(nl - line - 72))) {
+      return -1;
+    }
+    memcpy(hex, line + 7, 64);
+    hex[64] = '\0';
+    if (cb && cb(hex, ctx) != 0) return -1;
+    line = nl + 1;
+  }
+  return 0;
+}
+
+/*
+ * Visita as referências de um payload já descomprimido. Com `verify`, um
+ * objeto completo também tem o conteúdo conferido contra o hash.
+ */
+static int payload_references(const char *hex, const obj_header_t *hdr, unsigned char *payload,
+                              int verify, objects_ref_cb cb, void *ctx) {
+  int ret = 0;
+
+  /* Primeiro validar tudo; só então visitar as referências */
+  if (hdr->chunked) {
+    ret = foreach_chunk(payload, (size_t)hdr->payload_size, hdr->size, NULL, NULL);
+  } else if (hdr->depth == 0) {
+    if (verify) {
+      uint8_t digest[SHA256_DIGEST_SIZE];
+      char actual[SHA256_HEX_SIZE];
+
+      sha256_buffer(payload, (size_t)hdr->size, digest);
+      sha256_to_hex(digest, actual);
+      ret = strcmp(actual, hex) == 0 ? 0 : -1;
+    }
+    if (ret == 0 && hdr->type == OBJ_TREE) {
+      ret = tree_refs(payload, (size_t)hdr->size, NULL, NULL);
+    }
+  }
+  if (ret != 0) {
+    fprintf(stderr, "objeto corrompido: %s\n", hex);
+    return -1;
+  }
+
+  if (hdr->chunked) {
+    ref_walk_t walk = {cb, ctx};
+    ret = foreach_chunk(payload, (size_t)hdr->payload_size, hdr->size, chunk_ref, &walk);
+  } else if (hdr->depth > 0) {
+    ret = cb(hdr->base, ctx);
+  } else if (hdr->type == OBJ_TREE) {
+    ret = tree_refs(payload, (size_t)hdr->size, cb, ctx);
+  }
+  return ret;
+}
+
+int objects_raw_references(const char *hex, const unsigned char *raw, size_t len,
+                           objects_ref_cb cb, void *ctx) {
+  obj_header_t hdr;
+  unsigned char *payload;
+  FILE *fp;
+  int ret;
+
+  fp = fmemopen((void *)raw, len, "rb");
+  if (!fp) return -1;
+  ret = read_header(fp, &hdr) == 0 ? inflate_to_memory(fp, hdr.payload_size, &payload) : -1;
+  fclose(fp);
+  if (ret != 0) {
+    fprintf(stderr, "objeto corrompido: %s\n", hex);
+    return -1;
+  }
+  ret = payload_references(hex, &hdr, payload, 1, cb, ctx);
+  free(payload);
+  return ret;
+}
+
+int objects_references(const char *hex, objects_ref_cb cb, void *ctx, uint64_t *bytes_read) {
+  obj_header_t hdr;
+  unsigned char *payload;
+  FILE *fp;
+  int ret;
+
+  fp = open_object(hex, &hdr);
+  if (!fp) return -1;
+
+  /* Blob completo não aponta para nada: basta o cabeçalho */
+  if (hdr.depth > 0 || (hdr.type == OBJ_BLOB && !hdr.chunked)) {
+    fclose(fp);
+    return hdr.depth > 0 ? cb(hdr.base, ctx) : 0;
+  }
+
+  ret = inflate_to_memory(fp, hdr.payload_size, &payload);
+  fclose(fp);
+  if (ret != 0) {
+    fprintf(stderr, "objeto corrompido: %s\n", hex);
+    return -1;
+  }
+  if (bytes_read) *bytes_read += hdr.payload_size;
+  ret = payload_references(hex, &hdr, payload, 0, cb, ctx);
+  free(payload);
+  return ret;
+}
+
+typedef struct {
+  index_builder_t *builder;
+  const char *prefix;
+} flatten_t;
+
+static int flatten_entry(const objects_tree_entry_t *tree_entry, void *arg) {
+  flatten_t *flat = arg;
+  char path[PATH_MAX];
+  index_entry_t entry;
+
+  if (snprintf(path, sizeof(path), "%s%s", flat->prefix, tree_entry->name) >= (int)sizeof(path) - 1) {
+    fprintf(stderr, "caminho muito longo: %s%s\n", flat->prefix, tree_entry->name);
+    return -1;
+  }
+  if (tree_entry->mode == OBJ_MODE_DIR) {
+    flatten_t sub = {flat->builder, path};
+    strcat(path, "/");
+    return objects_tree_foreach(tree_entry->hex, flatten_entry, &sub);
+  }
+
+  /* Sem stat: nenhuma entrada é considerada limpa */
+  memset(&entry, 0, sizeof(entry));
+  entry.mode = tree_entry->mode;
+  sha256_from_hex(tree_entry->hex, entry.hash);
+  return index_builder_add_entry(flat->builder, path, &entry, NULL);
+}
+
+int objects_tree_to_index(const char *tree_hex, index_t *idx) {
+  index_builder_t builder;
+  flatten_t flat;
+
+  index_builder_init(&builder);
+  flat.builder = &builder;
+  flat.prefix = "";
+  if (objects_tree_foreach(tree_hex, flatten_entry, &flat) != 0) {
+    index_builder_free(&builder);
+    return -1;
+  }
+  index_builder_set_tree(&builder, tree_hex);
+  index_from_builder(idx, &builder);
+  return 0;
+}
+
+static int checkout_entry(const objects_tree_entry_t *entry, void *ctx) {
+  const char *dest_dir = ctx;
+  char path[PATH_MAX];
+
+  /* Nome vindo de um repositório remoto: nunca sair de dest_dir */
+  if (!objects_valid_name(entry->name, strlen(entry->name))) {
+    fprintf(stderr, "nome de entrada inválido: '%s'\n", entry->name);
+    return -1;
+  }
+  if (snprintf(path, sizeof(path), "%s/%s", dest_dir, entry->name) >= (int)sizeof(path)) {
+    fprintf(stderr, "caminho muito longo: %s/%s\n", dest_dir, entry->name);
+    return -1;
+  }
+
+  if (entry->mode == OBJ_MODE_DIR) {
+    return objects_checkout(entry->hex, path);
+  }
+
+  if (entry->mode == OBJ_MODE_LINK) {
+    unsigned char *target;
+    size_t len;
+    obj_type_t type;
+    int ret;
+
+    if (objects_read(entry->hex, &type, &target, &len) != 0) return -1;
+    unlink(path);
+    ret = symlink((const char *)target, path);
+    if (ret != 0) fprintf(stderr, "erro ao criar link %s: %s\n", path, strerror(errno));
+    free(target);
+    return ret;
+  }
+
+  {
+    mode_t mode = (entry->mode == OBJ_MODE_EXEC) ? 0755 : 0644;
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, mode);
+    int ret;
+
+    if (fd < 0) {
+      fprintf(stderr, "erro ao criar %s: %s\n", path, strerror(errno));
+      return -1;
+    }
+    ret = objects_read_to_fd(entry->hex, fd);
+    fchmod(fd, mode);
+    close(fd);
+    return ret;
+  }
+}
+
+int objects_checkout(const char *tree_hex, const char *dest_dir) {
+  if (mkdir(dest_dir, 0755) != 0 && errno != EEXIST) {
+    fprintf(stderr, "erro ao criar %s: %s\n", dest_dir, strerror(errno));
+    return -1;
+  }
+  return objects_tree_foreach(tree_hex, checkout_entry, (void *)dest_dir);
+}
+
+static int is_hex_name(const char *name, size_t len) {
+  size_t i;
+
+  if (strlen(name) != len) return 0;
+  for (i = 0; i < len; i++) {
+    if (!((name[i] >= '0' && name[i] <= '9') || (name[i] >= 'a' && name[i] <= 'f'))) return 0;
+  }
+  return 1;
+}
+
+/* Lê o arquivo de um objeto solto como está no disco (cabeçalho + zlib) */
+static int read_loose(const char *path, unsigned char **data, size_t *len) {
+  struct stat st;
+  ssize_t n;
+  int fd = open(path, O_RDONLY);
+
+  if (fd < 0) return -1;
+  if (fstat(fd, &st) != 0 || !(*data = malloc((size_t)st.st_size + 1))) {
+    close(fd);
+    return -1;
+  }
+  n = read(fd, *data, (size_t)st.st_size);
+  close(fd);
+  if (n != st.st_size) {
+    free(*data);
+    return -1;
+  }
+  *len = (size_t)n;
+  return 0;
+}
+
+typedef struct {
+  char **paths;
+  size_t count;
+  size_t capacity;
+} path_list_t;
+
+static int path_list_add(path_list_t *list, const char *path) {
+  if (list->count == list->capacity) {
+    size_t capacity = list->capacity ? list->capacity * 2 : 1024;
+    char **grown = realloc(list->paths, capacity * sizeof(char *));
+    if (!grown) return -1;
+    list->paths = grown;
+    list->capacity = capacity;
+  }
+  list->paths[list->count] = strdup(path);
+  if (!list->paths[list->count]) return -1;
+  list->count++;
+  return 0;
+}
+
+static void path_list_free(path_list_t *list) {
+  size_t i;
+  for (i = 0; i < list->count; i++) free(list->paths[i]);
+  free(list->paths);
+}
+
+/* Copia para o pack novo todos os registros dos packs existentes */
+static int repack_existing(pack_writer_t *w, const pack_set_t *set) {
+  size_t i;
+  size_t j;
+
+  for (i = 0; i < set->count; i++) {
+    const pack_t *pack = &set->packs[i];
+    for (j = 0; j < pack->count; j++) {
+      const pack_idx_entry_t *entry = &pack->entries[j];
+      unsigned char *data;
+      int ret;
+
+      /* Um objeto presente em dois packs só é copiado uma vez */
+      if (pack_set_find(set, entry->key, NULL) != entry) continue;
+      if (pack_read(pack, entry, &data) != 0) return -1;
+      ret = pack_writer_add(w, entry->key, data, (size_t)entry->length);
+      free(data);
+      if (ret != 0) return -1;
+    }
+  }
+  return 0;
+}
+
+/* Acrescenta os objetos soltos e guarda seus caminhos para remoção */
+static int repack_loose(pack_writer_t *w, const pack_set_t *set, path_list_t *loose) {
+  struct dirent *fan;
+  DIR *root = opendir(OBJECTS_DIR);
+  int ret = 0;
+
+  if (!root) return 0;
+  while (ret == 0 && (fan = readdir(root)) != NULL) {
+    char dir_path[PATH_MAX];
+    struct dirent *entry;
+    DIR *d;
+
+    if (!is_hex_name(fan->d_name, 2)) continue;
+    snprintf(dir_path, sizeof(dir_path), "%s/%s", OBJECTS_DIR, fan->d_name);
+    d = opendir(dir_path);
+    if (!d) continue;
+
+    while (ret == 0 && (entry = readdir(d)) != NULL) {
+      char hex[SHA256_HEX_SIZE];
+      char path[PATH_MAX];
+      uint8_t key[SHA256_DIGEST_SIZE];
+      unsigned char *data;
+      size_t len;
+
+      if (!is_hex_name(entry->d_name, 62)) continue;
+      snprintf(hex, sizeof(hex), "%s%s", fan->d_name, entry->d_name);
+      /* Caminho truncado leria outro arquivo, e o da lista seria apagado depois */
+      if (snprintf(path, sizeof(path), "%s/%s", dir_path, entry->d_name) >= (int)sizeof(path)) {
+        fprintf(stderr, "caminho muito longo: %s/%s\n", dir_path, entry->d_name);
+        ret = -1;
+        break;
+      }
+      sha256_from_hex(hex, key);
+
+      if (!pack_set_find(set, key, NULL)) {
+        if (read_loose(path, &data, &len) != 0) {
+          fprintf(stderr, "erro ao ler objeto %s\n", hex);
+          ret = -1;
+          break;
+        }
+        ret = pack_writer_add(w, key, data, len);
+        free(data);
+      }
+      if (ret == 0) ret = path_list_add(loose, path);
+    }
+    closedir(d);
+  }
+  closedir(root);
+  return ret;
+}
+
+int objects_repack(objects_repack_stats_t *stats) {
+  const pack_set_t *set = object_packs();
+  pack_writer_t w;
+  path_list_t loose = {NULL, 0, 0};
+  char pack_path[PATH_MAX];
+  size_t i;
+
+  memset(stats, 0, sizeof(*stats));
+  if (pack_writer_open(&w, OBJECTS_PACK_DIR) != 0) return -1;
+
+  if (repack_existing(&w, set) != 0 || repack_loose(&w, set, &loose) != 0) {
+    pack_writer_abort(&w);
+    path_list_free(&loose);
+    return -1;
+  }
+  if (w.count == 0) {
+    pack_writer_abort(&w);
+    path_list_free(&loose);
+    return 0;
+  }
+  stats->objects = w.count;
+  stats->pack_bytes = w.offset;
+  if (pack_writer_finish(&w, pack_path, sizeof(pack_path)) != 0) {
+    path_list_free(&loose);
+    return -1;
+  }
+
+  /* Só agora, com o pack novo no lugar, apagar packs antigos e objetos soltos */
+  for (i = 0; i < set->count; i++) {
+    const char *old = set->packs[i].path;
+    char idx_path[PATH_MAX];
+
+    if (strcmp(old, pack_path) == 0) continue;
+    snprintf(idx_path, sizeof(idx_path), "%.*s.idx", (int)strlen(old) - 5, old);
+    unlink(idx_path);
+    unlink(old);
+  }
+  for (i = 0; i < loose.count; i++) {
+    char *slash;
+    if (unlink(loose.paths[i]) == 0) stats->loose_removed++;
+    slash = strrchr(loose.paths[i], '/');
+    *slash = '\0';
+    rmdir(loose.paths[i]); /* falha se ainda houver objetos: tudo bem */
+  }
+
+  path_list_free(&loose);
+  objects_reload_packs();
+  return 0;
+}
+
+/* Temporários de gravações interrompidas (tmp_obj_*), mais antigos que `before` */
+static void sweep_temporaries(time_t before, objects_sweep_stats_t *stats) {
+  struct dirent *entry;
+  DIR *d = opendir(OBJECTS_DIR);
+
+  if (!d) return;
+  while ((entry = readdir(d)) != NULL) {
+    char path[PATH_MAX];
+    struct stat st;
+
+    if (strncmp(entry->d_name, "tmp_obj_", 8) != 0) continue;
+    snprintf(path, sizeof(path), "%s/%s", OBJECTS_DIR, entry->d_name);
+    if (lstat(path, &st) != 0 || st.st_mtime >= before) continue;
+    if (unlink(path) == 0) stats->bytes_freed += (uint64_t)st.st_size;
+  }
+  closedir(d);
+}
+
+int objects_sweep_loose(unsigned int fanout, objects_keep_cb keep, void *ctx, time_t before,
+                        objects_sweep_stats_t *stats) {
+  char dir_path[PATH_MAX];
+  struct dirent *entry;
+  DIR *d;
+
+  if (fanout > 0xff) return -1;
+  if (fanout == 0) sweep_temporaries(before, stats);
+
+  snprintf(dir_path, sizeof(dir_path), "%s/%02x", OBJECTS_DIR, fanout);
+  d = opendir(dir_path);
+  if (!d) return 0;
+
+  while ((entry = readdir(d)) != NULL) {
+    char hex[SHA256_HEX_SIZE];
+    char path[PATH_MAX];
+    uint8_t key[SHA256_DIGEST_SIZE];
+    struct stat st;
+
+    if (!is_hex_name(entry->d_name, 62)) continue;
+    snprintf(hex, sizeof(hex), "%02x%s", fanout, entry->d_name);
+    sha256_from_hex(hex, key);
+    if (keep(key, ctx)) continue;
+
+    /* Objeto recente pode ser de um commit ainda em andamento */
+    if (snprintf(path, sizeof(path), "%s/%s", dir_path, entry->d_name) >= (int)sizeof(path) ||
+        lstat(path, &st) != 0 || st.st_mtime >= before) {
+      continue;
+    }
+    if (unlink(path) == 0) {
+      stats->objects_removed++;
+      stats->bytes_freed += (uint64_t)st.st_size;
+    }
+  }
+  closedir(d);
+  rmdir(dir_path); /* só some se ficou vazio */
+  return 0;
+}
+
+static void remove_pack(const char *pack_path) {
+  char idx_path[PATH_MAX];
+
+  /* O .idx primeiro: leitores nunca veem um índice apontando para um pack apagado */
+  snprintf(idx_path, sizeof(idx_path), "%.*s.idx", (int)strlen(pack_path) - 5, pack_path);
+  unlink(idx_path);
+  unlink(pack_path);
+}
+
+/* Reescreve um pack só com os registros que `keep` aceita */
+static int rewrite_pack(const pack_t *pack, objects_keep_cb keep, void *ctx,
+                        objects_sweep_stats_t *stats) {
+  pack_writer_t w;
+  char new_path[PATH_MAX];
+  size_t i;
+
+  if (pack_writer_open(&w, OBJECTS_PACK_DIR) != 0) return -1;
+  for (i = 0; i < pack->count; i++) {
+    const pack_idx_entry_t *entry = &pack->entries[i];
+    unsigned char *data;
+    int ret;
+
+    if (!keep(entry->key, ctx)) {
+      stats->objects_removed++;
+      continue;
+    }
+    if (pack_read(pack, entry, &data) != 0) {
+      pack_writer_abort(&w);
+      return -1;
+    }
+    ret = pack_writer_add(&w, entry->key, data, (size_t)entry->length);
+    free(data);
+    if (ret != 0) {
+      pack_writer_abort(&w);
+      return -1;
+    }
+    stats->io_bytes += 2 * entry->length;
+  }
+  if (pack_writer_finish(&w, new_path, sizeof(new_path)) != 0) return -1;
+  if (strcmp(new_path, pack->path) != 0) remove_pack(pack->path);
+  return 0;
+}
+
+int objects_sweep_packs(objects_keep_cb keep, void *ctx, time_t before, uint64_t max_io,
+                        objects_sweep_stats_t *stats) {
+  const pack_set_t *set = object_packs();
+  int changed = 0;
+  int ret = 0;
+  size_t i;
+  size_t j;
+
+  for (i = 0; ret == 0 && i < set->count; i++) {
+    const pack_t *pack = &set->packs[i];
+    uint64_t live_bytes = 0;
+    size_t live = 0;
+    struct stat st;
+
+    if (stat(pack->path, &st) != 0 || st.st_mtime >= before) continue;
+    for (j = 0; j < pack->count; j++) {
+      if (keep(pack->entries[j].key, ctx)) {
+        live++;
+        live_bytes += pack->entries[j].length;
+      }
+    }
+    if (live == pack->count) continue;
+
+    if (live == 0) {
+      remove_pack(pack->path);
+      stats->objects_removed += pack->count;
+      stats->bytes_freed += (uint64_t)st.st_size;
+      stats->packs_removed++;
+      changed = 1;
+    } else if (max_io > 0 && stats->io_bytes + 2 * live_bytes > max_io) {
+      stats->packs_deferred++;
+    } else {
+      ret = rewrite_pack(pack, keep, ctx, stats);
+      if (ret == 0) {
+        stats->bytes_freed += (uint64_t)st.st_size - live_bytes;
+        stats->packs_rewritten++;
+        changed = 1;
+      }
+    }
+  }
+
+  if (changed) objects_reload_packs();
+  return ret;
+}
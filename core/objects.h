@@ -0,0 +1,169 @@
+#ifndef CLURG_OBJECTS_H
+#define CLURG_OBJECTS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "index.h"
+#include "sha256.h"
+#include "watch.h"
+
+/*
+ * Object store endereçado por conteúdo (.clurg/objects/ab/cdef...).
+ *
+ * Cada objeto é identificado pelo SHA-256 do seu conteúdo bruto e gravado uma
+ * única vez, comprimido com zlib. Blobs guardam o conteúdo de arquivos e trees
+ * guardam a listagem de um diretório ("<modo> <hash> <nome>\n", ordenada por
+ * nome). Um commit aponta só para a tree raiz, então commits seguidos
+ * compartilham todos os blobs e subárvores que não mudaram.
+ *
+ * Um blob novo cujo caminho já existia no commit anterior pode ser gravado
+ * como delta contra a versão anterior ("delta <tam> <base> <prof> <tam_delta>"
+ * no cabeçalho). A leitura reconstrói o conteúdo de forma transparente; o id
+ * continua sendo o hash do conteúdo completo. Cadeias são limitadas por
+ * delta.max_depth (.clurg/config): ao atingir o limite o blob é gravado
+ * inteiro e vira o keyframe da próxima cadeia.
+ *
+ * Blobs a partir de chunk.threshold são divididos em chunks (chunk.h), cada
+ * um gravado como blob próprio; o objeto do arquivo guarda só a lista
+ * ("chunked <tam> <tam_lista>" no cabeçalho).
+ *
+ * `clurg repack` move os objetos soltos para um pack (pack.h) em
+ * .clurg/objects/pack/; a leitura procura primeiro o arquivo solto e depois
+ * os packs, então as duas formas convivem.
+ */
+
+#define OBJECTS_DIR ".clurg/objects"
+#define OBJECTS_PACK_DIR ".clurg/objects/pack"
+
+#define OBJ_MODE_FILE 0100644
+#define OBJ_MODE_EXEC 0100755
+#define OBJ_MODE_LINK 0120000
+#define OBJ_MODE_DIR 0040000
+
+typedef enum { OBJ_BLOB = 1, OBJ_TREE = 2 } obj_type_t;
+
+/* Estatísticas acumuladas durante a gravação de uma árvore */
+typedef struct {
+  uint64_t files;          /* arquivos visitados */
+  uint64_t files_read;     /* arquivos relidos (stat diferente do índice) */
+  uint64_t bytes_total;    /* tamanho lógico da árvore */
+  uint64_t objects_new;    /* objetos que não existiam no store */
+  uint64_t objects_delta;  /* dos novos, quantos foram gravados como delta */
+  uint64_t bytes_stored;   /* bytes gravados em disco (comprimidos) */
+  uint64_t objects_chunked; /* dos novos, quantos foram divididos em chunks */
+  uint64_t chunks_reused;  /* chunks que já estavam no store */
+} objects_stats_t;
+
+typedef struct {
+  uint64_t objects;        /* objetos no pack novo */
+  uint64_t pack_bytes;     /* tamanho do pack novo */
+  uint64_t loose_removed;  /* arquivos soltos apagados */
+} objects_repack_stats_t;
+
+typedef struct {
+  uint64_t objects_removed;
+  uint64_t bytes_freed;
+  uint64_t packs_rewritten;
+  uint64_t packs_removed;
+  uint64_t packs_deferred;  /* packs com lixo que não couberam no orçamento */
+  uint64_t io_bytes;        /* lidos + gravados ao reescrever packs */
+} objects_sweep_stats_t;
+
+typedef struct {
+  unsigned int mode;
+  char hex[SHA256_HEX_SIZE];
+  const char *name;
+} objects_tree_entry_t;
+
+typedef int (*objects_tree_cb)(const objects_tree_entry_t *entry, void *ctx);
+typedef int (*objects_sink_cb)(const void *data, size_t len, void *ctx);
+typedef int (*objects_ref_cb)(const char *hex, void *ctx);
+typedef int (*objects_keep_cb)(const uint8_t digest[SHA256_DIGEST_SIZE], void *ctx);
+
+int objects_init(void);
+int objects_exists(const char *hex);
+int objects_path(const char *hex, char *path, size_t size);
+
+/* Gravação */
+int objects_write_buffer(obj_type_t type, const void *data, size_t len, char hex[SHA256_HEX_SIZE],
+                         objects_stats_t *stats);
+int objects_write_file(const char *path, char hex[SHA256_HEX_SIZE], objects_stats_t *stats);
+int objects_write_tree(const char *dir, char hex[SHA256_HEX_SIZE], objects_stats_t *stats);
+
+/*
+ * Como objects_write_tree, mas arquivos com stat idêntico ao de `cache` não
+ * são lidos; `next` (se não for NULL) recebe as entradas do novo índice.
+ */
+int objects_write_tree_indexed(const char *dir, char hex[SHA256_HEX_SIZE], objects_stats_t *stats,
+                               const index_t *cache, index_builder_t *next);
+
+/*
+ * Como objects_write_tree_indexed, mas `cache` precisa descrever a tree
+ * cache->tree e só os caminhos de `dirty` (ver watch.h) são visitados; o resto
+ * vem da tree anterior sem stat nem readdir. Com dirty->full, percorre tudo.
+ */
+int objects_write_tree_dirty(const char *dir, char hex[SHA256_HEX_SIZE], objects_stats_t *stats,
+                             const index_t *cache, index_builder_t *next,
+                             const watch_dirty_t *dirty);
+
+/* Leitura */
+int objects_read(const char *hex, obj_type_t *type, unsigned char **data, size_t *len);
+int objects_read_header(const char *hex, obj_type_t *type, uint64_t *size);
+int objects_read_stream(const char *hex, objects_sink_cb sink, void *ctx);
+int objects_read_to_fd(const char *hex, int fd);
+/* Visita as entradas de uma tree; nomes inválidos (objects_valid_name), repetidos
+ * ou fora de ordem são erro */
+int objects_tree_foreach(const char *tree_hex, objects_tree_cb cb, void *ctx);
+/* Nome de entrada de tree aceitável: não vazio, nem ".", ".." ou ".clurg", sem '/'
+ * nem NUL */
+int objects_valid_name(const char *name, size_t len);
+
+/*
+ * Lista plana (caminho, modo, hash) de todos os arquivos e symlinks de uma
+ * tree, como um índice em memória sem stat (ver index_from_builder).
+ */
+int objects_tree_to_index(const char *tree_hex, index_t *idx);
+
+/*
+ * Objeto no formato do disco (cabeçalho + zlib, como num arquivo solto ou
+ * num registro de pack): confere a integridade do que dá para conferir sem
+ * outros objetos e chama `cb` para cada objeto de que ele depende (base de
+ * um delta, chunks de um blob dividido, entradas de uma tree).
+ */
+int objects_raw_references(const char *hex, const unsigned char *raw, size_t len,
+                           objects_ref_cb cb, void *ctx);
+
+/*
+ * Como objects_raw_references, para um objeto do store local, sem conferir o
+ * hash; blobs completos nem são descomprimidos. `bytes_read` (se não for
+ * NULL) acumula os bytes descomprimidos.
+ */
+int objects_references(const char *hex, objects_ref_cb cb, void *ctx, uint64_t *bytes_read);
+
+/*
+ * Coleta de lixo (ver gc.h): apaga os objetos soltos de .clurg/objects/<fanout>
+ * que `keep` rejeita e cujo arquivo é anterior a `before`. O fanout 0 também
+ * limpa temporários de gravações interrompidas.
+ */
+int objects_sweep_loose(unsigned int fanout, objects_keep_cb keep, void *ctx, time_t before,
+                        objects_sweep_stats_t *stats);
+
+/*
+ * Packs anteriores a `before`: sem nada a manter são apagados; com lixo são
+ * reescritos, desde que stats->io_bytes não passe de `max_io` (0 = sem limite).
+ */
+int objects_sweep_packs(objects_keep_cb keep, void *ctx, time_t before, uint64_t max_io,
+                        objects_sweep_stats_t *stats);
+
+/* Agrupa objetos soltos e packs existentes num único pack */
+int objects_repack(objects_repack_stats_t *stats);
+
+/* Descarta os packs carregados (depois de criar ou apagar packs) */
+void objects_reload_packs(void);
+
+/* Reconstrói em dest_dir os arquivos de uma tree */
+int objects_checkout(const char *tree_hex, const char *dest_dir);
+
+#endif /* CLURG_OBJECTS_H */
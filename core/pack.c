@@ -0,0 +1,279 @@
+#define _GNU_SOURCE
+#include "pack.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "sha256.h"
+
+static int idx_path_for(const char *pack_path, char *idx_path, size_t size) {
+  size_t len = strlen(pack_path);
+
+  if (len < 5 || strcmp(pack_path + len - 5, ".pack") != 0 || len >= size) return -1;
+  memcpy(idx_path, pack_path, len - 5);
+  strcpy(idx_path + len - 5, ".idx");
+  return 0;
+}
+
+int pack_open(pack_t *pack, const char *pack_path) {
+  char idx_path[PATH_MAX];
+  const pack_idx_header_t *hdr;
+  struct stat st;
+  int fd;
+
+  memset(pack, 0, sizeof(*pack));
+  pack->fd = -1;
+  if (idx_path_for(pack_path, idx_path, sizeof(idx_path)) != 0) return -1;
+  snprintf(pack->path, sizeof(pack->path), "%s", pack_path);
+
+  fd = open(idx_path, O_RDONLY);
+  if (fd < 0) return -1;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(pack_idx_header_t)) {
+    close(fd);
+    return -1;
+  }
+  pack->map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (pack->map == MAP_FAILED) {
+    pack->map = NULL;
+    return -1;
+  }
+  pack->map_size = (size_t)st.st_size;
+
+  hdr = pack->map;
+  if (hdr->magic != PACK_IDX_MAGIC || hdr->version != PACK_VERSION ||
+      sizeof(*hdr) + hdr->count * sizeof(pack_idx_entry_t) != pack->map_size) {
+    fprintf(stderr, "aviso: índice de pack inválido: %s\n", idx_path);
+    pack_close(pack);
+    return -1;
+  }
+  pack->entries = (const pack_idx_entry_t *)((const char *)pack->map + sizeof(*hdr));
+  pack->count = (size_t)hdr->count;
+
+  pack->fd = open(pack_path, O_RDONLY);
+  if (pack->fd < 0) {
+    fprintf(stderr, "aviso: pack sem dados: %s\n", pack_path);
+    pack_close(pack);
+    return -1;
+  }
+  return 0;
+}
+
+void pack_close(pack_t *pack) {
+  if (pack->map) munmap(pack->map, pack->map_size);
+  if (pack->fd >= 0) close(pack->fd);
+  memset(pack, 0, sizeof(*pack));
+  pack->fd = -1;
+}
+
+const pack_idx_entry_t *pack_find(const pack_t *pack, const uint8_t key[PACK_KEY_SIZE]) {
+  size_t lo = 0;
+  size_t hi = pack->count;
+
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    int cmp = memcmp(key, pack->entries[mid].key, PACK_KEY_SIZE);
+    if (cmp == 0) return &pack->entries[mid];
+    if (cmp < 0) {
+      hi = mid;
+    } else {
+      lo = mid + 1;
+    }
+  }
+  return NULL;
+}
+
+int pack_read(const pack_t *pack, const pack_idx_entry_t *entry, unsigned char **data) {
+  unsigned char *buf = malloc(entry->length + 1);
+  uint64_t done = 0;
+
+  if (!buf) return -1;
+  while (done < entry->length) {
+    ssize_t n = pread(pack->fd, buf + done, entry->length - done, (off_t)(entry->offset + done));
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) {
+      fprintf(stderr, "erro ao ler %s: registro truncado\n", pack->path);
+      free(buf);
+      return -1;
+    }
+    done += (uint64_t)n;
+  }
+  buf[entry->length] = '\0';
+  *data = buf;
+  return 0;
+}
+
+int pack_set_load(pack_set_t *set, const char *dir) {
+  struct dirent *entry;
+  DIR *d;
+
+  memset(set, 0, sizeof(*set));
+  d = opendir(dir);
+  if (!d) return 0;
+
+  while ((entry = readdir(d)) != NULL) {
+    size_t len = strlen(entry->d_name);
+    char path[PATH_MAX];
+    pack_t *grown;
+
+    if (len < 5 || strcmp(entry->d_name + len - 5, ".pack") != 0) continue;
+    if (snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name) >= (int)sizeof(path)) continue;
+
+    grown = realloc(set->packs, (set->count + 1) * sizeof(*grown));
+    if (!grown) break;
+    set->packs = grown;
+    if (pack_open(&set->packs[set->count], path) == 0) set->count++;
+  }
+
+  closedir(d);
+  return 0;
+}
+
+void pack_set_free(pack_set_t *set) {
+  size_t i;
+
+  for (i = 0; i < set->count; i++) pack_close(&set->packs[i]);
+  free(set->packs);
+  memset(set, 0, sizeof(*set));
+}
+
+const pack_idx_entry_t *pack_set_find(const pack_set_t *set, const uint8_t key[PACK_KEY_SIZE],
+                                      const pack_t **pack) {
+  size_t i;
+
+  for (i = 0; i < set->count; i++) {
+    const pack_idx_entry_t *entry = pack_find(&set->packs[i], key);
+    if (entry) {
+      if (pack) *pack = &set->packs[i];
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+static int write_all(int fd, const void *data, size_t len) {
+  const unsigned char *p = data;
+  while (len > 0) {
+    ssize_t n = write(fd, p, len);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return -1;
+    }
+    p += n;
+    len -= (size_t)n;
+  }
+  return 0;
+}
+
+int pack_writer_open(pack_writer_t *w, const char *dir) {
+  memset(w, 0, sizeof(*w));
+  snprintf(w->dir, sizeof(w->dir), "%s", dir);
+
+  if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+    fprintf(stderr, "erro ao criar %s: %s\n", dir, strerror(errno));
+    return -1;
+  }
+  snprintf(w->tmp_path, sizeof(w->tmp_path), "%s/tmp_pack_XXXXXX", dir);
+  w->fd = mkstemp(w->tmp_path);
+  if (w->fd < 0) {
+    fprintf(stderr, "erro ao criar pack temporário: %s\n", strerror(errno));
+    return -1;
+  }
+  return 0;
+}
+
+int pack_writer_add(pack_writer_t *w, const uint8_t key[PACK_KEY_SIZE], const void *data,
+                    size_t len) {
+  pack_idx_entry_t *entry;
+
+  if (w->count == w->capacity) {
+    size_t capacity = w->capacity ? w->capacity * 2 : 1024;
+    pack_idx_entry_t *grown = realloc(w->entries, capacity * sizeof(*grown));
+    if (!grown) return -1;
+    w->entries = grown;
+    w->capacity = capacity;
+  }
+
+  if (write_all(w->fd, data, len) != 0) {
+    fprintf(stderr, "erro ao gravar pack: %s\n", strerror(errno));
+    return -1;
+  }
+
+  entry = &w->entries[w->count++];
+  memcpy(entry->key, key, PACK_KEY_SIZE);
+  entry->offset = w->offset;
+  entry->length = len;
+  w->offset += len;
+  return 0;
+}
+
+static int compare_entries(const void *a, const void *b) {
+  return memcmp(((const pack_idx_entry_t *)a)->key, ((const pack_idx_entry_t *)b)->key,
+                PACK_KEY_SIZE);
+}
+
+int pack_writer_finish(pack_writer_t *w, char *pack_path, size_t size) {
+  char idx_path[PATH_MAX];
+  char idx_tmp[PATH_MAX];
+  char hex[SHA256_HEX_SIZE];
+  uint8_t digest[SHA256_DIGEST_SIZE];
+  pack_idx_header_t hdr;
+  int fd;
+  int ok;
+
+  qsort(w->entries, w->count, sizeof(*w->entries), compare_entries);
+
+  /* O nome do pack vem do hash do índice: packs iguais têm o mesmo nome */
+  sha256_buffer(w->entries, w->count * sizeof(*w->entries), digest);
+  sha256_to_hex(digest, hex);
+  if (snprintf(pack_path, size, "%s/pack-%.16s.pack", w->dir, hex) >= (int)size) return -1;
+  if (idx_path_for(pack_path, idx_path, sizeof(idx_path)) != 0 ||
+      snprintf(idx_tmp, sizeof(idx_tmp), "%s.tmp", idx_path) >= (int)sizeof(idx_tmp)) {
+    fprintf(stderr, "caminho muito longo: %s\n", pack_path);
+    return -1;
+  }
+
+  memset(&hdr, 0, sizeof(hdr));
+  hdr.magic = PACK_IDX_MAGIC;
+  hdr.version = PACK_VERSION;
+  hdr.count = w->count;
+
+  ok = fsync(w->fd) == 0;
+  if (close(w->fd) != 0) ok = 0;
+  w->fd = -1;
+
+  fd = open(idx_tmp, O_WRONLY | O_CREAT | O_TRUNC, 0444);
+  if (fd < 0) ok = 0;
+  if (ok) {
+    ok = write_all(fd, &hdr, sizeof(hdr)) == 0 &&
+         write_all(fd, w->entries, w->count * sizeof(*w->entries)) == 0 && fsync(fd) == 0;
+  }
+  if (fd >= 0 && close(fd) != 0) ok = 0;
+
+  if (!ok || chmod(w->tmp_path, 0444) != 0 || rename(w->tmp_path, pack_path) != 0 ||
+      rename(idx_tmp, idx_path) != 0) {
+    fprintf(stderr, "erro ao gravar pack %s: %s\n", pack_path, strerror(errno));
+    unlink(idx_tmp);
+    pack_writer_abort(w);
+    return -1;
+  }
+
+  free(w->entries);
+  w->entries = NULL;
+  return 0;
+}
+
+void pack_writer_abort(pack_writer_t *w) {
+  if (w->fd >= 0) close(w->fd);
+  w->fd = -1;
+  if (w->tmp_path[0]) unlink(w->tmp_path);
+  free(w->entries);
+  w->entries = NULL;
+}
@@ -0,0 +1,86 @@
+#ifndef CLURG_PACK_H
+#define CLURG_PACK_H
+
+#include <limits.h>
+#include <linux/limits.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Pack files: muitos registros pequenos agrupados em um único arquivo.
+ *
+ *   pack-<hash>.pack   registros concatenados, sem cabeçalho
+ *   pack-<hash>.idx    pack_idx_header_t + pack_idx_entry_t[count]
+ *
+ * O índice tem entradas de tamanho fixo ordenadas pela chave (32 bytes), é
+ * lido via mmap e consultado por busca binária; o registro é lido do .pack
+ * pelo offset. Os objetos usam o digest SHA-256 como chave; os commits usam o
+ * id completado com zeros.
+ */
+
+#define PACK_IDX_MAGIC 0x4b415043u /* "CPAK" */
+#define PACK_VERSION 1
+#define PACK_KEY_SIZE 32
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t count;
+} pack_idx_header_t;
+
+typedef struct {
+  uint8_t key[PACK_KEY_SIZE];
+  uint64_t offset;
+  uint64_t length;
+} pack_idx_entry_t;
+
+typedef struct {
+  char path[PATH_MAX]; /* caminho do .pack */
+  int fd;
+  void *map;
+  size_t map_size;
+  const pack_idx_entry_t *entries;
+  size_t count;
+} pack_t;
+
+/* Todos os packs de um diretório */
+typedef struct {
+  pack_t *packs;
+  size_t count;
+} pack_set_t;
+
+typedef struct {
+  char dir[PATH_MAX];
+  char tmp_path[PATH_MAX];
+  int fd;
+  uint64_t offset;
+  pack_idx_entry_t *entries;
+  size_t count;
+  size_t capacity;
+} pack_writer_t;
+
+int pack_open(pack_t *pack, const char *pack_path);
+void pack_close(pack_t *pack);
+const pack_idx_entry_t *pack_find(const pack_t *pack, const uint8_t key[PACK_KEY_SIZE]);
+
+/* Lê o registro inteiro para um buffer alocado (com '\0' extra no fim) */
+int pack_read(const pack_t *pack, const pack_idx_entry_t *entry, unsigned char **data);
+
+/* Diretório ausente resulta num conjunto vazio */
+int pack_set_load(pack_set_t *set, const char *dir);
+void pack_set_free(pack_set_t *set);
+const pack_idx_entry_t *pack_set_find(const pack_set_t *set, const uint8_t key[PACK_KEY_SIZE],
+                                      const pack_t **pack);
+
+/*
+ * Escrita: os registros são anexados a um temporário em `dir`; finish ordena
+ * o índice e renomeia os dois arquivos (o .idx por último, então leitores
+ * nunca veem um pack incompleto).
+ */
+int pack_writer_open(pack_writer_t *w, const char *dir);
+int pack_writer_add(pack_writer_t *w, const uint8_t key[PACK_KEY_SIZE], const void *data,
+                    size_t len);
+int pack_writer_finish(pack_writer_t *w, char *pack_path, size_t size);
+void pack_writer_abort(pack_writer_t *w);
+
+#endif /* CLURG_PACK_H */
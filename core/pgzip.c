@@ -0,0 +1,263 @@
+#define _GNU_SOURCE
+#include "pgzip.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#include "threadpool.h"
+
+#define PGZIP_DICT_SIZE 32768
+#define PGZIP_SLOTS_PER_THREAD 2
+
+typedef struct {
+  pgzip_t *z;
+  z_stream zs;
+  int zs_ready;
+  unsigned char *in;
+  size_t in_len;
+  unsigned char dict[PGZIP_DICT_SIZE];
+  size_t dict_len;
+  unsigned char *out;
+  size_t out_len;
+  size_t out_cap;
+  uLong crc;
+  int last;
+  int status;
+  int busy; /* enviado e ainda não gravado */
+  int done; /* compressão concluída */
+} pgzip_block_t;
+
+struct pgzip {
+  threadpool_t *pool; /* NULL = comprimir em linha */
+  int threads;
+  int level;
+  pgzip_sink_cb sink;
+  void *ctx;
+  pgzip_block_t *blocks;
+  size_t nblocks;
+  size_t fill;   /* bloco recebendo entrada */
+  size_t oldest; /* próximo bloco a ser gravado */
+  unsigned char tail[PGZIP_DICT_SIZE]; /* últimos 32 KiB já enviados */
+  size_t tail_len;
+  uLong crc;
+  uint64_t isize;
+  int error;
+  pthread_mutex_t lock;
+  pthread_cond_t block_done;
+};
+
+static void compress_block(void *arg) {
+  pgzip_block_t *b = arg;
+  pgzip_t *z = b->z;
+  int flush = b->last ? Z_FINISH : Z_SYNC_FLUSH;
+  int zret;
+
+  b->status = 0;
+  b->out_len = 0;
+  b->crc = crc32(crc32(0L, Z_NULL, 0), b->in, (uInt)b->in_len);
+
+  if (!b->zs_ready) {
+    if (deflateInit2(&b->zs, z->level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+      b->status = -1;
+      goto out;
+    }
+    b->zs_ready = 1;
+  } else {
+    deflateReset(&b->zs);
+  }
+  if (b->dict_len > 0) deflateSetDictionary(&b->zs, b->dict, (uInt)b->dict_len);
+
+  b->zs.next_in = b->in;
+  b->zs.avail_in = (uInt)b->in_len;
+  do {
+    if (b->out_cap - b->out_len < 64) {
+      size_t cap = b->out_cap ? b->out_cap * 2 : deflateBound(&b->zs, (uLong)b->in_len) + 64;
+      unsigned char *grown = realloc(b->out, cap);
+      if (!grown) {
+        b->status = -1;
+        goto out;
+      }
+      b->out = grown;
+      b->out_cap = cap;
+    }
+    b->zs.next_out = b->out + b->out_len;
+    b->zs.avail_out = (uInt)(b->out_cap - b->out_len);
+    zret = deflate(&b->zs, flush);
+    b->out_len = b->out_cap - b->zs.avail_out;
+    if (zret == Z_STREAM_ERROR) {
+      b->status = -1;
+      goto out;
+    }
+  } while (b->zs.avail_out == 0 || (b->last && zret != Z_STREAM_END));
+
+out:
+  pthread_mutex_lock(&z->lock);
+  b->done = 1;
+  pthread_cond_broadcast(&z->block_done);
+  pthread_mutex_unlock(&z->lock);
+}
+
+/* Espera o bloco mais antigo e entrega sua saída, preservando a ordem */
+static int drain_oldest(pgzip_t *z) {
+  pgzip_block_t *b = &z->blocks[z->oldest];
+
+  pthread_mutex_lock(&z->lock);
+  while (!b->done) pthread_cond_wait(&z->block_done, &z->lock);
+  pthread_mutex_unlock(&z->lock);
+
+  b->busy = 0;
+  z->oldest = (z->oldest + 1) % z->nblocks;
+
+  if (!z->error && b->status != 0) {
+    fprintf(stderr, "erro: falha na compressão gzip\n");
+    z->error = 1;
+  }
+  if (!z->error) {
+    z->crc = crc32_combine(z->crc, b->crc, (z_off_t)b->in_len);
+    z->isize += b->in_len;
+    if (b->out_len > 0 && z->sink(b->out, b->out_len, z->ctx) != 0) z->error = 1;
+  }
+
+  b->in_len = 0;
+  return z->error ? -1 : 0;
+}
+
+static int submit_block(pgzip_t *z, int last) {
+  pgzip_block_t *b = &z->blocks[z->fill];
+
+  /* Dicionário = fim da entrada anterior; depois o fim deste bloco vira o novo */
+  memcpy(b->dict, z->tail, z->tail_len);
+  b->dict_len = z->tail_len;
+  if (b->in_len >= PGZIP_DICT_SIZE) {
+    memcpy(z->tail, b->in + b->in_len - PGZIP_DICT_SIZE, PGZIP_DICT_SIZE);
+    z->tail_len = PGZIP_DICT_SIZE;
+  } else {
+    size_t keep = PGZIP_DICT_SIZE - b->in_len;
+    if (keep > z->tail_len) keep = z->tail_len;
+    memmove(z->tail, z->tail + z->tail_len - keep, keep);
+    memcpy(z->tail + keep, b->in, b->in_len);
+    z->tail_len = keep + b->in_len;
+  }
+
+  b->last = last;
+  b->busy = 1;
+  b->done = 0;
+  if (!z->pool || threadpool_submit(z->pool, compress_block, b) != 0) {
+    compress_block(b);
+  }
+
+  z->fill = (z->fill + 1) % z->nblocks;
+  if (z->blocks[z->fill].busy) return drain_oldest(z);
+  return 0;
+}
+
+pgzip_t *pgzip_open(int threads, int level, pgzip_sink_cb sink, void *ctx) {
+  /* Cabeçalho gzip mínimo: sem nome, mtime 0, SO = Unix */
+  static const unsigned char header[10] = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 3};
+  pgzip_t *z;
+  size_t i;
+
+  if (threads <= 0) threads = threadpool_cpu_count();
+
+  z = calloc(1, sizeof(*z));
+  if (!z) return NULL;
+  z->threads = threads;
+  z->level = level;
+  z->sink = sink;
+  z->ctx = ctx;
+  z->crc = crc32(0L, Z_NULL, 0);
+  pthread_mutex_init(&z->lock, NULL);
+  pthread_cond_init(&z->block_done, NULL);
+
+  if (threads > 1) {
+    z->pool = threadpool_create(threads);
+    if (!z->pool) z->threads = 1; /* sem threads: seguir em linha */
+  }
+  z->nblocks = z->pool ? (size_t)z->threads * PGZIP_SLOTS_PER_THREAD : 1;
+
+  z->blocks = calloc(z->nblocks, sizeof(*z->blocks));
+  if (!z->blocks) goto fail;
+  for (i = 0; i < z->nblocks; i++) {
+    z->blocks[i].z = z;
+    z->blocks[i].in = malloc(PGZIP_BLOCK_SIZE);
+    if (!z->blocks[i].in) goto fail;
+  }
+
+  if (sink(header, sizeof(header), ctx) != 0) goto fail;
+  return z;
+
+fail:
+  pgzip_abort(z);
+  return NULL;
+}
+
+int pgzip_write(pgzip_t *z, const void *data, size_t len) {
+  const unsigned char *p = data;
+
+  while (len > 0) {
+    pgzip_block_t *b = &z->blocks[z->fill];
+    size_t room = PGZIP_BLOCK_SIZE - b->in_len;
+    size_t n = len < room ? len : room;
+
+    memcpy(b->in + b->in_len, p, n);
+    b->in_len += n;
+    p += n;
+    len -= n;
+
+    if (b->in_len == PGZIP_BLOCK_SIZE && submit_block(z, 0) != 0) return -1;
+    if (z->error) return -1;
+  }
+  return 0;
+}
+
+static void release(pgzip_t *z) {
+  size_t i;
+
+  /* Nenhum worker pode estar usando os blocos daqui em diante */
+  threadpool_destroy(z->pool);
+  for (i = 0; z->blocks && i < z->nblocks; i++) {
+    if (z->blocks[i].zs_ready) deflateEnd(&z->blocks[i].zs);
+    free(z->blocks[i].in);
+    free(z->blocks[i].out);
+  }
+  free(z->blocks);
+  pthread_mutex_destroy(&z->lock);
+  pthread_cond_destroy(&z->block_done);
+  free(z);
+}
+
+int pgzip_finish(pgzip_t *z) {
+  unsigned char trailer[8];
+  int ret = 0;
+  int i;
+
+  /* O último bloco pode estar vazio: ainda assim emite o bloco final do deflate */
+  if (submit_block(z, 1) != 0) ret = -1;
+  while (z->blocks[z->oldest].busy) {
+    if (drain_oldest(z) != 0) ret = -1;
+  }
+
+  if (ret == 0) {
+    for (i = 0; i < 4; i++) {
+      trailer[i] = (unsigned char)(z->crc >> (8 * i));
+      trailer[4 + i] = (unsigned char)(z->isize >> (8 * i)); /* ISIZE = tamanho mod 2^32 */
+    }
+    ret = z->sink(trailer, sizeof(trailer), z->ctx);
+  }
+
+  release(z);
+  return ret;
+}
+
+void pgzip_abort(pgzip_t *z) {
+  if (!z) return;
+  if (z->pool) threadpool_wait(z->pool);
+  release(z);
+}
+
+int pgzip_threads(const pgzip_t *z) {
+  return z->threads;
+}
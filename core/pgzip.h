@@ -0,0 +1,40 @@
+#ifndef CLURG_PGZIP_H
+#define CLURG_PGZIP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Compressor gzip paralelo, no estilo do pigz.
+ *
+ * A entrada é dividida em blocos de PGZIP_BLOCK_SIZE bytes comprimidos de
+ * forma independente num pool de threads. Cada bloco usa os últimos 32 KiB do
+ * bloco anterior como dicionário e termina com um sync flush, então a
+ * concatenação na ordem original forma um único membro gzip comum, legível
+ * por gzip/tar/zlib. O CRC32 final é combinado a partir dos CRCs dos blocos.
+ *
+ * A saída não depende do número de threads: 1 thread comprime em linha e
+ * produz exatamente os mesmos bytes que N threads.
+ */
+
+#define PGZIP_BLOCK_SIZE (256 * 1024)
+
+/* Recebe a saída comprimida, sempre na ordem do fluxo */
+typedef int (*pgzip_sink_cb)(const void *data, size_t len, void *ctx);
+
+typedef struct pgzip pgzip_t;
+
+/* threads <= 0 usa o número de CPUs; level segue o zlib (-1 = padrão) */
+pgzip_t *pgzip_open(int threads, int level, pgzip_sink_cb sink, void *ctx);
+
+int pgzip_write(pgzip_t *z, const void *data, size_t len);
+
+/* Comprime o restante, grava o trailer gzip e libera `z` */
+int pgzip_finish(pgzip_t *z);
+
+/* Descarta o fluxo (após erro) e libera `z` */
+void pgzip_abort(pgzip_t *z);
+
+int pgzip_threads(const pgzip_t *z);
+
+#endif /* CLURG_PGZIP_H */
@@ -1,41 +1,21 @@
+#define _GNU_SOURCE
 #include <limits.h>
 #include <linux/limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-<<<<<<< HEAD
-=======
+#include <sys/stat.h>
 #include <time.h>
->>>>>>> 6f9723b (Adjusts.)
 #include <unistd.h>
 
-#define MAX_PATH PATH_MAX
-
-<<<<<<< HEAD
-int clurg_push(const char *arg1, const char *arg2) {
-  char cwd[PATH_MAX];
-  char commits_dir[PATH_MAX];
-  char head_file[PATH_MAX];
-  char cmd[4096];
-  FILE *fp;
-  char head_id[256];
-  char archive_path[MAX_PATH];
-  char meta_path[MAX_PATH];
-  char project_name[256] = "default";
-  char remote_url[1024];
-  int ret;
+#include "commit.h"
+#include "csnap.h"
+#include "repo_config.h"
+#include "snapshot.h"
+#include "transfer.h"
 
-  // Parse arguments: project_name and remote_url
-  if (!arg1) {
-    fprintf(stderr, "erro: argumentos insuficientes\n");
-    fprintf(stderr, "Uso: clurg push <project_name> <remote_url>\n");
-    fprintf(stderr, "Ou: clurg push <remote_url> (usa 'default' como projeto)\n");
-    return 1;
-  }
+#define MAX_PATH PATH_MAX
 
-  if (arg2) {
-    // arg1 is project_name, arg2 is remote_url
-=======
 static int prepare_snapshot(const char *project_name, char *snapshot_path,
                             size_t size) {
   char timestamp[64];
@@ -47,17 +27,29 @@ static int prepare_snapshot(const char *project_name, char *snapshot_path,
   snprintf(snapshot_path, size, "/tmp/clurg_%s_%s.tar.gz", project_name,
            timestamp);
 
-  char cmd[2048];
-  /* tar --exclude=.clurg -czf <path> . */
-  snprintf(cmd, sizeof(cmd), "tar --exclude=.clurg -czf \"%s\" . 2>/dev/null",
-           snapshot_path);
+  char head_id[256];
+  char tree_hex[SHA256_HEX_SIZE];
+  snapshot_info_t info;
+  int ret;
+
+  if (commit_read_head(head_id, sizeof(head_id)) == 0 &&
+      commit_read_meta_field(head_id, "tree", tree_hex, sizeof(tree_hex)) == 0) {
+    /* Reconstruir o snapshot do HEAD direto do object store */
+    printf("📦 Gerando snapshot do projeto '%s' (commit %s)...\n", project_name, head_id);
+    ret = snapshot_create_from_tree(tree_hex, snapshot_path, &info);
+  } else {
+    /* Sem commit com tree: empacotar a árvore de trabalho */
+    printf("📦 Gerando snapshot do projeto '%s'...\n", project_name);
+    ret = snapshot_create_from_dir(".", snapshot_path, &info);
+  }
 
-  printf("📦 Gerando snapshot do projeto '%s'...\n", project_name);
-  int ret = system(cmd);
   if (ret != 0) {
-    fprintf(stderr, "erro: falha ao criar tar.gz (ret=%d)\n", ret);
+    fprintf(stderr, "erro: falha ao criar tar.gz\n");
     return 1;
   }
+  printf("   %llu arquivos, %llu bytes (gzip, %d threads), sha256 %s\n",
+         (unsigned long long)info.files, (unsigned long long)info.size, info.threads,
+         info.checksum);
   return 0;
 }
 
@@ -79,6 +71,33 @@ static int store_local_copy(const char *snapshot_path) {
   return 0;
 }
 
+/*
+ * Versão com acesso aleatório do snapshot do HEAD, usada por `clurg show`.
+ * Um commit nunca muda, então um .csnap existente é reaproveitado.
+ */
+static void store_seekable_copy(void) {
+  char head_id[256];
+  char tree_hex[SHA256_HEX_SIZE];
+  char csnap_path[MAX_PATH];
+  snapshot_info_t info;
+
+  if (repo_config_get_long("snapshot.seekable", 1) == 0) return;
+  if (commit_read_head(head_id, sizeof(head_id)) != 0 ||
+      commit_read_meta_field(head_id, "tree", tree_hex, sizeof(tree_hex)) != 0 ||
+      csnap_path_for(head_id, csnap_path, sizeof(csnap_path)) != 0 ||
+      access(csnap_path, F_OK) == 0) {
+    return;
+  }
+
+  mkdir(CSNAP_DIR, 0755);
+  if (csnap_create_from_tree(tree_hex, csnap_path, &info) != 0) {
+    fprintf(stderr, "aviso: falha ao gravar %s\n", csnap_path);
+    return;
+  }
+  printf("   %s: %llu arquivos, %llu bytes (acesso por arquivo)\n", csnap_path,
+         (unsigned long long)info.files, (unsigned long long)info.size);
+}
+
 static int send_remote(const char *project_name, const char *snapshot_path,
                        const char *remote_url, const char *notes) {
   char cmd[4096];
@@ -161,82 +180,34 @@ int clurg_push(const char *arg1, const char *arg2, const char *arg3) {
     return 1;
   }
 
-  if (arg2 && (strncmp(arg2, "http", 4) == 0)) {
+  if (arg2 && (strncmp(arg2, "http", 4) == 0 || strncmp(arg2, "file://", 7) == 0)) {
     // arg1: project, arg2: url, arg3: notes
->>>>>>> 6f9723b (Adjusts.)
     strncpy(project_name, arg1, sizeof(project_name) - 1);
     project_name[sizeof(project_name) - 1] = '\0';
     strncpy(remote_url, arg2, sizeof(remote_url) - 1);
     remote_url[sizeof(remote_url) - 1] = '\0';
   } else {
-<<<<<<< HEAD
-    // arg1 is remote_url, use default project
+    // arg1: url, arg2: notes
     strncpy(remote_url, arg1, sizeof(remote_url) - 1);
     remote_url[sizeof(remote_url) - 1] = '\0';
+    notes = arg2;
   }
 
-  if (getcwd(cwd, sizeof(cwd)) == NULL) {
-    perror("getcwd");
-    return 1;
-  }
-
-  /* Caminhos */
-  snprintf(commits_dir, sizeof(commits_dir), "%s/.clurg/commits", cwd);
-  snprintf(head_file, sizeof(head_file), "%s/HEAD", commits_dir);
-
-  /* Verificar se HEAD existe */
-  if (access(head_file, F_OK) != 0) {
-    fprintf(stderr, "erro: nenhum commit encontrado. Faça um commit primeiro.\n");
-    return 1;
-  }
-
-  /* Ler HEAD */
-  fp = fopen(head_file, "r");
-  if (!fp) {
-    perror("fopen HEAD");
-    return 1;
-  }
-  if (!fgets(head_id, sizeof(head_id), fp)) {
-    fprintf(stderr, "erro ao ler HEAD\n");
-    fclose(fp);
-    return 1;
-  }
-  fclose(fp);
-  head_id[strcspn(head_id, "\n")] = 0; /* remover newline */
-
-  /* Caminhos do commit */
-  snprintf(archive_path, sizeof(archive_path), "%s/%s.tar.gz", commits_dir, head_id);
-  snprintf(meta_path, sizeof(meta_path), "%s/%s.meta", commits_dir, head_id);
-
-  /* Verificar se arquivos existem */
-  if (access(archive_path, F_OK) != 0) {
-    fprintf(stderr, "erro: arquivo de commit não encontrado: %s\n", archive_path);
-    return 1;
-  }
-
-  printf("Enviando commit %s do projeto '%s' para %s...\n", head_id, project_name, remote_url);
-
-  /* Usar curl para enviar apenas project e commit_id via POST */
-  /* curl -X POST -d "project=project_name&commit_id=head_id" remote_url */
-  if (snprintf(cmd, sizeof(cmd), "curl -s -X POST -d \"project=%s&commit_id=%s\" \"%s\"",
-               project_name, head_id, remote_url) >= (int)sizeof(cmd)) {
-    fprintf(stderr, "comando muito longo\n");
-    return 1;
-  }
-
-  ret = system(cmd);
-  if (ret != 0) {
-    fprintf(stderr, "erro ao enviar commit (ret=%d). Verifique a URL e conexão.\n", ret);
-    return 1;
-  }
+  /* Remoto em diretório: só os objetos que faltam lá, sem tar.gz */
+  if (transfer_is_local(remote_url)) {
+    transfer_stats_t stats;
 
-  printf("Commit enviado com sucesso!\n");
-  return 0;
-=======
-    // arg1: url, arg2: notes
-    strncpy(remote_url, arg1, sizeof(remote_url) - 1);
-    remote_url[sizeof(remote_url) - 1] = '\0';
-    notes = arg2;
+    printf("🌐 Enviando objetos para %s...\n", remote_url);
+    if (transfer_push(remote_url, &stats) != 0) {
+      fprintf(stderr, "❌ Push para %s falhou\n", remote_url);
+      return 1;
+    }
+    store_seekable_copy();
+    printf("   %llu commits, %llu objetos novos (%llu bytes), %llu já estavam no remoto\n",
+           (unsigned long long)stats.commits, (unsigned long long)stats.objects,
+           (unsigned long long)stats.bytes, (unsigned long long)stats.objects_present);
+    printf("✅ Push executado com sucesso!\n");
+    return 0;
   }
 
   // 1. Prepare Snapshot
@@ -246,6 +217,7 @@ int clurg_push(const char *arg1, const char *arg2, const char *arg3) {
 
   // 2. Store Local Copy
   store_local_copy(snapshot_path);
+  store_seekable_copy();
 
   // 3. Send Remote
   int ret = send_remote(project_name, snapshot_path, remote_url, notes);
@@ -260,5 +232,4 @@ int clurg_push(const char *arg1, const char *arg2, const char *arg3) {
   }
 
   return ret;
->>>>>>> 6f9723b (Adjusts.)
 }
\ No newline at end of file
@@ -1,10 +1,6 @@
 #ifndef PUSH_H
 #define PUSH_H
 
-<<<<<<< HEAD
-int clurg_push(const char *project_name, const char *remote_url);
-=======
 int clurg_push(const char *arg1, const char *arg2, const char *arg3);
->>>>>>> 6f9723b (Adjusts.)
 
 #endif
\ No newline at end of file
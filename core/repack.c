@@ -0,0 +1,43 @@
+#include "repack.h"
+
+#include <stdio.h>
+#include <sys/stat.h>
+
+#include "commit.h"
+#include "commit_index.h"
+#include "objects.h"
+
+int clurg_repack(void) {
+  objects_repack_stats_t stats;
+  uint64_t metas = 0;
+  struct stat st;
+
+  if (stat(".clurg", &st) != 0) {
+    fprintf(stderr, "erro: não é um repositório clurg\n");
+    return 1;
+  }
+
+  printf("📦 Empacotando objetos...\n");
+  if (objects_repack(&stats) != 0) {
+    fprintf(stderr, "erro: falha ao empacotar objetos\n");
+    return 1;
+  }
+  printf("   %llu objetos no pack (%llu bytes), %llu arquivos soltos removidos\n",
+         (unsigned long long)stats.objects, (unsigned long long)stats.pack_bytes,
+         (unsigned long long)stats.loose_removed);
+
+  printf("📦 Empacotando metadados de commits...\n");
+  if (commit_repack(&metas) != 0) {
+    fprintf(stderr, "erro: falha ao empacotar commits\n");
+    return 1;
+  }
+  printf("   %llu .meta movidos para %s\n", (unsigned long long)metas, COMMITS_PACK_DIR);
+
+  /* Reescrever o índice do log sem registros duplicados */
+  if (commit_index_rebuild() != 0) {
+    fprintf(stderr, "aviso: não foi possível recriar %s\n", COMMIT_INDEX_FILE);
+  }
+
+  printf("✅ Repack concluído\n");
+  return 0;
+}
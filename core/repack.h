@@ -0,0 +1,6 @@
+#ifndef CLURG_REPACK_H
+#define CLURG_REPACK_H
+
+int clurg_repack(void);
+
+#endif
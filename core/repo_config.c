@@ -0,0 +1,65 @@
+#include "repo_config.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void env_name(const char *key, char *name, size_t size) {
+  size_t i = 0;
+  int n = snprintf(name, size, "CLURG_");
+
+  for (; key[i] && (size_t)n + i + 1 < size; i++) {
+    char c = key[i];
+    name[n + i] = (c == '.' || c == '-') ? '_' : (char)toupper((unsigned char)c);
+  }
+  name[n + i] = '\0';
+}
+
+int repo_config_get(const char *key, char *value, size_t size) {
+  char name[128];
+  char line[1024];
+  size_t key_len = strlen(key);
+  const char *env;
+  FILE *fp;
+  int ret = -1;
+
+  env_name(key, name, sizeof(name));
+  env = getenv(name);
+  if (env && env[0]) {
+    snprintf(value, size, "%s", env);
+    return 0;
+  }
+
+  fp = fopen(REPO_CONFIG_FILE, "r");
+  if (!fp) return -1;
+
+  while (fgets(line, sizeof(line), fp)) {
+    if (line[0] == '#') continue;
+    if (strncmp(line, key, key_len) == 0 && line[key_len] == ':') {
+      const char *v = line + key_len + 1;
+      while (*v == ' ') v++;
+      snprintf(value, size, "%s", v);
+      value[strcspn(value, "\r\n")] = '\0';
+      ret = 0;
+      break;
+    }
+  }
+
+  fclose(fp);
+  return ret;
+}
+
+long repo_config_get_long(const char *key, long fallback) {
+  char value[64];
+  char *end;
+  long n;
+
+  if (repo_config_get(key, value, sizeof(value)) != 0) return fallback;
+  n = strtol(value, &end, 10);
+  if (end == value || *end != '\0') {
+    fprintf(stderr, "aviso: valor inválido para %s: '%s'\n", key, value);
+    return fallback;
+  }
+  return n;
+}
@@ -0,0 +1,23 @@
+#ifndef CLURG_REPO_CONFIG_H
+#define CLURG_REPO_CONFIG_H
+
+#include <stddef.h>
+
+/*
+ * Configuração do repositório (.clurg/config), no mesmo formato "chave: valor"
+ * dos .meta. Linhas vazias e iniciadas por '#' são ignoradas.
+ *
+ * Toda chave pode ser sobrescrita por variável de ambiente: CLURG_ seguido da
+ * chave em maiúsculas, com '.' e '-' trocados por '_' (compress.threads ->
+ * CLURG_COMPRESS_THREADS).
+ */
+
+#define REPO_CONFIG_FILE ".clurg/config"
+
+/* 0 = encontrado, -1 = ausente */
+int repo_config_get(const char *key, char *value, size_t size);
+
+/* Valor inteiro da chave, ou `fallback` se ausente ou inválido */
+long repo_config_get_long(const char *key, long fallback);
+
+#endif /* CLURG_REPO_CONFIG_H */
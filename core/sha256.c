@@ -0,0 +1,627 @@
+#define _GNU_SOURCE
+#include "sha256.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SHA256_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+#define SHA256_LANES 8                  /* mensagens por passada do kernel AVX2 */
+#define SHA256_SMALL_FILE (64 * 1024)   /* até aqui o arquivo é lido inteiro */
+#define SHA256_FILES_BATCH (8u << 20)   /* bytes em memória por lote de sha256_files */
+
+static const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4,
+    0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe,
+    0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f,
+    0x4a7484aa, 0x5cb0a9dc, 0x76f988da, 0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc,
+    0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116,
+    0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7,
+    0xc67178f2};
+
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void sha256_compress_scalar(uint32_t state[8], const uint8_t *block, size_t nblocks) {
+  while (nblocks--) {
+    uint32_t w[64];
+    uint32_t a, b, c, d, e, f, g, h;
+    int i;
+
+    for (i = 0; i < 16; i++) {
+      w[i] = ((uint32_t)block[i * 4] << 24) | ((uint32_t)block[i * 4 + 1] << 16) |
+             ((uint32_t)block[i * 4 + 2] << 8) | (uint32_t)block[i * 4 + 3];
+    }
+    for (i = 16; i < 64; i++) {
+      uint32_t s0 = ROTR(w[i - 15], 7) ^ ROTR(w[i - 15], 18) ^ (w[i - 15] >> 3);
+      uint32_t s1 = ROTR(w[i - 2], 17) ^ ROTR(w[i - 2], 19) ^ (w[i - 2] >> 10);
+      w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    a = state[0];
+    b = state[1];
+    c = state[2];
+    d = state[3];
+    e = state[4];
+    f = state[5];
+    g = state[6];
+    h = state[7];
+
+    for (i = 0; i < 64; i++) {
+      uint32_t s1 = ROTR(e, 6) ^ ROTR(e, 11) ^ ROTR(e, 25);
+      uint32_t ch = (e & f) ^ (~e & g);
+      uint32_t t1 = h + s1 + ch + K[i] + w[i];
+      uint32_t s0 = ROTR(a, 2) ^ ROTR(a, 13) ^ ROTR(a, 22);
+      uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+      uint32_t t2 = s0 + maj;
+
+      h = g;
+      g = f;
+      f = e;
+      e = d + t1;
+      d = c;
+      c = b;
+      b = a;
+      a = t1 + t2;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+
+    block += 64;
+  }
+}
+
+#ifdef SHA256_X86
+/*
+ * SHA-NI: 4 rodadas por par de sha256rnds2, estado em ABEF/CDGH e a expansão
+ * da mensagem feita por sha256msg1/msg2 (mesma estrutura do exemplo da Intel).
+ */
+__attribute__((target("sha,sse4.1,ssse3"))) static void sha256_compress_shani(
+    uint32_t state[8], const uint8_t *block, size_t nblocks) {
+  const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+  __m128i state0, state1, tmp, msg, abef_save, cdgh_save;
+  __m128i m[4];
+  int g;
+
+  tmp = _mm_loadu_si128((const __m128i *)&state[0]);
+  state1 = _mm_loadu_si128((const __m128i *)&state[4]);
+  tmp = _mm_shuffle_epi32(tmp, 0xB1);          /* CDAB */
+  state1 = _mm_shuffle_epi32(state1, 0x1B);    /* EFGH */
+  state0 = _mm_alignr_epi8(tmp, state1, 8);    /* ABEF */
+  state1 = _mm_blend_epi16(state1, tmp, 0xF0); /* CDGH */
+
+  while (nblocks--) {
+    abef_save = state0;
+    cdgh_save = state1;
+
+    /* 16 grupos de 4 rodadas; m[] é a janela circular de W */
+    for (g = 0; g < 16; g++) {
+      if (g < 4) m[g] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(block + g * 16)), mask);
+      msg = _mm_add_epi32(m[g & 3], _mm_loadu_si128((const __m128i *)&K[g * 4]));
+      state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+      if (g >= 3 && g <= 14) {
+        tmp = _mm_alignr_epi8(m[g & 3], m[(g + 3) & 3], 4);
+        m[(g + 1) & 3] = _mm_add_epi32(m[(g + 1) & 3], tmp);
+        m[(g + 1) & 3] = _mm_sha256msg2_epu32(m[(g + 1) & 3], m[g & 3]);
+      }
+      msg = _mm_shuffle_epi32(msg, 0x0E);
+      state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+      if (g >= 1 && g <= 12) m[(g + 3) & 3] = _mm_sha256msg1_epu32(m[(g + 3) & 3], m[g & 3]);
+    }
+
+    state0 = _mm_add_epi32(state0, abef_save);
+    state1 = _mm_add_epi32(state1, cdgh_save);
+    block += 64;
+  }
+
+  tmp = _mm_shuffle_epi32(state0, 0x1B);       /* FEBA */
+  state1 = _mm_shuffle_epi32(state1, 0xB1);    /* DCHG */
+  state0 = _mm_blend_epi16(tmp, state1, 0xF0); /* DCBA */
+  state1 = _mm_alignr_epi8(state1, tmp, 8);    /* EFGH */
+  _mm_storeu_si128((__m128i *)&state[0], state0);
+  _mm_storeu_si128((__m128i *)&state[4], state1);
+}
+
+#define V_ROTR(x, n) _mm256_or_si256(_mm256_srli_epi32((x), (n)), _mm256_slli_epi32((x), 32 - (n)))
+
+static uint32_t load_u32(const uint8_t *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+/*
+ * AVX2: um bloco de 8 mensagens independentes por chamada, uma em cada lane
+ * de 32 bits. state[palavra][lane]; lanes fora de `active` ficam intactas.
+ */
+__attribute__((target("avx2"))) static void sha256_x8_avx2(uint32_t state[8][SHA256_LANES],
+                                                           const uint8_t *const block[SHA256_LANES],
+                                                           unsigned active) {
+  const __m256i bswap = _mm256_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3, 12,
+                                        13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+  __m256i w[16];
+  __m256i v[8];
+  __m256i old[8];
+  __m256i keep;
+  int i;
+
+  for (i = 0; i < 16; i++) {
+    w[i] = _mm256_shuffle_epi8(
+        _mm256_set_epi32((int)load_u32(block[7] + i * 4), (int)load_u32(block[6] + i * 4),
+                         (int)load_u32(block[5] + i * 4), (int)load_u32(block[4] + i * 4),
+                         (int)load_u32(block[3] + i * 4), (int)load_u32(block[2] + i * 4),
+                         (int)load_u32(block[1] + i * 4), (int)load_u32(block[0] + i * 4)),
+        bswap);
+  }
+  for (i = 0; i < 8; i++) {
+    old[i] = _mm256_loadu_si256((const __m256i *)state[i]);
+    v[i] = old[i];
+  }
+
+  for (i = 0; i < 64; i++) {
+    __m256i a = v[0], b = v[1], c = v[2], e = v[4], f = v[5], g = v[6];
+    __m256i s0, s1, t1, t2, ch, maj;
+
+    if (i >= 16) {
+      __m256i w15 = w[(i - 15) & 15];
+      __m256i w2 = w[(i - 2) & 15];
+      s0 = _mm256_xor_si256(_mm256_xor_si256(V_ROTR(w15, 7), V_ROTR(w15, 18)),
+                            _mm256_srli_epi32(w15, 3));
+      s1 = _mm256_xor_si256(_mm256_xor_si256(V_ROTR(w2, 17), V_ROTR(w2, 19)),
+                            _mm256_srli_epi32(w2, 10));
+      w[i & 15] = _mm256_add_epi32(_mm256_add_epi32(w[i & 15], s0),
+                                   _mm256_add_epi32(w[(i - 7) & 15], s1));
+    }
+
+    s1 = _mm256_xor_si256(_mm256_xor_si256(V_ROTR(e, 6), V_ROTR(e, 11)), V_ROTR(e, 25));
+    ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+    t1 = _mm256_add_epi32(_mm256_add_epi32(v[7], s1),
+                          _mm256_add_epi32(_mm256_add_epi32(ch, _mm256_set1_epi32((int)K[i])),
+                                           w[i & 15]));
+    s0 = _mm256_xor_si256(_mm256_xor_si256(V_ROTR(a, 2), V_ROTR(a, 13)), V_ROTR(a, 22));
+    maj = _mm256_xor_si256(_mm256_and_si256(a, _mm256_xor_si256(b, c)), _mm256_and_si256(b, c));
+    t2 = _mm256_add_epi32(s0, maj);
+
+    v[7] = g;
+    v[6] = f;
+    v[5] = e;
+    v[4] = _mm256_add_epi32(v[3], t1);
+    v[3] = c;
+    v[2] = b;
+    v[1] = a;
+    v[0] = _mm256_add_epi32(t1, t2);
+  }
+
+  keep = _mm256_set_epi32(-(int)((active >> 7) & 1), -(int)((active >> 6) & 1),
+                          -(int)((active >> 5) & 1), -(int)((active >> 4) & 1),
+                          -(int)((active >> 3) & 1), -(int)((active >> 2) & 1),
+                          -(int)((active >> 1) & 1), -(int)(active & 1));
+  for (i = 0; i < 8; i++) {
+    __m256i sum = _mm256_add_epi32(old[i], v[i]);
+    _mm256_storeu_si256((__m256i *)state[i], _mm256_blendv_epi8(old[i], sum, keep));
+  }
+}
+
+static void cpu_features(int *shani, int *avx2) {
+  unsigned int a, b, c, d;
+  unsigned int sse41, ssse3, osxsave;
+
+  *shani = 0;
+  *avx2 = 0;
+  if (!__get_cpuid(1, &a, &b, &c, &d)) return;
+  ssse3 = c & (1u << 9);
+  sse41 = c & (1u << 19);
+  osxsave = c & (1u << 27);
+  if (__get_cpuid_max(0, NULL) < 7) return;
+  __cpuid_count(7, 0, a, b, c, d);
+
+  *shani = (b & (1u << 29)) && sse41 && ssse3;
+  if ((b & (1u << 5)) && osxsave) {
+    unsigned int xcr0_lo, xcr0_hi;
+    /* O SO precisa salvar os registradores YMM (XCR0 bits 1 e 2) */
+    __asm__("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+    (void)xcr0_hi;
+    *avx2 = (xcr0_lo & 6) == 6;
+  }
+}
+#endif /* SHA256_X86 */
+
+typedef void (*compress_fn)(uint32_t state[8], const uint8_t *block, size_t nblocks);
+
+typedef struct {
+  const char *name;
+  compress_fn compress;
+  int lanes; /* > 1: sha256_multi usa o kernel multi-buffer */
+} sha256_impl_t;
+
+static const sha256_impl_t impl_scalar = {"scalar", sha256_compress_scalar, 1};
+#ifdef SHA256_X86
+static const sha256_impl_t impl_shani = {"sha-ni", sha256_compress_shani, 1};
+/* Sem SHA-NI, uma mensagem isolada continua no escalar; o AVX2 rende em lote */
+static const sha256_impl_t impl_avx2 = {"avx2", sha256_compress_scalar, SHA256_LANES};
+#endif
+
+static const sha256_impl_t *impl_current;
+
+/*
+ * Escolhe a implementação uma vez (CPUID). CLURG_SHA256_IMPL=scalar|sha-ni|avx2
+ * força uma delas, se a CPU suportar; útil para testes e comparações.
+ */
+static const sha256_impl_t *sha256_impl(void) {
+  const sha256_impl_t *impl = __atomic_load_n(&impl_current, __ATOMIC_ACQUIRE);
+  const char *force;
+
+  if (impl) return impl;
+
+  impl = &impl_scalar;
+#ifdef SHA256_X86
+  {
+    int shani, avx2;
+    cpu_features(&shani, &avx2);
+    if (shani) {
+      impl = &impl_shani;
+    } else if (avx2) {
+      impl = &impl_avx2;
+    }
+    force = getenv("CLURG_SHA256_IMPL");
+    if (force && *force) {
+      if (strcmp(force, "scalar") == 0) {
+        impl = &impl_scalar;
+      } else if (strcmp(force, "sha-ni") == 0 && shani) {
+        impl = &impl_shani;
+      } else if (strcmp(force, "avx2") == 0 && avx2) {
+        impl = &impl_avx2;
+      } else {
+        fprintf(stderr, "aviso: CLURG_SHA256_IMPL=%s não suportado, usando %s\n", force,
+                impl->name);
+      }
+    }
+  }
+#else
+  force = getenv("CLURG_SHA256_IMPL");
+  if (force && *force && strcmp(force, "scalar") != 0) {
+    fprintf(stderr, "aviso: CLURG_SHA256_IMPL=%s não suportado, usando scalar\n", force);
+  }
+#endif
+
+  /* Corrida benigna: todas as threads chegam ao mesmo resultado */
+  __atomic_store_n(&impl_current, impl, __ATOMIC_RELEASE);
+  return impl;
+}
+
+static void sha256_compress(uint32_t state[8], const uint8_t *block, size_t nblocks) {
+  sha256_impl()->compress(state, block, nblocks);
+}
+
+const char *sha256_impl_name(void) {
+  return sha256_impl()->name;
+}
+
+static const uint32_t H0[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                               0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+static void sha256_digest_from_state(const uint32_t state[8], uint8_t digest[SHA256_DIGEST_SIZE]) {
+  int i;
+  for (i = 0; i < 8; i++) {
+    digest[i * 4] = (uint8_t)(state[i] >> 24);
+    digest[i * 4 + 1] = (uint8_t)(state[i] >> 16);
+    digest[i * 4 + 2] = (uint8_t)(state[i] >> 8);
+    digest[i * 4 + 3] = (uint8_t)state[i];
+  }
+}
+
+void sha256_init(sha256_ctx_t *ctx) {
+  memcpy(ctx->state, H0, sizeof(H0));
+  ctx->total_len = 0;
+  ctx->buffer_len = 0;
+}
+
+void sha256_update(sha256_ctx_t *ctx, const void *data, size_t len) {
+  const uint8_t *p = data;
+
+  ctx->total_len += len;
+
+  /* Completar bloco pendente */
+  if (ctx->buffer_len > 0) {
+    size_t take = 64 - ctx->buffer_len;
+    if (take > len) take = len;
+    memcpy(ctx->buffer + ctx->buffer_len, p, take);
+    ctx->buffer_len += take;
+    p += take;
+    len -= take;
+    if (ctx->buffer_len < 64) return;
+    sha256_compress(ctx->state, ctx->buffer, 1);
+    ctx->buffer_len = 0;
+  }
+
+  /* Blocos inteiros direto do buffer de entrada, sem cópia */
+  if (len >= 64) {
+    size_t nblocks = len / 64;
+    sha256_compress(ctx->state, p, nblocks);
+    p += nblocks * 64;
+    len -= nblocks * 64;
+  }
+
+  if (len > 0) {
+    memcpy(ctx->buffer, p, len);
+    ctx->buffer_len = len;
+  }
+}
+
+void sha256_final(sha256_ctx_t *ctx, uint8_t digest[SHA256_DIGEST_SIZE]) {
+  uint64_t bits = ctx->total_len * 8;
+  uint8_t pad[72];
+  size_t pad_len = (ctx->buffer_len < 56) ? 56 - ctx->buffer_len : 120 - ctx->buffer_len;
+  int i;
+
+  memset(pad, 0, sizeof(pad));
+  pad[0] = 0x80;
+  for (i = 0; i < 8; i++) {
+    pad[pad_len + i] = (uint8_t)(bits >> (56 - 8 * i));
+  }
+  sha256_update(ctx, pad, pad_len + 8);
+  sha256_digest_from_state(ctx->state, digest);
+}
+
+void sha256_buffer(const void *data, size_t len, uint8_t digest[SHA256_DIGEST_SIZE]) {
+  sha256_ctx_t ctx;
+  sha256_init(&ctx);
+  sha256_update(&ctx, data, len);
+  sha256_final(&ctx, digest);
+}
+
+#ifdef SHA256_X86
+/* Até 8 jobs juntos: blocos inteiros lidos do buffer, o final (com padding) de `tail` */
+static void multi_group_avx2(sha256_job_t *const *jobs, size_t n) {
+  static const uint8_t idle[64];
+  uint32_t state[8][SHA256_LANES];
+  uint8_t tail[SHA256_LANES][128];
+  const uint8_t *block[SHA256_LANES];
+  size_t full[SHA256_LANES];
+  size_t nblocks[SHA256_LANES];
+  size_t max_blocks = 0;
+  size_t b, lane;
+  int i;
+
+  for (lane = 0; lane < SHA256_LANES; lane++) {
+    for (i = 0; i < 8; i++) state[i][lane] = H0[i];
+    full[lane] = 0;
+    nblocks[lane] = 0;
+    if (lane >= n) continue;
+
+    {
+      size_t len = jobs[lane]->len;
+      size_t rem = len % 64;
+      size_t tail_blocks = (rem < 56) ? 1 : 2;
+      uint64_t bits = (uint64_t)len * 8;
+
+      full[lane] = len / 64;
+      memset(tail[lane], 0, sizeof(tail[lane]));
+      if (rem) memcpy(tail[lane], (const uint8_t *)jobs[lane]->data + full[lane] * 64, rem);
+      tail[lane][rem] = 0x80;
+      for (i = 0; i < 8; i++) {
+        tail[lane][tail_blocks * 64 - 8 + i] = (uint8_t)(bits >> (56 - 8 * i));
+      }
+      nblocks[lane] = full[lane] + tail_blocks;
+      if (nblocks[lane] > max_blocks) max_blocks = nblocks[lane];
+    }
+  }
+
+  for (b = 0; b < max_blocks; b++) {
+    unsigned active = 0;
+    for (lane = 0; lane < SHA256_LANES; lane++) {
+      if (b < full[lane]) {
+        block[lane] = (const uint8_t *)jobs[lane]->data + b * 64;
+      } else if (b < nblocks[lane]) {
+        block[lane] = tail[lane] + (b - full[lane]) * 64;
+      } else {
+        block[lane] = idle;
+        continue;
+      }
+      active |= 1u << lane;
+    }
+    sha256_x8_avx2(state, block, active);
+  }
+
+  for (lane = 0; lane < n; lane++) {
+    uint32_t words[8];
+    for (i = 0; i < 8; i++) words[i] = state[i][lane];
+    sha256_digest_from_state(words, jobs[lane]->digest);
+  }
+}
+
+static int compare_job_len(const void *a, const void *b) {
+  const sha256_job_t *ja = *(sha256_job_t *const *)a;
+  const sha256_job_t *jb = *(sha256_job_t *const *)b;
+  return (ja->len > jb->len) - (ja->len < jb->len);
+}
+#endif /* SHA256_X86 */
+
+void sha256_multi(sha256_job_t *jobs, size_t count) {
+  const sha256_impl_t *impl = sha256_impl();
+  size_t i;
+
+#ifdef SHA256_X86
+  if (impl->lanes > 1 && count > 1) {
+    /* Ordenar por tamanho deixa menos lanes ociosas em cada grupo */
+    sha256_job_t **order = malloc(count * sizeof(*order));
+    if (order) {
+      for (i = 0; i < count; i++) order[i] = &jobs[i];
+      qsort(order, count, sizeof(*order), compare_job_len);
+      for (i = 0; i < count; i += SHA256_LANES) {
+        size_t n = count - i < SHA256_LANES ? count - i : SHA256_LANES;
+        multi_group_avx2(order + i, n);
+      }
+      free(order);
+      return;
+    }
+  }
+#endif
+
+  (void)impl;
+  for (i = 0; i < count; i++) sha256_buffer(jobs[i].data, jobs[i].len, jobs[i].digest);
+}
+
+static int hash_fd(int fd, uint8_t digest[SHA256_DIGEST_SIZE]) {
+  unsigned char buffer[131072];
+  sha256_ctx_t ctx;
+  ssize_t n;
+
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+  sha256_init(&ctx);
+  while ((n = read(fd, buffer, sizeof(buffer))) != 0) {
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return -1;
+    }
+    sha256_update(&ctx, buffer, (size_t)n);
+  }
+  sha256_final(&ctx, digest);
+  return 0;
+}
+
+int sha256_file(const char *path, uint8_t digest[SHA256_DIGEST_SIZE]) {
+  int fd = open(path, O_RDONLY);
+  int ret;
+
+  if (fd < 0) return -1;
+  ret = hash_fd(fd, digest);
+  close(fd);
+  return ret;
+}
+
+/* Lê o arquivo inteiro em buf (capacidade cap); 1 = não coube, o chamador faz stream */
+static int read_small(int fd, uint8_t *buf, size_t cap, size_t *len) {
+  size_t got = 0;
+
+  while (got < cap) {
+    ssize_t n = read(fd, buf + got, cap - got);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return -1;
+    }
+    if (n == 0) break;
+    got += (size_t)n;
+  }
+  *len = got;
+  return got == cap ? 1 : 0;
+}
+
+int sha256_files(const char *const *paths, size_t count,
+                 uint8_t (*digests)[SHA256_DIGEST_SIZE], int *results) {
+  uint8_t *arena = NULL;
+  size_t arena_used = 0;
+  sha256_job_t *jobs = NULL;
+  size_t *job_index = NULL;
+  size_t job_count = 0;
+  size_t i, j;
+  int ret = 0;
+
+  if (count > 1) {
+    arena = malloc(SHA256_FILES_BATCH);
+    jobs = malloc(count * sizeof(*jobs));
+    job_index = malloc(count * sizeof(*job_index));
+  }
+
+  for (i = 0; i < count; i++) {
+    struct stat st;
+    int fd = open(paths[i], O_RDONLY);
+
+    results[i] = -1;
+    if (fd < 0) continue;
+
+    if (arena && jobs && job_index && fstat(fd, &st) == 0 && S_ISREG(st.st_mode) &&
+        st.st_size < SHA256_SMALL_FILE) {
+      size_t len;
+      int r;
+
+      if (arena_used + SHA256_SMALL_FILE > SHA256_FILES_BATCH) {
+        sha256_multi(jobs, job_count);
+        for (j = 0; j < job_count; j++) {
+          memcpy(digests[job_index[j]], jobs[j].digest, SHA256_DIGEST_SIZE);
+          results[job_index[j]] = 0;
+        }
+        job_count = 0;
+        arena_used = 0;
+      }
+
+      /* Capacidade de st_size + 1 detecta arquivo que cresceu desde o fstat */
+      r = read_small(fd, arena + arena_used, (size_t)st.st_size + 1, &len);
+      if (r == 0) {
+        jobs[job_count].data = arena + arena_used;
+        jobs[job_count].len = len;
+        job_index[job_count++] = i;
+        arena_used += len;
+        close(fd);
+        continue;
+      }
+      if (r < 0 || lseek(fd, 0, SEEK_SET) != 0) {
+        close(fd);
+        continue;
+      }
+    }
+
+    if (hash_fd(fd, digests[i]) == 0) results[i] = 0;
+    close(fd);
+  }
+
+  sha256_multi(jobs, job_count);
+  for (j = 0; j < job_count; j++) {
+    memcpy(digests[job_index[j]], jobs[j].digest, SHA256_DIGEST_SIZE);
+    results[job_index[j]] = 0;
+  }
+
+  for (i = 0; i < count; i++) {
+    if (results[i] != 0) ret = -1;
+  }
+  free(arena);
+  free(jobs);
+  free(job_index);
+  return ret;
+}
+
+void sha256_to_hex(const uint8_t digest[SHA256_DIGEST_SIZE], char hex[SHA256_HEX_SIZE]) {
+  static const char digits[] = "0123456789abcdef";
+  int i;
+  for (i = 0; i < SHA256_DIGEST_SIZE; i++) {
+    hex[i * 2] = digits[digest[i] >> 4];
+    hex[i * 2 + 1] = digits[digest[i] & 0x0f];
+  }
+  hex[64] = '\0';
+}
+
+static int hex_value(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+int sha256_from_hex(const char *hex, uint8_t digest[SHA256_DIGEST_SIZE]) {
+  int i;
+  for (i = 0; i < SHA256_DIGEST_SIZE; i++) {
+    int hi = hex_value(hex[i * 2]);
+    int lo = (hi < 0) ? -1 : hex_value(hex[i * 2 + 1]);
+    if (hi < 0 || lo < 0) return -1;
+    digest[i] = (uint8_t)((hi << 4) | lo);
+  }
+  return 0;
+}
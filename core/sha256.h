@@ -0,0 +1,55 @@
+#ifndef CLURG_SHA256_H
+#define CLURG_SHA256_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SHA256_DIGEST_SIZE 32
+#define SHA256_HEX_SIZE 65 /* 64 dígitos + '\0' */
+
+typedef struct {
+  uint32_t state[8];
+  uint64_t total_len;
+  uint8_t buffer[64];
+  size_t buffer_len;
+} sha256_ctx_t;
+
+void sha256_init(sha256_ctx_t *ctx);
+void sha256_update(sha256_ctx_t *ctx, const void *data, size_t len);
+void sha256_final(sha256_ctx_t *ctx, uint8_t digest[SHA256_DIGEST_SIZE]);
+
+/* Atalho para buffers em memória */
+void sha256_buffer(const void *data, size_t len, uint8_t digest[SHA256_DIGEST_SIZE]);
+
+/*
+ * Implementação escolhida em tempo de execução: SHA-NI quando a CPU tem as
+ * instruções, senão AVX2 (8 mensagens por vez em sha256_multi) ou escalar.
+ * Retorna "sha-ni", "avx2" ou "scalar".
+ */
+const char *sha256_impl_name(void);
+
+/* Hash de vários buffers independentes de uma vez (multi-buffer) */
+typedef struct {
+  const void *data;
+  size_t len;
+  uint8_t digest[SHA256_DIGEST_SIZE]; /* saída */
+} sha256_job_t;
+
+void sha256_multi(sha256_job_t *jobs, size_t count);
+
+/* Hash do conteúdo de um arquivo (leitura em stream); -1 em erro de leitura */
+int sha256_file(const char *path, uint8_t digest[SHA256_DIGEST_SIZE]);
+
+/*
+ * Hash de vários arquivos: os pequenos são lidos inteiros e vão juntos para o
+ * sha256_multi, os grandes são lidos em stream. results[i] recebe 0 ou -1
+ * (arquivo ilegível); retorna -1 se algum falhou.
+ */
+int sha256_files(const char *const *paths, size_t count,
+                 uint8_t (*digests)[SHA256_DIGEST_SIZE], int *results);
+
+/* Conversão digest <-> hexadecimal (minúsculo, como sha256sum) */
+void sha256_to_hex(const uint8_t digest[SHA256_DIGEST_SIZE], char hex[SHA256_HEX_SIZE]);
+int sha256_from_hex(const char *hex, uint8_t digest[SHA256_DIGEST_SIZE]);
+
+#endif /* CLURG_SHA256_H */
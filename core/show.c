@@ -0,0 +1,123 @@
+#define _GNU_SOURCE
+#include "show.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "commit.h"
+#include "csnap.h"
+#include "objects.h"
+
+typedef struct {
+  const char *name;
+  size_t name_len;
+  objects_tree_entry_t found;
+  char found_name[NAME_MAX + 1];
+  int has_found;
+} show_lookup_t;
+
+static int match_entry(const objects_tree_entry_t *entry, void *ctx) {
+  show_lookup_t *lookup = ctx;
+
+  if (strlen(entry->name) != lookup->name_len ||
+      memcmp(entry->name, lookup->name, lookup->name_len) != 0) {
+    return 0;
+  }
+  lookup->found = *entry;
+  snprintf(lookup->found_name, sizeof(lookup->found_name), "%s", entry->name);
+  lookup->found.name = lookup->found_name;
+  lookup->has_found = 1;
+  return 1; /* encerra a iteração */
+}
+
+static int print_entry(const objects_tree_entry_t *entry, void *ctx) {
+  (void)ctx;
+  printf("%s%s\n", entry->name, entry->mode == OBJ_MODE_DIR ? "/" : "");
+  return 0;
+}
+
+/* Desce pela tree componente a componente, lendo só as trees do caminho */
+static int show_from_tree(const char *tree_hex, const char *path) {
+  char current[SHA256_HEX_SIZE];
+  unsigned int mode = OBJ_MODE_DIR;
+  const char *p = path;
+
+  snprintf(current, sizeof(current), "%s", tree_hex);
+  while (*p) {
+    show_lookup_t lookup;
+    const char *slash = strchr(p, '/');
+    size_t len = slash ? (size_t)(slash - p) : strlen(p);
+
+    if (mode != OBJ_MODE_DIR) break;
+    memset(&lookup, 0, sizeof(lookup));
+    lookup.name = p;
+    lookup.name_len = len;
+    if (objects_tree_foreach(current, match_entry, &lookup) < 0) return 1;
+    if (!lookup.has_found) break;
+
+    snprintf(current, sizeof(current), "%s", lookup.found.hex);
+    mode = lookup.found.mode;
+    p += len;
+    while (*p == '/') p++;
+    if (!*p) {
+      if (mode == OBJ_MODE_DIR) return objects_tree_foreach(current, print_entry, NULL) != 0;
+      fflush(stdout);
+      return objects_read_to_fd(current, STDOUT_FILENO) != 0;
+    }
+  }
+
+  if (!*path) return objects_tree_foreach(current, print_entry, NULL) != 0;
+  fprintf(stderr, "erro: caminho '%s' não existe no commit\n", path);
+  return 1;
+}
+
+int clurg_show(int argc, char *argv[]) {
+  char id[256];
+  char tree_hex[SHA256_HEX_SIZE];
+  char snap_path[PATH_MAX];
+  const char *path;
+  csnap_t snap;
+
+  if (argc < 2) {
+    fprintf(stderr, "uso: clurg show <commit|HEAD> <caminho>\n");
+    return 1;
+  }
+
+  if (strcmp(argv[0], "HEAD") == 0) {
+    if (commit_read_head(id, sizeof(id)) != 0) {
+      fprintf(stderr, "erro: repositório sem commits\n");
+      return 1;
+    }
+  } else {
+    snprintf(id, sizeof(id), "%s", argv[0]);
+  }
+
+  /* Caminhos relativos à raiz do repositório, com ou sem "./" e "/" */
+  path = argv[1];
+  while (strncmp(path, "./", 2) == 0) path += 2;
+  while (*path == '/') path++;
+
+  if (csnap_path_for(id, snap_path, sizeof(snap_path)) == 0 && access(snap_path, F_OK) == 0 &&
+      csnap_open(&snap, snap_path) == 0) {
+    const csnap_entry_t *entry = csnap_find(&snap, path);
+    int ret = 1;
+
+    if (entry) {
+      fflush(stdout);
+      ret = csnap_extract_to_fd(&snap, entry, STDOUT_FILENO) != 0;
+      csnap_close(&snap);
+      return ret;
+    }
+    /* Diretórios não têm entrada no .csnap: cair para a tree */
+    csnap_close(&snap);
+  }
+
+  if (commit_read_meta_field(id, "tree", tree_hex, sizeof(tree_hex)) != 0) {
+    fprintf(stderr, "erro: commit '%s' não encontrado ou sem tree\n", id);
+    return 1;
+  }
+  return show_from_tree(tree_hex, path);
+}
@@ -0,0 +1,13 @@
+#ifndef CLURG_SHOW_H
+#define CLURG_SHOW_H
+
+/*
+ * clurg show <commit|HEAD> <caminho>
+ *
+ * Escreve na saída padrão o conteúdo de um arquivo do commit (ou a listagem,
+ * se o caminho for um diretório). Usa o .csnap do commit quando existe e, fora
+ * dele, a tree do object store; nos dois casos só o necessário é lido.
+ */
+int clurg_show(int argc, char *argv[]);
+
+#endif
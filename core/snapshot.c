@@ -0,0 +1,394 @@
+#define _GNU_SOURCE
+#include "snapshot.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "../ci/ignore.h"
+#include "objects.h"
+#include "pgzip.h"
+#include "repo_config.h"
+
+#define SNAP_BUFFER_SIZE 65536
+#define TAR_BLOCK 512
+#define TAR_RECORD 10240
+#define TAR_MAX_OCTAL_SIZE 077777777777ULL
+
+typedef struct {
+  int fd;
+  pgzip_t *gz;
+  sha256_ctx_t sha;
+  uint64_t compressed; /* bytes já gravados no .tar.gz */
+  uint64_t tar_bytes;  /* bytes do tar ainda não comprimido */
+  uint64_t files;
+  time_t mtime;
+  const ignore_t *ignore; /* só em snapshot_create_from_dir */
+} snap_writer_t;
+
+static int write_all(int fd, const void *data, size_t len) {
+  const unsigned char *p = data;
+  while (len > 0) {
+    ssize_t n = write(fd, p, len);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return -1;
+    }
+    p += n;
+    len -= (size_t)n;
+  }
+  return 0;
+}
+
+/* Recebe a saída do pgzip: atualiza hash e tamanho e grava no arquivo */
+static int writer_emit(const void *data, size_t len, void *ctx) {
+  snap_writer_t *w = ctx;
+
+  sha256_update(&w->sha, data, len);
+  w->compressed += len;
+  if (write_all(w->fd, data, len) != 0) {
+    fprintf(stderr, "erro ao gravar snapshot: %s\n", strerror(errno));
+    return -1;
+  }
+  return 0;
+}
+
+static int writer_write(snap_writer_t *w, const void *data, size_t len) {
+  w->tar_bytes += len;
+  return pgzip_write(w->gz, data, len);
+}
+
+static int sink_to_writer(const void *data, size_t len, void *ctx) {
+  return writer_write(ctx, data, len);
+}
+
+static int writer_pad(snap_writer_t *w) {
+  static const char zeros[TAR_BLOCK];
+  size_t rest = (size_t)(w->tar_bytes % TAR_BLOCK);
+  if (rest == 0) return 0;
+  return writer_write(w, zeros, TAR_BLOCK - rest);
+}
+
+static void octal_field(char *field, size_t width, uint64_t value) {
+  snprintf(field, width, "%0*llo", (int)width - 1, (unsigned long long)value);
+}
+
+/* Registro pax "<len> chave=valor\n", onde <len> inclui os próprios dígitos */
+static size_t pax_record(char *buf, size_t size, const char *key, const char *value) {
+  size_t body = strlen(key) + strlen(value) + 3; /* ' ' '=' '\n' */
+  size_t digits = 1;
+  size_t total;
+
+  while (1) {
+    size_t pow = 1;
+    size_t i;
+    for (i = 0; i < digits; i++) pow *= 10;
+    total = body + digits;
+    if (total < pow) break;
+    digits++;
+  }
+
+  if (total >= size) return 0;
+  snprintf(buf, size, "%zu %s=%s\n", total, key, value);
+  return total;
+}
+
+static int write_raw_header(snap_writer_t *w, const char *name, char type, unsigned int mode,
+                            uint64_t size, const char *linkname) {
+  unsigned char block[TAR_BLOCK];
+  unsigned int sum = 0;
+  int i;
+
+  memset(block, 0, sizeof(block));
+  strncpy((char *)block, name, 100);
+  octal_field((char *)block + 100, 8, mode & 07777);
+  octal_field((char *)block + 108, 8, 0);
+  octal_field((char *)block + 116, 8, 0);
+  octal_field((char *)block + 124, 12, size > TAR_MAX_OCTAL_SIZE ? 0 : size);
+  octal_field((char *)block + 136, 12, (uint64_t)w->mtime);
+  memset(block + 148, ' ', 8);
+  block[156] = (unsigned char)type;
+  if (linkname) strncpy((char *)block + 157, linkname, 100);
+  memcpy(block + 257, "ustar", 6);
+  memcpy(block + 263, "00", 2);
+
+  for (i = 0; i < TAR_BLOCK; i++) sum += block[i];
+  snprintf((char *)block + 148, 8, "%06o", sum);
+  block[155] = ' ';
+
+  return writer_write(w, block, sizeof(block));
+}
+
+static int write_header(snap_writer_t *w, const char *name, char type, unsigned int mode,
+                        uint64_t size, const char *linkname) {
+  char pax[3 * PATH_MAX];
+  size_t pax_len = 0;
+
+  /* Nomes longos e arquivos > 8 GiB vão num cabeçalho pax antes da entrada */
+  if (strlen(name) > 100) {
+    pax_len += pax_record(pax + pax_len, sizeof(pax) - pax_len, "path", name);
+  }
+  if (linkname && strlen(linkname) > 100) {
+    pax_len += pax_record(pax + pax_len, sizeof(pax) - pax_len, "linkpath", linkname);
+  }
+  if (size > TAR_MAX_OCTAL_SIZE) {
+    char value[32];
+    snprintf(value, sizeof(value), "%llu", (unsigned long long)size);
+    pax_len += pax_record(pax + pax_len, sizeof(pax) - pax_len, "size", value);
+  }
+
+  if (pax_len > 0) {
+    if (write_raw_header(w, "././@PaxHeader", 'x', 0644, pax_len, NULL) != 0 ||
+        writer_write(w, pax, pax_len) != 0 || writer_pad(w) != 0) {
+      return -1;
+    }
+  }
+
+  return write_raw_header(w, name, type, mode, size, linkname);
+}
+
+static int writer_open(snap_writer_t *w, const char *out_path) {
+  /* compress.threads: 0 (padrão) = uma thread por CPU */
+  int threads = (int)repo_config_get_long("compress.threads", 0);
+  int level = (int)repo_config_get_long("compress.level", Z_DEFAULT_COMPRESSION);
+
+  memset(w, 0, sizeof(*w));
+  w->fd = open(out_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (w->fd < 0) {
+    fprintf(stderr, "erro ao criar %s: %s\n", out_path, strerror(errno));
+    return -1;
+  }
+  sha256_init(&w->sha);
+  w->mtime = time(NULL);
+
+  w->gz = pgzip_open(threads, level, writer_emit, w);
+  if (!w->gz) {
+    close(w->fd);
+    return -1;
+  }
+  return 0;
+}
+
+static int writer_close(snap_writer_t *w, int ok, snapshot_info_t *info) {
+  static const char zeros[TAR_BLOCK * 2];
+  uint8_t digest[SHA256_DIGEST_SIZE];
+  int threads = pgzip_threads(w->gz);
+  int ret = ok;
+
+  if (ret == 0) {
+    /* Dois blocos zerados e preenchimento até o tamanho de registro do tar */
+    ret = writer_write(w, zeros, sizeof(zeros));
+    while (ret == 0 && w->tar_bytes % TAR_RECORD != 0) {
+      size_t rest = TAR_RECORD - (size_t)(w->tar_bytes % TAR_RECORD);
+      ret = writer_write(w, zeros, rest > sizeof(zeros) ? sizeof(zeros) : rest);
+    }
+  }
+
+  if (ret == 0) {
+    ret = pgzip_finish(w->gz);
+  } else {
+    pgzip_abort(w->gz);
+  }
+  if (close(w->fd) != 0) ret = -1;
+
+  if (ret == 0 && info) {
+    sha256_final(&w->sha, digest);
+    sha256_to_hex(digest, info->checksum);
+    info->size = w->compressed;
+    info->files = w->files;
+    info->threads = threads;
+  }
+  return ret;
+}
+
+static int add_file(snap_writer_t *w, const char *path, const char *name, const struct stat *st) {
+  unsigned char buffer[SNAP_BUFFER_SIZE];
+  uint64_t remaining = (uint64_t)st->st_size;
+  int fd;
+
+  fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    fprintf(stderr, "erro ao abrir %s: %s\n", path, strerror(errno));
+    return -1;
+  }
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+  if (write_header(w, name, '0', st->st_mode, remaining, NULL) != 0) {
+    close(fd);
+    return -1;
+  }
+
+  while (remaining > 0) {
+    size_t want = remaining > sizeof(buffer) ? sizeof(buffer) : (size_t)remaining;
+    ssize_t n = read(fd, buffer, want);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) {
+      /* Arquivo encolheu durante a leitura: completar com zeros */
+      fprintf(stderr, "aviso: %s mudou durante o snapshot\n", path);
+      memset(buffer, 0, want);
+      n = (ssize_t)want;
+    }
+    if (writer_write(w, buffer, (size_t)n) != 0) {
+      close(fd);
+      return -1;
+    }
+    remaining -= (uint64_t)n;
+  }
+
+  close(fd);
+  w->files++;
+  return writer_pad(w);
+}
+
+static int add_dir(snap_writer_t *w, const char *base, const char *rel) {
+  char dir_path[PATH_MAX];
+  struct dirent *entry;
+  DIR *d;
+  int ret = 0;
+
+  snprintf(dir_path, sizeof(dir_path), "%s%s%s", base, rel[0] ? "/" : "", rel);
+  d = opendir(dir_path);
+  if (!d) {
+    fprintf(stderr, "erro ao abrir diretório %s: %s\n", dir_path, strerror(errno));
+    return -1;
+  }
+
+  while (ret == 0 && (entry = readdir(d)) != NULL) {
+    char path[PATH_MAX];
+    char name[PATH_MAX];
+    struct stat st;
+
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0 ||
+        strcmp(entry->d_name, ".clurg") == 0) {
+      continue;
+    }
+
+    if (snprintf(name, sizeof(name), "%s%s%s", rel, rel[0] ? "/" : "", entry->d_name) >=
+            (int)sizeof(name) ||
+        snprintf(path, sizeof(path), "%s/%s", base, name) >= (int)sizeof(path)) {
+      fprintf(stderr, "caminho muito longo: %s/%s\n", dir_path, entry->d_name);
+      ret = -1;
+      break;
+    }
+    if (lstat(path, &st) != 0) continue;
+    if (ignore_match(w->ignore, name, S_ISDIR(st.st_mode))) continue;
+
+    if (S_ISDIR(st.st_mode)) {
+      char dir_name[PATH_MAX + 1];
+      snprintf(dir_name, sizeof(dir_name), "%s/", name);
+      w->mtime = st.st_mtime;
+      ret = write_header(w, dir_name, '5', st.st_mode, 0, NULL);
+      if (ret == 0) ret = add_dir(w, base, name);
+    } else if (S_ISREG(st.st_mode)) {
+      w->mtime = st.st_mtime;
+      ret = add_file(w, path, name, &st);
+    } else if (S_ISLNK(st.st_mode)) {
+      char target[PATH_MAX];
+      ssize_t n = readlink(path, target, sizeof(target) - 1);
+      if (n < 0) continue;
+      target[n] = '\0';
+      w->mtime = st.st_mtime;
+      ret = write_header(w, name, '2', 0777, 0, target);
+    }
+  }
+
+  closedir(d);
+  return ret;
+}
+
+int snapshot_create_from_dir(const char *src_dir, const char *out_path, snapshot_info_t *info) {
+  snap_writer_t *w = malloc(sizeof(*w));
+  ignore_t *ignore;
+  int ret;
+
+  if (!w) return -1;
+  if (writer_open(w, out_path) != 0) {
+    free(w);
+    return -1;
+  }
+
+  ignore = ignore_load(src_dir);
+  w->ignore = ignore;
+  ret = ignore ? add_dir(w, src_dir, "") : -1;
+  ret = writer_close(w, ret, info);
+  ignore_free(ignore);
+  free(w);
+  if (ret != 0) unlink(out_path);
+  return ret;
+}
+
+typedef struct {
+  snap_writer_t *w;
+  const char *prefix;
+} tree_walk_t;
+
+static int add_tree_entry(const objects_tree_entry_t *entry, void *ctx) {
+  tree_walk_t *walk = ctx;
+  snap_writer_t *w = walk->w;
+  char name[PATH_MAX];
+
+  if (snprintf(name, sizeof(name), "%s%s", walk->prefix, entry->name) >= (int)sizeof(name) - 1) {
+    fprintf(stderr, "caminho muito longo: %s%s\n", walk->prefix, entry->name);
+    return -1;
+  }
+
+  if (entry->mode == OBJ_MODE_DIR) {
+    tree_walk_t sub = {w, name};
+    strcat(name, "/");
+    if (write_header(w, name, '5', 0755, 0, NULL) != 0) return -1;
+    return objects_tree_foreach(entry->hex, add_tree_entry, &sub);
+  }
+
+  if (entry->mode == OBJ_MODE_LINK) {
+    unsigned char *target;
+    size_t len;
+    obj_type_t type;
+    int ret;
+
+    if (objects_read(entry->hex, &type, &target, &len) != 0) return -1;
+    ret = write_header(w, name, '2', 0777, 0, (const char *)target);
+    free(target);
+    return ret;
+  }
+
+  {
+    obj_type_t type;
+    uint64_t size;
+    unsigned int mode = (entry->mode == OBJ_MODE_EXEC) ? 0755 : 0644;
+
+    if (objects_read_header(entry->hex, &type, &size) != 0) return -1;
+    if (write_header(w, name, '0', mode, size, NULL) != 0) return -1;
+    if (objects_read_stream(entry->hex, sink_to_writer, w) != 0) return -1;
+    w->files++;
+    return writer_pad(w);
+  }
+}
+
+int snapshot_create_from_tree(const char *tree_hex, const char *out_path, snapshot_info_t *info) {
+  snap_writer_t *w = malloc(sizeof(*w));
+  tree_walk_t walk;
+  int ret;
+
+  if (!w) return -1;
+  if (writer_open(w, out_path) != 0) {
+    free(w);
+    return -1;
+  }
+
+  walk.w = w;
+  walk.prefix = "";
+  ret = objects_tree_foreach(tree_hex, add_tree_entry, &walk);
+  ret = writer_close(w, ret, info);
+  free(w);
+  if (ret != 0) unlink(out_path);
+  return ret;
+}
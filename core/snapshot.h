@@ -0,0 +1,33 @@
+#ifndef CLURG_SNAPSHOT_H
+#define CLURG_SNAPSHOT_H
+
+#include <stdint.h>
+
+#include "sha256.h"
+
+/*
+ * Escritor de snapshots .tar.gz em processo.
+ *
+ * A árvore é percorrida uma única vez: cada arquivo é lido, empacotado no
+ * formato tar (ustar + pax para nomes longos) e enviado direto ao deflate.
+ * O SHA-256 e o tamanho do arquivo final são calculados sobre os bytes
+ * comprimidos no momento em que são escritos, sem reler o snapshot.
+ *
+ * A compressão usa o pgzip (gzip em blocos paralelos); threads e nível vêm de
+ * compress.threads / compress.level em .clurg/config.
+ */
+
+typedef struct {
+  uint64_t size;                     /* bytes do .tar.gz gerado */
+  uint64_t files;                    /* arquivos empacotados */
+  char checksum[SHA256_HEX_SIZE];    /* SHA-256 do .tar.gz gerado */
+  int threads;                       /* threads usadas na compressão */
+} snapshot_info_t;
+
+/* Empacota um diretório de trabalho (ignorando .clurg) */
+int snapshot_create_from_dir(const char *src_dir, const char *out_path, snapshot_info_t *info);
+
+/* Empacota uma tree do object store */
+int snapshot_create_from_tree(const char *tree_hex, const char *out_path, snapshot_info_t *info);
+
+#endif /* CLURG_SNAPSHOT_H */
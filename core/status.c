@@ -0,0 +1,457 @@
+#define _GNU_SOURCE
+#include "status.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../ci/ignore.h"
+#include "commit.h"
+#include "index.h"
+#include "objects.h"
+#include "threadpool.h"
+
+#define STATUS_BATCH 64      /* arquivos por tarefa do pool */
+#define STATUS_MIN_PARALLEL 16
+
+/* Arquivo com stat ambíguo: o conteúdo precisa ser comparado pelo hash */
+typedef struct {
+  char *path;
+  const index_entry_t *entry;
+  struct stat st;
+  int changed;
+} hash_job_t;
+
+typedef struct {
+  char kind; /* 'A', 'M' ou 'D' */
+  char *path;
+} change_t;
+
+typedef struct {
+  const index_t *base;
+  const ignore_t *ignore;
+  unsigned char *visited; /* um byte por entrada de `base` */
+  hash_job_t *jobs;
+  size_t job_count;
+  size_t job_capacity;
+  change_t *changes;
+  size_t change_count;
+  size_t change_capacity;
+  int error;
+} status_ctx_t;
+
+typedef struct {
+  hash_job_t *jobs;
+  size_t count;
+} hash_batch_t;
+
+static int add_change(status_ctx_t *ctx, char kind, const char *path) {
+  if (ctx->change_count == ctx->change_capacity) {
+    size_t capacity = ctx->change_capacity ? ctx->change_capacity * 2 : 64;
+    change_t *grown = realloc(ctx->changes, capacity * sizeof(*grown));
+    if (!grown) return -1;
+    ctx->changes = grown;
+    ctx->change_capacity = capacity;
+  }
+  ctx->changes[ctx->change_count].kind = kind;
+  ctx->changes[ctx->change_count].path = strdup(path);
+  if (!ctx->changes[ctx->change_count].path) return -1;
+  ctx->change_count++;
+  return 0;
+}
+
+static int add_job(status_ctx_t *ctx, const char *path, const index_entry_t *entry,
+                   const struct stat *st) {
+  hash_job_t *job;
+
+  if (ctx->job_count == ctx->job_capacity) {
+    size_t capacity = ctx->job_capacity ? ctx->job_capacity * 2 : 256;
+    hash_job_t *grown = realloc(ctx->jobs, capacity * sizeof(*grown));
+    if (!grown) return -1;
+    ctx->jobs = grown;
+    ctx->job_capacity = capacity;
+  }
+  job = &ctx->jobs[ctx->job_count];
+  job->path = strdup(path);
+  if (!job->path) return -1;
+  job->entry = entry;
+  job->st = *st;
+  job->changed = 0;
+  ctx->job_count++;
+  return 0;
+}
+
+static void hash_batch(void *arg) {
+  hash_batch_t *batch = arg;
+  const char *paths[STATUS_BATCH];
+  uint8_t digests[STATUS_BATCH][SHA256_DIGEST_SIZE];
+  int results[STATUS_BATCH];
+  size_t files = 0;
+  size_t i;
+
+  /* Symlinks: hash do alvo; arquivos regulares vão juntos para o multi-buffer */
+  for (i = 0; i < batch->count; i++) {
+    hash_job_t *job = &batch->jobs[i];
+
+    if (S_ISLNK(job->st.st_mode)) {
+      char target[PATH_MAX];
+      uint8_t digest[SHA256_DIGEST_SIZE];
+      ssize_t n = readlink(job->path, target, sizeof(target));
+
+      if (n >= 0) sha256_buffer(target, (size_t)n, digest);
+      job->changed = n < 0 || memcmp(digest, job->entry->hash, SHA256_DIGEST_SIZE) != 0;
+    } else {
+      paths[files++] = job->path;
+    }
+  }
+
+  sha256_files(paths, files, digests, results);
+
+  files = 0;
+  for (i = 0; i < batch->count; i++) {
+    hash_job_t *job = &batch->jobs[i];
+
+    if (S_ISLNK(job->st.st_mode)) continue;
+    /* Arquivo ilegível conta como modificado */
+    job->changed = results[files] != 0 ||
+                   memcmp(digests[files], job->entry->hash, SHA256_DIGEST_SIZE) != 0;
+    files++;
+  }
+}
+
+static void run_hash_jobs(status_ctx_t *ctx) {
+  size_t batches = (ctx->job_count + STATUS_BATCH - 1) / STATUS_BATCH;
+  hash_batch_t *list;
+  threadpool_t *pool = NULL;
+  size_t i;
+
+  if (ctx->job_count == 0) return;
+
+  list = calloc(batches, sizeof(*list));
+  if (!list) {
+    for (i = 0; i < batches; i++) {
+      hash_batch_t one = {ctx->jobs + i * STATUS_BATCH,
+                          (i + 1 < batches) ? STATUS_BATCH : ctx->job_count - i * STATUS_BATCH};
+      hash_batch(&one);
+    }
+    return;
+  }
+  if (ctx->job_count >= STATUS_MIN_PARALLEL) pool = threadpool_create(0);
+
+  for (i = 0; i < batches; i++) {
+    list[i].jobs = ctx->jobs + i * STATUS_BATCH;
+    list[i].count = (i + 1 < batches) ? STATUS_BATCH : ctx->job_count - i * STATUS_BATCH;
+    if (!pool || threadpool_submit(pool, hash_batch, &list[i]) != 0) hash_batch(&list[i]);
+  }
+
+  if (pool) {
+    threadpool_wait(pool);
+    threadpool_destroy(pool);
+  }
+  free(list);
+}
+
+/* Compara um arquivo da árvore de trabalho com a entrada do HEAD */
+static int check_file(status_ctx_t *ctx, const char *rel, const struct stat *st) {
+  const index_entry_t *entry = index_lookup(ctx->base, rel);
+
+  if (!entry) return add_change(ctx, 'A', rel);
+  ctx->visited[entry - ctx->base->entries] = 1;
+
+  /* Tipo (arquivo/symlink) ou bit de execução diferente: modificado sem ler nada */
+  if (S_ISLNK(entry->mode) != S_ISLNK(st->st_mode) ||
+      (!S_ISLNK(st->st_mode) && ((entry->mode & 0111) != 0) != ((st->st_mode & 0111) != 0))) {
+    return add_change(ctx, 'M', rel);
+  }
+
+  if (index_entry_is_clean(ctx->base, entry, st)) return 0;
+
+  /* Tamanho conhecido e diferente já basta; sem stat confiável, comparar o hash */
+  if (entry->mtime_ns != 0 && entry->size != (uint64_t)st->st_size) {
+    return add_change(ctx, 'M', rel);
+  }
+  return add_job(ctx, rel, entry, st);
+}
+
+static int walk_dir(status_ctx_t *ctx, const char *dir, const char *rel) {
+  struct dirent *entry;
+  DIR *d = opendir(dir);
+
+  if (!d) {
+    fprintf(stderr, "erro ao abrir diretório %s: %s\n", dir, strerror(errno));
+    return -1;
+  }
+
+  while (!ctx->error && (entry = readdir(d)) != NULL) {
+    char path[PATH_MAX];
+    char rel_path[PATH_MAX];
+    struct stat st;
+
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0 ||
+        strcmp(entry->d_name, ".clurg") == 0) {
+      continue;
+    }
+    if (snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name) >= (int)sizeof(path) ||
+        snprintf(rel_path, sizeof(rel_path), "%s%s%s", rel, rel[0] ? "/" : "", entry->d_name) >=
+            (int)sizeof(rel_path)) {
+      continue;
+    }
+    if (fstatat(dirfd(d), entry->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0) continue;
+    if (ignore_match(ctx->ignore, rel_path, S_ISDIR(st.st_mode))) continue;
+
+    if (S_ISDIR(st.st_mode)) {
+      if (walk_dir(ctx, path, rel_path) != 0) ctx->error = 1;
+    } else if (S_ISREG(st.st_mode) || S_ISLNK(st.st_mode)) {
+      if (check_file(ctx, rel_path, &st) != 0) ctx->error = 1;
+    }
+  }
+
+  closedir(d);
+  return ctx->error ? -1 : 0;
+}
+
+static int compare_strings(const void *a, const void *b) {
+  return strcmp(*(const char *const *)a, *(const char *const *)b);
+}
+
+/* 1 se algum diretório acima de `path` já foi percorrido inteiro */
+static int under_walked(char **walked, size_t count, const char *path) {
+  char prefix[PATH_MAX];
+  const char *key = prefix;
+  size_t i;
+
+  for (i = 0; path[i] && i < sizeof(prefix); i++) {
+    if (path[i] == '/') {
+      prefix[i] = '\0';
+      if (bsearch(&key, walked, count, sizeof(*walked), compare_strings)) return 1;
+    }
+    prefix[i] = path[i];
+  }
+  return 0;
+}
+
+static int ignored_path(const ignore_t *ignore, const char *path, int is_dir) {
+  char prefix[PATH_MAX];
+  size_t i;
+
+  for (i = 0; path[i] && i < sizeof(prefix); i++) {
+    if (path[i] == '/') {
+      prefix[i] = '\0';
+      if (ignore_match(ignore, prefix, 1)) return 1;
+    }
+    prefix[i] = path[i];
+  }
+  return ignore_match(ignore, path, is_dir);
+}
+
+/*
+ * Com o clurg watch, só os caminhos relatados (e os que já diferiam na última
+ * consulta) são examinados; as demais entradas do índice contam como vistas.
+ */
+static int walk_dirty(status_ctx_t *ctx, const watch_dirty_t *dirty) {
+  const index_t *base = ctx->base;
+  char **walked = NULL;
+  size_t walked_count = 0;
+  size_t i;
+
+  memset(ctx->visited, 1, base->count);
+  for (i = 0; i < dirty->count && !ctx->error; i++) {
+    const char *path = dirty->paths[i];
+    const index_entry_t *entry;
+    char prefix[PATH_MAX];
+    size_t len;
+    size_t e;
+    struct stat st;
+
+    if (under_walked(walked, walked_count, path)) continue;
+
+    /* O que o índice tem nesse caminho (ou abaixo dele) precisa ser reencontrado */
+    entry = index_lookup(base, path);
+    if (entry) ctx->visited[entry - base->entries] = 0;
+    len = (size_t)snprintf(prefix, sizeof(prefix), "%s/", path);
+    for (e = len < sizeof(prefix) ? index_lower_bound(base, prefix) : base->count;
+         e < base->count && strncmp(index_entry_path(base, &base->entries[e]), prefix, len) == 0;
+         e++) {
+      ctx->visited[e] = 0;
+    }
+
+    if (lstat(path, &st) != 0) continue;
+    if (ignored_path(ctx->ignore, path, S_ISDIR(st.st_mode))) continue;
+
+    if (S_ISDIR(st.st_mode)) {
+      char **grown = realloc(walked, (walked_count + 1) * sizeof(*walked));
+      if (!grown) {
+        ctx->error = 1;
+        break;
+      }
+      walked = grown;
+      walked[walked_count++] = (char *)path;
+      if (walk_dir(ctx, path, path) != 0) ctx->error = 1;
+    } else if (S_ISREG(st.st_mode) || S_ISLNK(st.st_mode)) {
+      if (check_file(ctx, path, &st) != 0) ctx->error = 1;
+    }
+  }
+
+  free(walked);
+  return ctx->error ? -1 : 0;
+}
+
+/*
+ * Lista de arquivos do HEAD: o índice de stat quando ele descreve exatamente a
+ * tree do HEAD (*from_index = 1); caso contrário, a própria tree (mais lenta,
+ * sem stat).
+ */
+static int load_base(const char *tree_hex, index_t *base, int *from_index) {
+  index_load(base);
+  *from_index = strcmp(base->tree, tree_hex) == 0;
+  if (tree_hex[0] == '\0' || *from_index) return 0;
+  index_free(base);
+
+  /* Sem stat: toda entrada vinda da tree é ambígua e será comparada pelo hash */
+  return objects_tree_to_index(tree_hex, base);
+}
+
+/*
+ * Regrava o índice com o stat dos arquivos confirmados iguais pelo hash, para
+ * que a próxima consulta não precise lê-los de novo.
+ */
+static void refresh_index(status_ctx_t *ctx) {
+  const index_t *base = ctx->base;
+  const struct stat **fresh;
+  index_builder_t builder;
+  size_t refreshed = 0;
+  size_t i;
+
+  fresh = calloc(base->count + 1, sizeof(*fresh));
+  if (!fresh) return;
+  for (i = 0; i < ctx->job_count; i++) {
+    if (!ctx->jobs[i].changed) {
+      fresh[ctx->jobs[i].entry - base->entries] = &ctx->jobs[i].st;
+      refreshed++;
+    }
+  }
+
+  if (refreshed > 0) {
+    index_builder_init(&builder);
+    for (i = 0; i < base->count; i++) {
+      const index_entry_t *entry = &base->entries[i];
+      if (index_builder_add_entry(&builder, index_entry_path(base, entry), entry, fresh[i]) != 0) {
+        break;
+      }
+    }
+    if (i == base->count) {
+      index_builder_set_tree(&builder, base->tree);
+      index_builder_write(&builder);
+    }
+    index_builder_free(&builder);
+  }
+  free(fresh);
+}
+
+static int compare_changes(const void *a, const void *b) {
+  return strcmp(((const change_t *)a)->path, ((const change_t *)b)->path);
+}
+
+/* O que ainda difere do índice precisa ser reexaminado na próxima consulta */
+static void save_watch_state(const status_ctx_t *ctx, const watch_dirty_t *dirty) {
+  const char **paths = malloc((ctx->change_count + 1) * sizeof(*paths));
+  size_t i;
+
+  if (!paths) return;
+  for (i = 0; i < ctx->change_count; i++) paths[i] = ctx->changes[i].path;
+  watch_dirty_save(dirty, paths, ctx->change_count);
+  free(paths);
+}
+
+int clurg_status(void) {
+  char head[64];
+  char tree_hex[SHA256_HEX_SIZE] = "";
+  char cwd[PATH_MAX];
+  status_ctx_t ctx;
+  index_t base;
+  watch_dirty_t dirty;
+  int from_index = 0;
+  size_t i;
+  int ret = 0;
+
+  if (access(".clurg", F_OK) != 0) {
+    printf("❌ Repositório não inicializado.\n");
+    return 1;
+  }
+
+  if (commit_read_head(head, sizeof(head)) != 0) {
+    printf("📂 Repositório inicializado (sem commits).\n");
+    head[0] = '\0';
+  } else {
+    printf("🔖 HEAD atual: %s\n", head);
+    if (commit_read_meta_field(head, "tree", tree_hex, sizeof(tree_hex)) != 0) {
+      fprintf(stderr, "erro: commit %s sem tree no object store\n", head);
+      return 1;
+    }
+  }
+  if (getcwd(cwd, sizeof(cwd))) printf("📂 Working directory: %s\n", cwd);
+
+  memset(&ctx, 0, sizeof(ctx));
+  if (head[0] == '\0') {
+    memset(&base, 0, sizeof(base));
+  } else if (load_base(tree_hex, &base, &from_index) != 0) {
+    fprintf(stderr, "erro: não foi possível ler a tree %s\n", tree_hex);
+    return 1;
+  }
+  ctx.base = &base;
+  ctx.visited = calloc(base.count + 1, 1);
+  ctx.ignore = ignore_load(".");
+  if (!ctx.visited || !ctx.ignore) {
+    free(ctx.visited);
+    ignore_free((ignore_t *)ctx.ignore);
+    index_free(&base);
+    return 1;
+  }
+
+  /* O token do watch vem antes da varredura: o que mudar durante ela fica para a próxima */
+  watch_dirty_load(&dirty);
+  if (!from_index || head[0] == '\0') dirty.full = 1;
+  if (!dirty.full ? walk_dirty(&ctx, &dirty) != 0 : walk_dir(&ctx, ".", "") != 0) {
+    ret = 1;
+    goto out;
+  }
+
+  run_hash_jobs(&ctx);
+  for (i = 0; i < ctx.job_count; i++) {
+    if (ctx.jobs[i].changed && add_change(&ctx, 'M', ctx.jobs[i].path) != 0) ret = 1;
+  }
+  for (i = 0; i < base.count; i++) {
+    if (!ctx.visited[i] && add_change(&ctx, 'D', index_entry_path(&base, &base.entries[i])) != 0) {
+      ret = 1;
+    }
+  }
+  if (head[0] != '\0') refresh_index(&ctx);
+
+  qsort(ctx.changes, ctx.change_count, sizeof(*ctx.changes), compare_changes);
+  if (from_index && ret == 0) save_watch_state(&ctx, &dirty);
+  if (ctx.change_count == 0) {
+    printf("✅ Nenhuma alteração desde o último commit.\n");
+  } else {
+    printf("📝 Alterações (A = adicionado, M = modificado, D = removido):\n");
+    for (i = 0; i < ctx.change_count; i++) {
+      printf("  %c  %s\n", ctx.changes[i].kind, ctx.changes[i].path);
+    }
+  }
+
+out:
+  watch_dirty_free(&dirty);
+  for (i = 0; i < ctx.job_count; i++) free(ctx.jobs[i].path);
+  for (i = 0; i < ctx.change_count; i++) free(ctx.changes[i].path);
+  free(ctx.jobs);
+  free(ctx.changes);
+  free(ctx.visited);
+  ignore_free((ignore_t *)ctx.ignore);
+  index_free(&base);
+  return ret;
+}
@@ -0,0 +1,6 @@
+#ifndef CLURG_STATUS_H
+#define CLURG_STATUS_H
+
+int clurg_status(void);
+
+#endif
@@ -0,0 +1,139 @@
+#define _GNU_SOURCE
+#include "threadpool.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+typedef struct task {
+  threadpool_fn fn;
+  void *arg;
+  struct task *next;
+} task_t;
+
+struct threadpool {
+  pthread_mutex_t lock;
+  pthread_cond_t has_work;  /* sinalizada ao enfileirar ou encerrar */
+  pthread_cond_t idle;      /* sinalizada quando pending chega a zero */
+  task_t *head;
+  task_t *tail;
+  size_t pending;           /* tarefas enfileiradas + em execução */
+  int shutdown;
+  int nthreads;
+  pthread_t *threads;
+};
+
+int threadpool_cpu_count(void) {
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return n > 0 ? (int)n : 1;
+}
+
+static void *worker_main(void *ctx) {
+  threadpool_t *pool = ctx;
+
+  pthread_mutex_lock(&pool->lock);
+  while (1) {
+    task_t *task;
+
+    while (!pool->head && !pool->shutdown) {
+      pthread_cond_wait(&pool->has_work, &pool->lock);
+    }
+    if (!pool->head) break; /* shutdown com fila vazia */
+
+    task = pool->head;
+    pool->head = task->next;
+    if (!pool->head) pool->tail = NULL;
+    pthread_mutex_unlock(&pool->lock);
+
+    task->fn(task->arg);
+    free(task);
+
+    pthread_mutex_lock(&pool->lock);
+    if (--pool->pending == 0) pthread_cond_broadcast(&pool->idle);
+  }
+  pthread_mutex_unlock(&pool->lock);
+  return NULL;
+}
+
+threadpool_t *threadpool_create(int threads) {
+  threadpool_t *pool;
+  int i;
+
+  if (threads <= 0) threads = threadpool_cpu_count();
+
+  pool = calloc(1, sizeof(*pool));
+  if (!pool) return NULL;
+  pool->threads = calloc((size_t)threads, sizeof(pthread_t));
+  if (!pool->threads) {
+    free(pool);
+    return NULL;
+  }
+
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->has_work, NULL);
+  pthread_cond_init(&pool->idle, NULL);
+
+  for (i = 0; i < threads; i++) {
+    if (pthread_create(&pool->threads[i], NULL, worker_main, pool) != 0) break;
+  }
+  pool->nthreads = i;
+  if (pool->nthreads == 0) {
+    threadpool_destroy(pool);
+    return NULL;
+  }
+  return pool;
+}
+
+int threadpool_size(const threadpool_t *pool) {
+  return pool->nthreads;
+}
+
+int threadpool_submit(threadpool_t *pool, threadpool_fn fn, void *arg) {
+  task_t *task = malloc(sizeof(*task));
+
+  if (!task) return -1;
+  task->fn = fn;
+  task->arg = arg;
+  task->next = NULL;
+
+  pthread_mutex_lock(&pool->lock);
+  if (pool->tail) {
+    pool->tail->next = task;
+  } else {
+    pool->head = task;
+  }
+  pool->tail = task;
+  pool->pending++;
+  pthread_cond_signal(&pool->has_work);
+  pthread_mutex_unlock(&pool->lock);
+  return 0;
+}
+
+void threadpool_wait(threadpool_t *pool) {
+  pthread_mutex_lock(&pool->lock);
+  while (pool->pending > 0) {
+    pthread_cond_wait(&pool->idle, &pool->lock);
+  }
+  pthread_mutex_unlock(&pool->lock);
+}
+
+void threadpool_destroy(threadpool_t *pool) {
+  int i;
+
+  if (!pool) return;
+
+  pthread_mutex_lock(&pool->lock);
+  pool->shutdown = 1;
+  pthread_cond_broadcast(&pool->has_work);
+  pthread_mutex_unlock(&pool->lock);
+
+  for (i = 0; i < pool->nthreads; i++) {
+    pthread_join(pool->threads[i], NULL);
+  }
+
+  pthread_mutex_destroy(&pool->lock);
+  pthread_cond_destroy(&pool->has_work);
+  pthread_cond_destroy(&pool->idle);
+  free(pool->threads);
+  free(pool);
+}
@@ -0,0 +1,34 @@
+#ifndef CLURG_THREADPOOL_H
+#define CLURG_THREADPOOL_H
+
+#include <stddef.h>
+
+/*
+ * Pool fixo de threads com fila FIFO de tarefas.
+ *
+ * As tarefas não retornam valor: quem precisa de resultado guarda no próprio
+ * `arg` e chama threadpool_wait() antes de lê-lo.
+ */
+
+typedef void (*threadpool_fn)(void *arg);
+
+typedef struct threadpool threadpool_t;
+
+/* Número de CPUs online (mínimo 1) */
+int threadpool_cpu_count(void);
+
+/* Cria um pool com `threads` workers (<= 0 usa o número de CPUs) */
+threadpool_t *threadpool_create(int threads);
+
+int threadpool_size(const threadpool_t *pool);
+
+/* Enfileira `fn(arg)`; retorna -1 sem memória */
+int threadpool_submit(threadpool_t *pool, threadpool_fn fn, void *arg);
+
+/* Bloqueia até todas as tarefas enfileiradas terminarem */
+void threadpool_wait(threadpool_t *pool);
+
+/* Espera as tarefas pendentes e encerra os workers */
+void threadpool_destroy(threadpool_t *pool);
+
+#endif /* CLURG_THREADPOOL_H */
@@ -0,0 +1,435 @@
+#define _GNU_SOURCE
+#include "transfer.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "commit.h"
+#include "commit_index.h"
+#include "objects.h"
+#include "pack.h"
+
+/* Um repositório clurg visto pelo caminho da raiz (loose + packs) */
+typedef struct {
+  char root[PATH_MAX];
+  pack_set_t objects;
+  pack_set_t commits;
+} store_t;
+
+typedef struct {
+  const store_t *src;
+  const store_t *dst;
+  transfer_stats_t *stats;
+} copy_t;
+
+int transfer_is_local(const char *url) {
+  return strncmp(url, "file://", 7) == 0 || strstr(url, "://") == NULL;
+}
+
+static const char *url_path(const char *url) {
+  return strncmp(url, "file://", 7) == 0 ? url + 7 : url;
+}
+
+static int store_file(const store_t *st, const char *rel, char *path, size_t size) {
+  return snprintf(path, size, "%s/%s", st->root, rel) >= (int)size ? -1 : 0;
+}
+
+static int object_file(const store_t *st, const char *hex, char *path, size_t size) {
+  if (strlen(hex) != 64) return -1;
+  return snprintf(path, size, "%s/%s/%.2s/%s", st->root, OBJECTS_DIR, hex, hex + 2) >= (int)size
+             ? -1
+             : 0;
+}
+
+/* Cria .clurg, objects e commits em `root` se faltarem (o remoto pode ser um diretório vazio) */
+static int store_prepare(const char *root) {
+  static const char *const dirs[] = {".clurg", COMMITS_DIR, OBJECTS_DIR};
+  char path[PATH_MAX];
+  size_t i;
+
+  for (i = 0; i < sizeof(dirs) / sizeof(dirs[0]); i++) {
+    if (snprintf(path, sizeof(path), "%s/%s", root, dirs[i]) >= (int)sizeof(path)) return -1;
+    if (mkdir(path, 0755) != 0 && errno != EEXIST) {
+      fprintf(stderr, "erro ao criar %s: %s\n", path, strerror(errno));
+      return -1;
+    }
+  }
+  return 0;
+}
+
+static int store_open(store_t *st, const char *root) {
+  char dir[PATH_MAX];
+
+  memset(st, 0, sizeof(*st));
+  if (snprintf(st->root, sizeof(st->root), "%s", root) >= (int)sizeof(st->root)) return -1;
+  if (store_file(st, OBJECTS_PACK_DIR, dir, sizeof(dir)) != 0) return -1;
+  pack_set_load(&st->objects, dir);
+  if (store_file(st, COMMITS_PACK_DIR, dir, sizeof(dir)) != 0) return -1;
+  pack_set_load(&st->commits, dir);
+  return 0;
+}
+
+static void store_close(store_t *st) {
+  pack_set_free(&st->objects);
+  pack_set_free(&st->commits);
+}
+
+static int read_whole(const char *path, unsigned char **data, size_t *len) {
+  struct stat st;
+  unsigned char *buf;
+  size_t done = 0;
+  int fd = open(path, O_RDONLY);
+
+  if (fd < 0) return -1;
+  if (fstat(fd, &st) != 0 || !(buf = malloc((size_t)st.st_size + 1))) {
+    close(fd);
+    return -1;
+  }
+  while (done < (size_t)st.st_size) {
+    ssize_t n = read(fd, buf + done, (size_t)st.st_size - done);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;
+    done += (size_t)n;
+  }
+  close(fd);
+  if (done != (size_t)st.st_size) {
+    free(buf);
+    return -1;
+  }
+  buf[done] = '\0';
+  *data = buf;
+  *len = done;
+  return 0;
+}
+
+/* Grava via temporário + rename, criando o diretório pai se preciso */
+static int write_whole(const char *path, const void *data, size_t len, mode_t mode) {
+  char tmp_path[PATH_MAX];
+  char dir[PATH_MAX];
+  char *slash;
+  FILE *fp;
+
+  snprintf(dir, sizeof(dir), "%s", path);
+  slash = strrchr(dir, '/');
+  if (slash) {
+    *slash = '\0';
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+      fprintf(stderr, "erro ao criar %s: %s\n", dir, strerror(errno));
+      return -1;
+    }
+  }
+  if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp.%d", path, (int)getpid()) >=
+      (int)sizeof(tmp_path)) {
+    return -1;
+  }
+
+  fp = fopen(tmp_path, "wb");
+  if (!fp) {
+    fprintf(stderr, "erro ao gravar %s: %s\n", tmp_path, strerror(errno));
+    return -1;
+  }
+  if (fwrite(data, 1, len, fp) != len) {
+    fclose(fp);
+    fp = NULL;
+  }
+  if (!fp || fclose(fp) != 0) {
+    unlink(tmp_path);
+    fprintf(stderr, "erro ao gravar %s\n", path);
+    return -1;
+  }
+  chmod(tmp_path, mode);
+  if (rename(tmp_path, path) != 0) {
+    fprintf(stderr, "erro ao gravar %s: %s\n", path, strerror(errno));
+    unlink(tmp_path);
+    return -1;
+  }
+  return 0;
+}
+
+static const pack_idx_entry_t *find_object(const store_t *st, const char *hex,
+                                           const pack_t **pack) {
+  uint8_t key[PACK_KEY_SIZE];
+
+  if (sha256_from_hex(hex, key) != 0) return NULL;
+  return pack_set_find(&st->objects, key, pack);
+}
+
+static int has_object(const store_t *st, const char *hex) {
+  char path[PATH_MAX];
+
+  if (object_file(st, hex, path, sizeof(path)) != 0) return 0;
+  return access(path, F_OK) == 0 || find_object(st, hex, NULL) != NULL;
+}
+
+/* Bytes do objeto como estão no disco: loose e registro de pack têm o mesmo formato */
+static int read_object_raw(const store_t *st, const char *hex, unsigned char **data, size_t *len) {
+  char path[PATH_MAX];
+  const pack_idx_entry_t *entry;
+  const pack_t *pack;
+
+  if (object_file(st, hex, path, sizeof(path)) != 0) return -1;
+  if (read_whole(path, data, len) == 0) return 0;
+
+  entry = find_object(st, hex, &pack);
+  if (!entry || pack_read(pack, entry, data) != 0) return -1;
+  *len = (size_t)entry->length;
+  return 0;
+}
+
+static int read_meta(const store_t *st, const char *id, char **text) {
+  char rel[PATH_MAX];
+  char path[PATH_MAX];
+  uint8_t key[PACK_KEY_SIZE];
+  const pack_idx_entry_t *entry;
+  const pack_t *pack;
+  size_t len;
+
+  if (strchr(id, '/') || snprintf(rel, sizeof(rel), "%s/%s.meta", COMMITS_DIR, id) >=
+                             (int)sizeof(rel)) {
+    return -1;
+  }
+  if (store_file(st, rel, path, sizeof(path)) != 0) return -1;
+  if (read_whole(path, (unsigned char **)text, &len) == 0) return 0;
+
+  if (commit_pack_key(id, key) != 0) return -1;
+  entry = pack_set_find(&st->commits, key, &pack);
+  if (!entry) return -1;
+  return pack_read(pack, entry, (unsigned char **)text);
+}
+
+static int has_meta(const store_t *st, const char *id) {
+  char *text;
+
+  if (read_meta(st, id, &text) != 0) return 0;
+  free(text);
+  return 1;
+}
+
+static int read_head(const store_t *st, char *id, size_t size) {
+  char path[PATH_MAX];
+  FILE *fp;
+
+  id[0] = '\0';
+  if (store_file(st, HEAD_FILE, path, sizeof(path)) != 0) return -1;
+  fp = fopen(path, "r");
+  if (!fp) return -1;
+  if (!fgets(id, (int)size, fp)) id[0] = '\0';
+  fclose(fp);
+  id[strcspn(id, "\r\n")] = '\0';
+  return id[0] != '\0' ? 0 : -1;
+}
+
+/*
+ * Copia `hex` e, antes dele, tudo de que ele depende. Um objeto que o destino
+ * já tem encerra a descida: pela ordem de gravação, o resto também está lá.
+ */
+static int copy_object(const char *hex, void *ctx) {
+  copy_t *copy = ctx;
+  char path[PATH_MAX];
+  unsigned char *raw;
+  size_t len;
+  int ret;
+
+  if (has_object(copy->dst, hex)) {
+    copy->stats->objects_present++;
+    return 0;
+  }
+  if (read_object_raw(copy->src, hex, &raw, &len) != 0) {
+    fprintf(stderr, "erro: objeto %s não encontrado em %s\n", hex, copy->src->root);
+    return -1;
+  }
+
+  ret = objects_raw_references(hex, raw, len, copy_object, copy);
+  if (ret == 0) {
+    ret = object_file(copy->dst, hex, path, sizeof(path)) == 0 ? write_whole(path, raw, len, 0444)
+                                                                : -1;
+  }
+  if (ret == 0) {
+    copy->stats->objects++;
+    copy->stats->bytes += len;
+  }
+  free(raw);
+  return ret;
+}
+
+static int copy_meta(copy_t *copy, const char *id) {
+  char rel[PATH_MAX];
+  char path[PATH_MAX];
+  char tree[SHA256_HEX_SIZE];
+  char *text;
+  int ret;
+
+  if (read_meta(copy->src, id, &text) != 0) {
+    fprintf(stderr, "erro: commit %s não encontrado em %s\n", id, copy->src->root);
+    return -1;
+  }
+
+  /* A tree vai antes do .meta, pelo mesmo motivo que os objetos */
+  ret = commit_meta_text_field(text, "tree", tree, sizeof(tree)) == 0 && tree[0]
+            ? copy_object(tree, copy)
+            : 0;
+  if (ret == 0) {
+    snprintf(rel, sizeof(rel), "%s/%s.meta", COMMITS_DIR, id);
+    ret = store_file(copy->dst, rel, path, sizeof(path)) == 0
+              ? write_whole(path, text, strlen(text), 0644)
+              : -1;
+  }
+  if (ret == 0) copy->stats->commits++;
+  free(text);
+  return ret;
+}
+
+static int seen_id(char (*ids)[32], size_t count, const char *id) {
+  size_t i;
+
+  for (i = 0; i < count; i++) {
+    if (strcmp(ids[i], id) == 0) return 1;
+  }
+  return 0;
+}
+
+/*
+ * Copia a cadeia de commits até `head` que o destino ainda não tem, do mais
+ * antigo ao mais novo. Um pai ausente na origem encerra a cadeia.
+ */
+static int copy_history(const store_t *src, const store_t *dst, const char *head,
+                        transfer_stats_t *stats) {
+  copy_t copy = {src, dst, stats};
+  char (*ids)[32] = NULL;
+  size_t count = 0;
+  size_t capacity = 0;
+  char id[32];
+  int ret = 0;
+
+  snprintf(id, sizeof(id), "%s", head);
+  while (id[0] && !has_meta(dst, id)) {
+    char *text;
+
+    if (count == capacity) {
+      size_t new_capacity = capacity ? capacity * 2 : 16;
+      char (*grown)[32] = realloc(ids, new_capacity * sizeof(*ids));
+      if (!grown) {
+        ret = -1;
+        break;
+      }
+      ids = grown;
+      capacity = new_capacity;
+    }
+    if (read_meta(src, id, &text) != 0) {
+      /* Pais apagados pelo `clurg gc` (retenção): o histórico começa aqui */
+      if (count > 0) break;
+      fprintf(stderr, "erro: commit %s não encontrado em %s\n", id, src->root);
+      ret = -1;
+      break;
+    }
+    memcpy(ids[count++], id, sizeof(id));
+    if (commit_meta_text_field(text, "parent", id, sizeof(id)) != 0) id[0] = '\0';
+    free(text);
+    /* Repositórios antigos podem ter commits que apontam para si mesmos */
+    if (seen_id(ids, count, id)) break;
+  }
+
+  while (ret == 0 && count > 0) ret = copy_meta(&copy, ids[--count]);
+  free(ids);
+  return ret;
+}
+
+static int write_head(const store_t *st, const char *id) {
+  char path[PATH_MAX];
+  char line[64];
+
+  snprintf(line, sizeof(line), "%s\n", id);
+  return store_file(st, HEAD_FILE, path, sizeof(path)) == 0
+             ? write_whole(path, line, strlen(line), 0644)
+             : -1;
+}
+
+int transfer_push(const char *url, transfer_stats_t *stats) {
+  const char *root = url_path(url);
+  store_t local;
+  store_t remote;
+  char head[32];
+  char remote_head[32];
+  char path[PATH_MAX];
+  struct stat st;
+  int ret = -1;
+
+  memset(stats, 0, sizeof(*stats));
+  if (commit_read_head(head, sizeof(head)) != 0) {
+    fprintf(stderr, "erro: nenhum commit para enviar\n");
+    return -1;
+  }
+  if (stat(root, &st) != 0 || !S_ISDIR(st.st_mode)) {
+    fprintf(stderr, "erro: remoto %s não é um diretório\n", root);
+    return -1;
+  }
+  if (store_prepare(root) != 0) return -1;
+  if (store_open(&local, ".") != 0) return -1;
+  if (store_open(&remote, root) != 0) {
+    store_close(&local);
+    return -1;
+  }
+
+  if (read_head(&remote, remote_head, sizeof(remote_head)) == 0 &&
+      strcmp(remote_head, head) != 0 && !commit_is_ancestor(remote_head, head)) {
+    fprintf(stderr, "erro: o HEAD remoto (%s) não está no histórico local; faça clone de novo\n",
+            remote_head);
+    goto out;
+  }
+
+  if (copy_history(&local, &remote, head, stats) != 0 || write_head(&remote, head) != 0) goto out;
+
+  /* O log.idx do remoto não conhece os commits novos: ele é recriado na próxima leitura */
+  if (store_file(&remote, COMMIT_INDEX_FILE, path, sizeof(path)) == 0) unlink(path);
+  if (store_file(&remote, COMMIT_INDEX_STRINGS, path, sizeof(path)) == 0) unlink(path);
+  ret = 0;
+
+out:
+  store_close(&remote);
+  store_close(&local);
+  return ret;
+}
+
+int transfer_clone(const char *url, transfer_stats_t *stats) {
+  const char *root = url_path(url);
+  store_t local;
+  store_t remote;
+  char head[32];
+  char tree[SHA256_HEX_SIZE];
+  int ret = -1;
+
+  memset(stats, 0, sizeof(*stats));
+  if (store_open(&remote, root) != 0) return -1;
+  if (read_head(&remote, head, sizeof(head)) != 0) {
+    fprintf(stderr, "erro: %s não tem commits\n", root);
+    store_close(&remote);
+    return -1;
+  }
+  if (store_prepare(".") != 0 || store_open(&local, ".") != 0) {
+    store_close(&remote);
+    return -1;
+  }
+
+  if (copy_history(&remote, &local, head, stats) != 0) goto out;
+  objects_reload_packs();
+  if (commit_read_meta_field(head, "tree", tree, sizeof(tree)) != 0 ||
+      objects_checkout(tree, ".") != 0) {
+    fprintf(stderr, "erro ao reconstruir os arquivos do commit %s\n", head);
+    goto out;
+  }
+  if (commit_update_head(head) != 0) goto out;
+  commit_index_rebuild();
+  ret = 0;
+
+out:
+  store_close(&local);
+  store_close(&remote);
+  return ret;
+}
@@ -0,0 +1,34 @@
+#ifndef CLURG_TRANSFER_H
+#define CLURG_TRANSFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Remotos em diretório (um caminho ou file://<caminho>): o remoto é outro
+ * repositório clurg e push/clone copiam objetos do store, não um .tar.gz.
+ *
+ * A cópia parte do commit e desce pelas referências de cada objeto (tree →
+ * entradas, blob dividido → chunks, delta → base); o objeto só é gravado no
+ * destino depois de tudo de que ele depende. Assim, um objeto presente no
+ * destino implica que o que está abaixo dele também está, e a descida para
+ * ali: de um arquivo grande editado só os chunks novos trafegam.
+ */
+
+typedef struct {
+  uint64_t commits;        /* .meta copiados */
+  uint64_t objects;        /* objetos copiados */
+  uint64_t objects_present; /* referências que o destino já tinha */
+  uint64_t bytes;          /* bytes copiados (objetos comprimidos) */
+} transfer_stats_t;
+
+/* 1 se `url` não é HTTP: caminho local ou file:// */
+int transfer_is_local(const char *url);
+
+/* Envia o HEAD local (commits, trees, blobs e chunks que faltam) e move o HEAD remoto */
+int transfer_push(const char *url, transfer_stats_t *stats);
+
+/* Copia o HEAD do remoto para o diretório atual e reconstrói os arquivos */
+int transfer_clone(const char *url, transfer_stats_t *stats);
+
+#endif /* CLURG_TRANSFER_H */
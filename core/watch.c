@@ -0,0 +1,755 @@
+#define _GNU_SOURCE
+#include "watch.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../ci/ignore.h"
+#include "index.h"
+
+#define WATCH_DIRTY_MAX 65536 /* acima disso é mais barato varrer tudo */
+#define WATCH_EVENT_BUFFER 65536
+#define WATCH_CLIENT_TIMEOUT_MS 2000
+#define WATCH_MASK                                                                          \
+  (IN_CREATE | IN_DELETE | IN_MODIFY | IN_ATTRIB | IN_MOVED_FROM | IN_MOVED_TO |            \
+   IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR | IN_DONT_FOLLOW | IN_EXCL_UNLINK)
+
+/* ---- daemon ---- */
+
+typedef struct {
+  char *path;
+  uint64_t seq;
+} dirty_slot_t;
+
+typedef struct {
+  int ifd;
+  int lfd;
+  char **wd_paths; /* caminho relativo de cada watch, indexado pelo wd */
+  size_t wd_capacity;
+  size_t watches;
+  dirty_slot_t *slots; /* tabela hash com endereçamento aberto */
+  size_t slot_capacity;
+  size_t slot_count;
+  uint64_t seq;
+  uint64_t overflow_seq; /* tokens anteriores a isto não valem mais */
+  char instance[32];
+  ignore_t *ignore;
+} watchd_t;
+
+static volatile sig_atomic_t watch_stop;
+
+static void on_signal(int sig) {
+  (void)sig;
+  watch_stop = 1;
+}
+
+static uint64_t hash_path(const char *s) {
+  uint64_t h = 1469598103934665603ULL; /* FNV-1a */
+  while (*s) {
+    h ^= (unsigned char)*s++;
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+static void dirty_clear(watchd_t *w) {
+  size_t i;
+  for (i = 0; i < w->slot_capacity; i++) free(w->slots[i].path);
+  memset(w->slots, 0, w->slot_capacity * sizeof(*w->slots));
+  w->slot_count = 0;
+}
+
+/* Descarta tudo o que se sabia: quem tiver token anterior faz varredura completa */
+static void overflow(watchd_t *w, const char *why) {
+  dirty_clear(w);
+  w->overflow_seq = ++w->seq;
+  fprintf(stderr, "aviso: %s; próximas consultas farão varredura completa\n", why);
+}
+
+static void mark(watchd_t *w, const char *path) {
+  size_t mask = w->slot_capacity - 1;
+  size_t i;
+
+  if (w->slot_count >= WATCH_DIRTY_MAX) {
+    overflow(w, "muitos caminhos alterados");
+    return;
+  }
+  for (i = hash_path(path) & mask;; i = (i + 1) & mask) {
+    if (!w->slots[i].path) {
+      w->slots[i].path = strdup(path);
+      if (!w->slots[i].path) {
+        overflow(w, "memória insuficiente");
+        return;
+      }
+      w->slot_count++;
+      break;
+    }
+    if (strcmp(w->slots[i].path, path) == 0) break;
+  }
+  w->slots[i].seq = ++w->seq;
+}
+
+static int set_wd_path(watchd_t *w, int wd, const char *rel) {
+  char *copy = strdup(rel);
+
+  if (!copy) return -1;
+  if ((size_t)wd >= w->wd_capacity) {
+    size_t capacity = w->wd_capacity ? w->wd_capacity : 1024;
+    char **grown;
+    while (capacity <= (size_t)wd) capacity *= 2;
+    grown = realloc(w->wd_paths, capacity * sizeof(*grown));
+    if (!grown) {
+      free(copy);
+      return -1;
+    }
+    memset(grown + w->wd_capacity, 0, (capacity - w->wd_capacity) * sizeof(*grown));
+    w->wd_paths = grown;
+    w->wd_capacity = capacity;
+  }
+  if (w->wd_paths[wd]) {
+    free(w->wd_paths[wd]); /* mesmo inode observado de novo */
+  } else {
+    w->watches++;
+  }
+  w->wd_paths[wd] = copy;
+  return 0;
+}
+
+static void drop_wd(watchd_t *w, int wd) {
+  if (wd < 0 || (size_t)wd >= w->wd_capacity || !w->wd_paths[wd]) return;
+  free(w->wd_paths[wd]);
+  w->wd_paths[wd] = NULL;
+  w->watches--;
+}
+
+/* Observa `rel` e tudo abaixo; o watch vem antes do readdir para não perder criações */
+static void crawl(watchd_t *w, const char *rel) {
+  const char *dir = rel[0] ? rel : ".";
+  struct dirent *entry;
+  DIR *d;
+  int wd;
+
+  wd = inotify_add_watch(w->ifd, dir, WATCH_MASK);
+  if (wd < 0) {
+    if (errno == ENOSPC) {
+      overflow(w, "limite de watches do inotify (fs.inotify.max_user_watches) atingido");
+    } else if (errno != ENOENT && errno != ENOTDIR) {
+      fprintf(stderr, "aviso: inotify em %s: %s\n", dir, strerror(errno));
+    }
+    return;
+  }
+  if (set_wd_path(w, wd, rel) != 0) {
+    overflow(w, "memória insuficiente");
+    return;
+  }
+
+  d = opendir(dir);
+  if (!d) return;
+  while ((entry = readdir(d)) != NULL) {
+    char child[PATH_MAX];
+    struct stat st;
+
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+    if (!rel[0] && strcmp(entry->d_name, ".clurg") == 0) continue;
+    if (entry->d_type != DT_DIR && entry->d_type != DT_UNKNOWN) continue;
+    if (fstatat(dirfd(d), entry->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0 || !S_ISDIR(st.st_mode)) {
+      continue;
+    }
+    if (snprintf(child, sizeof(child), "%s%s%s", rel, rel[0] ? "/" : "", entry->d_name) >=
+        (int)sizeof(child)) {
+      continue;
+    }
+    if (ignore_match(w->ignore, child, 1)) continue;
+    crawl(w, child);
+  }
+  closedir(d);
+}
+
+/* Diretório saiu da árvore (ou foi renomeado): os caminhos dos watches abaixo dele mudaram */
+static void unwatch_tree(watchd_t *w, const char *rel) {
+  size_t len = strlen(rel);
+  size_t wd;
+
+  for (wd = 0; wd < w->wd_capacity; wd++) {
+    const char *p = w->wd_paths[wd];
+    if (p && strncmp(p, rel, len) == 0 && (p[len] == '\0' || p[len] == '/')) {
+      inotify_rm_watch(w->ifd, (int)wd);
+      drop_wd(w, (int)wd);
+    }
+  }
+}
+
+static void reload_ignore(watchd_t *w) {
+  ignore_t *ig = ignore_load(".");
+
+  if (!ig) return;
+  ignore_free(w->ignore);
+  w->ignore = ig;
+  crawl(w, ""); /* diretórios que deixaram de ser ignorados */
+  overflow(w, IGNORE_FILE " alterado");
+}
+
+static void handle_event(watchd_t *w, const struct inotify_event *ev) {
+  char path[PATH_MAX];
+  const char *dir;
+  int is_dir = (ev->mask & IN_ISDIR) != 0;
+
+  if (ev->mask & IN_Q_OVERFLOW) {
+    overflow(w, "fila do inotify estourou");
+    return;
+  }
+  if (ev->mask & IN_IGNORED) {
+    drop_wd(w, ev->wd);
+    return;
+  }
+  if (ev->wd < 0 || (size_t)ev->wd >= w->wd_capacity || !w->wd_paths[ev->wd]) return;
+  dir = w->wd_paths[ev->wd];
+
+  if (ev->len == 0) {
+    /* Evento do próprio diretório; o pai relata a mudança pelo nome */
+    if (dir[0] == '\0' && (ev->mask & (IN_DELETE_SELF | IN_MOVE_SELF))) {
+      fprintf(stderr, "raiz do repositório removida, encerrando\n");
+      watch_stop = 1;
+    }
+    return;
+  }
+
+  if (snprintf(path, sizeof(path), "%s%s%s", dir, dir[0] ? "/" : "", ev->name) >=
+      (int)sizeof(path)) {
+    overflow(w, "caminho muito longo");
+    return;
+  }
+  if (dir[0] == '\0' && strcmp(ev->name, ".clurg") == 0) return;
+  if (dir[0] == '\0' && strcmp(ev->name, IGNORE_FILE) == 0) {
+    mark(w, path);
+    reload_ignore(w);
+    return;
+  }
+  if (ignore_match(w->ignore, path, is_dir)) return;
+
+  if (is_dir && (ev->mask & IN_MOVED_FROM)) unwatch_tree(w, path);
+  if (is_dir && (ev->mask & (IN_CREATE | IN_MOVED_TO))) crawl(w, path);
+  mark(w, path);
+}
+
+static void drain_events(watchd_t *w) {
+  char buf[WATCH_EVENT_BUFFER] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+  for (;;) {
+    ssize_t n = read(w->ifd, buf, sizeof(buf));
+    char *p;
+
+    if (n <= 0) {
+      if (n < 0 && errno == EINTR) continue;
+      return; /* EAGAIN: fila vazia */
+    }
+    for (p = buf; p < buf + n;) {
+      const struct inotify_event *ev = (const struct inotify_event *)p;
+      handle_event(w, ev);
+      p += sizeof(*ev) + ev->len;
+    }
+  }
+}
+
+static int write_str(int fd, const char *s) {
+  size_t len = strlen(s);
+  while (len > 0) {
+    ssize_t n = write(fd, s, len);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return -1;
+    }
+    s += n;
+    len -= (size_t)n;
+  }
+  return 0;
+}
+
+static void answer_since(watchd_t *w, int fd, const char *token) {
+  char reply[WATCH_TOKEN_MAX + 16];
+  const char *colon = strrchr(token, ':');
+  size_t instance_len = strlen(w->instance);
+  uint64_t since = 0;
+  int valid = 0;
+  size_t i;
+
+  if (colon && (size_t)(colon - token) == instance_len &&
+      strncmp(token, w->instance, instance_len) == 0) {
+    char *end;
+    since = strtoull(colon + 1, &end, 10);
+    valid = *end == '\0' && since >= w->overflow_seq && since <= w->seq;
+  }
+
+  snprintf(reply, sizeof(reply), "%s %s:%llu\n", valid ? "ok" : "full", w->instance,
+           (unsigned long long)w->seq);
+  if (write_str(fd, reply) != 0) return;
+  for (i = 0; valid && i < w->slot_capacity; i++) {
+    if (w->slots[i].path && w->slots[i].seq > since) {
+      if (write_str(fd, w->slots[i].path) != 0 || write_str(fd, "\n") != 0) return;
+    }
+  }
+  write_str(fd, "\n");
+}
+
+static void serve_client(watchd_t *w) {
+  struct timeval tv = {WATCH_CLIENT_TIMEOUT_MS / 1000, 0};
+  char request[WATCH_TOKEN_MAX + 16];
+  size_t len = 0;
+  int fd = accept(w->lfd, NULL, NULL);
+
+  if (fd < 0) return;
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+  while (len < sizeof(request) - 1) {
+    ssize_t n = read(fd, request + len, sizeof(request) - 1 - len);
+    if (n <= 0) break;
+    len += (size_t)n;
+    if (memchr(request, '\n', len)) break;
+  }
+  request[len] = '\0';
+  request[strcspn(request, "\n")] = '\0';
+
+  /* Tudo o que aconteceu antes da consulta já está na fila do inotify */
+  drain_events(w);
+
+  if (strncmp(request, "since ", 6) == 0) {
+    answer_since(w, fd, request + 6);
+  } else if (strcmp(request, "ping") == 0) {
+    char reply[128];
+    snprintf(reply, sizeof(reply), "ok %s:%llu %zu %zu\n", w->instance,
+             (unsigned long long)w->seq, w->watches, w->slot_count);
+    write_str(fd, reply);
+  } else if (strcmp(request, "stop") == 0) {
+    /* Sem o socket, quem chegar depois do "ok" já vê o daemon parado */
+    unlink(WATCH_SOCKET);
+    write_str(fd, "ok\n");
+    watch_stop = 1;
+  }
+  close(fd);
+}
+
+static int daemon_loop(watchd_t *w) {
+  struct timespec now;
+
+  clock_gettime(CLOCK_REALTIME, &now);
+  snprintf(w->instance, sizeof(w->instance), "%lx-%llx", (unsigned long)getpid(),
+           (unsigned long long)now.tv_sec * 1000000000ULL + (unsigned long long)now.tv_nsec);
+
+  w->slot_capacity = WATCH_DIRTY_MAX * 2;
+  w->slots = calloc(w->slot_capacity, sizeof(*w->slots));
+  w->ignore = ignore_load(".");
+  w->ifd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (!w->slots || !w->ignore || w->ifd < 0) {
+    fprintf(stderr, "erro: não foi possível iniciar o inotify: %s\n", strerror(errno));
+    return 1;
+  }
+  crawl(w, "");
+  fprintf(stderr, "observando %zu diretórios (instância %s)\n", w->watches, w->instance);
+
+  while (!watch_stop) {
+    struct pollfd fds[2] = {{w->ifd, POLLIN, 0}, {w->lfd, POLLIN, 0}};
+
+    if (poll(fds, 2, -1) < 0) {
+      if (errno == EINTR) continue;
+      break;
+    }
+    if (fds[0].revents & POLLIN) drain_events(w);
+    if (fds[1].revents & POLLIN) serve_client(w);
+  }
+  return 0;
+}
+
+static void daemon_free(watchd_t *w) {
+  size_t i;
+
+  if (w->slots) dirty_clear(w);
+  free(w->slots);
+  for (i = 0; i < w->wd_capacity; i++) free(w->wd_paths[i]);
+  free(w->wd_paths);
+  ignore_free(w->ignore);
+  if (w->ifd >= 0) close(w->ifd);
+  if (w->lfd >= 0) close(w->lfd);
+}
+
+/* ---- cliente ---- */
+
+static int watch_connect(void) {
+  struct sockaddr_un addr;
+  struct timeval tv = {WATCH_CLIENT_TIMEOUT_MS / 1000, 0};
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+  if (fd < 0) return -1;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", WATCH_SOCKET);
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+  if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static int watch_alive(void) {
+  int fd = watch_connect();
+  if (fd < 0) return 0;
+  close(fd);
+  return 1;
+}
+
+/* Envia o pedido e devolve a resposta para leitura linha a linha (NULL sem daemon) */
+static FILE *watch_request(const char *request) {
+  int fd = watch_connect();
+  FILE *fp;
+
+  if (fd < 0) return NULL;
+  if (write_str(fd, request) != 0 || shutdown(fd, SHUT_WR) != 0 || !(fp = fdopen(fd, "r"))) {
+    close(fd);
+    return NULL;
+  }
+  return fp;
+}
+
+static int read_line(FILE *fp, char **line, size_t *cap) {
+  ssize_t n = getline(line, cap, fp);
+  if (n < 0) return -1;
+  (*line)[strcspn(*line, "\n")] = '\0';
+  return 0;
+}
+
+static int push_path(watch_dirty_t *dirty, size_t *capacity, const char *path) {
+  char *copy;
+
+  if (dirty->count == *capacity) {
+    size_t grown_capacity = *capacity ? *capacity * 2 : 64;
+    char **grown = realloc(dirty->paths, grown_capacity * sizeof(*grown));
+    if (!grown) return -1;
+    dirty->paths = grown;
+    *capacity = grown_capacity;
+  }
+  copy = strdup(path);
+  if (!copy) return -1;
+  dirty->paths[dirty->count++] = copy;
+  return 0;
+}
+
+static int compare_paths(const void *a, const void *b) {
+  return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/* Identidade do .clurg/index: qualquer regravação muda pelo menos o mtime */
+static void index_identity(char *out, size_t size) {
+  struct stat st;
+
+  if (stat(INDEX_FILE, &st) != 0) {
+    out[0] = '\0';
+    return;
+  }
+  snprintf(out, size, "%llu %llu %lld.%09ld", (unsigned long long)st.st_ino,
+           (unsigned long long)st.st_size, (long long)st.st_mtim.tv_sec, st.st_mtim.tv_nsec);
+}
+
+void watch_dirty_load(watch_dirty_t *dirty) {
+  char request[WATCH_TOKEN_MAX + 16];
+  char saved_token[WATCH_TOKEN_MAX] = "";
+  char identity[128];
+  char *line = NULL;
+  size_t line_cap = 0;
+  size_t capacity = 0;
+  int state_ok = 0;
+  FILE *fp;
+  size_t i;
+
+  memset(dirty, 0, sizeof(*dirty));
+  dirty->full = 1;
+
+  /* Estado da última varredura: token, identidade do índice e caminhos pendentes */
+  fp = fopen(WATCH_STATE_FILE, "r");
+  if (fp) {
+    index_identity(identity, sizeof(identity));
+    if (read_line(fp, &line, &line_cap) == 0 && strlen(line) < sizeof(saved_token)) {
+      strcpy(saved_token, line);
+      state_ok = identity[0] && read_line(fp, &line, &line_cap) == 0 &&
+                 strcmp(line, identity) == 0;
+    }
+    while (state_ok && read_line(fp, &line, &line_cap) == 0) {
+      if (line[0] && push_path(dirty, &capacity, line) != 0) state_ok = 0;
+    }
+    fclose(fp);
+  }
+
+  snprintf(request, sizeof(request), "since %s\n", state_ok ? saved_token : "-");
+  fp = watch_request(request);
+  if (fp) {
+    if (read_line(fp, &line, &line_cap) == 0) {
+      int ok = strncmp(line, "ok ", 3) == 0;
+      if ((ok || strncmp(line, "full ", 5) == 0) &&
+          strlen(line + (ok ? 3 : 5)) < sizeof(dirty->token)) {
+        int complete = 0;
+        strcpy(dirty->token, line + (ok ? 3 : 5));
+        while (read_line(fp, &line, &line_cap) == 0) {
+          if (line[0] == '\0') {
+            complete = 1;
+            break;
+          }
+          if (push_path(dirty, &capacity, line) != 0) ok = 0;
+        }
+        /* Sem a linha vazia final a resposta veio cortada */
+        if (ok && state_ok && complete) dirty->full = 0;
+        if (!complete) dirty->token[0] = '\0';
+      }
+    }
+    fclose(fp);
+  }
+  free(line);
+
+  if (dirty->full) {
+    for (i = 0; i < dirty->count; i++) free(dirty->paths[i]);
+    dirty->count = 0;
+    return;
+  }
+
+  qsort(dirty->paths, dirty->count, sizeof(*dirty->paths), compare_paths);
+  capacity = 0;
+  for (i = 0; i < dirty->count; i++) {
+    if (capacity > 0 && strcmp(dirty->paths[capacity - 1], dirty->paths[i]) == 0) {
+      free(dirty->paths[i]);
+    } else {
+      dirty->paths[capacity++] = dirty->paths[i];
+    }
+  }
+  dirty->count = capacity;
+}
+
+/* strcmp(s, key[0..len)) */
+static int compare_prefix(const char *s, const char *key, size_t len) {
+  int cmp = strncmp(s, key, len);
+  return cmp != 0 ? cmp : s[len] != '\0';
+}
+
+/* Posição do primeiro caminho >= key[0..len); 1 se for igual */
+static int find_path(const watch_dirty_t *dirty, const char *key, size_t len, size_t *pos) {
+  size_t lo = 0;
+  size_t hi = dirty->count;
+
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (compare_prefix(dirty->paths[mid], key, len) < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  *pos = lo;
+  return lo < dirty->count && compare_prefix(dirty->paths[lo], key, len) == 0;
+}
+
+int watch_dirty_touches(const watch_dirty_t *dirty, const char *rel) {
+  char below[PATH_MAX];
+  size_t len = strlen(rel);
+  size_t pos;
+  size_t i;
+
+  if (dirty->full) return 1;
+  if (len == 0) return dirty->count > 0;
+
+  /* O próprio caminho ou um diretório acima dele */
+  for (i = 1; i <= len; i++) {
+    if ((i == len || rel[i] == '/') && find_path(dirty, rel, i, &pos)) return 1;
+  }
+
+  /* Algo abaixo: o primeiro caminho >= "rel/" começa com "rel/" */
+  if (len + 2 > sizeof(below)) return 1;
+  memcpy(below, rel, len);
+  below[len] = '/';
+  below[len + 1] = '\0';
+  find_path(dirty, below, len + 1, &pos);
+  return pos < dirty->count && strncmp(dirty->paths[pos], below, len + 1) == 0;
+}
+
+int watch_dirty_save(const watch_dirty_t *dirty, const char *const *changed, size_t count) {
+  char tmp_path[] = WATCH_STATE_FILE ".tmp";
+  char identity[128];
+  FILE *fp;
+  size_t i;
+
+  index_identity(identity, sizeof(identity));
+  if (dirty->token[0] == '\0' || identity[0] == '\0') {
+    unlink(WATCH_STATE_FILE); /* sem daemon o estado não serve para nada */
+    return 0;
+  }
+
+  fp = fopen(tmp_path, "w");
+  if (!fp) return -1;
+  fprintf(fp, "%s\n%s\n", dirty->token, identity);
+  for (i = 0; i < count; i++) fprintf(fp, "%s\n", changed[i]);
+  if (fclose(fp) != 0 || rename(tmp_path, WATCH_STATE_FILE) != 0) {
+    unlink(tmp_path);
+    return -1;
+  }
+  return 0;
+}
+
+void watch_dirty_free(watch_dirty_t *dirty) {
+  size_t i;
+  for (i = 0; i < dirty->count; i++) free(dirty->paths[i]);
+  free(dirty->paths);
+  memset(dirty, 0, sizeof(*dirty));
+}
+
+/* ---- comando ---- */
+
+static int watch_print_status(void) {
+  FILE *fp = watch_request("ping\n");
+  char *line = NULL;
+  size_t cap = 0;
+  char instance[WATCH_TOKEN_MAX];
+  size_t watches = 0;
+  size_t dirty = 0;
+
+  if (!fp) {
+    printf("clurg watch não está em execução.\n");
+    return 1;
+  }
+  if (read_line(fp, &line, &cap) != 0 ||
+      sscanf(line, "ok %63s %zu %zu", instance, &watches, &dirty) != 3) {
+    /* Daemon encerrando: aceitou a conexão mas não responde mais */
+    printf("clurg watch não está em execução.\n");
+    free(line);
+    fclose(fp);
+    return 1;
+  }
+  printf("👀 clurg watch ativo: %zu diretórios observados, %zu caminhos alterados\n", watches,
+         dirty);
+  free(line);
+  fclose(fp);
+  return 0;
+}
+
+static int watch_start(int foreground) {
+  struct sockaddr_un addr;
+  struct sigaction sa;
+  struct stat sock_st, st;
+  watchd_t w;
+  pid_t pid;
+  int ret;
+
+  if (access(".clurg", F_OK) != 0) {
+    fprintf(stderr, "erro: repositório não inicializado\n");
+    return 1;
+  }
+  if (watch_alive()) {
+    printf("clurg watch já está em execução.\n");
+    return 0;
+  }
+
+  memset(&w, 0, sizeof(w));
+  w.ifd = -1;
+  w.lfd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (w.lfd < 0) {
+    perror("socket");
+    return 1;
+  }
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", WATCH_SOCKET);
+  unlink(WATCH_SOCKET); /* socket de um daemon que morreu */
+  if (bind(w.lfd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(w.lfd, 16) != 0) {
+    fprintf(stderr, "erro ao criar %s: %s\n", WATCH_SOCKET, strerror(errno));
+    close(w.lfd);
+    return 1;
+  }
+  if (stat(WATCH_SOCKET, &sock_st) != 0) memset(&sock_st, 0, sizeof(sock_st));
+
+  if (!foreground) {
+    int log_fd;
+
+    pid = fork();
+    if (pid < 0) {
+      perror("fork");
+      close(w.lfd);
+      unlink(WATCH_SOCKET);
+      return 1;
+    }
+    if (pid > 0) {
+      close(w.lfd);
+      printf("👀 clurg watch iniciado (pid %d, log em %s)\n", (int)pid, WATCH_LOG_FILE);
+      return 0;
+    }
+    setsid();
+    log_fd = open(WATCH_LOG_FILE, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (log_fd >= 0) {
+      dup2(log_fd, STDOUT_FILENO);
+      dup2(log_fd, STDERR_FILENO);
+      close(log_fd);
+    }
+    log_fd = open("/dev/null", O_RDONLY);
+    if (log_fd >= 0) {
+      dup2(log_fd, STDIN_FILENO);
+      close(log_fd);
+    }
+  }
+
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = on_signal;
+  sigaction(SIGTERM, &sa, NULL);
+  sigaction(SIGINT, &sa, NULL);
+  signal(SIGPIPE, SIG_IGN);
+  setvbuf(stderr, NULL, _IOLBF, 0);
+
+  ret = daemon_loop(&w);
+  daemon_free(&w);
+  /* Depois de um stop outro daemon pode já ter criado o socket dele */
+  if (stat(WATCH_SOCKET, &st) == 0 && st.st_ino == sock_st.st_ino && st.st_dev == sock_st.st_dev) {
+    unlink(WATCH_SOCKET);
+  }
+  fprintf(stderr, "clurg watch encerrado\n");
+  return ret;
+}
+
+int clurg_watch(int argc, char *argv[]) {
+  if (argc > 0 && strcmp(argv[0], "--stop") == 0) {
+    FILE *fp = watch_request("stop\n");
+    char *line = NULL;
+    size_t cap = 0;
+    int ok;
+
+    if (!fp) {
+      printf("clurg watch não está em execução.\n");
+      return 1;
+    }
+    /* O "ok" só chega depois de o daemon largar o socket */
+    ok = read_line(fp, &line, &cap) == 0 && strcmp(line, "ok") == 0;
+    free(line);
+    fclose(fp);
+    if (!ok) {
+      printf("clurg watch não está em execução.\n");
+      return 1;
+    }
+    printf("clurg watch encerrado.\n");
+    return 0;
+  }
+  if (argc > 0 && strcmp(argv[0], "--status") == 0) return watch_print_status();
+  if (argc > 0 && strcmp(argv[0], "--foreground") != 0) {
+    fprintf(stderr, "Uso: clurg watch [--foreground | --stop | --status]\n");
+    return 1;
+  }
+  return watch_start(argc > 0);
+}
@@ -0,0 +1,57 @@
+#ifndef CLURG_WATCH_H
+#define CLURG_WATCH_H
+
+#include <stddef.h>
+
+/*
+ * clurg watch [--foreground | --stop | --status]
+ *
+ * Daemon opcional que mantém um inotify em cada diretório da árvore de
+ * trabalho (fora .clurg e o que o .clurgignore exclui) e guarda em memória os
+ * caminhos alterados, cada um com um número de sequência. Responde pelo socket
+ * .clurg/watch.sock:
+ *
+ *   since <token>\n  →  "ok <token novo>\n" + caminhos alterados depois de
+ *                        <token>, um por linha, e uma linha vazia no fim
+ *                    →  "full <token novo>\n\n" quando não dá para responder
+ *                        (token de outra instância, fila do inotify estourou,
+ *                        limite de watches ou de caminhos atingido)
+ *   stop\n, ping\n
+ *
+ * status e commit guardam em .clurg/watch.state o token usado na última
+ * varredura, a identidade do .clurg/index gravado depois dela e os caminhos
+ * que já estavam diferentes do índice. Se o índice ainda é o mesmo, basta
+ * reexaminar esses caminhos mais os que o daemon relatou; em qualquer dúvida
+ * (sem daemon, estado inválido, "full") a varredura completa é feita.
+ */
+
+#define WATCH_SOCKET ".clurg/watch.sock"
+#define WATCH_STATE_FILE ".clurg/watch.state"
+#define WATCH_LOG_FILE ".clurg/logs/watch.log"
+#define WATCH_TOKEN_MAX 64
+
+/* Caminhos a reexaminar desde a última varredura registrada */
+typedef struct {
+  char token[WATCH_TOKEN_MAX]; /* vazio se não há daemon */
+  char **paths;                /* ordenados (strcmp), sem repetição */
+  size_t count;
+  int full;                    /* 1 = é preciso varrer a árvore inteira */
+} watch_dirty_t;
+
+int clurg_watch(int argc, char *argv[]);
+
+/* Nunca falha: sem daemon ou sem estado válido, dirty->full = 1 */
+void watch_dirty_load(watch_dirty_t *dirty);
+
+/* 1 se `rel`, um diretório acima dele ou algo abaixo dele está em `dirty` */
+int watch_dirty_touches(const watch_dirty_t *dirty, const char *rel);
+
+/*
+ * Registra o token de `dirty` para o índice atual, com os caminhos que ainda
+ * diferem dele. Chamar depois de gravar .clurg/index.
+ */
+int watch_dirty_save(const watch_dirty_t *dirty, const char *const *changed, size_t count);
+
+void watch_dirty_free(watch_dirty_t *dirty);
+
+#endif
@@ -26,22 +26,42 @@ BACKUP_FILE="$BACKUP_DIR/weekly_backup_$TIMESTAMP.tar.gz"
 
 echo "📦 Criando backup: $(basename "$BACKUP_FILE")"
 
-# Criar backup completo (excluindo arquivos temporários)
-tar -czf "$BACKUP_FILE" \
+# Compressor: gzip paralelo do próprio clurg (compress.threads/compress.level
+# do .clurg/config ou CLURG_COMPRESS_*); gzip só sem o binário compilado
+if [ -x "$REPO_DIR/bin/clurg" ]; then
+    COMPRESSOR="$REPO_DIR/bin/clurg compress"
+else
+    COMPRESSOR="gzip"
+fi
+
+# Criar backup completo (excluindo arquivos temporários). Com pipefail uma
+# falha do tar também derruba o pipeline, em vez de deixar um backup truncado
+set -o pipefail
+if ! tar -cf - \
     --exclude='.clurg/backups/*' \
     --exclude='.clurg/logs/*' \
     --exclude='*.tmp' \
     --exclude='*.log' \
     .clurg/ \
-    2>/dev/null
+    2>/dev/null | $COMPRESSOR > "$BACKUP_FILE"; then
+    rm -f "$BACKUP_FILE"
+    echo "❌ Erro: Falha ao criar backup"
+    exit 1
+fi
 
 # Verificar se o backup foi criado com sucesso
 if [ -f "$BACKUP_FILE" ]; then
     BACKUP_SIZE=$(du -h "$BACKUP_FILE" | cut -f1)
     echo "✅ Backup criado com sucesso: $BACKUP_SIZE"
 
-    # Calcular hash do backup para verificação
-    BACKUP_HASH=$(sha256sum "$BACKUP_FILE" | cut -d' ' -f1)
+    # Calcular hash do backup para verificação (clurg hash: SHA-256 em
+    # processo, mesma saída do sha256sum, que fica como alternativa)
+    if [ -x "$REPO_DIR/bin/clurg" ]; then
+        HASHER="$REPO_DIR/bin/clurg hash"
+    else
+        HASHER="sha256sum"
+    fi
+    BACKUP_HASH=$($HASHER "$BACKUP_FILE" | cut -d' ' -f1)
     echo "$BACKUP_HASH  $(basename "$BACKUP_FILE")" > "$BACKUP_FILE.sha256"
 
     # Limpar backups antigos (manter apenas últimos 4 backups semanais)
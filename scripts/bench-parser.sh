@@ -0,0 +1,37 @@
+#!/bin/bash
+
+# bench-parser.sh - Mede o parse de um pipeline grande do clurg-ci
+# Uso: scripts/bench-parser.sh [steps] [repetições]
+#
+# Gera um pipeline com um step "setup" e N shards que dependem dele (padrão
+# 10000), como os gerados para testes em shards, e mostra o melhor tempo de
+# parse de `clurg-ci check`.
+
+set -e
+
+CLURG_ROOT="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+CLURG_CI="$CLURG_ROOT/bin/clurg-ci"
+STEPS="${1:-10000}"
+RUNS="${2:-5}"
+
+if [ ! -x "$CLURG_CI" ]; then
+    echo "❌ $CLURG_CI não encontrado (rode make)"
+    exit 1
+fi
+
+PIPELINE="$(mktemp /tmp/clurg-bench-XXXXXX.ci)"
+trap 'rm -f "$PIPELINE"' EXIT
+
+{
+    echo "# gerado por bench-parser.sh"
+    echo 'pipeline "shards"'
+    echo 'step "setup" { run: "make" }'
+    for i in $(seq "$STEPS"); do
+        echo "step \"shard-$i\" { needs: [\"setup\"] run: \"./run-tests.sh --shard $i --of $STEPS\" }"
+    done
+} > "$PIPELINE"
+
+echo "📊 $STEPS shards, $(du -h "$PIPELINE" | cut -f1) (melhor de $RUNS)"
+for r in $(seq "$RUNS"); do
+    "$CLURG_CI" check "$PIPELINE" | sed -n 's/.*parse em \([0-9.]*\) ms.*/\1/p'
+done | sort -n | head -1 | sed 's/$/ ms/'
@@ -0,0 +1,78 @@
+#!/bin/bash
+
+# bench-workspace.sh - Mede o tempo de setup do workspace do clurg-ci
+# Uso: scripts/bench-workspace.sh [diretório] [repetições]
+#
+# Sem diretório, gera uma árvore sintética (BENCH_FILES arquivos de
+# BENCH_SIZE bytes, padrão 20000 x 16 KiB) num diretório temporário. Para
+# cada estratégia mede um pipeline com um step vazio, dominado pelo setup do
+# workspace (o tempo só do setup também aparece em "Workspace criado em").
+# BASELINE_CI=<binário> inclui outro clurg-ci (ex.: compilado de uma versão
+# anterior) na comparação, como "baseline".
+
+set -e
+
+CLURG_ROOT="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+CLURG_CI="$CLURG_ROOT/bin/clurg-ci"
+RUNS="${2:-3}"
+BENCH_FILES="${BENCH_FILES:-20000}"
+BENCH_SIZE="${BENCH_SIZE:-16384}"
+
+if [ ! -x "$CLURG_CI" ]; then
+    echo "❌ $CLURG_CI não encontrado (rode make)"
+    exit 1
+fi
+
+TREE="$1"
+if [ -z "$TREE" ]; then
+    TREE="$(mktemp -d /tmp/clurg-bench-XXXXXX)"
+    trap 'rm -rf "$TREE"' EXIT
+    echo "🌳 Gerando $BENCH_FILES arquivos de $BENCH_SIZE bytes em $TREE..."
+    mkdir -p "$TREE/.clurg"
+    per_dir=100
+    i=0
+    while [ "$i" -lt "$BENCH_FILES" ]; do
+        dir="$TREE/d$((i / per_dir / 10))/s$((i / per_dir))"
+        mkdir -p "$dir"
+        head -c "$BENCH_SIZE" /dev/urandom > "$dir/f$i"
+        i=$((i + 1))
+    done
+fi
+
+PIPELINE="$(mktemp /tmp/clurg-bench-XXXXXX.ci)"
+trap 'rm -f "$PIPELINE"; [ -z "$1" ] && rm -rf "$TREE"' EXIT
+printf 'pipeline "bench"\nstep "noop" { run: "true" }\n' > "$PIPELINE"
+
+# Melhor de $RUNS execuções do pipeline inteiro (setup + step vazio +
+# limpeza), em ms: compara também binários que não imprimem o tempo de setup
+measure() {
+    local bin="$1"
+    shift
+    local best=""
+    local r t0 t1 ms
+    for r in $(seq "$RUNS"); do
+        sync # não cobrar o writeback da execução anterior desta
+        t0=$(date +%s%N)
+        if ! (cd "$TREE" && env "$@" "$bin" run "$PIPELINE" >/dev/null 2>&1); then
+            echo "-"
+            return
+        fi
+        t1=$(date +%s%N)
+        ms=$(((t1 - t0) / 1000000))
+        if [ -z "$best" ] || [ "$ms" -lt "$best" ]; then
+            best="$ms"
+        fi
+    done
+    echo "$best"
+}
+
+echo "📊 Pipeline vazio (melhor de $RUNS, ms) - $(du -sh --exclude=.clurg "$TREE" | cut -f1) em $TREE"
+printf '%-22s %10s\n' "estratégia" "ms"
+if [ -n "$BASELINE_CI" ]; then
+    printf '%-22s %10s\n' "baseline" "$(measure "$BASELINE_CI")"
+fi
+printf '%-22s %10s\n' "copy, 1 thread" "$(measure "$CLURG_CI" CLURG_CI_WORKSPACE=copy CLURG_CI_COPY_THREADS=1)"
+printf '%-22s %10s\n' "copy, paralelo" "$(measure "$CLURG_CI" CLURG_CI_WORKSPACE=copy)"
+printf '%-22s %10s\n' "reflink" "$(measure "$CLURG_CI" CLURG_CI_WORKSPACE=reflink)"
+printf '%-22s %10s\n' "hardlink" "$(measure "$CLURG_CI" CLURG_CI_WORKSPACE=hardlink)"
+printf '%-22s %10s\n' "overlay" "$(measure "$CLURG_CI" CLURG_CI_WORKSPACE=overlay)"
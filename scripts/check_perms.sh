@@ -5,12 +5,14 @@
 echo "=== Verificação de Permissões Clurg ==="
 
 # Verificar se scripts são executáveis
-if [ ! -x "scripts/commit.sh" ]; then
-    echo "❌ scripts/commit.sh não é executável"
-    echo "   Execute: chmod +x scripts/commit.sh"
-else
-    echo "✅ scripts/commit.sh executável"
-fi
+for script in scripts/*.sh; do
+    if [ ! -x "$script" ]; then
+        echo "❌ $script não é executável"
+        echo "   Execute: chmod +x $script"
+    else
+        echo "✅ $script executável"
+    fi
+done
 
 # Verificar binários
 for bin in bin/clurg bin/clurg-ci bin/clurg-web; do
@@ -74,24 +74,18 @@ cleanup_backups() {
         return
     fi
 
-    local to_remove=$((backup_count - KEEP_BACKUPS))
-    local removed=0
-    local space_saved=0
-
-    log "Removing $to_remove oldest backups"
-
-    # Remover backups mais antigos (ordenados por data)
-    ls -t "$BACKUP_DIR"/backup-*.tar.gz | tail -n "$to_remove" | while read -r backup; do
-        if [ -f "$backup" ]; then
-            local size_mb=$(du -m "$backup" | cut -f1)
-            log "Removing backup: $(basename "$backup") (${size_mb}MB)"
-            rm -f "$backup"
-            removed=$((removed + 1))
-            space_saved=$((space_saved + size_mb))
-        fi
-    done
+    log "Removing $((backup_count - KEEP_BACKUPS)) oldest backups"
+
+    # clurg gc apaga os backups excedentes junto com commits e objetos inalcançáveis
+    if [ -x "$CLURG_ROOT/bin/clurg" ]; then
+        (cd "$CLURG_ROOT" && bin/clurg gc --auto --keep-backups "$KEEP_BACKUPS") >>"$LOG_FILE" 2>&1 \
+            || log "clurg gc failed"
+    else
+        ls -t "$BACKUP_DIR"/backup-*.tar.gz | tail -n +$((KEEP_BACKUPS + 1)) | xargs rm -f
+    fi
 
-    log "Backup cleanup: removed $removed files, saved ${space_saved}MB"
+    local remaining=$(ls -1 "$BACKUP_DIR"/backup-*.tar.gz 2>/dev/null | wc -l)
+    log "Backup cleanup: $remaining backups remaining"
 }
 
 # Limpar logs antigos
@@ -16,17 +16,15 @@ if [ ! -d ".clurg" ]; then
     exit 1
 fi
 
-# 2. Limpeza profunda de commits muito antigos (90 dias)
+# 2. Limpeza profunda de commits muito antigos (90 dias) e dos objetos
+#    que só eles referenciavam. Sem orçamento: roda até o fim.
 echo "🧹 Executando limpeza profunda..."
-COMMITS_DIR=".clurg/commits"
 DEEP_CLEAN_DAYS=90
 
-if [ -d "$COMMITS_DIR" ]; then
-    find "$COMMITS_DIR" -name "*.tar.gz" -mtime +$DEEP_CLEAN_DAYS -print | while read -r old_commit; do
-        base_name=$(basename "$old_commit" .tar.gz)
-        echo "🗑️ Removendo commit muito antigo: $base_name"
-        rm -f "$COMMITS_DIR/$base_name.tar.gz" "$COMMITS_DIR/$base_name.meta" "$COMMITS_DIR/$base_name.metadata.json"
-    done
+if [ -x "$REPO_DIR/bin/clurg" ]; then
+    "$REPO_DIR/bin/clurg" gc --keep-days "$DEEP_CLEAN_DAYS" || echo "⚠️ clurg gc falhou"
+else
+    echo "⚠️ bin/clurg não encontrado - limpeza profunda ignorada"
 fi
 
 # 3. Limpeza de backups antigos (manter apenas 30 dias)
@@ -40,7 +38,13 @@ fi
 echo "🔍 Verificando integridade geral..."
 INTEGRITY_FILE=".clurg/integrity.txt"
 if [ -f "$INTEGRITY_FILE" ]; then
-    if ! sha256sum -c "$INTEGRITY_FILE" --quiet 2>/dev/null; then
+    # clurg hash -c confere a lista inteira num só processo (multi-buffer)
+    if [ -x "$REPO_DIR/bin/clurg" ]; then
+        HASHER="$REPO_DIR/bin/clurg hash"
+    else
+        HASHER="sha256sum"
+    fi
+    if ! $HASHER -c "$INTEGRITY_FILE" --quiet 2>/dev/null; then
         echo "⚠️ ALERTA: Integridade comprometida! Arquivos modificados fora do VCS"
         # Em produção, poderia enviar notificação
     else
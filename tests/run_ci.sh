@@ -0,0 +1,524 @@
+#!/bin/bash
+# Testes do clurg-ci (parser, executor, workspaces, cache, logs)
+# Cada seção roda num projeto descartável em /tmp
+
+set -e  # Parar em caso de erro
+
+# Cores para output
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+YELLOW='\033[1;33m'
+NC='\033[0m' # No Color
+
+# Diretório do projeto
+PROJECT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+CLURG="$PROJECT_DIR/bin/clurg"
+CLURG_CI="$PROJECT_DIR/bin/clurg-ci"
+cd "$PROJECT_DIR"
+
+echo "=========================================="
+echo "Testes do clurg-ci"
+echo "=========================================="
+echo ""
+
+# Contador de testes
+TESTS_PASSED=0
+TESTS_FAILED=0
+TESTS_SKIPPED=0
+
+# Função para testar
+test_check() {
+    local name="$1"
+    local command="$2"
+
+    echo -n "Teste: $name ... "
+    if eval "$command" > /tmp/clurg_test_output 2>&1; then
+        echo -e "${GREEN}OK${NC}"
+        TESTS_PASSED=$((TESTS_PASSED + 1))
+        return 0
+    else
+        echo -e "${RED}FALHOU${NC}"
+        echo "Saída:"
+        cat /tmp/clurg_test_output | head -10
+        TESTS_FAILED=$((TESTS_FAILED + 1))
+        return 1
+    fi
+}
+
+# Função para pular teste
+test_skip() {
+    local name="$1"
+    local reason="$2"
+
+    echo -e "Teste: $name ... ${YELLOW}PULADO${NC} ($reason)"
+    TESTS_SKIPPED=$((TESTS_SKIPPED + 1))
+}
+
+# Projeto clurg novo e vazio em /tmp; o diretório atual passa a ser ele
+new_project() {
+    PROJECT="/tmp/clurg_ci_$$_$1"
+    rm -rf "$PROJECT"
+    mkdir -p "$PROJECT"
+    cd "$PROJECT"
+    "$CLURG" init > /dev/null 2>&1
+}
+
+# Script executável `$1` com o conteúdo de stdin
+script() {
+    cat > "$1"
+    chmod +x "$1"
+}
+
+# Executa o pipeline `$1`; a saída fica em ci.out e o código de saída em RUN_RC
+run_ci() {
+    RUN_RC=0
+    "$CLURG_CI" run "$@" > ci.out 2>&1 || RUN_RC=$?
+}
+
+# Limpar testes anteriores
+cleanup() {
+    rm -f /tmp/clurg_test_output
+    rm -rf /tmp/clurg_ci_$$_*
+}
+
+trap cleanup EXIT
+
+test_check "Binários existem" "[ -x '$CLURG' ] && [ -x '$CLURG_CI' ]"
+echo ""
+
+echo "1. Workspaces (CLURG_CI_WORKSPACE)"
+echo "----------------------------------------"
+new_project workspace
+mkdir -p sub
+echo "hello" > sub/data.txt
+echo "ignorado" > skip.log
+echo "*.log" > .clurgignore
+# Confere o conteúdo e só cria arquivo novo: no modo hardlink, escrever num
+# arquivo existente alteraria o repositório
+script check.sh <<'EOF'
+#!/bin/sh
+[ "$(cat sub/data.txt)" = hello ] && [ ! -e skip.log ] && [ ! -e .clurg ] && echo novo > sub/novo.txt
+EOF
+printf 'pipeline "ws"\n\nstep "check" {\n  run: "./check.sh"\n}\n' > ws.ci
+for strategy in overlay reflink hardlink copy warm; do
+    CLURG_CI_WORKSPACE=$strategy run_ci ws.ci
+    test_check "Workspace $strategy tem o repositório sem os ignorados" "[ $RUN_RC -eq 0 ]"
+done
+test_check "Steps não alteram o repositório" "[ ! -e sub/novo.txt ] && [ \"\$(cat sub/data.txt)\" = hello ]"
+cd "$PROJECT_DIR"
+echo ""
+
+echo "2. Cache de resultados dos steps"
+echo "----------------------------------------"
+new_project cache
+mkdir -p src
+echo "v1" > src/input.txt
+# Conta as execuções reais num arquivo fora do workspace
+script build.sh <<EOF
+#!/bin/sh
+echo x >> "$PROJECT/runs"
+cat src/input.txt > out.txt
+EOF
+cat > cache.ci <<'EOF'
+pipeline "cache"
+
+step "build" {
+  inputs: ["src/", "build.sh"]
+  outputs: ["out.txt"]
+  run: "./build.sh"
+}
+
+step "check" {
+  run: "grep -q v out.txt"
+}
+EOF
+# As mensagens do cache saem na saída do step: CLURG_CI_STREAM as traz para ci.out
+export CLURG_CI_STREAM=1
+run_ci cache.ci
+test_check "Primeira execução roda o step e guarda o resultado" \
+    "[ $RUN_RC -eq 0 ] && grep -q 'cache: guardado' ci.out && [ \$(wc -l < runs) -eq 1 ]"
+run_ci cache.ci
+test_check "Segunda execução é hit e restaura os outputs" \
+    "[ $RUN_RC -eq 0 ] && grep -q 'cache: hit' ci.out && [ \$(wc -l < runs) -eq 1 ]"
+echo "v2" > src/input.txt
+run_ci cache.ci
+test_check "Input alterado invalida o cache" \
+    "[ $RUN_RC -eq 0 ] && ! grep -q 'cache: hit' ci.out && [ \$(wc -l < runs) -eq 2 ]"
+CLURG_CI_CACHE=0 run_ci cache.ci
+test_check "CLURG_CI_CACHE=0 desliga o cache" \
+    "[ $RUN_RC -eq 0 ] && ! grep -q 'cache:' ci.out && [ \$(wc -l < runs) -eq 3 ]"
+# Entrada sem o outputs.tar de um step com outputs: não pode ser hit
+rm -f .clurg/ci/cache/*/*/outputs.tar
+run_ci cache.ci
+test_check "Entrada sem outputs.tar roda o step de novo" \
+    "[ $RUN_RC -eq 0 ] && grep -q 'inválida' ci.out && grep -q 'cache: guardado' ci.out && [ \$(wc -l < runs) -eq 4 ]"
+run_ci cache.ci
+test_check "Entrada regravada volta a ser hit" \
+    "[ $RUN_RC -eq 0 ] && grep -q 'cache: hit' ci.out && [ \$(wc -l < runs) -eq 4 ]"
+unset CLURG_CI_STREAM
+cd "$PROJECT_DIR"
+echo ""
+
+echo "3. Cópia paralela do workspace"
+echo "----------------------------------------"
+new_project copy
+for d in 1 2 3 4 5 6; do
+    mkdir -p "tree/d$d/sub"
+    for f in 1 2 3 4 5; do
+        seq "$d$f" > "tree/d$d/f$f.txt"
+        head -c $((d * f * 1000)) /dev/urandom > "tree/d$d/sub/b$f.bin"
+    done
+done
+head -c 3000000 /dev/urandom > tree/grande.bin
+ln -s d1/f1.txt tree/link.txt
+printf '#!/bin/sh\nexit 0\n' > tree/exec.sh
+chmod +x tree/exec.sh
+(cd tree && find -L . -type f -exec sha256sum {} + | sort -k2 > ../sums)
+# O step confere hashes e bit de execução da cópia; symlinks são seguidos,
+# então link.txt chega com o conteúdo do alvo
+script verify.sh <<'EOF'
+#!/bin/sh
+cd tree && find -L . -type f -exec sha256sum {} + | sort -k2 | cmp -s - ../sums &&
+    cmp -s link.txt d1/f1.txt && [ -x exec.sh ]
+EOF
+printf 'pipeline "copy"\n\nstep "verify" {\n  run: "./verify.sh"\n}\n' > copy.ci
+CLURG_CI_WORKSPACE=copy CLURG_CI_COPY_THREADS=4 run_ci copy.ci
+test_check "Cópia com 4 threads reproduz conteúdo e modos" \
+    "[ $RUN_RC -eq 0 ] && grep -q '(copy,' ci.out"
+CLURG_CI_WORKSPACE=copy CLURG_CI_COPY_THREADS=1 run_ci copy.ci
+test_check "Cópia com 1 thread reproduz conteúdo e modos" "[ $RUN_RC -eq 0 ]"
+mkdir -p deep/dir
+cd deep/dir
+CLURG_CI_WORKSPACE=copy run_ci ../../copy.ci
+test_check "clurg-ci acha a raiz do projeto a partir de um subdiretório" \
+    "[ $RUN_RC -eq 0 ] && ls '$PROJECT'/.clurg/ci/logs/*.log"
+cd "$PROJECT_DIR"
+echo ""
+
+echo "4. Dependências (needs) e fail-fast"
+echo "----------------------------------------"
+new_project needs
+# Cada step anota o próprio nome num arquivo fora do workspace
+script mark.sh <<EOF
+#!/bin/sh
+sleep 0.2
+echo "\$1" >> "$PROJECT/order"
+EOF
+cat > order.ci <<'EOF'
+pipeline "order"
+
+step "first" {
+  run: "./mark.sh first"
+}
+
+step "left" {
+  needs: ["first"]
+  run: "./mark.sh left"
+}
+
+step "right" {
+  needs: ["first"]
+  run: "./mark.sh right"
+}
+
+step "last" {
+  needs: ["left", "right"]
+  run: "./mark.sh last"
+}
+EOF
+run_ci -j 2 order.ci
+test_check "Steps rodam depois dos needs" \
+    "[ $RUN_RC -eq 0 ] && [ \"\$(head -1 order)\" = first ] && [ \"\$(tail -1 order)\" = last ] && [ \$(wc -l < order) -eq 4 ]"
+
+# Irmão que ignora SIGTERM: só o SIGKILL depois do prazo o derruba
+script stubborn.sh <<'EOF'
+#!/bin/sh
+trap '' TERM
+sleep 60
+EOF
+script fail.sh <<'EOF'
+#!/bin/sh
+sleep 0.5
+exit 3
+EOF
+cat > failfast.ci <<'EOF'
+pipeline "failfast"
+
+step "stubborn" {
+  run: "./stubborn.sh"
+}
+
+step "fail" {
+  needs: []
+  run: "./fail.sh"
+}
+
+step "after" {
+  needs: ["fail"]
+  run: "./mark.sh after"
+}
+EOF
+rm -f order
+START=$(date +%s)
+run_ci -j 2 failfast.ci
+ELAPSED=$(($(date +%s) - START))
+test_check "Falha de um step cancela os irmãos, mesmo os que ignoram SIGTERM" \
+    "[ $RUN_RC -ne 0 ] && [ $ELAPSED -lt 30 ] && grep -q 'Step cancelado: stubborn' ci.out"
+test_check "Dependentes do step que falhou não rodam" \
+    "grep -q 'Step não executado: after' ci.out && [ ! -e order ]"
+
+# Comando vazio: o step falha antes do fork e também derruba o irmão
+sed -e 's|"./fail.sh"|" "|' failfast.ci > spawn.ci
+START=$(date +%s)
+run_ci -j 2 spawn.ci
+ELAPSED=$(($(date +%s) - START))
+test_check "Falha ao iniciar um step cancela os irmãos" \
+    "[ $RUN_RC -ne 0 ] && [ $ELAPSED -lt 30 ] && grep -q 'Step cancelado: stubborn' ci.out"
+cd "$PROJECT_DIR"
+echo ""
+
+echo "5. Pool de workspaces warm"
+echo "----------------------------------------"
+new_project warm
+echo "v1" > src.c
+echo "x" > extra.txt
+# Registros fora do projeto, para o sync não levá-los ao workspace
+OUT="/tmp/clurg_ci_$$_warm_out"
+mkdir -p "$OUT"
+# "Compila" só quando a saída falta ou é mais velha que a fonte, como o make
+script build.sh <<EOF
+#!/bin/sh
+if [ ! -e out.o ] || [ src.c -nt out.o ]; then
+    cp src.c out.o
+    echo x >> "$OUT/builds"
+fi
+cat src.c > "$OUT/last"
+ls > "$OUT/listing"
+EOF
+printf 'pipeline "warm"\n\nstep "build" {\n  run: "./build.sh"\n}\n' > warm.ci
+# Mesmo pipeline (mesmo pool), mas o step estraga uma fonte no workspace
+printf 'pipeline "warm"\n\nstep "break" {\n  run: "./break.sh"\n}\n' > break.ci
+printf '#!/bin/sh\necho estragado > src.c\n' | script break.sh
+run_ci --warm warm.ci
+test_check "Primeira execução warm compila" \
+    "[ $RUN_RC -eq 0 ] && grep -q '(warm' ci.out && [ \$(wc -l < '$OUT/builds') -eq 1 ] && [ -d .clurg/ci/workspaces/warm ]"
+run_ci --warm warm.ci
+test_check "Saídas do build ficam no workspace entre execuções" \
+    "[ $RUN_RC -eq 0 ] && [ \$(wc -l < '$OUT/builds') -eq 1 ]"
+echo "v2" > src.c
+rm extra.txt
+run_ci --warm warm.ci
+test_check "Fonte alterada no repositório é sincronizada e recompilada" \
+    "[ $RUN_RC -eq 0 ] && [ \$(wc -l < '$OUT/builds') -eq 2 ] && [ \"\$(cat '$OUT/last')\" = v2 ]"
+test_check "Arquivo apagado do repositório sai do workspace" \
+    "! grep -qx extra.txt '$OUT/listing' && grep -qx out.o '$OUT/listing'"
+run_ci --warm break.ci
+run_ci --warm warm.ci
+test_check "Fonte alterada no workspace volta ao conteúdo do repositório" \
+    "[ $RUN_RC -eq 0 ] && [ \"\$(cat '$OUT/last')\" = v2 ]"
+test_check "Repositório não é alterado pelo workspace warm" "[ \"\$(cat src.c)\" = v2 ] && [ ! -e out.o ]"
+cd "$PROJECT_DIR"
+echo ""
+
+echo "6. Parser de pipelines"
+echo "----------------------------------------"
+new_project parser
+# Mais steps e comandos maiores que os antigos MAX_STEPS/MAX_COMMAND
+{
+    echo 'pipeline "grande" # comentário'
+    for n in $(seq 1 300); do
+        printf '\nstep "s%d" {\n  run: "true' "$n"
+        for a in $(seq 1 200); do printf ' arg%d' "$a"; done
+        printf '"\n}\n'
+    done
+} > big.ci
+test_check "check aceita 300 steps com comandos longos" \
+    "'$CLURG_CI' check big.ci | grep -q '300 steps'"
+run_ci -j 8 big.ci
+test_check "Pipeline grande executa todos os steps" "[ $RUN_RC -eq 0 ] && [ \$(grep -c 'Executando step' ci.out) -eq 300 ]"
+printf 'pipeline "x"\n\nstep "a" {\n  run: "true"\n  bogus: "x"\n}\n' > key.ci
+printf 'pipeline "x"\n\nstep "a" {\n  run: "true\n}\n' > string.ci
+printf 'pipeline "x"\n\nstep "a" {\n  needs: ["zz"]\n  run: "true"\n}\n' > needs.ci
+test_check "Chave desconhecida sai com arquivo e linha" "! '$CLURG_CI' check key.ci && '$CLURG_CI' check key.ci 2>&1 | grep -q '^key.ci:5: '"
+test_check "String não fechada sai com arquivo e linha" "'$CLURG_CI' check string.ci 2>&1 | grep -q '^string.ci:4: '"
+test_check "needs de step inexistente é recusado" "! '$CLURG_CI' check needs.ci && '$CLURG_CI' check needs.ci 2>&1 | grep -q \"needs desconhecido 'zz'\""
+test_check "run não executa pipeline inválido" "! '$CLURG_CI' run key.ci"
+cd "$PROJECT_DIR"
+echo ""
+
+echo "7. Recursos por step nos logs"
+echo "----------------------------------------"
+new_project stats
+printf '#!/bin/sh\nhead -c 300000000 /dev/zero | sha256sum > /dev/null\n' | script cpu.sh
+printf '#!/bin/sh\ndd if=/dev/zero of=/dev/null bs=64M count=1 2> /dev/null\n' | script mem.sh
+printf '#!/bin/sh\nsleep 0.3\nexit 4\n' | script slow.sh
+cat > stats.ci <<'EOF'
+pipeline "stats"
+
+step "cpu" {
+  run: "./cpu.sh"
+}
+
+step "mem" {
+  run: "./mem.sh"
+}
+
+step "slow" {
+  run: "./slow.sh"
+}
+EOF
+run_ci stats.ci
+LOG=$(ls .clurg/ci/logs/*.log | tail -1)
+test_check "Linha do log traz tempo, CPU e memória" \
+    "[ $RUN_RC -ne 0 ] && grep -q 'cpu: OK \[[0-9.]*s, cpu [0-9.]*s+[0-9.]*s, rss ' '$LOG'"
+if command -v python3 > /dev/null 2>&1; then
+    test_check "JSON ao lado do log tem os recursos de cada step" "python3 - '${LOG%.log}.json' <<'EOF'
+import json, sys
+steps = {s['name']: s for s in json.load(open(sys.argv[1]))['steps']}
+assert steps['cpu']['user_s'] + steps['cpu']['sys_s'] > 0.05, steps['cpu']
+assert steps['mem']['max_rss_kb'] > 60000, steps['mem']
+assert steps['slow']['wall_s'] >= 0.3 and steps['slow']['exit_code'] == 4, steps['slow']
+assert steps['slow']['status'] == 'fail'
+EOF"
+else
+    test_skip "JSON ao lado do log tem os recursos de cada step" "python3 não instalado"
+fi
+cd "$PROJECT_DIR"
+echo ""
+
+echo "8. Saída dos steps"
+echo "----------------------------------------"
+new_project output
+printf '#!/bin/sh\nseq 1 500000\necho erro no fim >&2\nexit 1\n' | script loud.sh
+printf '#!/bin/sh\nfor n in 1 2 3 4 5; do echo "$1 $n"; sleep 0.05; done\n' | script talk.sh
+# Um processo em segundo plano herda o pipe e continua escrevendo nele
+printf '#!/bin/sh\n(sleep 3; echo tarde) &\necho pronto\n' | script bg.sh
+cat > talk.ci <<'EOF'
+pipeline "talk"
+
+step "a" {
+  run: "./talk.sh a"
+}
+
+step "b" {
+  needs: []
+  run: "./talk.sh b"
+}
+
+step "bg" {
+  needs: []
+  run: "./bg.sh"
+}
+
+step "loud" {
+  needs: ["a", "b", "bg"]
+  run: "./loud.sh"
+}
+EOF
+START=$(date +%s)
+run_ci -j 4 talk.ci
+ELAPSED=$(($(date +%s) - START))
+DIR=$(ls -d .clurg/ci/logs/ci_*/ | tail -1)
+test_check "Log do step guarda a saída inteira, stdout e stderr" \
+    "{ seq 1 500000; echo erro no fim; } | cmp -s - '$DIR/loud.log'"
+test_check "Steps paralelos têm logs separados" \
+    "[ \$(grep -c '^a ' '$DIR/a.log') -eq 5 ] && ! grep -q '^b ' '$DIR/a.log' && [ \$(grep -c '^b ' '$DIR/b.log') -eq 5 ]"
+test_check "Falha mostra só o fim da saída" \
+    "grep -q '^--- saída de loud (fim, [0-9]* bytes no total) ---\$' ci.out && grep -qx 'erro no fim' ci.out && grep -qx 499982 ci.out && ! grep -qx 499981 ci.out"
+test_check "Processo em segundo plano não segura o pipeline" "[ $ELAPSED -lt 3 ] && grep -qx pronto '$DIR/bg.log'"
+CLURG_CI_STREAM=1 run_ci -j 4 talk.ci
+test_check "CLURG_CI_STREAM=1 mostra a saída ao vivo" "grep -q 'a 5' ci.out && grep -q 'b 5' ci.out"
+cd "$PROJECT_DIR"
+echo ""
+
+echo "9. Log de eventos JSONL"
+echo "----------------------------------------"
+new_project events
+printf '#!/bin/sh\nexit 2\n' | script fail.sh
+# Muitos steps curtos em paralelo, uma falha e um dependente não executado
+{
+    echo 'pipeline "events"'
+    for n in $(seq 1 100); do
+        printf '\nstep "s%d" {\n  needs: []\n  run: "true"\n}\n' "$n"
+    done
+    printf '\nstep "fail" {\n  needs: ["s100"]\n  run: "./fail.sh"\n}\n'
+    printf '\nstep "after" {\n  needs: ["fail"]\n  run: "true"\n}\n'
+} > events.ci
+run_ci -j 8 events.ci
+JSONL=$(ls .clurg/ci/logs/*.jsonl | tail -1)
+if command -v python3 > /dev/null 2>&1; then
+    test_check "Eventos são JSON válido, em ordem e completos" "[ $RUN_RC -ne 0 ] && python3 - '$JSONL' <<'EOF'
+import json, sys
+events = [json.loads(line) for line in open(sys.argv[1])]
+times = [e['t_ns'] for e in events]
+assert times == sorted(times), 't_ns fora de ordem'
+assert events[0]['event'] == 'pipeline_start' and events[0]['steps'] == 102
+assert events[-1]['event'] == 'pipeline_end' and events[-1]['status'] == 'fail'
+started = set()
+ended = {}
+for e in events[1:-1]:
+    if e['event'] == 'step_start':
+        started.add(e['step'])
+    elif e['event'] == 'step_end':
+        assert e['step'] not in ended, 'step_end repetido'
+        assert e['status'] == 'skipped' or e['step'] in started, 'step_end sem step_start'
+        ended[e['step']] = e['status']
+assert len(ended) == 102, len(ended)
+assert ended['fail'] == 'fail' and ended['after'] == 'skipped' and ended['s1'] == 'ok'
+EOF"
+else
+    test_skip "Eventos são JSON válido, em ordem e completos" "python3 não instalado"
+fi
+cd "$PROJECT_DIR"
+echo ""
+
+echo "10. Pipelines com matrix"
+echo "----------------------------------------"
+new_project matrix
+CELLS="/tmp/clurg_ci_$$_cells"
+script cell.sh <<EOF
+#!/bin/sh
+echo "\$CC \$MODE" >> "$CELLS"
+sleep 1
+[ "\$CC" != bad ]
+EOF
+cat > matrix.ci <<'EOF'
+pipeline "matrix"
+
+matrix {
+  CC: ["gcc", "clang", "bad"]
+  MODE: ["debug", "release"]
+}
+
+step "build" {
+  run: "./cell.sh"
+}
+EOF
+test_check "check conta as combinações" "'$CLURG_CI' check matrix.ci | grep -q 'Matrix: 6 combinações'"
+START=$(date +%s)
+run_ci -j 6 matrix.ci
+ELAPSED=$(($(date +%s) - START))
+test_check "Cada combinação roda uma vez com o seu ambiente" \
+    "[ \$(sort -u '$CELLS' | wc -l) -eq 6 ] && [ \$(wc -l < '$CELLS') -eq 6 ] && grep -qx 'clang release' '$CELLS'"
+test_check "Combinações rodam em paralelo" "[ $ELAPSED -lt 4 ]"
+test_check "Resumo aponta as combinações que falharam" \
+    "[ $RUN_RC -ne 0 ] && grep -q 'Resumo da matrix (4/6 ok' ci.out && grep -q 'FAIL  CC=bad MODE=debug' ci.out && grep -q 'OK    CC=gcc MODE=release' ci.out"
+test_check "Cada combinação tem o seu log" "[ \$(ls .clurg/ci/logs/*.log | wc -l) -eq 6 ]"
+cd "$PROJECT_DIR"
+echo ""
+
+echo "=========================================="
+echo "Resumo dos Testes do clurg-ci"
+echo "=========================================="
+echo -e "Testes passaram: ${GREEN}$TESTS_PASSED${NC}"
+echo -e "Testes falharam: ${RED}$TESTS_FAILED${NC}"
+echo -e "Testes pulados: ${YELLOW}$TESTS_SKIPPED${NC}"
+echo ""
+
+if [ $TESTS_FAILED -eq 0 ]; then
+    echo -e "${GREEN}✓ Todos os testes do clurg-ci passaram!${NC}"
+    exit 0
+else
+    echo -e "${RED}✗ Alguns testes falharam${NC}"
+    exit 1
+fi
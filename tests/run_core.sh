@@ -0,0 +1,547 @@
+#!/bin/bash
+# Testes do núcleo do Clurg (clurg commit, log, checkout, gc...)
+# Cada seção roda num repositório descartável em /tmp
+
+set -e  # Parar em caso de erro
+
+# Cores para output
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+YELLOW='\033[1;33m'
+NC='\033[0m' # No Color
+
+# Diretório do projeto
+PROJECT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+CLURG="$PROJECT_DIR/bin/clurg"
+cd "$PROJECT_DIR"
+
+echo "=========================================="
+echo "Testes do Núcleo do Clurg"
+echo "=========================================="
+echo ""
+
+# Contador de testes
+TESTS_PASSED=0
+TESTS_FAILED=0
+TESTS_SKIPPED=0
+
+# Função para testar
+test_check() {
+    local name="$1"
+    local command="$2"
+
+    echo -n "Teste: $name ... "
+    if eval "$command" > /tmp/clurg_test_output 2>&1; then
+        echo -e "${GREEN}OK${NC}"
+        TESTS_PASSED=$((TESTS_PASSED + 1))
+        return 0
+    else
+        echo -e "${RED}FALHOU${NC}"
+        echo "Saída:"
+        cat /tmp/clurg_test_output | head -10
+        TESTS_FAILED=$((TESTS_FAILED + 1))
+        return 1
+    fi
+}
+
+# Função para pular teste
+test_skip() {
+    local name="$1"
+    local reason="$2"
+
+    echo -e "Teste: $name ... ${YELLOW}PULADO${NC} ($reason)"
+    TESTS_SKIPPED=$((TESTS_SKIPPED + 1))
+}
+
+# Repositório novo e vazio em /tmp; o diretório atual passa a ser ele
+new_repo() {
+    REPO="/tmp/clurg_core_$$_$1"
+    rm -rf "$REPO"
+    mkdir -p "$REPO"
+    cd "$REPO"
+    "$CLURG" init > /dev/null 2>&1
+}
+
+# Commit silencioso; a saída fica em /tmp/clurg_core_commit
+commit() {
+    "$CLURG" commit "$1" > /tmp/clurg_core_commit 2>&1
+}
+
+head_id() {
+    cat .clurg/HEAD
+}
+
+# Limpar testes anteriores
+cleanup() {
+    rm -f /tmp/clurg_test_output /tmp/clurg_core_commit
+    rm -rf /tmp/clurg_core_$$_*
+}
+
+trap cleanup EXIT
+
+test_check "Binário existe" "[ -x '$CLURG' ]"
+echo ""
+
+echo "1. Ids de commit"
+echo "----------------------------------------"
+new_repo ids
+echo "um" > a.txt
+commit "c1"
+echo "dois" > a.txt
+commit "c2"
+echo "três" > a.txt
+commit "c3"
+# Três commits seguidos costumam cair no mesmo segundo: o sufixo os separa
+test_check "Commits seguidos têm ids distintos" \
+    "[ \$(ls .clurg/commits/*.meta | wc -l) -eq 3 ]"
+test_check "Nenhum commit é pai de si mesmo" \
+    "! grep -l \"^parent: \$(head_id)\$\" .clurg/commits/\$(head_id).meta"
+test_check "clurg log não repete ids" \
+    "[ -z \"\$('$CLURG' log | grep '^Commit:' | sort | uniq -d)\" ] && [ \$('$CLURG' log | grep -c '^Commit:') -eq 3 ]"
+test_check "Ordem dos ids segue a ordem dos commits" \
+    "'$CLURG' log | sed -n 's/^Commit: //p' > ids && LC_ALL=C sort -r ids | cmp -s - ids && [ \"\$(head -1 ids)\" = \"\$(head_id)\" ]"
+cd "$PROJECT_DIR"
+echo ""
+
+echo "2. Checkout"
+echo "----------------------------------------"
+new_repo checkout
+echo "v1" > a.txt
+mkdir -p dir && echo "só no primeiro" > dir/old.txt
+commit "primeiro"
+FIRST=$(head_id)
+echo "v2" > a.txt
+rm -rf dir
+echo "novo" > b.txt
+commit "segundo"
+LAST=$(head_id)
+"$CLURG" checkout "$FIRST" > /tmp/clurg_core_checkout 2>&1
+test_check "Checkout restaura o commit antigo" \
+    "[ \"\$(cat a.txt)\" = v1 ] && [ -f dir/old.txt ] && [ ! -e b.txt ] && [ \"\$(head_id)\" = '$FIRST' ]"
+test_check "Ponta anterior fica em .clurg/refs/tips" "grep -qx '$LAST' .clurg/refs/tips"
+"$CLURG" checkout "$LAST" > /tmp/clurg_core_checkout 2>&1
+test_check "Checkout de volta restaura a ponta" \
+    "[ \"\$(cat a.txt)\" = v2 ] && [ ! -e dir ] && [ -f b.txt ] && [ \"\$(head_id)\" = '$LAST' ]"
+test_check "Status limpo depois do checkout" "'$CLURG' status | grep -q 'Nenhuma alteração'"
+echo "local" > a.txt
+test_check "Alterações locais bloqueiam o checkout" "! '$CLURG' checkout '$FIRST' && [ \"\$(cat a.txt)\" = local ]"
+rm -f /tmp/clurg_core_checkout
+cd "$PROJECT_DIR"
+echo ""
+
+echo "3. Coleta de lixo (clurg gc)"
+echo "----------------------------------------"
+new_repo gc
+for n in 1 2 3; do
+    echo "versão $n" > a.txt
+    echo "arquivo $n" > "f$n.txt"
+    commit "c$n"
+done
+LAST=$(head_id)
+FIRST=$("$CLURG" log | sed -n 's/^Commit: //p' | tail -1)
+"$CLURG" checkout "$FIRST" > /dev/null 2>&1
+# Envelhecer tudo além de gc.grace para o gc poder apagar de fato
+find .clurg/commits .clurg/objects -type f -exec touch -d '2 hours ago' {} +
+test_check "gc sem retenção mantém os commits após checkout antigo" \
+    "'$CLURG' gc && [ \$(ls .clurg/commits/*.meta | wc -l) -eq 3 ]"
+test_check "gc --auto do hook mantém os commits mais novos" \
+    "'$CLURG' gc --auto --keep-commits 50 --keep-days 30 && [ \$(ls .clurg/commits/*.meta | wc -l) -eq 3 ]"
+test_check "Retenção explícita vale por linha de histórico" \
+    "'$CLURG' gc --keep-commits 1 && [ -f .clurg/commits/$FIRST.meta ] && [ -f .clurg/commits/$LAST.meta ] && [ \$(ls .clurg/commits/*.meta | wc -l) -eq 2 ]"
+test_check "Checkout da ponta após gc restaura os arquivos" \
+    "'$CLURG' checkout '$LAST' && [ \"\$(cat a.txt)\" = 'versão 3' ] && [ -f f2.txt ] && [ -f f3.txt ]"
+cd "$PROJECT_DIR"
+echo ""
+
+echo "4. Trees maliciosas"
+echo "----------------------------------------"
+# Grava uma tree crua (stdin) no object store do diretório atual e imprime o hash
+write_tree_object() {
+    python3 -c '
+import hashlib, os, sys, zlib
+data = sys.stdin.buffer.read()
+h = hashlib.sha256(data).hexdigest()
+os.makedirs(".clurg/objects/" + h[:2], exist_ok=True)
+with open(".clurg/objects/%s/%s" % (h[:2], h[2:]), "wb") as f:
+    f.write(b"tree %d\n" % len(data) + zlib.compress(data))
+print(h)'
+}
+
+# Commit cujo .meta aponta para a tree `$2`, com id `$1`, filho do HEAD
+write_evil_commit() {
+    printf 'id: %s\nparent: %s\ntree: %s\ntimestamp: 2999-01-01 00:00:00\nauthor: x\nmessage: x\n' \
+        "$1" "$(head_id)" "$2" > ".clurg/commits/$1.meta"
+}
+
+if command -v python3 > /dev/null 2>&1; then
+    new_repo evil_src
+    SRC="$REPO"
+    echo "conteúdo" > ok.txt
+    commit "legítimo"
+    BLOB=$(printf '%s' "$("$CLURG" hash ok.txt)" | cut -c1-64)
+    SUB=$(printf '100644 %s escaped.txt\n' "$BLOB" | write_tree_object)
+    DOTDOT=$(printf '040000 %s ..\n' "$SUB" | write_tree_object)
+    SLASH=$(printf '100644 %s sub/../../slash.txt\n' "$BLOB" | write_tree_object)
+
+    write_evil_commit 29990101000001 "$SLASH"
+    test_check "Checkout recusa nome com '/'" \
+        "! '$CLURG' checkout 29990101000001 && [ ! -e '$SRC/../slash.txt' ] && [ ! -e /tmp/slash.txt ]"
+
+    write_evil_commit 29990101000002 "$DOTDOT"
+    echo 29990101000002 > .clurg/HEAD
+    mkdir -p "$SRC/clone/work"
+    cd "$SRC/clone/work"
+    test_check "Clone recusa entrada '..'" \
+        "! '$CLURG' clone evil 'file://$SRC' && [ ! -e '$SRC/clone/escaped.txt' ]"
+else
+    test_skip "Checkout recusa nome com '/'" "python3 não instalado"
+    test_skip "Clone recusa entrada '..'" "python3 não instalado"
+fi
+cd "$PROJECT_DIR"
+echo ""
+
+echo "5. Packs (clurg repack)"
+echo "----------------------------------------"
+new_repo pack
+for n in 1 2 3; do
+    echo "arquivo $n" > "f$n.txt"
+    commit "c$n"
+done
+FIRST=$("$CLURG" log | sed -n 's/^Commit: //p' | tail -1)
+test_check "Repack conclui" "'$CLURG' repack"
+test_check "Objetos e .meta soltos vão para os packs" \
+    "ls .clurg/objects/pack/*.pack .clurg/commits/pack/*.idx && [ -z \"\$(find .clurg/objects -path '*/pack' -prune -o -type f -print)\" ] && ! ls .clurg/commits/*.meta"
+test_check "Log lê os commits empacotados" "[ \$('$CLURG' log | grep -c '^Commit:') -eq 3 ]"
+test_check "Checkout lê objetos do pack" \
+    "'$CLURG' checkout '$FIRST' && [ -f f1.txt ] && [ ! -e f2.txt ] && [ \"\$(cat f1.txt)\" = 'arquivo 1' ]"
+cd "$PROJECT_DIR"
+echo ""
+
+echo "6. Commit e snapshot nativos"
+echo "----------------------------------------"
+new_repo snapshot
+mkdir -p src/deep
+echo "main" > src/main.c
+echo "fundo" > src/deep/x.txt
+printf '#!/bin/sh\n' > run.sh
+chmod +x run.sh
+commit "snapshot"
+test_check "Commit grava o .meta sem scripts auxiliares" \
+    "[ ! -e .clurg/scripts/commit.sh ] && grep -q '^tree: [0-9a-f]\{64\}\$' .clurg/commits/\$(head_id).meta"
+# Sem remoto no ar o push falha, mas deixa o tar.gz em .clurg/snapshots
+"$CLURG" push http://127.0.0.1:1/ > /dev/null 2>&1 || true
+test_check "Snapshot do push tem os arquivos do commit" \
+    "mkdir x && tar -xzf .clurg/snapshots/*.tar.gz -C x && cmp x/src/main.c src/main.c && cmp x/src/deep/x.txt src/deep/x.txt && [ -x x/run.sh ] && [ ! -e x/.clurg ]"
+cd "$PROJECT_DIR"
+echo ""
+
+echo "7. Índice de stat"
+echo "----------------------------------------"
+new_repo index
+for n in 1 2 3 4; do echo "arquivo $n" > "f$n.txt"; done
+commit "c1"
+test_check "Primeiro commit lê todos os arquivos" "grep -q '4 arquivos (4 lidos)' /tmp/clurg_core_commit"
+commit "c2"
+test_check "Commit sem mudanças não relê nada" "grep -q '4 arquivos (0 lidos)' /tmp/clurg_core_commit"
+echo "mudou" > f2.txt
+touch -d '1 minute ago' f3.txt
+commit "c3"
+test_check "Só os arquivos com stat diferente são relidos" \
+    "grep -q '4 arquivos (2 lidos), 2 novos objetos' /tmp/clurg_core_commit"
+rm .clurg/index
+commit "c4"
+test_check "Sem .clurg/index o commit relê tudo e recria o índice" \
+    "grep -q '4 arquivos (4 lidos)' /tmp/clurg_core_commit && [ -s .clurg/index ]"
+cd "$PROJECT_DIR"
+echo ""
+
+echo "8. Compressão paralela dos snapshots"
+echo "----------------------------------------"
+new_repo pgzip
+mkdir -p data
+for n in 1 2 3 4 5 6 7 8; do
+    seq 1 $((n * 20000)) > "data/seq$n.txt"
+done
+head -c 1500000 /dev/urandom > data/random.bin
+commit "pgzip"
+# O nome do tar.gz só muda de segundo em segundo: tirar cada um do caminho.
+# O mtime dos cabeçalhos tar é a hora do push, então repetir até os dois
+# caírem no mesmo segundo e só o gzip poder diferir
+for attempt in 1 2 3; do
+    for threads in 1 4; do
+        CLURG_COMPRESS_THREADS=$threads "$CLURG" push http://127.0.0.1:1/ > "push$threads.out" 2>&1 || true
+        mv .clurg/snapshots/*.tar.gz "snap$threads.tar.gz"
+    done
+    zcat snap1.tar.gz | cmp -s - <(zcat snap4.tar.gz) && break
+done
+test_check "Snapshot com 4 threads é um gzip válido" \
+    "grep -q 'gzip, 4 threads' push4.out && gzip -t snap4.tar.gz"
+test_check "Saída é a mesma com 1 e 4 threads" "cmp snap1.tar.gz snap4.tar.gz"
+test_check "Conteúdo sobrevive à compressão em blocos" \
+    "mkdir x && tar -xzf snap4.tar.gz -C x && cmp x/data/seq8.txt data/seq8.txt && cmp x/data/random.bin data/random.bin"
+seq 1 300000 > plain.txt
+test_check "clurg compress gera gzip que o gzip lê" "'$CLURG' compress < plain.txt | gzip -dc | cmp -s - plain.txt"
+test_check "clurg compress não depende do número de threads" \
+    "CLURG_COMPRESS_THREADS=1 '$CLURG' compress < plain.txt > c1.gz && CLURG_COMPRESS_THREADS=4 '$CLURG' compress < plain.txt > c4.gz && cmp c1.gz c4.gz"
+# backup.sh usa o diretório pai do script como repositório
+mkdir -p scripts
+cp "$PROJECT_DIR/scripts/backup.sh" scripts/
+ln -s "$PROJECT_DIR/bin" bin
+test_check "backup.sh comprime com o clurg" \
+    "./scripts/backup.sh && gzip -t .clurg/backups/weekly_backup_*.tar.gz && tar -tzf .clurg/backups/weekly_backup_*.tar.gz | grep -q '^.clurg/HEAD\$'"
+rm -f .clurg/backups/*
+mkdir -p fakebin
+printf '#!/bin/sh\nexit 2\n' > fakebin/tar
+chmod +x fakebin/tar
+test_check "backup.sh falha quando o tar falha" \
+    "! PATH=\"\$PWD/fakebin:\$PATH\" ./scripts/backup.sh && [ -z \"\$(ls .clurg/backups)\" ]"
+cd "$PROJECT_DIR"
+echo ""
+
+echo "9. Deltas entre versões"
+echo "----------------------------------------"
+new_repo delta
+seq 1 50000 > big.txt
+commit "base"
+FIRST=$(head_id)
+sed -i 's/^25000$/vinte e cinco mil/' big.txt
+commit "linha alterada"
+test_check "Arquivo pouco alterado é gravado como delta" \
+    "grep -q '1 como delta' /tmp/clurg_core_commit && grep -q '^stored_bytes: [0-9]\{1,3\}\$' .clurg/commits/\$(head_id).meta"
+test_check "Versão em delta é reconstruída na leitura" \
+    "'$CLURG' show \$(head_id) big.txt | cmp -s - big.txt"
+test_check "Checkout da versão base depois do delta" \
+    "'$CLURG' checkout '$FIRST' && seq 1 50000 | cmp -s - big.txt"
+sed -i 's/^100$/cem/' big.txt
+CLURG_DELTA_MAX_DEPTH=0 "$CLURG" commit "sem delta" > /tmp/clurg_core_commit 2>&1
+test_check "delta.max_depth=0 desliga os deltas" \
+    "grep -q '0 como delta' /tmp/clurg_core_commit"
+cd "$PROJECT_DIR"
+echo ""
+
+echo "10. Índice do log"
+echo "----------------------------------------"
+new_repo log
+for n in 1 2 3; do
+    echo "$n" > a.txt
+    USER=ana commit "c$n"
+done
+echo "4" > a.txt
+USER=bia commit "c4"
+LAST=$(head_id)
+count_log() {
+    "$CLURG" log "$@" | grep -c '^Commit:' || true
+}
+test_check "log -n limita a quantidade" \
+    "[ \$(count_log -n 2) -eq 2 ] && [ \"\$('$CLURG' log -n 1 | sed -n 's/^Commit: //p')\" = '$LAST' ]"
+test_check "log --author filtra pelo autor" "[ \$(count_log --author ana) -eq 3 ] && [ \$(count_log --author bia) -eq 1 ]"
+test_check "log --since filtra pela data" "[ \$(count_log --since 2000-01-01) -eq 4 ] && [ \$(count_log --since 2999-01-01) -eq 0 ]"
+rm .clurg/commits/log.idx .clurg/commits/log.str
+test_check "Índice apagado é reconstruído a partir dos .meta" \
+    "[ \$(count_log) -eq 4 ] && [ -s .clurg/commits/log.idx ] && [ \$(count_log --author bia) -eq 1 ]"
+# log.str que não aceita mais escrita mas continua legível: com ulimit -f o
+# append falha com EFBIG (como num disco cheio) e o log.idx antigo ainda abre.
+# Bytes a mais no fim do log.str não são referenciados por nenhum registro
+head -c 2048 /dev/zero >> .clurg/commits/log.str
+echo "5" > a.txt
+(trap '' XFSZ; ulimit -f 1; USER=ana commit "c5")
+test_check "Falha ao gravar o índice não esconde o commit do log" \
+    "[ \"\$('$CLURG' log -n 1 | sed -n 's/^Commit: //p')\" = \"\$(head_id)\" ] && [ \$(count_log) -eq 5 ] && [ \$(count_log --author ana) -eq 4 ]"
+# log.idx menor que o cabeçalho
+head -c 10 .clurg/commits/log.idx > idx.tmp && mv idx.tmp .clurg/commits/log.idx
+echo "6" > a.txt
+commit "c6"
+test_check "log.idx truncado é recriado em vez de receber o registro" \
+    "[ \$(count_log) -eq 6 ] && [ \"\$('$CLURG' log -n 1 | sed -n 's/^Commit: //p')\" = \"\$(head_id)\" ]"
+cd "$PROJECT_DIR"
+echo ""
+
+echo "11. Status"
+echo "----------------------------------------"
+new_repo status
+mkdir -p dir/sub
+echo "fica" > same.txt
+echo "antes" > changed.txt
+echo "some" > dir/sub/gone.txt
+commit "base"
+test_check "Status limpo logo após o commit" "'$CLURG' status | grep -q 'Nenhuma alteração'"
+echo "depois" > changed.txt
+rm dir/sub/gone.txt
+echo "novo" > dir/new.txt
+"$CLURG" status > status.out 2>&1
+test_check "Status mostra A, M e D com o caminho completo" \
+    "grep -q '^  M  changed.txt\$' status.out && grep -q '^  D  dir/sub/gone.txt\$' status.out && grep -q '^  A  dir/new.txt\$' status.out"
+test_check "Arquivos iguais ao HEAD não aparecem" "! grep -q 'same.txt' status.out"
+touch -d '1 minute ago' same.txt
+test_check "Mudança só de mtime não conta como alteração" "! '$CLURG' status | grep -q same.txt"
+cd "$PROJECT_DIR"
+echo ""
+
+echo "12. SHA-256 (clurg hash)"
+echo "----------------------------------------"
+new_repo sha
+# Tamanhos nas bordas do bloco de 64 bytes e arquivos suficientes para o multi-buffer
+for size in 0 1 55 56 63 64 65 1000 100000; do
+    head -c $size /dev/urandom > "s$size.bin"
+done
+head -c 3000000 /dev/urandom > grande.bin
+sha256sum *.bin > expected.sum
+for impl in scalar sha-ni avx2; do
+    if CLURG_SHA256_IMPL=$impl "$CLURG" hash s0.bin 2>&1 | grep -q 'não suportado'; then
+        test_skip "Implementação $impl confere com sha256sum" "CPU sem suporte"
+        continue
+    fi
+    test_check "Implementação $impl confere com sha256sum" \
+        "CLURG_SHA256_IMPL=$impl '$CLURG' hash *.bin | cmp -s - expected.sum"
+done
+test_check "hash -c aceita a lista do sha256sum" "'$CLURG' hash -c expected.sum"
+head -c 10 /dev/urandom >> s1000.bin
+test_check "hash -c acusa arquivo alterado" "! '$CLURG' hash -c expected.sum"
+cd "$PROJECT_DIR"
+echo ""
+
+echo "13. Snapshots com acesso aleatório (clurg show)"
+echo "----------------------------------------"
+new_repo show
+mkdir -p src
+seq 1 1000 > src/lista.txt
+head -c 500000 /dev/urandom > dados.bin
+commit "show"
+ID=$(head_id)
+test_check "show lê arquivos do commit pelo object store" \
+    "'$CLURG' show '$ID' src/lista.txt | cmp -s - src/lista.txt"
+test_check "show de caminho inexistente falha" "! '$CLURG' show '$ID' src/nada.txt"
+"$CLURG" push http://127.0.0.1:1/ > /dev/null 2>&1 || true
+test_check "Push grava o .csnap do HEAD" "[ -s .clurg/snapshots/$ID.csnap ]"
+# Sem os objetos, só o .csnap pode responder
+mv .clurg/objects objects.bak
+test_check "show lê um arquivo direto do .csnap" \
+    "'$CLURG' show '$ID' dados.bin | cmp -s - dados.bin && '$CLURG' show '$ID' src/lista.txt | cmp -s - src/lista.txt"
+mv objects.bak .clurg/objects
+cd "$PROJECT_DIR"
+echo ""
+
+echo "14. .clurgignore"
+echo "----------------------------------------"
+new_repo ignore
+mkdir -p build node_modules/pkg src/build docs
+echo "x" > build/out.o
+echo "x" > node_modules/pkg/index.js
+echo "x" > src/build/gerado.c
+echo "x" > src/main.c
+echo "x" > debug.log
+echo "x" > keep.log
+echo "x" > docs/a.tmp
+echo "x" > raiz.txt
+echo "x" > src/raiz.txt
+cat > .clurgignore <<'EOF'
+# comentário
+*.log
+!keep.log
+/build/
+node_modules/
+docs/**/*.tmp
+/raiz.txt
+EOF
+"$CLURG" status > status.out 2>&1
+test_check "Status não lista os ignorados" \
+    "! grep -q -e 'debug.log' -e 'build/out.o' -e 'node_modules' -e 'a.tmp' -e ' raiz.txt' status.out"
+test_check "Negação, âncora e diretório homônimo fora da raiz valem" \
+    "grep -q 'keep.log' status.out && grep -q 'src/build/gerado.c' status.out && grep -q 'src/raiz.txt' status.out"
+commit "ignore"
+ID=$(head_id)
+test_check "Commit não grava os ignorados" \
+    "! '$CLURG' show '$ID' debug.log && ! '$CLURG' show '$ID' build/out.o && ! '$CLURG' show '$ID' raiz.txt && '$CLURG' show '$ID' keep.log && '$CLURG' show '$ID' src/raiz.txt"
+cd "$PROJECT_DIR"
+echo ""
+
+echo "15. Daemon de observação (clurg watch)"
+echo "----------------------------------------"
+new_repo watch
+mkdir -p a/b/c
+echo "v1" > a/b/c/deep.txt
+echo "v1" > top.txt
+commit "base"
+if "$CLURG" watch > /dev/null 2>&1 && sleep 0.3 && "$CLURG" watch --status | grep -q 'ativo'; then
+    "$CLURG" status > /dev/null 2>&1
+    echo "v2" > a/b/c/deep.txt
+    mkdir -p a/novo && echo "n" > a/novo/n.txt
+    sleep 0.3
+    test_check "Daemon registra os caminhos alterados" \
+        "'$CLURG' watch --status | grep -q '[1-9][0-9]* caminhos alterados'"
+    "$CLURG" status > status.out 2>&1
+    test_check "Status com o daemon vê mudanças em diretórios novos e fundos" \
+        "grep -q 'M  a/b/c/deep.txt' status.out && grep -q 'A  a/novo/n.txt' status.out && ! grep -q top.txt status.out"
+    commit "pelo daemon"
+    test_check "Commit com o daemon grava a árvore completa" \
+        "'$CLURG' show \$(head_id) a/b/c/deep.txt | grep -qx v2 && '$CLURG' show \$(head_id) top.txt | grep -qx v1 && '$CLURG' show \$(head_id) a/novo/n.txt"
+    test_check "watch --stop encerra o daemon" \
+        "'$CLURG' watch --stop && ! '$CLURG' watch --status"
+else
+    "$CLURG" watch --stop > /dev/null 2>&1 || true
+    test_skip "Daemon registra os caminhos alterados" "inotify indisponível"
+fi
+cd "$PROJECT_DIR"
+echo ""
+
+echo "16. Chunks de arquivos grandes e remotos em diretório"
+echo "----------------------------------------"
+new_repo chunk
+head -c 4000000 /dev/urandom > big.bin
+cp big.bin ../clurg_core_$$_big.orig
+commit "grande"
+FIRST=$(head_id)
+test_check "Arquivo grande é dividido em chunks" \
+    "[ \$(sed -n 's/.* \([0-9]*\) novos objetos.*/\1/p' /tmp/clurg_core_commit) -gt 10 ]"
+# Inserir bytes no meio só altera os chunks em volta do ponto de inserção
+{ head -c 2000000 ../clurg_core_$$_big.orig; printf 'INSERIDO'; tail -c +2000001 ../clurg_core_$$_big.orig; } > big.bin
+commit "inserção"
+test_check "Inserção no meio grava poucos objetos novos" \
+    "[ \$(sed -n 's/.* \([0-9]*\) novos objetos.*/\1/p' /tmp/clurg_core_commit) -le 6 ]"
+test_check "Checkout remonta o arquivo a partir dos chunks" \
+    "'$CLURG' checkout '$FIRST' && cmp big.bin ../clurg_core_$$_big.orig"
+REMOTE="/tmp/clurg_core_$$_remote"
+mkdir -p "$REMOTE"
+test_check "Push para remoto em diretório" "'$CLURG' push 'file://$REMOTE' && [ -f '$REMOTE/.clurg/HEAD' ]"
+test_check "Segundo push não reenvia objetos" "'$CLURG' push 'file://$REMOTE' | grep -q ' 0 objetos novos'"
+mkdir -p /tmp/clurg_core_$$_clone
+cd /tmp/clurg_core_$$_clone
+test_check "Clone do remoto em diretório traz o arquivo intacto" \
+    "'$CLURG' clone proj 'file://$REMOTE' && cmp big.bin ../clurg_core_$$_big.orig"
+cd "$PROJECT_DIR"
+echo ""
+
+echo "17. Deploy"
+echo "----------------------------------------"
+new_repo deploy
+printf '# Ambiente: staging\ndeploy: true\ntimeout: 5\n' > clurg.deploy
+echo "v1" > app.txt
+commit "app"
+DEPLOY_ID=$(head_id)
+ENV_DIR=".clurg/projects/clurg_core_$$_deploy/deploy/staging"
+test_check "Deploy reconstrói o commit a partir dos objetos" \
+    "'$CLURG' deploy staging '$DEPLOY_ID' > /dev/null 2>&1 && grep -q v1 '$ENV_DIR/app.txt'"
+test_check "Deploy de id inexistente falha com erro claro" \
+    "! '$CLURG' deploy staging 20990101_000000 > /dev/null 2>/tmp/clurg_test_output && grep -q 'não existe' /tmp/clurg_test_output"
+# Projeto com snapshots próprios não cai no object store do repositório
+mkdir -p ".clurg/projects/clurg_core_$$_deploy/commits"
+test_check "Projeto com commits próprios recusa id de fora deles" \
+    "! '$CLURG' deploy staging '$DEPLOY_ID' > /dev/null 2>/tmp/clurg_test_output && grep -q 'não pertence ao projeto' /tmp/clurg_test_output"
+cd "$PROJECT_DIR"
+echo ""
+
+echo "=========================================="
+echo "Resumo dos Testes do Núcleo"
+echo "=========================================="
+echo -e "Testes passaram: ${GREEN}$TESTS_PASSED${NC}"
+echo -e "Testes falharam: ${RED}$TESTS_FAILED${NC}"
+echo -e "Testes pulados: ${YELLOW}$TESTS_SKIPPED${NC}"
+echo ""
+
+if [ $TESTS_FAILED -eq 0 ]; then
+    echo -e "${GREEN}✓ Todos os testes do núcleo passaram!${NC}"
+    exit 0
+else
+    echo -e "${RED}✗ Alguns testes falharam${NC}"
+    exit 1
+fi